@@ -0,0 +1,2138 @@
+#include "Benchmarks.h"
+#include "StandInLlm.h"
+
+#include "Engine/AttributeIndex.h"
+#include "Engine/ContextPacker.h"
+#include "Engine/Decompressor.h"
+#include "Engine/Filter.h"
+#include "Engine/FilterWorker.h"
+#include "Engine/KeywordSketch.h"
+#include "Engine/LineParser.h"
+#include "Engine/LineSplitter.h"
+#include "Engine/LlmClient.h"
+#include "Engine/LogCache.h"
+#include "Engine/LogDocument.h"
+#include "Engine/LogFollower.h"
+#include "Engine/LogLoader.h"
+#include "Engine/LogMerge.h"
+#include "Engine/MappedFile.h"
+#include "Engine/Parallel.h"
+#include "Engine/RegexLineParser.h"
+#include "Engine/RowAggregates.h"
+#include "Engine/Summary.h"
+#include "Engine/TemplateMiner.h"
+#include "Engine/Text.h"
+#include "Engine/TextSearch.h"
+#include "Engine/Timestamp.h"
+#include "Engine/TrigramIndex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(LOGMINDS_HAVE_ZLIB)
+#include <zlib.h>
+#endif
+#if defined(LOGMINDS_HAVE_ZSTD)
+#include <zstd.h>
+#endif
+
+using namespace LogMinds::Engine;
+
+namespace LogMinds::Cli
+{
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        double Seconds(Clock::time_point start)
+        {
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        }
+
+        void Report(char const* name, size_t bytes, size_t lines, double seconds)
+        {
+            std::printf("%-34s %9.1f ms %8.2f GB/s %10.2f Mlines/s\n", name, seconds * 1000.0,
+                static_cast<double>(bytes) / seconds / 1e9, static_cast<double>(lines) / seconds / 1e6);
+        }
+
+        std::filesystem::path ResolveInput(BenchOptions const& options)
+        {
+            if (!options.Path.empty())
+            {
+                return options.Path;
+            }
+            std::fprintf(stderr, "preparing %zu MB synthetic log...\n", options.SizeMb);
+            return EnsureSyntheticFile(options.SizeMb << 20, options.Layout);
+        }
+
+        std::vector<std::string_view> SplitSample(std::string_view text)
+        {
+            std::vector<std::string_view> lines;
+            size_t start = 0;
+            while (start < text.size())
+            {
+                auto end = text.find('\n', start);
+                if (end == std::string_view::npos)
+                {
+                    end = text.size();
+                }
+                lines.push_back(text.substr(start, end - start));
+                start = end + 1;
+            }
+            return lines;
+        }
+
+        // Level 6 gzip and level 3 zstd, the tools' defaults. Empty when the
+        // build has no library for it.
+        std::string Compress(std::string_view text, Compression compression)
+        {
+            std::string output;
+#if defined(LOGMINDS_HAVE_ZLIB)
+            if (compression == Compression::Gzip)
+            {
+                z_stream stream{};
+                deflateInit2(&stream, 6, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+                output.resize(deflateBound(&stream, static_cast<uLong>(text.size())));
+                stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(text.data()));
+                stream.avail_in = static_cast<uInt>(text.size());
+                stream.next_out = reinterpret_cast<Bytef*>(output.data());
+                stream.avail_out = static_cast<uInt>(output.size());
+                deflate(&stream, Z_FINISH);
+                output.resize(stream.total_out);
+                deflateEnd(&stream);
+            }
+#endif
+#if defined(LOGMINDS_HAVE_ZSTD)
+            if (compression == Compression::Zstd)
+            {
+                output.resize(ZSTD_compressBound(text.size()));
+                output.resize(ZSTD_compress(output.data(), output.size(), text.data(), text.size(), 3));
+            }
+#endif
+            (void)text;
+            (void)compression;
+            return output;
+        }
+
+        bool SameRows(LogStore const& left, LogStore const& right)
+        {
+            auto same = left.Size() == right.Size();
+            for (size_t row = 0; same && row < left.Size(); ++row)
+            {
+                same = left.Raw(row) == right.Raw(row) && left.Message(row) == right.Message(row) &&
+                    left.Context(row) == right.Context(row) && left.Source(row) == right.Source(row) &&
+                    left.Level(row) == right.Level(row) && left.OccurredOn(row) == right.OccurredOn(row);
+            }
+            return same;
+        }
+
+        // Follows a file whose last line has no newline yet, from the store a
+        // load of it gives, as the window does, then appends remainder; the
+        // rows followed must be those of loading the grown file.
+        bool FollowsUnfinishedLine(std::filesystem::path const& path, std::string const& written,
+            std::string_view remainder, unsigned threadCount)
+        {
+            {
+                std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+                stream << written;
+            }
+            auto expected = ParseDocument(written + std::string(remainder), threadCount);
+            auto latest = std::make_shared<LogStore const>(ParseDocument(written, threadCount));
+            std::mutex mutex;
+            std::condition_variable delivered;
+            {
+                LogFollower follower(path, latest, written.size(), [&](FollowUpdate&& update)
+                {
+                    std::lock_guard lock(mutex);
+                    latest = std::move(update.Store);
+                    delivered.notify_all();
+                }, std::chrono::milliseconds(20), threadCount);
+                {
+                    std::ofstream stream(path, std::ios::binary | std::ios::app);
+                    stream << remainder;
+                }
+                std::unique_lock lock(mutex);
+                delivered.wait_for(lock, std::chrono::seconds(5), [&]()
+                {
+                    return latest->Size() >= expected.Size();
+                });
+            }
+            std::filesystem::remove(path);
+            return SameRows(*latest, expected);
+        }
+
+        bool SameTemplates(LogStore const& left, LogStore const& right)
+        {
+            auto same = left.Size() == right.Size() && left.Templates().Size() == right.Templates().Size();
+            for (size_t row = 0; same && row < left.Size(); ++row)
+            {
+                same = left.TemplateId(row) == right.TemplateId(row);
+            }
+            for (uint32_t id = 0; same && id < left.Templates().Size(); ++id)
+            {
+                same = left.Templates().Text(id) == right.Templates().Text(id);
+            }
+            return same;
+        }
+
+        bool SameAggregates(RowAggregates const& left, RowAggregates const& right)
+        {
+            auto trimmed = [](std::vector<size_t> counts)
+            {
+                while (!counts.empty() && counts.back() == 0)
+                {
+                    counts.pop_back();
+                }
+                return counts;
+            };
+            return left.Rows() == right.Rows() && trimmed(left.LevelRows()) == trimmed(right.LevelRows()) &&
+                left.OverflowLevelRows() == right.OverflowLevelRows() &&
+                trimmed(left.SourceRows()) == trimmed(right.SourceRows()) && left.TimedRows() == right.TimedRows() &&
+                left.FirstTime() == right.FirstTime() && left.LastTime() == right.LastTime() &&
+                left.CriticalRows() == right.CriticalRows() && left.CriticalSamples() == right.CriticalSamples();
+        }
+
+        // The summary's keyword count before KeywordSketch: every distinct
+        // word in a hash map.
+        void CountKeywordsExactly(std::string_view message, std::unordered_map<std::string, uint64_t>& counts)
+        {
+            auto lowerMessage = ToLower(message);
+            std::string word;
+            size_t wordLength = 0;
+            size_t offset = 0;
+            while (offset < lowerMessage.size())
+            {
+                auto start = offset;
+                auto codePoint = DecodeUtf8(lowerMessage, offset);
+                if (codePoint != c_invalidCodePoint && IsWordCodePoint(codePoint))
+                {
+                    word.append(lowerMessage, start, offset - start);
+                    ++wordLength;
+                    continue;
+                }
+                if (wordLength > 3)
+                {
+                    ++counts[word];
+                }
+                word.clear();
+                wordLength = 0;
+            }
+            if (wordLength > 3)
+            {
+                ++counts[word];
+            }
+        }
+
+        size_t HeapBytes(std::string const& text)
+        {
+            // Strings within the small-string buffer do not allocate.
+            return text.capacity() > std::string().capacity() ? text.capacity() + 1 : 0;
+        }
+
+        size_t RecordBytes(std::vector<LogRecord> const& records)
+        {
+            auto bytes = records.capacity() * sizeof(LogRecord);
+            for (auto const& record : records)
+            {
+                bytes += HeapBytes(record.Timestamp) + HeapBytes(record.Level) + HeapBytes(record.Source) +
+                    HeapBytes(record.Message) + HeapBytes(record.Context) + HeapBytes(record.Raw);
+            }
+            return bytes;
+        }
+
+        template <typename Parse>
+        double TimeParse(std::vector<std::string_view> const& lines, Parse parse, size_t& records)
+        {
+            records = 0;
+            auto start = Clock::now();
+            for (auto line : lines)
+            {
+                records += parse(line) ? 1 : 0;
+            }
+            return Seconds(start);
+        }
+    }
+
+    int RunLoadBenchmark(BenchOptions const& options)
+    {
+        auto path = ResolveInput(options);
+        auto threads = ResolveThreadCount(options.Threads);
+
+        MappedFile file;
+        std::string error;
+        auto start = Clock::now();
+        if (!file.Open(path, error))
+        {
+            std::cerr << "cannot map " << path.string() << ": " << error << "\n";
+            return 1;
+        }
+        auto text = file.Text();
+        std::printf("file %s, %.1f MB, %u threads, mapped in %.2f ms\n", path.string().c_str(),
+            static_cast<double>(text.size()) / (1 << 20), threads, Seconds(start) * 1000.0);
+
+        // Warm the page cache so every row below measures CPU, not the disk.
+        auto lines = CountNewlines(text);
+
+        {
+            start = Clock::now();
+            std::ifstream stream(path, std::ios::binary);
+            std::ostringstream buffer;
+            buffer << stream.rdbuf();
+            std::istringstream copy(buffer.str());
+            std::string line;
+            size_t count = 0;
+            while (std::getline(copy, line))
+            {
+                ++count;
+            }
+            Report("read + copy + getline (old path)", text.size(), count, Seconds(start));
+        }
+
+        start = Clock::now();
+        lines = CountNewlines(text);
+        Report("mmap + SIMD newline scan, 1 thread", text.size(), lines, Seconds(start));
+
+        start = Clock::now();
+        auto chunks = SplitIntoChunks(text, threads * 8);
+        std::atomic<size_t> parallelLines{ 0 };
+        ParallelFor(chunks.size(), threads, [&](size_t index)
+        {
+            parallelLines += CountNewlines(chunks[index]);
+        });
+        Report("mmap + SIMD newline scan, N threads", text.size(), parallelLines.load(), Seconds(start));
+
+        auto parseBytes = std::min(text.size(), options.ParseMb << 20);
+        auto sample = text.substr(0, parseBytes);
+        auto cut = sample.rfind('\n');
+        sample = sample.substr(0, cut == std::string_view::npos ? sample.size() : cut + 1);
+
+        start = Clock::now();
+        auto sequential = ParseLines(sample, 1);
+        Report("parse lines, 1 thread", sample.size(), sequential.Size(), Seconds(start));
+
+        start = Clock::now();
+        auto parallel = ParseLines(sample, threads);
+        Report("parse lines, N threads", sample.size(), parallel.Size(), Seconds(start));
+
+        if (sequential.Size() != parallel.Size())
+        {
+            std::cerr << "record count mismatch: " << sequential.Size() << " vs " << parallel.Size() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    int RunParseBenchmark(BenchOptions const& options)
+    {
+        static constexpr SyntheticLayout c_layouts[] = { SyntheticLayout::Iso, SyntheticLayout::Syslog,
+            SyntheticLayout::KeyValue, SyntheticLayout::Level, SyntheticLayout::Json, SyntheticLayout::Plain,
+            SyntheticLayout::Mixed };
+        static constexpr char const* c_names[] = { "iso", "syslog", "kv", "level", "json", "plain", "mixed" };
+
+        std::printf("%-8s %12s %12s %12s %9s  %s\n", "layout", "regex", "cascade", "sniffed", "speedup",
+            "detected");
+        for (size_t i = 0; i < std::size(c_layouts); ++i)
+        {
+            std::string text;
+            AppendSyntheticLog(text, options.ParseMb << 20, c_layouts[i]);
+            auto lines = SplitSample(text);
+
+            size_t regexRecords = 0;
+            size_t scannerRecords = 0;
+            auto regexSeconds = TimeParse(lines, [](std::string_view line) { return ParseLineWithRegex(line); },
+                regexRecords);
+            auto scannerSeconds = TimeParse(lines, [](std::string_view line) { return ParseLine(line); },
+                scannerRecords);
+
+            auto format = DetectLineFormat(text);
+            size_t sniffedRecords = 0;
+            size_t misses = 0;
+            auto sniffedSeconds = TimeParse(lines, [&](std::string_view line)
+            {
+                bool hit = true;
+                auto record = ParseLineAs(format, line, hit);
+                misses += hit ? 0 : 1;
+                return record;
+            }, sniffedRecords);
+
+            if (regexRecords != scannerRecords || regexRecords != sniffedRecords)
+            {
+                std::cerr << c_names[i] << ": record count mismatch\n";
+                return 1;
+            }
+
+            auto rate = [&](double seconds)
+            {
+                return static_cast<double>(lines.size()) / seconds / 1e6;
+            };
+            std::printf("%-8s %7.2f Ml/s %7.2f Ml/s %7.2f Ml/s %8.1fx  %s, %.1f%% hits\n", c_names[i],
+                rate(regexSeconds), rate(scannerSeconds), rate(sniffedSeconds), regexSeconds / sniffedSeconds,
+                std::string(LineFormatName(format)).c_str(),
+                100.0 * static_cast<double>(sniffedRecords - misses) / static_cast<double>(sniffedRecords));
+        }
+        return 0;
+    }
+
+    int RunStoreBenchmark(BenchOptions const& options)
+    {
+        auto path = ResolveInput(options);
+        MappedFile file;
+        std::string error;
+        if (!file.Open(path, error))
+        {
+            std::cerr << "cannot map " << path.string() << ": " << error << "\n";
+            return 1;
+        }
+
+        auto text = file.Text().substr(0, std::min(file.Size(), options.ParseMb << 20));
+        auto cut = text.rfind('\n');
+        text = text.substr(0, cut == std::string_view::npos ? text.size() : cut + 1);
+        CountNewlines(text);
+        std::printf("%.1f MB of %s, 1 thread\n", static_cast<double>(text.size()) / (1 << 20),
+            path.string().c_str());
+
+        auto start = Clock::now();
+        std::vector<LogRecord> records;
+        ForEachLine(text, [&](std::string_view line)
+        {
+            if (auto parsed = ParseLine(line))
+            {
+                records.push_back(std::move(*parsed));
+            }
+        });
+        auto recordSeconds = Seconds(start);
+        auto recordBytes = RecordBytes(records);
+
+        start = Clock::now();
+        auto store = ParseLines(text, 1);
+        auto storeSeconds = Seconds(start);
+        auto storeBytes = store.MemoryUsage();
+
+        if (records.size() != store.Size())
+        {
+            std::cerr << "record count mismatch: " << records.size() << " vs " << store.Size() << "\n";
+            return 1;
+        }
+
+        auto rows = static_cast<double>(records.size());
+        std::printf("%-28s %10s %12s %12s\n", "layout", "load ms", "MB", "bytes/entry");
+        std::printf("%-28s %10.1f %12.1f %12.1f\n", "vector<LogRecord>", recordSeconds * 1000.0,
+            static_cast<double>(recordBytes) / (1 << 20), static_cast<double>(recordBytes) / rows);
+        std::printf("%-28s %10.1f %12.1f %12.1f\n", "LogStore (columns + arena)", storeSeconds * 1000.0,
+            static_cast<double>(storeBytes) / (1 << 20), static_cast<double>(storeBytes) / rows);
+        return 0;
+    }
+
+    int RunSearchBenchmark(BenchOptions const& options, std::string const& term)
+    {
+        auto path = ResolveInput(options);
+        MappedFile file;
+        std::string error;
+        if (!file.Open(path, error))
+        {
+            std::cerr << "cannot map " << path.string() << ": " << error << "\n";
+            return 1;
+        }
+        auto store = ParseDocument(file.Text(), options.Threads);
+        std::printf("%zu records, typing \"%s\"\n", store.Size(), term.c_str());
+        std::printf("%-16s %10s %14s %10s %14s\n", "query", "full ms", "full rows", "incr ms", "incr rows");
+
+        IncrementalFilter incremental(options.Threads);
+        double fullTotal = 0;
+        double incrementalTotal = 0;
+        FilterQuery query;
+        for (size_t length = 1; length <= term.size(); ++length)
+        {
+            query.SearchTerm = ToLower(term.substr(0, length));
+
+            auto start = Clock::now();
+            auto full = ApplyFilter(store, query, options.Threads);
+            auto fullSeconds = Seconds(start);
+
+            start = Clock::now();
+            auto refined = incremental.Apply(store, query);
+            auto incrementalSeconds = Seconds(start);
+
+            if (full != refined)
+            {
+                std::cerr << "selection mismatch for \"" << query.SearchTerm << "\"\n";
+                return 1;
+            }
+            fullTotal += fullSeconds;
+            incrementalTotal += incrementalSeconds;
+            std::printf("%-16s %10.1f %14zu %10.1f %14zu\n", query.SearchTerm.c_str(), fullSeconds * 1000.0,
+                store.Size(), incrementalSeconds * 1000.0, incremental.LastScannedRows());
+        }
+        std::printf("%-16s %10.1f %14s %10.1f\n", "total", fullTotal * 1000.0, "", incrementalTotal * 1000.0);
+        return 0;
+    }
+
+    int RunIndexBenchmark(BenchOptions const& options, std::string const& term)
+    {
+        auto path = ResolveInput(options);
+        MappedFile file;
+        std::string error;
+        if (!file.Open(path, error))
+        {
+            std::cerr << "cannot map " << path.string() << ": " << error << "\n";
+            return 1;
+        }
+        auto store = ParseDocument(file.Text(), options.Threads);
+        auto threads = ResolveThreadCount(options.Threads);
+
+        auto start = Clock::now();
+        auto index = TrigramIndex::Build(store, 1);
+        auto sequentialSeconds = Seconds(start);
+        start = Clock::now();
+        index = TrigramIndex::Build(store, threads);
+        auto parallelSeconds = Seconds(start);
+
+        std::printf("%zu records, store %.1f MB\n", store.Size(), static_cast<double>(store.MemoryUsage()) / (1 << 20));
+        std::printf("index build %.1f ms (1 thread), %.1f ms (%u threads), %.1f MB, %.1f bytes/row\n",
+            sequentialSeconds * 1000.0, parallelSeconds * 1000.0, threads,
+            static_cast<double>(index.MemoryUsage()) / (1 << 20),
+            static_cast<double>(index.MemoryUsage()) / static_cast<double>(std::max<size_t>(1, store.Size())));
+
+        std::vector<std::string> terms = { "timeout", "connection reset", "order:4242", "shard=3", "no such text" };
+        if (!term.empty())
+        {
+            terms.insert(terms.begin(), term);
+        }
+
+        std::printf("%-18s %10s %10s %12s %10s\n", "term", "scan ms", "index ms", "candidates", "matches");
+        for (auto const& text : terms)
+        {
+            FilterQuery query;
+            query.SearchTerm = ToLower(text);
+
+            start = Clock::now();
+            auto scanned = ApplyFilter(store, query, options.Threads);
+            auto scanSeconds = Seconds(start);
+
+            start = Clock::now();
+            auto candidates = index.Candidates(query.SearchTerm);
+            auto indexed = candidates ? ApplyFilter(store, query, *candidates, options.Threads) :
+                ApplyFilter(store, query, options.Threads);
+            auto indexSeconds = Seconds(start);
+
+            if (scanned != indexed)
+            {
+                std::cerr << "selection mismatch for \"" << text << "\"\n";
+                return 1;
+            }
+            std::printf("%-18s %10.1f %10.2f %12zu %10zu\n", text.c_str(), scanSeconds * 1000.0,
+                indexSeconds * 1000.0, candidates ? candidates->size() : store.Size(), indexed.size());
+        }
+        return 0;
+    }
+
+    int RunMatchBenchmark(BenchOptions const& options, std::string const& term)
+    {
+        auto path = ResolveInput(options);
+        MappedFile file;
+        std::string error;
+        if (!file.Open(path, error))
+        {
+            std::cerr << "cannot map " << path.string() << ": " << error << "\n";
+            return 1;
+        }
+        auto store = ParseDocument(file.Text(), options.Threads);
+        size_t rawBytes = 0;
+        for (size_t row = 0; row < store.Size(); ++row)
+        {
+            rawBytes += store.Raw(row).size();
+        }
+        std::printf("%zu records, %.1f MB of raw lines, %s kernel\n", store.Size(),
+            static_cast<double>(rawBytes) / (1 << 20), CaseInsensitiveMatcher::Kernel());
+
+        std::vector<std::string> terms = { "timeout", "e", "connection reset", "order:4242", "\xC3\xA9", "no such text" };
+        if (!term.empty())
+        {
+            terms.insert(terms.begin(), term);
+        }
+
+        // The lower-casing columns do what the filter did before: a ToLower
+        // copy of every searched field, then std::string::find.
+        std::printf("%-18s %12s %12s %12s %12s %10s\n", "term", "lower raw ms", "match raw ms", "lower all ms",
+            "filter ms", "matches");
+        for (auto const& text : terms)
+        {
+            auto lowered = ToLower(text);
+            CaseInsensitiveMatcher matcher(lowered);
+
+            size_t lowerHits = 0;
+            auto start = Clock::now();
+            for (size_t row = 0; row < store.Size(); ++row)
+            {
+                lowerHits += ToLower(store.Raw(row)).find(lowered) != std::string::npos ? 1 : 0;
+            }
+            auto lowerSeconds = Seconds(start);
+
+            size_t matchHits = 0;
+            start = Clock::now();
+            for (size_t row = 0; row < store.Size(); ++row)
+            {
+                matchHits += matcher.FoundIn(store.Raw(row)) ? 1 : 0;
+            }
+            auto matchSeconds = Seconds(start);
+
+            std::vector<uint32_t> expected;
+            start = Clock::now();
+            for (size_t row = 0; row < store.Size(); ++row)
+            {
+                if (ToLower(store.Message(row)).find(lowered) != std::string::npos ||
+                    ToLower(store.Context(row)).find(lowered) != std::string::npos ||
+                    ToLower(store.Source(row)).find(lowered) != std::string::npos ||
+                    ToLower(store.Raw(row)).find(lowered) != std::string::npos)
+                {
+                    expected.push_back(static_cast<uint32_t>(row));
+                }
+            }
+            auto referenceSeconds = Seconds(start);
+
+            FilterQuery query;
+            query.SearchTerm = lowered;
+            start = Clock::now();
+            auto selection = ApplyFilter(store, query, options.Threads);
+            auto filterSeconds = Seconds(start);
+
+            if (lowerHits != matchHits || selection != expected)
+            {
+                std::cerr << "match mismatch for \"" << text << "\"\n";
+                return 1;
+            }
+            std::printf("%-18s %12.1f %12.1f %12.1f %12.1f %10zu\n", text.c_str(), lowerSeconds * 1000.0,
+                matchSeconds * 1000.0, referenceSeconds * 1000.0, filterSeconds * 1000.0, selection.size());
+        }
+        return 0;
+    }
+
+    int RunTypingBenchmark(BenchOptions const& options, std::string const& term)
+    {
+        auto path = ResolveInput(options);
+        MappedFile file;
+        std::string error;
+        if (!file.Open(path, error))
+        {
+            std::cerr << "cannot map " << path.string() << ": " << error << "\n";
+            return 1;
+        }
+        auto store = std::make_shared<LogStore const>(ParseDocument(file.Text(), options.Threads));
+        auto index = std::make_shared<TrigramIndex const>(TrigramIndex::Build(*store, options.Threads));
+        auto const keystroke = std::chrono::milliseconds(options.KeystrokeMs);
+        std::printf("%zu records, typing \"%s\" one key every %zu ms, %lld ms debounce\n", store->Size(),
+            term.c_str(), options.KeystrokeMs, static_cast<long long>(FilterWorker::c_defaultDebounce.count()));
+
+        // What the UI thread used to do per keystroke: filter synchronously.
+        IncrementalFilter synchronous(options.Threads);
+        FilterQuery query;
+        double blockedTotal = 0;
+        double blockedMax = 0;
+        for (size_t length = 1; length <= term.size(); ++length)
+        {
+            query.SearchTerm = term.substr(0, length);
+            auto start = Clock::now();
+            synchronous.Apply(*store, query, index.get());
+            auto seconds = Seconds(start);
+            blockedTotal += seconds;
+            blockedMax = std::max(blockedMax, seconds);
+        }
+
+        std::mutex mutex;
+        std::condition_variable delivered;
+        std::vector<std::pair<FilterResult, Clock::time_point>> results;
+        FilterWorker worker([&](FilterResult&& result)
+        {
+            auto now = Clock::now();
+            std::lock_guard lock(mutex);
+            results.emplace_back(std::move(result), now);
+            delivered.notify_one();
+        });
+
+        std::vector<std::string> submitted(1);
+        uint64_t last = 0;
+        double submitMax = 0;
+        for (size_t length = 1; length <= term.size(); ++length)
+        {
+            query.SearchTerm = term.substr(0, length);
+            submitted.push_back(query.SearchTerm);
+            auto start = Clock::now();
+            last = worker.Submit(store, index, nullptr, query);
+            submitMax = std::max(submitMax, Seconds(start));
+            if (length < term.size())
+            {
+                std::this_thread::sleep_for(keystroke);
+            }
+        }
+        {
+            std::unique_lock lock(mutex);
+            delivered.wait(lock, [&]()
+            {
+                return !results.empty() && results.back().first.Generation == last;
+            });
+        }
+
+        std::printf("%-16s %12s %12s %10s\n", "query", "latency ms", "scanned", "rows");
+        for (auto const& [result, at] : results)
+        {
+            std::printf("%-16s %12.1f %12zu %10zu\n", submitted[result.Generation].c_str(),
+                std::chrono::duration<double, std::milli>(at - result.SubmittedAt).count(), result.ScannedRows,
+                result.Rows.size());
+        }
+        std::printf("%zu keystrokes, %zu results, %zu scans cancelled\n", term.size(), results.size(),
+            worker.CancelledScans());
+        std::printf("UI thread blocked: synchronous %.1f ms total (%.1f ms max), background %.3f ms max per keystroke\n",
+            blockedTotal * 1000.0, blockedMax * 1000.0, submitMax * 1000.0);
+        if (results.back().first.Rows != synchronous.Apply(*store, query, index.get()))
+        {
+            std::cerr << "final selection differs from the synchronous filter\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    int RunFilterScalingBenchmark(BenchOptions const& options, FilterQuery const& extra)
+    {
+        auto path = ResolveInput(options);
+        MappedFile file;
+        std::string error;
+        if (!file.Open(path, error))
+        {
+            std::cerr << "cannot map " << path.string() << ": " << error << "\n";
+            return 1;
+        }
+        auto store = ParseDocument(file.Text(), options.Threads);
+
+        std::vector<unsigned> threadCounts;
+        auto maxThreads = ResolveThreadCount(options.Threads);
+        for (unsigned threads = 1; threads < maxThreads; threads *= 2)
+        {
+            threadCounts.push_back(threads);
+        }
+        threadCounts.push_back(maxThreads);
+
+        std::vector<std::pair<std::string, FilterQuery>> queries;
+        auto addQuery = [&](std::string name, std::string term, std::string level)
+        {
+            FilterQuery query;
+            query.SearchTerm = std::move(term);
+            query.Level = std::move(level);
+            queries.emplace_back(std::move(name), std::move(query));
+        };
+        if (!extra.SearchTerm.empty() || !extra.Level.empty() || extra.StartTime || extra.EndTime)
+        {
+            queries.emplace_back("options", extra);
+        }
+        addQuery("timeout", "timeout", "");
+        addQuery("order:4242", "order:4242", "");
+        addQuery("level ERROR", "", "ERROR");
+        addQuery("e + WARN", "e", "WARN");
+        addQuery("no such text", "no such text", "");
+
+        std::printf("%zu records, best of 3 full scans\n%-16s", store.Size(), "query");
+        for (auto threads : threadCounts)
+        {
+            std::printf(" %8u thr", threads);
+        }
+        std::printf(" %9s %10s\n", "speedup", "rows");
+
+        for (auto const& [name, query] : queries)
+        {
+            std::printf("%-16s", name.c_str());
+            std::vector<uint32_t> sequential;
+            double first = 0;
+            double last = 0;
+            for (auto threads : threadCounts)
+            {
+                double best = 0;
+                for (int run = 0; run < 3; ++run)
+                {
+                    auto start = Clock::now();
+                    auto selection = ApplyFilter(store, query, threads);
+                    auto seconds = Seconds(start);
+                    best = run == 0 ? seconds : std::min(best, seconds);
+                    if (threads == 1 && run == 0)
+                    {
+                        sequential = std::move(selection);
+                    }
+                    else if (selection != sequential)
+                    {
+                        std::cerr << "\nselection with " << threads << " threads differs from the sequential scan\n";
+                        return 1;
+                    }
+                }
+                first = threads == 1 ? best : first;
+                last = best;
+                std::printf(" %9.1f ms", best * 1000.0);
+            }
+            std::printf(" %8.2fx %10zu\n", first / last, sequential.size());
+        }
+        return 0;
+    }
+
+    int RunAttributeIndexBenchmark(BenchOptions const& options, FilterQuery const& extra)
+    {
+        auto path = ResolveInput(options);
+        MappedFile file;
+        std::string error;
+        if (!file.Open(path, error))
+        {
+            std::cerr << "cannot map " << path.string() << ": " << error << "\n";
+            return 1;
+        }
+        auto store = ParseDocument(file.Text(), options.Threads);
+
+        auto start = Clock::now();
+        auto attributes = AttributeIndex::Build(store);
+        auto buildSeconds = Seconds(start);
+        std::printf("%zu records, index build %.1f ms, %.2f MB, time ranges through the %s\n", store.Size(),
+            buildSeconds * 1000.0, static_cast<double>(attributes.MemoryUsage()) / (1 << 20),
+            attributes.UsesZoneMap() ? "zone map" : "sorted permutation");
+
+        std::optional<int64_t> first;
+        std::optional<int64_t> last;
+        for (size_t row = 0; row < store.Size(); ++row)
+        {
+            if (auto occurredOn = store.OccurredOn(row))
+            {
+                first = first ? std::min(*first, *occurredOn) : *occurredOn;
+                last = last ? std::max(*last, *occurredOn) : *occurredOn;
+            }
+        }
+
+        std::vector<std::pair<std::string, FilterQuery>> queries;
+        if (!extra.SearchTerm.empty() || !extra.Level.empty() || extra.StartTime || extra.EndTime)
+        {
+            queries.emplace_back("options", extra);
+        }
+        auto addQuery = [&](std::string name, std::string level, double from, double to)
+        {
+            FilterQuery query;
+            query.Level = std::move(level);
+            if (first && to > from)
+            {
+                auto span = static_cast<double>(*last - *first);
+                query.StartTime = *first + static_cast<int64_t>(span * from);
+                query.EndTime = *first + static_cast<int64_t>(span * to);
+            }
+            queries.emplace_back(std::move(name), std::move(query));
+        };
+        addQuery("level ERROR", "ERROR", 0, 0);
+        addQuery("level FATAL", "FATAL", 0, 0);
+        addQuery("last 1% of time", "", 0.99, 1.0);
+        addQuery("middle 10%", "", 0.45, 0.55);
+        addQuery("first half", "", 0.0, 0.5);
+        addQuery("ERROR, middle 10%", "ERROR", 0.45, 0.55);
+        addQuery("FATAL, first half", "FATAL", 0.0, 0.5);
+
+        std::printf("%-20s %10s %10s %10s\n", "query", "scan ms", "index ms", "rows");
+        for (auto const& [name, query] : queries)
+        {
+            start = Clock::now();
+            auto scanned = ApplyFilter(store, query, options.Threads);
+            auto scanSeconds = Seconds(start);
+
+            IncrementalFilter filter(options.Threads);
+            start = Clock::now();
+            auto indexed = filter.Apply(store, query, nullptr, &attributes);
+            auto indexSeconds = Seconds(start);
+
+            if (scanned != indexed)
+            {
+                std::cerr << "selection mismatch for " << name << "\n";
+                return 1;
+            }
+            std::printf("%-20s %10.1f %10.2f %10zu\n", name.c_str(), scanSeconds * 1000.0, indexSeconds * 1000.0,
+                indexed.size());
+        }
+        return 0;
+    }
+
+    int RunTimestampBenchmark(BenchOptions const& options)
+    {
+        struct Sample
+        {
+            char const* Name;
+            SyntheticLayout Layout;
+            bool Syslog;
+        };
+        static constexpr Sample c_samples[] = {
+            { "iso", SyntheticLayout::Iso, false },
+            { "json", SyntheticLayout::Json, false },
+            { "syslog", SyntheticLayout::Syslog, true },
+        };
+
+        // Early in the year, so that stamps from later months go to the year
+        // before.
+        auto reference = *ParseTimestamp("2024-03-15 12:00:00");
+        std::printf("%-8s %10s %12s %12s %9s %12s\n", "layout", "stamps", "get_time", "decoder", "speedup",
+            "differences");
+        for (auto const& sample : c_samples)
+        {
+            std::string text;
+            AppendSyntheticLog(text, options.ParseMb << 20, sample.Layout);
+            auto store = ParseLines(text, options.Threads);
+            std::vector<std::string_view> stamps;
+            for (size_t row = 0; row < store.Size(); ++row)
+            {
+                if (!store.Timestamp(row).empty())
+                {
+                    stamps.push_back(store.Timestamp(row));
+                }
+            }
+
+            auto time = [&](auto decode, std::vector<std::optional<int64_t>>& results)
+            {
+                results.resize(stamps.size());
+                auto start = Clock::now();
+                for (size_t i = 0; i < stamps.size(); ++i)
+                {
+                    results[i] = decode(stamps[i]);
+                }
+                return Seconds(start);
+            };
+
+            std::vector<std::optional<int64_t>> legacy;
+            std::vector<std::optional<int64_t>> decoded;
+            auto legacySeconds = sample.Syslog ? time([&](std::string_view stamp)
+            {
+                return ParseSyslogTimestampWithGetTime(stamp, reference);
+            }, legacy) : time(ParseTimestampWithGetTime, legacy);
+            auto decodedSeconds = sample.Syslog ? time([&](std::string_view stamp)
+            {
+                return ParseSyslogTimestamp(stamp, reference);
+            }, decoded) : time(ParseTimestamp, decoded);
+
+            size_t differences = 0;
+            for (size_t i = 0; i < stamps.size(); ++i)
+            {
+                if (legacy[i] != decoded[i])
+                {
+                    if (differences++ < 5)
+                    {
+                        std::cerr << "  " << sample.Name << " differs for \"" << stamps[i] << "\"\n";
+                    }
+                }
+            }
+
+            auto rate = [&](double seconds)
+            {
+                return static_cast<double>(stamps.size()) / seconds / 1e6;
+            };
+            std::printf("%-8s %10zu %7.2f Ms/s %7.2f Ms/s %8.1fx %12zu\n", sample.Name, stamps.size(),
+                rate(legacySeconds), rate(decodedSeconds), legacySeconds / decodedSeconds, differences);
+            if (differences != 0)
+            {
+                return 1;
+            }
+        }
+
+        std::printf("\nzones, fractions and syslog years (reference %s):\n", FormatTimestamp(reference).c_str());
+        size_t differences = 0;
+        auto show = [&](std::string_view stamp, std::optional<int64_t> legacy, std::optional<int64_t> decoded)
+        {
+            differences += legacy != decoded ? 1 : 0;
+            std::printf("  %-30s get_time %-20s decoder %-20s\n", std::string(stamp).c_str(),
+                legacy ? std::to_string(*legacy).c_str() : "-", decoded ? std::to_string(*decoded).c_str() : "-");
+        };
+        for (auto stamp : { "2024-03-01T12:34:56Z", "2024-03-01T12:34:56.1234567Z", "2024-03-01 12:34:56,5 +08:00",
+            "2024-03-01T12:34:56-0530", "2024-03-01 12:34:56\t+08:00", "2024-3-1 1:2:3" })
+        {
+            show(stamp, ParseTimestampWithGetTime(stamp), ParseTimestamp(stamp));
+        }
+        for (auto stamp : { "Dec 31 23:59:59", "Mar 16 08:00:00", "Mar 17 08:00:00", "Feb 29 00:00:00" })
+        {
+            auto decoded = ParseSyslogTimestamp(stamp, reference);
+            show(stamp, ParseSyslogTimestampWithGetTime(stamp, reference), decoded);
+            std::printf("  %-30s -> %s\n", "", decoded ? FormatTimestamp(*decoded).c_str() : "-");
+        }
+        return differences == 0 ? 0 : 1;
+    }
+
+    int RunFollowBenchmark(BenchOptions const& options, FilterQuery const& query)
+    {
+        auto path = std::filesystem::temp_directory_path() / "logminds-follow.log";
+        std::string seed;
+        AppendSyntheticLog(seed, 64 << 20, options.Layout, 3);
+        {
+            std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+            stream.write(seed.data(), static_cast<std::streamsize>(seed.size()));
+        }
+        auto initial = std::make_shared<LogStore const>(ParseDocument(seed, options.Threads));
+
+        std::string pool;
+        AppendSyntheticLog(pool, 8 << 20, options.Layout, 4);
+        auto lines = SplitSample(pool);
+
+        struct Delivery
+        {
+            size_t Rows;
+            size_t Matches;
+            double ReadMs;
+            double FilterMs;
+            bool Restarted;
+        };
+        std::mutex mutex;
+        std::condition_variable delivered;
+        std::vector<Delivery> deliveries;
+        std::shared_ptr<LogStore const> latest = initial;
+
+        // The handler does what the window does with an update: filter just
+        // the new rows.
+        LogFollower follower(path, initial, seed.size(), [&](FollowUpdate&& update)
+        {
+            auto readMs = std::chrono::duration<double, std::milli>(Clock::now() - update.PolledAt).count();
+            std::vector<uint32_t> fresh;
+            for (auto row = update.FirstNewRow; row < update.Store->Size(); ++row)
+            {
+                fresh.push_back(static_cast<uint32_t>(row));
+            }
+            auto start = Clock::now();
+            auto matches = ApplyFilter(*update.Store, query, fresh, options.Threads);
+            auto filterMs = Seconds(start) * 1000.0;
+
+            std::lock_guard lock(mutex);
+            deliveries.push_back({ fresh.size(), matches.size(), readMs, filterMs, update.Restarted });
+            latest = std::move(update.Store);
+            delivered.notify_all();
+        }, LogFollower::c_defaultInterval, options.Threads);
+
+        std::printf("appending %zu lines/s for %zu s to %s, polling every %lld ms\n", options.FollowRate,
+            options.FollowSeconds, path.string().c_str(),
+            static_cast<long long>(LogFollower::c_defaultInterval.count()));
+        size_t written = 0;
+        {
+            std::ofstream stream(path, std::ios::binary | std::ios::app);
+            constexpr auto c_tick = std::chrono::milliseconds(10);
+            auto begin = Clock::now();
+            auto end = begin + std::chrono::seconds(options.FollowSeconds);
+            for (auto tick = begin; tick < end; tick += c_tick)
+            {
+                std::this_thread::sleep_until(tick);
+                auto due = static_cast<size_t>(std::chrono::duration<double>(tick + c_tick - begin).count() *
+                    static_cast<double>(options.FollowRate));
+                std::string block;
+                for (; written < due; ++written)
+                {
+                    block.append(lines[written % lines.size()]);
+                    block.push_back('\n');
+                }
+                stream.write(block.data(), static_cast<std::streamsize>(block.size()));
+                stream.flush();
+            }
+        }
+
+        // What loading the finished file from scratch gives.
+        auto whole = seed;
+        for (size_t i = 0; i < written; ++i)
+        {
+            whole.append(lines[i % lines.size()]);
+            whole.push_back('\n');
+        }
+        auto expected = ParseDocument(whole, options.Threads);
+        std::shared_ptr<LogStore const> followed;
+        {
+            std::unique_lock lock(mutex);
+            delivered.wait_for(lock, std::chrono::seconds(10), [&]()
+            {
+                return latest->Size() >= expected.Size();
+            });
+            followed = latest;
+        }
+        auto identical = followed->Size() == expected.Size();
+        for (size_t row = 0; identical && row < expected.Size(); ++row)
+        {
+            identical = followed->Raw(row) == expected.Raw(row) && followed->Message(row) == expected.Message(row) &&
+                followed->Context(row) == expected.Context(row) && followed->Source(row) == expected.Source(row) &&
+                followed->Level(row) == expected.Level(row) && followed->OccurredOn(row) == expected.OccurredOn(row);
+        }
+
+        // Rotate: the file is replaced by a new, shorter one.
+        std::filesystem::rename(path, path.string() + ".1");
+        {
+            std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+            for (size_t i = 0; i < 1000; ++i)
+            {
+                stream << lines[i] << '\n';
+            }
+        }
+        auto rotatedRows = ParseLines(std::string_view(lines[0].data(), lines[999].data() + lines[999].size() -
+            lines[0].data()), options.Threads).Size();
+        bool rotated = false;
+        {
+            std::unique_lock lock(mutex);
+            rotated = delivered.wait_for(lock, std::chrono::seconds(10), [&]()
+            {
+                return !deliveries.empty() && deliveries.back().Restarted && latest->Size() == rotatedRows;
+            });
+        }
+
+        // Replace it with a JSON array that keeps growing; its lines are no
+        // rows of their own, so nothing is delivered.
+        size_t deliveredBefore = 0;
+        {
+            std::lock_guard lock(mutex);
+            deliveredBefore = deliveries.size();
+        }
+        auto appendObjects = [&](size_t first, size_t count, char const* tail)
+        {
+            std::ofstream stream(path, std::ios::binary | std::ios::app);
+            if (first == 0)
+            {
+                stream << "[\n";
+            }
+            for (auto i = first; i < first + count; ++i)
+            {
+                stream << "  {\"level\": \"INFO\", \"message\": \"object " << i << "\"},\n";
+            }
+            stream << tail;
+        };
+        std::filesystem::remove(path);
+        appendObjects(0, 100, "");
+        std::this_thread::sleep_for(2 * LogFollower::c_defaultInterval);
+        appendObjects(100, 100, "  {\"level\": \"INFO\", \"message\": \"last\"}\n]\n");
+        std::this_thread::sleep_for(3 * LogFollower::c_defaultInterval);
+        bool documentIgnored = false;
+        {
+            std::lock_guard lock(mutex);
+            documentIgnored = deliveries.size() == deliveredBefore;
+        }
+
+        std::lock_guard lock(mutex);
+        size_t rows = 0;
+        size_t matches = 0;
+        size_t largest = 0;
+        double readMax = 0;
+        double readTotal = 0;
+        double filterMax = 0;
+        size_t updates = 0;
+        for (auto const& delivery : deliveries)
+        {
+            if (delivery.Restarted)
+            {
+                continue;
+            }
+            ++updates;
+            rows += delivery.Rows;
+            matches += delivery.Matches;
+            largest = std::max(largest, delivery.Rows);
+            readMax = std::max(readMax, delivery.ReadMs);
+            readTotal += delivery.ReadMs;
+            filterMax = std::max(filterMax, delivery.FilterMs);
+        }
+        std::printf("%zu lines written, %zu rows in %zu updates (largest %zu), %zu matches\n", written, rows, updates,
+            largest, matches);
+        std::printf("read + parse + merge per update: mean %.1f ms, max %.1f ms; filter on new rows: max %.2f ms\n",
+            updates ? readTotal / static_cast<double>(updates) : 0.0, readMax, filterMax);
+        std::printf("rotation %s\n", rotated ? "detected, re-read from the start" : "NOT detected");
+        std::printf("growing JSON array %s\n", documentIgnored ? "not followed" : "FOLLOWED line by line");
+
+        std::printf("followed rows %s a full reload\n", identical ? "match" : "DIFFER from");
+
+        // Following starts while the last line is half written; it is then
+        // finished with more text, or with just its newline.
+        std::string head;
+        for (size_t i = 0; i < 10; ++i)
+        {
+            head.append(lines[i]);
+            head.push_back('\n');
+        }
+        auto half = lines[10].size() / 2;
+        auto linePath = std::filesystem::temp_directory_path() / "logminds-follow-line.log";
+        auto lineFinished = FollowsUnfinishedLine(linePath, head + std::string(lines[10].substr(0, half)),
+            std::string(lines[10].substr(half)) + "\n" + std::string(lines[11]) + "\n", options.Threads);
+        auto lineEnded = FollowsUnfinishedLine(linePath, head + std::string(lines[10]),
+            "\n" + std::string(lines[11]) + "\n", options.Threads);
+        std::printf("unfinished last line: finished later %s, ended later %s a full reload\n",
+            lineFinished ? "matches" : "DIFFERS from", lineEnded ? "matches" : "DIFFERS from");
+
+        std::filesystem::remove(path.string() + ".1");
+        return identical && rotated && documentIgnored && lineFinished && lineEnded ? 0 : 1;
+    }
+
+    int RunMergeBenchmark(BenchOptions const& options)
+    {
+        // Each file is a time-ordered slice, as rotated or per-host logs are.
+        auto directory = std::filesystem::temp_directory_path() / "logminds-merge";
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+        auto fileCount = std::max<size_t>(1, options.MergeFiles);
+        size_t bytes = 0;
+        std::vector<std::filesystem::path> paths;
+        for (size_t file = 0; file < fileCount; ++file)
+        {
+            std::string text;
+            AppendSyntheticLog(text, (options.ParseMb << 20) / fileCount, options.Layout, 11 + file);
+            auto store = ParseDocument(text, options.Threads);
+            std::vector<uint32_t> order(store.Size());
+            std::iota(order.begin(), order.end(), 0u);
+            std::stable_sort(order.begin(), order.end(), [&](uint32_t left, uint32_t right)
+            {
+                return store.OccurredOn(left).value_or(LogStore::c_noTimestamp) <
+                    store.OccurredOn(right).value_or(LogStore::c_noTimestamp);
+            });
+            char name[32];
+            std::snprintf(name, sizeof(name), "part-%03zu.log", file);
+            paths.push_back(directory / name);
+            std::ofstream stream(paths.back(), std::ios::binary | std::ios::trunc);
+            for (auto row : order)
+            {
+                stream << store.Raw(row) << '\n';
+                bytes += store.Raw(row).size() + 1;
+            }
+        }
+        std::printf("%zu files, %.1f MB in %s\n", fileCount, static_cast<double>(bytes) / (1 << 20),
+            directory.string().c_str());
+
+        std::string error;
+        auto start = Clock::now();
+        auto expanded = ExpandLogPaths({ directory }, error);
+        ParseReport report;
+        auto merged = ParseLogFiles(expanded, options.Threads, &report, error);
+        auto mergeSeconds = Seconds(start);
+        if (!error.empty())
+        {
+            std::fprintf(stderr, "%s", error.c_str());
+            return 1;
+        }
+
+        // The approach the merge replaces: parse, concatenate, sort a
+        // permutation, then copy the rows out in order.
+        start = Clock::now();
+        std::vector<LogStore> inputs(paths.size());
+        ParallelFor(paths.size(), options.Threads, [&](size_t index)
+        {
+            MappedFile file;
+            std::string openError;
+            if (file.Open(paths[index], openError))
+            {
+                inputs[index] = ParseDocument(file.Text(), 1);
+            }
+        });
+        LogStore concatenated;
+        std::vector<int64_t> keys;
+        for (auto& input : inputs)
+        {
+            auto key = LogStore::c_noTimestamp;
+            for (size_t row = 0; row < input.Size(); ++row)
+            {
+                key = input.OccurredOn(row).value_or(key);
+                keys.push_back(key);
+            }
+            concatenated.Append(std::move(input));
+        }
+        std::vector<uint32_t> order(concatenated.Size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t left, uint32_t right)
+        {
+            return keys[left] < keys[right];
+        });
+        LogStore sorted;
+        sorted.Reserve(concatenated.Size(), concatenated.ArenaSize());
+        LogStore::RowImporter importer(sorted, concatenated);
+        for (auto row : order)
+        {
+            importer.Append(row, 0);
+        }
+        auto sortSeconds = Seconds(start);
+        auto sortPeak = concatenated.MemoryUsage() + sorted.MemoryUsage() + order.capacity() * sizeof(uint32_t) +
+            keys.capacity() * sizeof(int64_t);
+
+        Report("parse + k-way merge", bytes, merged.Size(), mergeSeconds);
+        Report("parse + concatenate + sort", bytes, sorted.Size(), sortSeconds);
+        std::printf("merged store %.1f MB; concatenate + sort holds %.1f MB at its peak\n",
+            static_cast<double>(merged.MemoryUsage()) / (1 << 20), static_cast<double>(sortPeak) / (1 << 20));
+
+        auto identical = merged.Size() == sorted.Size();
+        auto ordered = true;
+        auto previous = LogStore::c_noTimestamp;
+        std::vector<size_t> perOrigin(merged.OriginNames().size());
+        for (size_t row = 0; row < merged.Size(); ++row)
+        {
+            auto key = merged.OccurredOn(row).value_or(previous);
+            ordered = ordered && key >= previous;
+            previous = key;
+            ++perOrigin[merged.OriginId(row)];
+            identical = identical && merged.Raw(row) == sorted.Raw(row) && merged.Level(row) == sorted.Level(row) &&
+                merged.Source(row) == sorted.Source(row) && merged.Message(row) == sorted.Message(row);
+        }
+        for (size_t origin = 1; origin < perOrigin.size(); ++origin)
+        {
+            FilterQuery query;
+            query.Origin = merged.OriginNames()[origin];
+            identical = identical && perOrigin[origin] == ApplyFilter(merged, query, options.Threads).size();
+        }
+        std::printf("merged timeline %s, rows %s the sorted concatenation\n", ordered ? "ordered" : "NOT ordered",
+            identical ? "match" : "DIFFER from");
+
+        std::filesystem::remove_all(directory);
+        return identical && ordered ? 0 : 1;
+    }
+
+    int RunDecompressBenchmark(BenchOptions const& options)
+    {
+        auto path = ResolveInput(options);
+        MappedFile file;
+        std::string error;
+        if (!file.Open(path, error))
+        {
+            std::cerr << "cannot map " << path.string() << ": " << error << "\n";
+            return 1;
+        }
+
+        auto text = file.Text().substr(0, std::min(file.Size(), options.ParseMb << 20));
+        auto cut = text.rfind('\n');
+        text = text.substr(0, cut == std::string_view::npos ? text.size() : cut + 1);
+        std::printf("%.1f MB of %s, %u threads\n", static_cast<double>(text.size()) / (1 << 20),
+            path.string().c_str(), ResolveThreadCount(options.Threads));
+
+        auto start = Clock::now();
+        auto plain = ParseDocument(text, options.Threads);
+        Report("parse uncompressed text", text.size(), plain.Size(), Seconds(start));
+
+        auto failed = false;
+        for (auto compression : { Compression::Gzip, Compression::Zstd })
+        {
+            auto name = std::string(CompressionName(compression));
+            auto compressed = Compress(text, compression);
+            if (!IsCompressionSupported(compression) || compressed.empty())
+            {
+                std::printf("%s: not supported by this build\n", name.c_str());
+                continue;
+            }
+            auto compressedPath = std::filesystem::temp_directory_path() / ("logminds-bench.log." + name);
+            auto decompressedPath = std::filesystem::temp_directory_path() / "logminds-bench.log";
+            {
+                std::ofstream stream(compressedPath, std::ios::binary | std::ios::trunc);
+                stream.write(compressed.data(), static_cast<std::streamsize>(compressed.size()));
+            }
+            std::printf("%s: %.1f MB compressed (%.1fx)\n", name.c_str(),
+                static_cast<double>(compressed.size()) / (1 << 20),
+                static_cast<double>(text.size()) / static_cast<double>(compressed.size()));
+
+            // What had to be done by hand before: decompress to disk, then
+            // open the result.
+            start = Clock::now();
+            {
+                MappedFile input;
+                input.Open(compressedPath, error);
+                Decompressor decompressor(input.Text(), compression);
+                std::ofstream stream(decompressedPath, std::ios::binary | std::ios::trunc);
+                std::string block;
+                while (decompressor.Next(block))
+                {
+                    stream.write(block.data(), static_cast<std::streamsize>(block.size()));
+                }
+            }
+            auto decompressSeconds = Seconds(start);
+            LogStore staged;
+            {
+                MappedFile input;
+                input.Open(decompressedPath, error);
+                staged = ParseDocument(input.Text(), options.Threads);
+            }
+            auto stagedSeconds = Seconds(start);
+
+            start = Clock::now();
+            ParseReport report;
+            LogStore direct;
+            {
+                MappedFile input;
+                input.Open(compressedPath, error);
+                direct = ParseDocument(input.Text(), options.Threads, &report);
+            }
+            auto directSeconds = Seconds(start);
+
+            // Cut off mid-stream: the rows before the cut are kept and the
+            // problem is reported.
+            ParseReport truncatedReport;
+            auto truncated = ParseDocument(std::string_view(compressed).substr(0, compressed.size() / 2),
+                options.Threads, &truncatedReport);
+
+            Report((name + " decompress to disk").c_str(), text.size(), staged.Size(), decompressSeconds);
+            Report((name + " decompress to disk + load").c_str(), text.size(), staged.Size(), stagedSeconds);
+            Report((name + " pipelined load").c_str(), text.size(), direct.Size(), directSeconds);
+            std::printf("%-34s %9.1f MB/s against %.1f MB/s\n", (name + " end to end").c_str(),
+                static_cast<double>(text.size()) / directSeconds / (1 << 20),
+                static_cast<double>(text.size()) / stagedSeconds / (1 << 20));
+
+            auto same = SameRows(direct, plain) && report.Error.empty();
+            auto reported = !truncatedReport.Error.empty() && truncated.Size() < plain.Size();
+            std::printf("%s rows %s the uncompressed load; half a file %s (%zu rows kept: %s)\n", name.c_str(),
+                same ? "match" : "DIFFER from", reported ? "is reported" : "is NOT reported", truncated.Size(),
+                truncatedReport.Error.c_str());
+            failed = failed || !same || !reported;
+
+            std::filesystem::remove(compressedPath);
+            std::filesystem::remove(decompressedPath);
+        }
+        return failed ? 1 : 0;
+    }
+
+    int RunCacheBenchmark(BenchOptions const& options)
+    {
+        auto input = ResolveInput(options);
+        MappedFile file;
+        std::string error;
+        if (!file.Open(input, error))
+        {
+            std::cerr << "cannot map " << input.string() << ": " << error << "\n";
+            return 1;
+        }
+        auto text = file.Text().substr(0, std::min(file.Size(), options.ParseMb << 20));
+        auto cut = text.rfind('\n');
+        text = text.substr(0, cut == std::string_view::npos ? text.size() : cut + 1);
+
+        // The source is a copy so that it can be grown and edited.
+        auto directory = std::filesystem::temp_directory_path() / "logminds-cache-bench";
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+        auto path = directory / "source.log";
+        {
+            std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+            stream.write(text.data(), static_cast<std::streamsize>(text.size()));
+        }
+        file.Close();
+        LogCache cache(directory / "cache");
+        std::printf("%.1f MB of %s, cache in %s\n", static_cast<double>(text.size()) / (1 << 20),
+            input.string().c_str(), (directory / "cache").string().c_str());
+
+        // What opening the file costs without a cache: parse, then the two
+        // indexes the window builds.
+        auto start = Clock::now();
+        MappedFile source;
+        source.Open(path, error);
+        ParseReport report;
+        auto store = ParseDocument(source.Text(), options.Threads, &report);
+        auto parseSeconds = Seconds(start);
+        auto attributes = AttributeIndex::Build(store);
+        auto index = TrigramIndex::Build(store, options.Threads);
+        auto coldSeconds = Seconds(start);
+        auto stamp = SourceStamp::Of(path, source.Text());
+
+        start = Clock::now();
+        if (!cache.Save(path, stamp, store, report, &attributes, &index, error))
+        {
+            std::cerr << error << "\n";
+            return 1;
+        }
+        auto saveSeconds = Seconds(start);
+        source.Close();
+
+        start = Clock::now();
+        source.Open(path, error);
+        CachedLog cached;
+        auto state = cache.Load(path, source.Text(), options.Threads, cached);
+        auto warmSeconds = Seconds(start);
+        source.Close();
+
+        std::printf("%-34s %10.1f ms\n", "parse", parseSeconds * 1000.0);
+        std::printf("%-34s %10.1f ms\n", "parse + attribute + trigram index", coldSeconds * 1000.0);
+        std::printf("%-34s %10.1f ms, %.1f MB entry\n", "save cache entry", saveSeconds * 1000.0,
+            static_cast<double>(std::filesystem::file_size(cache.EntryPath(path))) / (1 << 20));
+        std::printf("%-34s %10.1f ms (%s)\n", "reopen from cache", warmSeconds * 1000.0,
+            std::string(CacheStateName(state)).c_str());
+
+        FilterQuery probe;
+        probe.SearchTerm = "timeout";
+        probe.Level = "ERROR";
+        auto fresh = state == CacheState::Fresh && SameRows(cached.Store, store) &&
+            SameTemplates(cached.Store, store) && SameAggregates(cached.Store.Aggregates(), store.Aggregates()) &&
+            cached.Attributes &&
+            cached.SearchIndex && cached.Report.Hits == report.Hits &&
+            cached.Attributes->Select(cached.Store, probe) == attributes.Select(store, probe) &&
+            cached.SearchIndex->Candidates(probe.SearchTerm) == index.Candidates(probe.SearchTerm);
+
+        // Appended lines are parsed onto the cached rows.
+        std::string appended;
+        AppendSyntheticLog(appended, text.size() / 10, options.Layout, 7);
+        {
+            std::ofstream stream(path, std::ios::binary | std::ios::app);
+            stream.write(appended.data(), static_cast<std::streamsize>(appended.size()));
+        }
+        start = Clock::now();
+        source.Open(path, error);
+        state = cache.Load(path, source.Text(), options.Threads, cached);
+        auto extendSeconds = Seconds(start);
+        start = Clock::now();
+        auto grown = ParseDocument(source.Text(), options.Threads);
+        auto reparseSeconds = Seconds(start);
+        auto extended = state == CacheState::Extended && SameRows(cached.Store, grown) &&
+            SameAggregates(cached.Store.Aggregates(), grown.Aggregates());
+        std::printf("%-34s %10.1f ms (%s) against %.1f ms to parse it all\n", "reopen after 10% appended",
+            extendSeconds * 1000.0, std::string(CacheStateName(state)).c_str(), reparseSeconds * 1000.0);
+        cache.Save(path, SourceStamp::Of(path, source.Text()), cached.Store, cached.Report, nullptr, nullptr, error);
+        source.Close();
+
+        // An edit that keeps the size and the modification time is caught
+        // by the content hash.
+        auto modified = std::filesystem::last_write_time(path);
+        {
+            std::fstream stream(path, std::ios::binary | std::ios::in | std::ios::out);
+            stream.seekp(10);
+            stream.put('#');
+        }
+        std::filesystem::last_write_time(path, modified);
+        source.Open(path, error);
+        auto edited = cache.Load(path, source.Text(), options.Threads, cached);
+        source.Close();
+        std::printf("edited in place: %s\n", std::string(CacheStateName(edited)).c_str());
+
+        std::printf("cached rows and indexes %s a parse; extended rows %s a full parse\n",
+            fresh ? "match" : "DIFFER from", extended ? "match" : "DIFFER from");
+        std::filesystem::remove_all(directory);
+        return fresh && extended && edited == CacheState::Stale ? 0 : 1;
+    }
+
+    int RunProgressiveBenchmark(BenchOptions const& options)
+    {
+        auto input = ResolveInput(options);
+        MappedFile file;
+        std::string error;
+        if (!file.Open(input, error))
+        {
+            std::cerr << "cannot map " << input.string() << ": " << error << "\n";
+            return 1;
+        }
+        auto text = file.Text().substr(0, std::min(file.Size(), options.ParseMb << 20));
+        auto cut = text.rfind('\n');
+        text = text.substr(0, cut == std::string_view::npos ? text.size() : cut + 1);
+        auto path = std::filesystem::temp_directory_path() / "logminds-progressive.log";
+        {
+            std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+            stream.write(text.data(), static_cast<std::streamsize>(text.size()));
+        }
+        file.Close();
+        std::printf("%.1f MB of %s\n", static_cast<double>(text.size()) / (1 << 20), input.string().c_str());
+
+        MappedFile source;
+        source.Open(path, error);
+        auto start = Clock::now();
+        ParseReport expectedReport;
+        ParseContext context{ LastWriteTicks(path) };
+        auto expected = ParseDocument(source.Text(), options.Threads, &expectedReport, context);
+        auto blockingSeconds = Seconds(start);
+        source.Close();
+
+        struct Outcome
+        {
+            std::mutex Mutex;
+            std::condition_variable Done;
+            std::optional<double> FirstRowSeconds;
+            size_t RowUpdates{ 0 };
+            size_t ProgressUpdates{ 0 };
+            std::optional<LoadUpdate> Last;
+        };
+        auto load = [&](Outcome& outcome, Clock::time_point started)
+        {
+            MappedFile mapped;
+            mapped.Open(path, error);
+            return std::make_unique<LogLoader>(std::move(mapped), [&outcome, started](LoadUpdate&& update)
+            {
+                std::lock_guard lock(outcome.Mutex);
+                ++outcome.ProgressUpdates;
+                if (update.Store && update.Store->Size() > update.FirstNewRow)
+                {
+                    ++outcome.RowUpdates;
+                    if (!outcome.FirstRowSeconds)
+                    {
+                        outcome.FirstRowSeconds = Seconds(started);
+                    }
+                }
+                if (update.Finished)
+                {
+                    outcome.Last = std::move(update);
+                }
+                outcome.Done.notify_all();
+            }, options.Threads, context);
+        };
+
+        Outcome full;
+        start = Clock::now();
+        auto loader = load(full, start);
+        double progressiveSeconds = 0;
+        {
+            std::unique_lock lock(full.Mutex);
+            full.Done.wait(lock, [&]()
+            {
+                return full.Last.has_value();
+            });
+            progressiveSeconds = Seconds(start);
+        }
+        loader.reset();
+
+        // Cancelled as soon as the first rows are visible.
+        Outcome cancelled;
+        double cancelSeconds = 0;
+        start = Clock::now();
+        loader = load(cancelled, start);
+        {
+            std::unique_lock lock(cancelled.Mutex);
+            cancelled.Done.wait(lock, [&]()
+            {
+                return cancelled.FirstRowSeconds.has_value() || cancelled.Last.has_value();
+            });
+        }
+        auto cancelledAt = Clock::now();
+        loader->Cancel();
+        {
+            std::unique_lock lock(cancelled.Mutex);
+            cancelled.Done.wait(lock, [&]()
+            {
+                return cancelled.Last.has_value();
+            });
+            cancelSeconds = Seconds(cancelledAt);
+        }
+        loader.reset();
+        std::filesystem::remove(path);
+
+        auto const& last = *full.Last;
+        auto identical = SameRows(*last.Store, expected) && last.Report.Hits == expectedReport.Hits &&
+            last.Report.Misses == expectedReport.Misses && !last.Cancelled;
+        auto const& partial = *cancelled.Last->Store;
+        auto prefix = partial.Size() <= expected.Size();
+        for (size_t row = 0; prefix && row < partial.Size(); ++row)
+        {
+            prefix = partial.Raw(row) == expected.Raw(row);
+        }
+
+        std::printf("%-34s %10.1f ms\n", "ParseDocument, rows at the end", blockingSeconds * 1000.0);
+        std::printf("%-34s %10.1f ms to the first row, %.1f ms in all\n", "LogLoader", *full.FirstRowSeconds * 1000.0,
+            progressiveSeconds * 1000.0);
+        std::printf("%zu updates, %zu of them with rows\n", full.ProgressUpdates, full.RowUpdates);
+        std::printf("cancel after the first rows: stopped in %.1f ms with %zu of %zu rows (%.1f%% of the bytes)\n",
+            cancelSeconds * 1000.0, partial.Size(), expected.Size(),
+            100.0 * static_cast<double>(cancelled.Last->BytesParsed) / static_cast<double>(text.size()));
+        std::printf("progressive rows %s ParseDocument; cancelled rows %s a prefix of them\n",
+            identical ? "match" : "DIFFER from", prefix ? "are" : "are NOT");
+        // A document parsed in one piece finishes before it can be cancelled.
+        auto stopped = cancelled.Last->Cancelled || cancelled.Last->BytesParsed == text.size();
+        return identical && prefix && stopped ? 0 : 1;
+    }
+
+    int RunSummaryBenchmark(BenchOptions const& options)
+    {
+        auto path = ResolveInput(options);
+        MappedFile file;
+        std::string error;
+        if (!file.Open(path, error))
+        {
+            std::cerr << "cannot map " << path.string() << ": " << error << "\n";
+            return 1;
+        }
+        auto text = file.Text().substr(0, std::min(file.Size(), options.ParseMb << 20));
+        auto cut = text.rfind('\n');
+        text = text.substr(0, cut == std::string_view::npos ? text.size() : cut + 1);
+        auto store = ParseDocument(text, options.Threads);
+        std::printf("%.1f MB, %zu rows\n", static_cast<double>(text.size()) / (1 << 20), store.Size());
+
+        // What the summary used to do before writing a word: walk every row.
+        auto start = Clock::now();
+        RowAggregates recounted;
+        for (size_t row = 0; row < store.Size(); ++row)
+        {
+            recounted.Add(store, row);
+        }
+        auto recountSeconds = Seconds(start);
+        start = Clock::now();
+        auto const& running = store.Aggregates();
+        auto lookupSeconds = Seconds(start);
+        std::printf("%-34s %10.2f ms\n", "count every row", recountSeconds * 1000.0);
+        std::printf("%-34s %10.4f ms\n", "aggregates kept while parsing", lookupSeconds * 1000.0);
+        auto identical = SameAggregates(recounted, running);
+
+        // A filter pass hands its aggregates over with the selection.
+        std::vector<std::pair<std::string, FilterQuery>> queries;
+        auto addQuery = [&](std::string name, std::string term, std::string level)
+        {
+            FilterQuery query;
+            query.SearchTerm = std::move(term);
+            query.Level = std::move(level);
+            queries.emplace_back(std::move(name), std::move(query));
+        };
+        addQuery("level ERROR", "", "ERROR");
+        addQuery("search \"timeout\"", "timeout", "");
+        addQuery("search \"a\"", "a", "");
+        for (auto const& [name, query] : queries)
+        {
+            start = Clock::now();
+            auto rows = ApplyFilter(store, query, options.Threads);
+            auto filterSeconds = Seconds(start);
+            start = Clock::now();
+            auto aggregates = RowAggregates::Of(store, rows, options.Threads);
+            auto countSeconds = Seconds(start);
+            start = Clock::now();
+            auto summary = BuildSummary(store, aggregates, rows);
+            auto summarySeconds = Seconds(start);
+            std::printf("%-22s %8zu rows: filter %8.2f ms, aggregates %6.2f ms, summary %8.2f ms\n", name.c_str(),
+                rows.size(), filterSeconds * 1000.0, countSeconds * 1000.0, summarySeconds * 1000.0);
+
+            RowAggregates sequential;
+            for (auto row : rows)
+            {
+                sequential.Add(store, row);
+            }
+            identical = identical && SameAggregates(aggregates, sequential);
+        }
+
+        std::printf("running and per-selection aggregates %s a recount\n", identical ? "match" : "DIFFER from");
+        return identical ? 0 : 1;
+    }
+
+    int RunKeywordBenchmark(BenchOptions const& options)
+    {
+        auto path = ResolveInput(options);
+        MappedFile file;
+        std::string error;
+        if (!file.Open(path, error))
+        {
+            std::cerr << "cannot map " << path.string() << ": " << error << "\n";
+            return 1;
+        }
+        auto text = file.Text().substr(0, std::min(file.Size(), options.ParseMb << 20));
+        auto cut = text.rfind('\n');
+        text = text.substr(0, cut == std::string_view::npos ? text.size() : cut + 1);
+        auto start = Clock::now();
+        auto store = ParseDocument(text, options.Threads);
+        auto parseSeconds = Seconds(start);
+        std::printf("%.1f MB, %zu rows, parsed in %.1f ms\n", static_cast<double>(text.size()) / (1 << 20),
+            store.Size(), parseSeconds * 1000.0);
+
+        constexpr size_t c_top = 5;
+        auto ok = true;
+        auto compare = [&](char const* name, std::vector<uint32_t> const& rows, KeywordSketch const& sketch)
+        {
+            auto begin = Clock::now();
+            std::unordered_map<std::string, uint64_t> counts;
+            for (auto row : rows)
+            {
+                CountKeywordsExactly(store.Message(row), counts);
+            }
+            auto exactSeconds = Seconds(begin);
+            size_t exactBytes = counts.bucket_count() * sizeof(void*);
+            for (auto const& [word, count] : counts)
+            {
+                // Node: next pointer, key, value and the cached hash.
+                exactBytes += sizeof(void*) + sizeof(word) + sizeof(count) + sizeof(size_t) + HeapBytes(word);
+            }
+            std::vector<std::pair<std::string, uint64_t>> exact(counts.begin(), counts.end());
+            auto top = std::min(c_top, exact.size());
+            std::partial_sort(exact.begin(), exact.begin() + top, exact.end(), [](auto const& left, auto const& right)
+            {
+                return left.second != right.second ? left.second > right.second : left.first < right.first;
+            });
+            exact.resize(top);
+
+            // Counts may come out high, never low.
+            auto estimated = sketch.Top(c_top);
+            size_t agreed = 0;
+            double worstError = 0;
+            for (auto const& [word, count] : estimated)
+            {
+                auto exactCount = counts[word];
+                ok = ok && count >= exactCount;
+                worstError = std::max(worstError, static_cast<double>(count - exactCount) / static_cast<double>(count));
+                agreed += std::any_of(exact.begin(), exact.end(), [&](auto const& pair)
+                {
+                    return pair.first == word;
+                }) ? 1 : 0;
+            }
+            std::printf("%-16s %8zu rows, %8zu words: hash map %8.1f ms %8.1f MB; sketch %5.1f MB %s, top %zu "
+                "agree %zu/%zu, worst overcount %.2f%%\n", name, rows.size(), counts.size(), exactSeconds * 1000.0,
+                static_cast<double>(exactBytes) / (1 << 20), static_cast<double>(sketch.MemoryUsage()) / (1 << 20),
+                sketch.Exact() ? "exact" : "estimated", c_top, agreed, exact.size(), worstError * 100.0);
+        };
+
+        // What parsing now spends on the sketch, on one thread.
+        start = Clock::now();
+        KeywordSketch sequential;
+        for (size_t row = 0; row < store.Size(); ++row)
+        {
+            sequential.Add(store.Message(row));
+        }
+        auto sketchSeconds = Seconds(start);
+        std::printf("%-34s %10.1f ms (%.1f ns per row, %.1f%% of the parse)\n", "sketch every message, one thread",
+            sketchSeconds * 1000.0, sketchSeconds * 1e9 / static_cast<double>(std::max<size_t>(1, store.Size())),
+            100.0 * sketchSeconds / parseSeconds);
+
+        std::vector<uint32_t> all(store.Size());
+        std::iota(all.begin(), all.end(), 0u);
+        compare("whole file", all, store.Keywords());
+        compare("one thread", all, sequential);
+
+        std::vector<std::pair<std::string, FilterQuery>> queries;
+        auto addQuery = [&](std::string name, std::string term, std::string level)
+        {
+            FilterQuery query;
+            query.SearchTerm = std::move(term);
+            query.Level = std::move(level);
+            queries.emplace_back(std::move(name), std::move(query));
+        };
+        addQuery("level ERROR", "", "ERROR");
+        addQuery("search \"timeout\"", "timeout", "");
+        for (auto const& [name, query] : queries)
+        {
+            auto rows = ApplyFilter(store, query, options.Threads);
+            start = Clock::now();
+            auto sketch = KeywordSketch::Of(store, rows, options.Threads);
+            std::printf("%-16s sketched in %.1f ms\n", name.c_str(), Seconds(start) * 1000.0);
+            compare(name.c_str(), rows, sketch);
+        }
+
+        std::printf("sketch counts %s\n", ok ? "never fall below the exact ones" : "FALL BELOW the exact ones");
+        return ok ? 0 : 1;
+    }
+
+    int RunTemplateBenchmark(BenchOptions const& options)
+    {
+        std::string text;
+        std::vector<uint16_t> truth;
+        AppendTemplateCorpus(text, options.ParseMb << 20, truth);
+        std::printf("%.1f MB, %zu lines of %zu templates\n", static_cast<double>(text.size()) / (1 << 20), truth.size(),
+            TemplateCorpusSize());
+
+        auto maxThreads = ResolveThreadCount(options.Threads);
+        std::vector<unsigned> threadCounts;
+        for (unsigned threads = 1; threads < maxThreads; threads *= 2)
+        {
+            threadCounts.push_back(threads);
+        }
+        threadCounts.push_back(maxThreads);
+
+        LogStore store;
+        for (auto threads : threadCounts)
+        {
+            auto start = Clock::now();
+            store = ParseLines(text, threads);
+            auto seconds = Seconds(start);
+            std::printf("parse and mine, %2u threads %12.1f ms %8.2f Mrows/s\n", threads, seconds * 1000.0,
+                static_cast<double>(store.Size()) / seconds / 1e6);
+        }
+        if (store.Size() != truth.size())
+        {
+            std::printf("parsed %zu rows, expected %zu\n", store.Size(), truth.size());
+            return 1;
+        }
+
+        // Mining alone, on one thread and split the way ParseLines splits it.
+        auto start = Clock::now();
+        TemplateMiner sequential;
+        for (size_t row = 0; row < store.Size(); ++row)
+        {
+            sequential.Add(store.Message(row));
+        }
+        auto seconds = Seconds(start);
+        std::printf("mine only, one thread %20.1f ms %8.2f Mrows/s (%.0f ns per row)\n", seconds * 1000.0,
+            static_cast<double>(store.Size()) / seconds / 1e6,
+            seconds * 1e9 / static_cast<double>(std::max<size_t>(1, store.Size())));
+        for (auto threads : threadCounts)
+        {
+            if (threads == 1)
+            {
+                continue;
+            }
+            start = Clock::now();
+            auto chunkCount = static_cast<size_t>(threads) * 4;
+            auto perChunk = (store.Size() + chunkCount - 1) / chunkCount;
+            std::vector<TemplateMiner> partials(chunkCount);
+            ParallelFor(chunkCount, threads, [&](size_t chunk)
+            {
+                auto end = std::min(store.Size(), (chunk + 1) * perChunk);
+                for (auto row = std::min(store.Size(), chunk * perChunk); row < end; ++row)
+                {
+                    partials[chunk].Add(store.Message(row));
+                }
+            });
+            auto mineSeconds = Seconds(start);
+            auto merged = std::move(partials.front());
+            for (size_t chunk = 1; chunk < chunkCount; ++chunk)
+            {
+                merged.Merge(partials[chunk]);
+            }
+            seconds = Seconds(start);
+            std::printf("mine only, %2u threads %19.1f ms %8.2f Mrows/s (merging %.2f ms)\n", threads, seconds * 1000.0,
+                static_cast<double>(store.Size()) / seconds / 1e6, (seconds - mineSeconds) * 1000.0);
+        }
+
+        // Grouping accuracy as in the Drain paper: a row counts when the rows
+        // of its mined template are exactly the rows of its known one.
+        auto const& miner = store.Templates();
+        std::vector<size_t> minedRows(miner.Size());
+        std::vector<size_t> knownRows(TemplateCorpusSize());
+        std::vector<std::unordered_map<uint16_t, size_t>> overlap(miner.Size());
+        for (size_t row = 0; row < store.Size(); ++row)
+        {
+            auto id = store.TemplateId(row);
+            ++minedRows[id];
+            ++knownRows[truth[row]];
+            ++overlap[id][truth[row]];
+        }
+        size_t accurateRows = 0;
+        for (size_t id = 0; id < miner.Size(); ++id)
+        {
+            if (overlap[id].size() == 1)
+            {
+                auto known = overlap[id].begin()->first;
+                accurateRows += knownRows[known] == minedRows[id] ? minedRows[id] : 0;
+            }
+        }
+        std::printf("%zu templates mined, %zu known; grouping accuracy %.4f; %.1f KB\n", miner.Size(),
+            TemplateCorpusSize(), static_cast<double>(accurateRows) / static_cast<double>(store.Size()),
+            static_cast<double>(miner.MemoryUsage()) / 1024.0);
+
+        start = Clock::now();
+        auto groups = GroupByTemplate(store, options.Threads);
+        std::printf("group by template %24.1f ms, %zu groups\n", Seconds(start) * 1000.0, groups.size());
+        for (size_t index = 0; index < std::min<size_t>(groups.size(), 5); ++index)
+        {
+            std::printf("  %9zu  %s\n", groups[index].Rows, miner.Text(groups[index].Template).c_str());
+        }
+
+        // Template plus parameters must rebuild every message, up to spacing.
+        auto split = [](std::string_view line)
+        {
+            std::vector<std::string_view> tokens;
+            for (size_t position = 0; position < line.size();)
+            {
+                auto begin = line.find_first_not_of(" \t", position);
+                if (begin == std::string_view::npos)
+                {
+                    break;
+                }
+                auto end = std::min(line.size(), line.find_first_of(" \t", begin));
+                tokens.push_back(line.substr(begin, end - begin));
+                position = end;
+            }
+            return tokens;
+        };
+        std::vector<std::string> texts(miner.Size());
+        for (size_t id = 0; id < miner.Size(); ++id)
+        {
+            texts[id] = miner.Text(static_cast<uint32_t>(id));
+        }
+        size_t mismatches = 0;
+        for (size_t row = 0; row < store.Size(); ++row)
+        {
+            auto message = split(store.Message(row));
+            auto pattern = split(texts[store.TemplateId(row)]);
+            auto parameters = store.Parameters(row);
+            auto matches = message.size() == pattern.size();
+            size_t next = 0;
+            for (size_t position = 0; matches && position < pattern.size(); ++position)
+            {
+                auto token = pattern[position];
+                if (token.size() >= TemplateMiner::c_wildcard.size() &&
+                    token.substr(token.size() - TemplateMiner::c_wildcard.size()) == TemplateMiner::c_wildcard)
+                {
+                    matches = next < parameters.size() &&
+                        message[position] == std::string(token.substr(0, token.size() - TemplateMiner::c_wildcard.size())) +
+                        std::string(parameters[next]);
+                    ++next;
+                }
+                else
+                {
+                    matches = message[position] == token;
+                }
+            }
+            mismatches += matches && next == parameters.size() ? 0 : 1;
+        }
+        std::printf("template and parameters %s every message (%zu mismatches)\n",
+            mismatches == 0 ? "rebuild" : "DO NOT REBUILD", mismatches);
+        return mismatches == 0 ? 0 : 1;
+    }
+
+    int RunInterpretBenchmark(BenchOptions const& options)
+    {
+        std::string generated;
+        MappedFile file;
+        std::string_view text;
+        if (options.Path.empty())
+        {
+            std::vector<uint16_t> templates;
+            AppendTemplateCorpus(generated, options.ParseMb << 20, templates);
+            text = generated;
+        }
+        else
+        {
+            std::string error;
+            if (!file.Open(options.Path, error))
+            {
+                std::cerr << "cannot map " << options.Path << ": " << error << "\n";
+                return 1;
+            }
+            text = file.Text().substr(0, std::min(file.Size(), options.ParseMb << 20));
+            auto cut = text.rfind('\n');
+            text = text.substr(0, cut == std::string_view::npos ? text.size() : cut + 1);
+        }
+        auto start = Clock::now();
+        auto store = ParseDocument(text, options.Threads);
+        std::printf("%.1f MB, %zu rows, %zu templates, parsed in %.1f ms\n", static_cast<double>(text.size()) / (1 << 20),
+            store.Size(), store.Templates().Size(), Seconds(start) * 1000.0);
+
+        auto ok = true;
+        // Every context must fit and name each template and quote each line
+        // at most once.
+        auto check = [&](PackedContext const& context, size_t budget)
+        {
+            std::unordered_map<std::string, size_t> lines;
+            std::istringstream stream(context.Text);
+            for (std::string line; std::getline(stream, line);)
+            {
+                constexpr std::string_view c_quotes[] = { "  首次：", "  首条：" };
+                if (line.rfind("- [", 0) == 0 && line.find("] ") != std::string::npos)
+                {
+                    ++lines["template " + line.substr(line.find("] ") + 2)];
+                }
+                for (auto quote : c_quotes)
+                {
+                    if (line.rfind(quote, 0) == 0)
+                    {
+                        ++lines["line " + line.substr(quote.size())];
+                    }
+                }
+            }
+            auto repeated = std::count_if(lines.begin(), lines.end(), [](auto const& pair)
+            {
+                return pair.second > 1;
+            });
+            auto fits = context.Tokens <= budget && EstimateTokens(context.Text) <= context.Tokens;
+            ok = ok && fits && repeated == 0;
+            return fits && repeated == 0;
+        };
+        auto report = [&](char const* name, size_t rows, size_t budget, PackedContext const& context, double seconds)
+        {
+            auto valid = check(context, budget);
+            std::printf("%-18s %9zu rows, budget %6zu: %7.2f ms, %6zu tokens, %4zu/%zu templates, %zu bursts, %3zu lines%s\n",
+                name, rows, budget, seconds * 1000.0, context.Tokens, context.Templates, context.TemplateCount,
+                context.Bursts, context.Examples, valid ? "" : "  OVER BUDGET OR REPEATED");
+        };
+
+        constexpr size_t c_budgets[] = { 1000, 3000, 12000 };
+        PackedContext sample;
+        for (auto budget : c_budgets)
+        {
+            // Best of three; the first run also faults the columns in.
+            double best = 1e9;
+            PackedContext context;
+            for (int run = 0; run < 3; ++run)
+            {
+                start = Clock::now();
+                context = PackContext(store, budget, options.Threads);
+                best = std::min(best, Seconds(start));
+            }
+            report("whole input", store.Size(), budget, context, best);
+            if (budget == 3000)
+            {
+                sample = context;
+            }
+        }
+
+        std::vector<std::pair<std::string, FilterQuery>> queries;
+        auto addQuery = [&](std::string name, std::string term, std::string level)
+        {
+            FilterQuery query;
+            query.SearchTerm = std::move(term);
+            query.Level = std::move(level);
+            queries.emplace_back(std::move(name), std::move(query));
+        };
+        addQuery("level ERROR", "", "ERROR");
+        addQuery("search \"block\"", "block", "");
+        for (auto const& [name, query] : queries)
+        {
+            auto rows = ApplyFilter(store, query, options.Threads);
+            auto aggregates = RowAggregates::Of(store, rows, options.Threads);
+            start = Clock::now();
+            auto context = PackContext(store, aggregates, rows, 3000, options.Threads);
+            report(name.c_str(), rows.size(), 3000, context, Seconds(start));
+        }
+
+        std::printf("--- context packed for 3000 tokens ---\n%s---\n", sample.Text.c_str());
+
+        StandInLlmServer server;
+        std::string error;
+        if (!server.Start(0, error))
+        {
+            std::printf("stand-in server not started: %s\n", error.c_str());
+            return 1;
+        }
+        LlmSettings settings;
+        settings.Url = server.Url();
+        auto body = BuildChatRequest(settings, {
+            { "system", std::string(InterpretInstructions()) },
+            { "user", sample.Text },
+        });
+        for (auto delay : { 0, 40 })
+        {
+            server.FirstTokenDelay = std::chrono::milliseconds(delay);
+            std::string reply;
+            std::optional<double> firstToken;
+            size_t pieces = 0;
+            start = Clock::now();
+            auto streamed = StreamChatCompletion(settings, body, [&](std::string_view piece)
+            {
+                if (!firstToken)
+                {
+                    firstToken = Seconds(start);
+                }
+                reply.append(piece);
+                ++pieces;
+                return true;
+            }, error);
+            auto total = Seconds(start);
+            auto intact = streamed && reply == StandInLlmServer::Reply() && server.LastBody() == body;
+            ok = ok && intact;
+            std::printf("stand-in, %2d ms to think: first token after %6.2f ms, %zu pieces in %.1f ms, reply %s%s\n",
+                delay, firstToken.value_or(0.0) * 1000.0, pieces, total * 1000.0, intact ? "intact" : "DAMAGED",
+                streamed ? "" : (" (" + error + ")").c_str());
+        }
+
+        // A cancel while the server is still thinking ends the request
+        // within a poll period, quietly.
+        server.FirstTokenDelay = std::chrono::seconds(1);
+        GenerationCounter generations;
+        auto generation = generations.Advance();
+        std::thread canceller([&]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            generations.Advance();
+        });
+        error.clear();
+        start = Clock::now();
+        auto quiet = StreamChatCompletion(settings, body, [](std::string_view)
+        {
+            return true;
+        }, error, generations.Token(generation));
+        auto afterCancel = Seconds(start) - 0.1;
+        canceller.join();
+        auto prompt = quiet && error.empty() && afterCancel < 0.4;
+        ok = ok && prompt;
+        std::printf("cancelled while the stand-in thinks: returned %.1f ms after the cancel%s\n", afterCancel * 1000.0,
+            prompt ? "" : "  TOO LATE OR WITH AN ERROR");
+        server.Stop();
+
+        // Nothing listens there now.
+        error.clear();
+        auto refused = !StreamChatCompletion(settings, body, [](std::string_view)
+        {
+            return true;
+        }, error);
+        ok = ok && refused;
+        std::printf("closed endpoint %s: %s\n", refused ? "reported" : "NOT REPORTED", error.c_str());
+        return ok ? 0 : 1;
+    }
+}
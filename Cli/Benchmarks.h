@@ -0,0 +1,123 @@
+#pragma once
+
+#include "SyntheticLog.h"
+
+#include "Engine/Filter.h"
+
+#include <cstddef>
+#include <string>
+
+namespace LogMinds::Cli
+{
+    struct BenchOptions
+    {
+        // Empty means "generate a synthetic file of SizeMb".
+        std::string Path;
+        size_t SizeMb{ 1024 };
+        size_t ParseMb{ 64 };
+        unsigned Threads{ 0 };
+        size_t KeystrokeMs{ 60 };
+        size_t FollowRate{ 50000 };
+        size_t FollowSeconds{ 5 };
+        size_t MergeFiles{ 8 };
+        SyntheticLayout Layout{ SyntheticLayout::Mixed };
+    };
+
+    int RunLoadBenchmark(BenchOptions const& options);
+
+    // Lines per second of ParseLine against the std::regex reference, per
+    // synthetic layout, over ParseMb of generated text.
+    int RunParseBenchmark(BenchOptions const& options);
+
+    // Load time and bytes per entry of a vector<LogRecord> against LogStore
+    // for the first ParseMb of the input.
+    int RunStoreBenchmark(BenchOptions const& options);
+
+    // Types term one character at a time and times a full ApplyFilter
+    // against IncrementalFilter for every prefix.
+    int RunSearchBenchmark(BenchOptions const& options, std::string const& term);
+
+    // Trigram index build time and memory, and search latency through the
+    // index against a full scan for a few terms (plus --search, if given).
+    int RunIndexBenchmark(BenchOptions const& options, std::string const& term);
+
+    // Case-insensitive search over every record: ToLower + find against
+    // CaseInsensitiveMatcher on the raw lines, and the old four-field filter
+    // against ApplyFilter, for a few terms (plus --search, if given).
+    int RunMatchBenchmark(BenchOptions const& options, std::string const& term);
+
+    // Types term into a FilterWorker one key every KeystrokeMs and reports
+    // the keystroke-to-result latency of every delivered result, next to the
+    // time a synchronous filter would have blocked the caller.
+    int RunTypingBenchmark(BenchOptions const& options, std::string const& term);
+
+    // Full filter scans with 1, 2, 4, ... up to --threads workers for a few
+    // queries (plus the filter options, if given); every selection is checked
+    // against the single-threaded one.
+    int RunFilterScalingBenchmark(BenchOptions const& options, LogMinds::Engine::FilterQuery const& extra);
+
+    // Level bitmap and time index build time and memory, and level / time
+    // window selections through them against a full scan.
+    int RunAttributeIndexBenchmark(BenchOptions const& options, LogMinds::Engine::FilterQuery const& extra);
+
+    // ParseTimestamp / ParseSyslogTimestamp against the std::get_time
+    // decoders of the regex reference, over the stamps of ParseMb of
+    // generated ISO, JSON and syslog lines; the two must agree.
+    int RunTimestampBenchmark(BenchOptions const& options);
+
+    // Appends FollowRate lines per second to a temporary file that starts
+    // at 64 MB, for FollowSeconds while a LogFollower tails it, filtering
+    // each batch of new rows with query; then rotates the file and checks
+    // that the follower starts over, and that a growing JSON array that
+    // replaces it is not followed line by line.
+    int RunFollowBenchmark(BenchOptions const& options, LogMinds::Engine::FilterQuery const& query);
+
+    // Splits ParseMb of generated lines into MergeFiles time-ordered files
+    // and loads the folder through ParseLogFiles, against parsing the files,
+    // concatenating them and sorting the rows; the two timelines must match.
+    int RunMergeBenchmark(BenchOptions const& options);
+
+    // Compresses ParseMb of the input with gzip and zstd and loads it
+    // straight from the compressed file (decompression overlapping the
+    // parse) against decompressing to disk first; the rows must match an
+    // uncompressed load.
+    int RunDecompressBenchmark(BenchOptions const& options);
+
+    // Cold open (parse plus indexes) of ParseMb of the input against
+    // reopening it through a LogCache entry, then reopening after lines
+    // were appended and after an in-place edit.
+    int RunCacheBenchmark(BenchOptions const& options);
+
+    // Loads ParseMb of the input through a LogLoader and reports the time to
+    // the first row and to the last against a blocking ParseDocument, then
+    // cancels a second load once its first rows arrive; the rows must match.
+    int RunProgressiveBenchmark(BenchOptions const& options);
+
+    // Counting levels, sources, the time range and error rows over every
+    // row against the aggregates the store kept while parsing, and the
+    // aggregates of a few filter selections; all must match a recount.
+    int RunSummaryBenchmark(BenchOptions const& options);
+
+    // Counting keywords with KeywordSketch against the exact hash map the
+    // summary used before: time, memory and top-5 agreement over the whole
+    // input and a few filter selections. The sketch's counts must never be
+    // below the exact ones.
+    int RunKeywordBenchmark(BenchOptions const& options);
+
+    // Parses ParseMb of a generated corpus with known templates (the event
+    // templates of public HDFS, OpenSSH, BGL and Spark logs) at 1, 2, 4, ...
+    // up to --threads workers, mining included, against mining the messages
+    // alone; then the grouping accuracy of the mined templates against the
+    // known ones and GroupByTemplate time. Every row's template and
+    // parameters must give back its message.
+    int RunTemplateBenchmark(BenchOptions const& options);
+
+    // Packs the whole input (ParseMb of it, or of a generated corpus with an
+    // error burst when no file is given) and a few filter selections into
+    // several token budgets, checking that every context fits its budget
+    // and repeats no template or line; then streams one through the
+    // stand-in server and reports the time to the first token. The reply
+    // must arrive intact, and a cancel while the server thinks must end the
+    // request within a poll period.
+    int RunInterpretBenchmark(BenchOptions const& options);
+}
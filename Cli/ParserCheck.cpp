@@ -0,0 +1,233 @@
+#include "ParserCheck.h"
+
+#include "SyntheticLog.h"
+
+#include "Engine/LineParser.h"
+#include "Engine/LineSplitter.h"
+#include "Engine/LogDocument.h"
+#include "Engine/MappedFile.h"
+#include "Engine/RegexLineParser.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <iterator>
+#include <optional>
+
+using namespace LogMinds::Engine;
+
+namespace LogMinds::Cli
+{
+    namespace
+    {
+        // Fragments that sit on the decision points of the four layouts:
+        // separators, brackets, level prefixes, offsets and stray CRs.
+        constexpr char const* c_fragments[] = {
+            "2024-03-01", "2024-3-1", " ", "  ", "\t", "T", "t", "12:34:56", "1:2:3", ".123", ",5", ".", "Z", "z",
+            "+08:00", "-05:30", "+0800", "-", ":", "|", "[", "]", "[]", "[src]", "api.gateway", "INFO", "info",
+            "Information", "WARN", "WARNING", "warning", "ERR", "ERROR", "error", "FATAL", "CRITICAL", "NOTICE",
+            "notice", "TRACE", "debug", "Mar", "Dec", "Jan", " 5", " 16", "31", "15", "web01", "sshd[812]:", "proc", ": ", "\r", "message",
+            "a=b", "{", "}", "\"", "é", "日志", "0", "99",
+        };
+
+        // Keys and values for fuzzed JSON objects: every reserved key in a
+        // few spellings, escapes, nesting, numbers and literals. Separators
+        // are occasionally corrupted so malformed lines are covered too.
+        constexpr char const* c_jsonKeys[] = {
+            "timestamp", "time", "@timestamp", "datetime", "date", "eventTime", "eventtime", "EventTime", "level",
+            "Level", "severity", "logLevel", "loglevel", "lvl", "priority", "logger", "source", "module",
+            "service", "category", "name", "NAME", "message", "msg", "event", "description", "detail", "user",
+            "id", "lev\\u0065l", "m\\u0073g", "pr\xC4\xB0ority", "", "k\\\"q",
+        };
+
+        constexpr char const* c_jsonValues[] = {
+            "\"2024-03-01T12:34:56Z\"", "\"2024-03-01 12:34:56.123\"", "\"\"", "\"INFO\"", "\"warning\"",
+            "\"error\"", "\"api.gateway\"", "\"hello world\"", "\"line\\nbreak\"", "\"tab\\tq\\\"\"",
+            "\"\\u00e9\\ud83d\\ude00\"", "\"\\ud800\"", "\"\\x\"", "\"日志\"", "0", "-1.5", "1e3", "12.",
+            "1e", "true", "false", "null", "nul", "[]", "[1,\"a\",{\"b\":null}]", "{\"x\":{\"y\":2}}", "{}",
+            "\"unterminated",
+        };
+
+        class Random
+        {
+        public:
+            explicit Random(uint64_t seed) : m_state(seed * 0x9E3779B97F4A7C15ull + 1) {}
+
+            uint32_t Below(uint32_t bound)
+            {
+                m_state ^= m_state << 13;
+                m_state ^= m_state >> 7;
+                m_state ^= m_state << 17;
+                return static_cast<uint32_t>(m_state >> 16) % bound;
+            }
+
+        private:
+            uint64_t m_state;
+        };
+
+        std::string Describe(std::optional<LogRecord> const& record)
+        {
+            if (!record)
+            {
+                return "<none>";
+            }
+            std::string text = "ts=[" + record->Timestamp + "] level=[" + record->Level + "] source=[" +
+                record->Source + "] message=[" + record->Message + "] context=[" + record->Context + "] raw=[" +
+                record->Raw + "] occurred=";
+            text += record->OccurredOn ? std::to_string(*record->OccurredOn) : "-";
+            return text;
+        }
+
+        bool Same(std::optional<LogRecord> const& left, std::optional<LogRecord> const& right)
+        {
+            if (!left || !right)
+            {
+                return !left && !right;
+            }
+            return left->Timestamp == right->Timestamp && left->Level == right->Level &&
+                left->Source == right->Source && left->Message == right->Message &&
+                left->Context == right->Context && left->Raw == right->Raw && left->OccurredOn == right->OccurredOn;
+        }
+
+        class Checker
+        {
+        public:
+            void Check(std::string_view line)
+            {
+                ++m_lines;
+                auto expected = ParseLineWithRegex(line, m_context);
+                auto actual = ParseLine(line, m_context);
+                if (Same(expected, actual))
+                {
+                    return;
+                }
+                if (m_mismatches++ < 20)
+                {
+                    std::cout << "mismatch for line: " << line << "\n  regex:   " << Describe(expected)
+                        << "\n  scanner: " << Describe(actual) << "\n";
+                }
+            }
+
+            void CheckText(std::string_view text)
+            {
+                size_t start = 0;
+                while (start < text.size())
+                {
+                    auto end = text.find('\n', start);
+                    if (end == std::string_view::npos)
+                    {
+                        end = text.size();
+                    }
+                    Check(text.substr(start, end - start));
+                    start = end + 1;
+                }
+            }
+
+            // Homogeneous files read through the sniffed layout must come out
+            // exactly as the cascade reads them.
+            void CheckDispatch(std::string_view text)
+            {
+                ParseReport report;
+                auto records = ParseLines(text, 0, &report, m_context);
+                size_t row = 0;
+                size_t differing = 0;
+                ForEachLine(text, [&](std::string_view line)
+                {
+                    if (auto expected = ParseLine(line, m_context))
+                    {
+                        differing += row < records.Size() && Same(expected, records.Record(row)) ? 0 : 1;
+                        ++row;
+                    }
+                });
+                differing += row == records.Size() ? 0 : 1;
+                std::printf("  %-6s %zu hits, %zu misses, %zu differences\n",
+                    std::string(LineFormatName(report.Format)).c_str(), report.Hits, report.Misses, differing);
+                m_mismatches += differing;
+            }
+
+            size_t Lines() const
+            {
+                return m_lines;
+            }
+
+            size_t Mismatches() const
+            {
+                return m_mismatches;
+            }
+
+        private:
+            // Early in a year, so that syslog stamps of later months are
+            // placed in the year before.
+            ParseContext m_context{ *ParseTimestamp("2024-03-15 12:00:00") };
+            size_t m_lines{ 0 };
+            size_t m_mismatches{ 0 };
+        };
+    }
+
+    int RunParserVerification(std::string const& path, size_t fuzzLines)
+    {
+        Checker checker;
+
+        std::printf("synthetic layouts, read through the detected layout:\n");
+        for (auto layout : { SyntheticLayout::Iso, SyntheticLayout::Syslog, SyntheticLayout::KeyValue,
+            SyntheticLayout::Level, SyntheticLayout::Json, SyntheticLayout::Plain })
+        {
+            std::string text;
+            AppendSyntheticLog(text, 1 << 20, layout, 7);
+            checker.CheckText(text);
+            checker.CheckDispatch(text);
+        }
+        std::printf("synthetic layouts: %zu lines\n", checker.Lines());
+
+        Random random(42);
+        std::string line;
+        for (size_t i = 0; i < fuzzLines; ++i)
+        {
+            line.clear();
+            auto count = 1 + random.Below(12);
+            for (uint32_t j = 0; j < count; ++j)
+            {
+                line += c_fragments[random.Below(static_cast<uint32_t>(std::size(c_fragments)))];
+            }
+            checker.Check(line);
+        }
+        std::printf("random fragments: %zu lines\n", fuzzLines);
+
+        for (size_t i = 0; i < fuzzLines; ++i)
+        {
+            line = random.Below(16) == 0 ? " { " : "{";
+            auto count = random.Below(7);
+            for (uint32_t j = 0; j < count; ++j)
+            {
+                if (j > 0)
+                {
+                    line += random.Below(64) == 0 ? " " : (random.Below(4) == 0 ? " , " : ",");
+                }
+                line += "\"";
+                line += c_jsonKeys[random.Below(static_cast<uint32_t>(std::size(c_jsonKeys)))];
+                line += random.Below(64) == 0 ? "\" " : (random.Below(4) == 0 ? "\" : " : "\":");
+                line += c_jsonValues[random.Below(static_cast<uint32_t>(std::size(c_jsonValues)))];
+            }
+            line += random.Below(64) == 0 ? "} x" : "}";
+            checker.Check(line);
+        }
+        std::printf("random JSON objects: %zu lines\n", fuzzLines);
+
+        if (!path.empty())
+        {
+            MappedFile file;
+            std::string error;
+            if (!file.Open(path, error))
+            {
+                std::cerr << "cannot read " << path << ": " << error << "\n";
+                return 1;
+            }
+            auto before = checker.Lines();
+            checker.CheckText(file.Text());
+            std::printf("%s: %zu lines\n", path.c_str(), checker.Lines() - before);
+        }
+
+        std::printf("%zu of %zu lines differ\n", checker.Mismatches(), checker.Lines());
+        return checker.Mismatches() == 0 ? 0 : 1;
+    }
+}
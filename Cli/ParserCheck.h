@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+
+namespace LogMinds::Cli
+{
+    // Runs ParseLine and the std::regex reference over synthetic, randomly
+    // assembled and (optionally) user-supplied lines and reports every line
+    // where the two disagree. Returns a process exit code.
+    int RunParserVerification(std::string const& path, size_t fuzzLines);
+}
@@ -0,0 +1,154 @@
+#include "SearchCheck.h"
+
+#include "SyntheticLog.h"
+
+#include "Engine/Filter.h"
+#include "Engine/LogDocument.h"
+#include "Engine/MappedFile.h"
+#include "Engine/Text.h"
+#include "Engine/TextSearch.h"
+
+#include <clocale>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+using namespace LogMinds::Engine;
+
+namespace LogMinds::Cli
+{
+    namespace
+    {
+        // Letters in both cases, the code points whose lower case is ASCII
+        // (Kelvin sign, dotted capital I) or longer than they are (A with
+        // stroke), other cased and uncased non-ASCII text, and bytes that are
+        // not valid UTF-8 (a lone lead byte, overlong 'A's).
+        constexpr char const* c_pieces[] = {
+            "a", "A", "t", "T", "i", "I", "k", "K", "o", "O", "e", "E", "z", "Z", "@", "[", "`", "{", " ", "-",
+            "time", "TIME", "Out", "ouT", "timeout", "TIMEOUT", "\xE2\x84\xAA", "\xC4\xB0", "\xC3\x89", "\xC3\xA9",
+            "\xC3\x9F", "\xCE\xA3", "\xCF\x83", "\xE6\x97\xA5\xE5\xBF\x97", "\xC8\xBA", "\xE2\xB1\xA5", "\xC3", "\xC1\x81", "\xE0\x81\x81", "\xFF", "\r",
+        };
+
+        class Random
+        {
+        public:
+            explicit Random(uint64_t seed) : m_state(seed * 0x9E3779B97F4A7C15ull + 1) {}
+
+            uint32_t Below(uint32_t bound)
+            {
+                m_state ^= m_state << 13;
+                m_state ^= m_state >> 7;
+                m_state ^= m_state << 17;
+                return static_cast<uint32_t>(m_state >> 16) % bound;
+            }
+
+        private:
+            uint64_t m_state;
+        };
+
+        std::string RandomText(Random& random, uint32_t maxPieces)
+        {
+            std::string text;
+            auto count = random.Below(maxPieces + 1);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                text += c_pieces[random.Below(static_cast<uint32_t>(std::size(c_pieces)))];
+            }
+            return text;
+        }
+
+        bool ReferenceMatches(LogStore const& store, size_t row, FilterQuery const& query)
+        {
+            if (!query.Level.empty() && store.Level(row) != query.Level)
+            {
+                return false;
+            }
+            return ToLower(store.Message(row)).find(query.SearchTerm) != std::string::npos ||
+                ToLower(store.Context(row)).find(query.SearchTerm) != std::string::npos ||
+                ToLower(store.Source(row)).find(query.SearchTerm) != std::string::npos ||
+                ToLower(store.Raw(row)).find(query.SearchTerm) != std::string::npos;
+        }
+
+        // Number of rows where the filter and the reference disagree.
+        size_t CheckStore(LogStore const& store)
+        {
+            size_t differing = 0;
+            for (auto term : { "timeout", "TimeOut", "err", "order:4242", "shard=3", "\xC3\xA9", "x", "no such text" })
+            {
+                FilterQuery query;
+                query.SearchTerm = ToLower(term);
+                auto selection = ApplyFilter(store, query);
+                std::vector<uint32_t> expected;
+                for (size_t row = 0; row < store.Size(); ++row)
+                {
+                    if (ReferenceMatches(store, row, query))
+                    {
+                        expected.push_back(static_cast<uint32_t>(row));
+                    }
+                }
+                if (selection != expected)
+                {
+                    std::printf("  \"%s\": %zu rows selected, %zu expected\n", term, selection.size(), expected.size());
+                    ++differing;
+                }
+            }
+            return differing;
+        }
+    }
+
+    int RunSearchVerification(std::string const& path, size_t fuzzStrings)
+    {
+        // Under the "C" locale towlower maps no non-ASCII code point at all;
+        // a UTF-8 locale brings in the Kelvin sign and friends.
+        if (!std::setlocale(LC_CTYPE, "C.UTF-8"))
+        {
+            std::setlocale(LC_CTYPE, "");
+        }
+        std::printf("lower case of the Kelvin sign: %s\n", ToLower("\xE2\x84\xAA").c_str());
+
+        Random random(42);
+        size_t mismatches = 0;
+        for (size_t i = 0; i < fuzzStrings; ++i)
+        {
+            // Short and long texts, so both the vector loops and their scalar
+            // tails see hits and near misses.
+            auto text = RandomText(random, i % 4 == 0 ? 120 : 12);
+            auto term = ToLower(RandomText(random, 3));
+            auto expected = ToLower(text).find(term) != std::string::npos;
+            if (CaseInsensitiveMatcher(term).FoundIn(text) != expected && mismatches++ < 20)
+            {
+                std::cout << "mismatch: term [" << term << "] text [" << text << "] expected " << expected << "\n";
+            }
+        }
+        std::printf("random strings: %zu pairs, %zu differ\n", fuzzStrings, mismatches);
+
+        size_t differing = 0;
+        for (auto layout : { SyntheticLayout::Mixed, SyntheticLayout::Json })
+        {
+            std::string text;
+            AppendSyntheticLog(text, 4 << 20, layout, 7);
+            auto store = ParseDocument(text);
+            differing += CheckStore(store);
+            std::printf("synthetic %s: %zu rows\n", layout == SyntheticLayout::Json ? "json" : "mixed", store.Size());
+        }
+
+        if (!path.empty())
+        {
+            MappedFile file;
+            std::string error;
+            if (!file.Open(path, error))
+            {
+                std::cerr << "cannot read " << path << ": " << error << "\n";
+                return 1;
+            }
+            auto store = ParseDocument(file.Text());
+            differing += CheckStore(store);
+            std::printf("%s: %zu rows\n", path.c_str(), store.Size());
+        }
+
+        std::printf("%zu string mismatches, %zu differing selections\n", mismatches, differing);
+        return mismatches == 0 && differing == 0 ? 0 : 1;
+    }
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+
+namespace LogMinds::Cli
+{
+    // Checks CaseInsensitiveMatcher against ToLower(text).find(term) over
+    // random mixed-case ASCII, non-ASCII and malformed UTF-8 strings, and the
+    // filter against the same reference over synthetic and (optionally)
+    // user-supplied logs. Returns a process exit code.
+    int RunSearchVerification(std::string const& path, size_t fuzzStrings);
+}
@@ -0,0 +1,274 @@
+#include "StandInLlm.h"
+
+#include "Engine/Json.h"
+#include "Engine/Text.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace LogMinds::Engine;
+
+namespace LogMinds::Cli
+{
+    namespace
+    {
+#if defined(_WIN32)
+        using SocketHandle = SOCKET;
+#else
+        using SocketHandle = int;
+#endif
+#if defined(MSG_NOSIGNAL)
+        constexpr int c_sendFlags = MSG_NOSIGNAL;
+#else
+        constexpr int c_sendFlags = 0;
+#endif
+        constexpr intptr_t c_noSocket = -1;
+        // Requests larger than this are refused.
+        constexpr size_t c_maxRequestBytes = 64 << 20;
+
+        // Quotes, a backslash and line breaks, so escapes are exercised too.
+        constexpr std::string_view c_reply =
+            "整体状况：日志以 INFO 为主，服务总体可用。\n"
+            "值得关注：\"timeout waiting for lock\" 在错误集中的时段反复出现，可能是数据库锁竞争；"
+            "罕见模板中的 \"failed to deliver message\" 需要确认是否有消息丢失。\n"
+            "建议：检查 orders 表上的长事务，对照 C:\\logs\\db 下的慢查询记录，并为投递失败设置告警。";
+
+        SocketHandle Handle(intptr_t socket)
+        {
+            return static_cast<SocketHandle>(socket);
+        }
+
+        void CloseSocket(intptr_t socket)
+        {
+#if defined(_WIN32)
+            closesocket(Handle(socket));
+#else
+            close(Handle(socket));
+#endif
+        }
+
+        bool SendAll(intptr_t socket, std::string_view bytes)
+        {
+            while (!bytes.empty())
+            {
+                auto sent = send(Handle(socket), bytes.data(), static_cast<int>(bytes.size()), c_sendFlags);
+                if (sent <= 0)
+                {
+                    return false;
+                }
+                bytes.remove_prefix(static_cast<size_t>(sent));
+            }
+            return true;
+        }
+
+        bool SendChunk(intptr_t socket, std::string_view data)
+        {
+            char size[24];
+            std::snprintf(size, sizeof(size), "%zx\r\n", data.size());
+            return SendAll(socket, size) && SendAll(socket, data) && SendAll(socket, "\r\n");
+        }
+
+        void SendError(intptr_t socket, int status, std::string_view message)
+        {
+            std::string body = "{\"error\":{\"message\":";
+            AppendJsonString(body, message);
+            body += "}}";
+            SendAll(socket, "HTTP/1.1 " + std::to_string(status) + " Error\r\nContent-Type: application/json\r\n"
+                "Connection: close\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body);
+        }
+    }
+
+    StandInLlmServer::~StandInLlmServer()
+    {
+        Stop();
+    }
+
+    bool StandInLlmServer::Start(uint16_t port, std::string& error)
+    {
+#if defined(_WIN32)
+        WSADATA data;
+        WSAStartup(MAKEWORD(2, 2), &data);
+#endif
+        auto listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        m_listener = static_cast<intptr_t>(listener);
+        if (m_listener == c_noSocket)
+        {
+            error = "cannot create a socket";
+            return false;
+        }
+        int reuse = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<char const*>(&reuse), sizeof(reuse));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(port);
+        socklen_t length = sizeof(address);
+        if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 8) != 0 ||
+            getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) != 0)
+        {
+            error = "cannot listen on port " + std::to_string(port);
+            CloseSocket(m_listener);
+            m_listener = c_noSocket;
+            return false;
+        }
+        m_port = ntohs(address.sin_port);
+        m_stopping = false;
+        m_thread = std::thread([this]
+        {
+            Serve();
+        });
+        return true;
+    }
+
+    void StandInLlmServer::Stop()
+    {
+        m_stopping = true;
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+        if (m_listener != c_noSocket)
+        {
+            CloseSocket(m_listener);
+            m_listener = c_noSocket;
+        }
+    }
+
+    std::string StandInLlmServer::Url() const
+    {
+        return "http://127.0.0.1:" + std::to_string(m_port) + "/v1/chat/completions";
+    }
+
+    std::string_view StandInLlmServer::Reply()
+    {
+        return c_reply;
+    }
+
+    std::string StandInLlmServer::LastBody() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_lastBody;
+    }
+
+    void StandInLlmServer::Serve()
+    {
+        while (!m_stopping)
+        {
+            // Wakes up now and then to notice Stop.
+            fd_set readable;
+            FD_ZERO(&readable);
+            FD_SET(Handle(m_listener), &readable);
+            timeval timeout{ 0, 100 * 1000 };
+            if (select(static_cast<int>(m_listener + 1), &readable, nullptr, nullptr, &timeout) <= 0)
+            {
+                continue;
+            }
+            auto connection = static_cast<intptr_t>(accept(Handle(m_listener), nullptr, nullptr));
+            if (connection == c_noSocket)
+            {
+                continue;
+            }
+            Answer(connection);
+            CloseSocket(connection);
+        }
+    }
+
+    void StandInLlmServer::Answer(intptr_t connection)
+    {
+        std::string request;
+        size_t headEnd = std::string::npos;
+        size_t contentLength = 0;
+        char buffer[16 * 1024];
+        while (headEnd == std::string::npos || request.size() < headEnd + 4 + contentLength)
+        {
+            auto received = recv(Handle(connection), buffer, sizeof(buffer), 0);
+            if (received <= 0 || request.size() > c_maxRequestBytes)
+            {
+                return;
+            }
+            request.append(buffer, static_cast<size_t>(received));
+            if (headEnd == std::string::npos && (headEnd = request.find("\r\n\r\n")) != std::string::npos)
+            {
+                auto head = ToLower(std::string_view(request).substr(0, headEnd));
+                auto header = head.find("\r\ncontent-length:");
+                if (header != std::string::npos)
+                {
+                    contentLength = std::strtoull(head.c_str() + header + 17, nullptr, 10);
+                }
+            }
+        }
+        auto body = std::string_view(request).substr(headEnd + 4, contentLength);
+
+        JsonValue value;
+        if (request.compare(0, 5, "POST ") != 0 || !JsonValue::TryParse(body, value))
+        {
+            SendError(connection, 400, "expected a POST with a JSON body");
+            return;
+        }
+        auto messages = value.Lookup("messages");
+        auto stream = value.Lookup("stream");
+        if (!messages || messages->ValueType() != JsonValueType::Array || messages->GetArray().empty() || !stream ||
+            !stream->GetBoolean())
+        {
+            SendError(connection, 400, "expected \"messages\" and \"stream\": true");
+            return;
+        }
+        {
+            std::lock_guard lock(m_mutex);
+            m_lastBody = std::string(body);
+        }
+        ++m_requests;
+
+        if (!SendAll(connection, "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\n"
+            "Transfer-Encoding: chunked\r\nConnection: close\r\n\r\n"))
+        {
+            return;
+        }
+        std::this_thread::sleep_for(FirstTokenDelay);
+
+        // One to three characters per event; every third event is split
+        // across two chunks.
+        size_t offset = 0;
+        for (size_t event = 0; offset < c_reply.size() && !m_stopping; ++event)
+        {
+            auto end = offset;
+            for (size_t characters = 0; characters < 1 + event % 3 && end < c_reply.size(); ++characters)
+            {
+                DecodeUtf8(c_reply, end);
+            }
+            std::string data = "data: {\"id\":\"stand-in\",\"object\":\"chat.completion.chunk\",\"choices\":[{\"index\":0,"
+                "\"delta\":{\"content\":";
+            AppendJsonString(data, c_reply.substr(offset, end - offset));
+            data += "},\"finish_reason\":null}]}\n\n";
+            offset = end;
+            auto sent = event % 3 == 2 ? SendChunk(connection, std::string_view(data).substr(0, data.size() / 2)) &&
+                SendChunk(connection, std::string_view(data).substr(data.size() / 2)) : SendChunk(connection, data);
+            if (!sent)
+            {
+                return;
+            }
+            std::this_thread::sleep_for(TokenDelay);
+        }
+        SendChunk(connection, "data: {\"id\":\"stand-in\",\"object\":\"chat.completion.chunk\",\"choices\":[{\"index\":0,"
+            "\"delta\":{},\"finish_reason\":\"stop\"}]}\n\ndata: [DONE]\n\n");
+        SendAll(connection, "0\r\n\r\n");
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace LogMinds::Cli
+{
+    // Stands in for an OpenAI-compatible chat completions server on
+    // 127.0.0.1: every POST with a JSON body asking to stream gets Reply(),
+    // a few characters per server-sent event, after FirstTokenDelay and
+    // then TokenDelay between events. Connections are served one at a time.
+    class StandInLlmServer
+    {
+    public:
+        std::chrono::milliseconds FirstTokenDelay{ 40 };
+        std::chrono::milliseconds TokenDelay{ 2 };
+
+        StandInLlmServer() = default;
+        StandInLlmServer(StandInLlmServer const&) = delete;
+        StandInLlmServer& operator=(StandInLlmServer const&) = delete;
+        ~StandInLlmServer();
+
+        // Port 0 picks a free one.
+        bool Start(uint16_t port, std::string& error);
+        void Stop();
+
+        uint16_t Port() const
+        {
+            return m_port;
+        }
+
+        std::string Url() const;
+
+        static std::string_view Reply();
+
+        size_t Requests() const
+        {
+            return m_requests.load();
+        }
+
+        // The body of the last request answered.
+        std::string LastBody() const;
+
+    private:
+        // A socket handle; SOCKET is pointer-sized on Windows.
+        intptr_t m_listener{ -1 };
+        uint16_t m_port{ 0 };
+        std::thread m_thread;
+        std::atomic<bool> m_stopping{ false };
+        std::atomic<size_t> m_requests{ 0 };
+        mutable std::mutex m_mutex;
+        std::string m_lastBody;
+
+        void Serve();
+        void Answer(intptr_t connection);
+    };
+}
@@ -0,0 +1,314 @@
+#include "SyntheticLog.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+namespace LogMinds::Cli
+{
+    namespace
+    {
+        constexpr char const* c_levels[] = { "TRACE", "DEBUG", "INFO", "INFO", "INFO", "WARN", "ERROR", "FATAL" };
+        constexpr char const* c_sources[] = { "auth", "api.gateway", "db.pool", "scheduler", "cache", "billing", "worker-7", "http" };
+        constexpr char const* c_hosts[] = { "web01", "web02", "db01", "edge-3" };
+        constexpr char const* c_processes[] = { "sshd[812]", "nginx[2231]", "kernel", "cron[77]" };
+        constexpr char const* c_months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+        constexpr char const* c_messages[] = {
+            "request completed status=%u duration_ms=%u",
+            "connection reset by peer %u.%u.%u.%u",
+            "user %u logged in from session %08x",
+            "cache miss for key order:%u shard=%u",
+            "timeout waiting for lock table=orders txn=%u after %ums",
+            "retrying upstream call attempt=%u of %u",
+            "disk usage at %u%% on volume %u",
+            "failed to deliver message id=%08x queue=%u",
+        };
+
+        struct CorpusTemplate
+        {
+            char const* Component;
+            char const* Level;
+            // %n number, %i IPv4 address, %p port, %b block id, %h hex, %u user name.
+            char const* Pattern;
+        };
+
+        constexpr CorpusTemplate c_corpus[] = {
+            { "dfs.DataNode$PacketResponder", "INFO", "PacketResponder %n for block blk_%b terminating" },
+            { "dfs.DataNode$DataXceiver", "INFO", "Receiving block blk_%b src: /%i:%p dest: /%i:50010" },
+            { "dfs.FSNamesystem", "INFO", "BLOCK* NameSystem.addStoredBlock: blockMap updated: %i:50010 is added to blk_%b size %n" },
+            { "dfs.DataNode$PacketResponder", "INFO", "Received block blk_%b of size %n from /%i" },
+            { "spark.executor.Executor", "INFO", "Running task %n.0 in stage %n.0 (TID %n)" },
+            { "spark.executor.Executor", "INFO", "Finished task %n.0 in stage %n.0 (TID %n). %n bytes result sent to driver" },
+            { "sshd", "WARN", "Failed password for invalid user %u from %i port %p ssh2" },
+            { "sshd", "WARN", "Failed password for %u from %i port %p ssh2" },
+            { "spark.storage.BlockManager", "INFO", "Found block rdd_%n_%n locally" },
+            { "dfs.FSNamesystem", "INFO", "BLOCK* NameSystem.allocateBlock: /user/root/rand/_temporary/_task_%h_m_%n_0/part-%n. blk_%b" },
+            { "sshd", "INFO", "Invalid user %u from %i" },
+            { "sshd", "INFO", "Received disconnect from %i: 11: Bye Bye [preauth]" },
+            { "spark.storage.MemoryStore", "INFO", "Block broadcast_%n stored as values in memory (estimated size %n.%n KB, free %n.%n MB)" },
+            { "dfs.FSDataset", "INFO", "Deleting block blk_%b file /mnt/hadoop/dfs/data/current/subdir%n/blk_%b" },
+            { "sshd", "INFO", "Accepted password for %u from %i port %p ssh2" },
+            { "bgl.KERNEL", "INFO", "CE sym %n, at 0x%h, mask 0x%h" },
+            { "bgl.KERNEL", "INFO", "generating core.%n" },
+            { "sshd", "INFO", "pam_unix(sshd:auth): authentication failure; logname= uid=0 euid=0 tty=ssh ruser= rhost=%i user=%u" },
+            { "spark.broadcast.TorrentBroadcast", "INFO", "Started reading broadcast variable %n" },
+            { "bgl.KERNEL", "ERROR", "instruction cache parity error corrected" },
+            { "bgl.KERNEL", "ERROR", "total of %n ddr error(s) detected and corrected" },
+            { "bgl.APP", "FATAL", "ciod: failed to read message prefix on control stream (CioStream socket to %i:%p" },
+            { "dfs.DataNode", "WARN", "%i:50010:Got exception while serving blk_%b to /%i:" },
+            { "bgl.KERNEL", "FATAL", "data TLB error interrupt" },
+        };
+        constexpr char const* c_users[] = { "root", "admin", "oracle", "test", "guest", "ubuntu", "postgres", "git", "ftpuser", "support" };
+
+        class Random
+        {
+        public:
+            explicit Random(uint64_t seed) : m_state(seed * 0x9E3779B97F4A7C15ull + 1) {}
+
+            uint32_t Next()
+            {
+                m_state ^= m_state << 13;
+                m_state ^= m_state >> 7;
+                m_state ^= m_state << 17;
+                return static_cast<uint32_t>(m_state >> 16);
+            }
+
+            uint32_t Below(uint32_t bound)
+            {
+                return Next() % bound;
+            }
+
+        private:
+            uint64_t m_state;
+        };
+
+        template <size_t N>
+        char const* Pick(Random& random, char const* const (&values)[N])
+        {
+            return values[random.Below(static_cast<uint32_t>(N))];
+        }
+
+        void AppendNumber(std::string& output, uint64_t value)
+        {
+            char digits[24];
+            auto length = std::snprintf(digits, sizeof(digits), "%llu", static_cast<unsigned long long>(value));
+            output.append(digits, static_cast<size_t>(length));
+        }
+
+        void AppendCorpusMessage(std::string& output, char const* pattern, Random& random)
+        {
+            for (auto cursor = pattern; *cursor; ++cursor)
+            {
+                if (*cursor != '%' || !cursor[1])
+                {
+                    output.push_back(*cursor);
+                    continue;
+                }
+                switch (*++cursor)
+                {
+                case 'n':
+                    AppendNumber(output, random.Below(random.Below(2) ? 100 : 100000));
+                    break;
+                case 'i':
+                    AppendNumber(output, 10);
+                    output.push_back('.');
+                    AppendNumber(output, 250);
+                    output.push_back('.');
+                    AppendNumber(output, random.Below(32));
+                    output.push_back('.');
+                    AppendNumber(output, random.Below(256));
+                    break;
+                case 'p':
+                    AppendNumber(output, 1024 + random.Below(64000));
+                    break;
+                case 'b':
+                    if (random.Below(2))
+                    {
+                        output.push_back('-');
+                    }
+                    AppendNumber(output, (static_cast<uint64_t>(random.Next()) << 31) ^ random.Next());
+                    break;
+                case 'h':
+                {
+                    char digits[16];
+                    auto length = std::snprintf(digits, sizeof(digits), "%08x", random.Next());
+                    output.append(digits, static_cast<size_t>(length));
+                    break;
+                }
+                case 'u':
+                    output += Pick(random, c_users);
+                    break;
+                default:
+                    output.push_back(*cursor);
+                    break;
+                }
+            }
+        }
+
+        void AppendLine(std::string& output, SyntheticLayout layout, Random& random, uint64_t sequence)
+        {
+            char message[160];
+            std::snprintf(message, sizeof(message), Pick(random, c_messages), random.Below(600), random.Below(5000),
+                random.Below(256), random.Below(256));
+
+            auto seconds = sequence / 20;
+            auto day = 1 + (seconds / 86400) % 28;
+            auto hour = (seconds / 3600) % 24;
+            auto minute = (seconds / 60) % 60;
+            auto second = seconds % 60;
+            auto millis = (sequence * 37) % 1000;
+
+            char line[384];
+            int length = 0;
+            switch (layout)
+            {
+            case SyntheticLayout::Iso:
+                length = std::snprintf(line, sizeof(line), "2024-03-%02u %02u:%02u:%02u.%03u [%s] %s: %s\n",
+                    static_cast<unsigned>(day), static_cast<unsigned>(hour), static_cast<unsigned>(minute),
+                    static_cast<unsigned>(second), static_cast<unsigned>(millis), Pick(random, c_sources),
+                    Pick(random, c_levels), message);
+                break;
+            case SyntheticLayout::Syslog:
+                length = std::snprintf(line, sizeof(line), "%s %2u %02u:%02u:%02u %s %s: %s\n", c_months[2],
+                    static_cast<unsigned>(day), static_cast<unsigned>(hour), static_cast<unsigned>(minute),
+                    static_cast<unsigned>(second), Pick(random, c_hosts), Pick(random, c_processes), message);
+                break;
+            case SyntheticLayout::KeyValue:
+                length = std::snprintf(line, sizeof(line), "[%s] | %s - %s\n", Pick(random, c_sources),
+                    Pick(random, c_levels), message);
+                break;
+            case SyntheticLayout::Level:
+                length = std::snprintf(line, sizeof(line), "[%s] %s\n", Pick(random, c_levels), message);
+                break;
+            case SyntheticLayout::Json:
+                length = std::snprintf(line, sizeof(line),
+                    "{\"timestamp\":\"2024-03-%02uT%02u:%02u:%02u.%03uZ\",\"level\":\"%s\",\"logger\":\"%s\",\"message\":\"%s\",\"requestId\":\"%08x\",\"attempt\":%u}\n",
+                    static_cast<unsigned>(day), static_cast<unsigned>(hour), static_cast<unsigned>(minute),
+                    static_cast<unsigned>(second), static_cast<unsigned>(millis), Pick(random, c_levels),
+                    Pick(random, c_sources), message, random.Next(), random.Below(5));
+                break;
+            case SyntheticLayout::Plain:
+                length = std::snprintf(line, sizeof(line), "%s\n", message);
+                break;
+            case SyntheticLayout::Mixed:
+                AppendLine(output, static_cast<SyntheticLayout>(1 + random.Below(6)), random, sequence);
+                return;
+            }
+
+            if (length > 0)
+            {
+                output.append(line, std::min<size_t>(static_cast<size_t>(length), sizeof(line) - 1));
+            }
+        }
+    }
+
+    bool TryParseLayout(std::string_view name, SyntheticLayout& layout)
+    {
+        struct NamedLayout
+        {
+            std::string_view Name;
+            SyntheticLayout Layout;
+        };
+        static constexpr NamedLayout c_layouts[] = {
+            { "mixed", SyntheticLayout::Mixed },
+            { "iso", SyntheticLayout::Iso },
+            { "syslog", SyntheticLayout::Syslog },
+            { "kv", SyntheticLayout::KeyValue },
+            { "level", SyntheticLayout::Level },
+            { "json", SyntheticLayout::Json },
+            { "plain", SyntheticLayout::Plain },
+        };
+        for (auto const& entry : c_layouts)
+        {
+            if (entry.Name == name)
+            {
+                layout = entry.Layout;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void AppendSyntheticLog(std::string& output, size_t bytes, SyntheticLayout layout, uint64_t seed)
+    {
+        Random random(seed);
+        auto target = output.size() + bytes;
+        output.reserve(target + 512);
+        for (uint64_t sequence = 0; output.size() < target; ++sequence)
+        {
+            AppendLine(output, layout, random, sequence);
+        }
+    }
+
+    void AppendTemplateCorpus(std::string& output, size_t bytes, std::vector<uint16_t>& templates, uint64_t seed)
+    {
+        constexpr auto c_count = static_cast<uint32_t>(std::size(c_corpus));
+        Random random(seed);
+        auto target = output.size() + bytes;
+        output.reserve(target + 512);
+        std::vector<uint32_t> errors;
+        for (uint32_t index = 0; index < c_count; ++index)
+        {
+            if (std::string_view(c_corpus[index].Level) == "ERROR" || std::string_view(c_corpus[index].Level) == "FATAL")
+            {
+                errors.push_back(index);
+            }
+        }
+        // An incident: for half a percent of the text, two thirds in, every
+        // other line is an error.
+        auto incidentBegin = output.size() + bytes / 3 * 2;
+        auto incidentEnd = incidentBegin + bytes / 200;
+        for (uint64_t sequence = 0; output.size() < target; ++sequence)
+        {
+            // The smaller of two draws: the first templates dominate, the
+            // last ones are rare.
+            auto index = std::min(random.Below(c_count), random.Below(c_count));
+            if (output.size() >= incidentBegin && output.size() < incidentEnd && random.Below(2) == 0)
+            {
+                index = errors[random.Below(static_cast<uint32_t>(errors.size()))];
+            }
+            auto const& entry = c_corpus[index];
+            auto seconds = sequence / 20;
+            char prefix[96];
+            auto length = std::snprintf(prefix, sizeof(prefix), "2024-03-%02u %02u:%02u:%02u.%03u [%s] %s: ",
+                static_cast<unsigned>(1 + (seconds / 86400) % 28), static_cast<unsigned>((seconds / 3600) % 24),
+                static_cast<unsigned>((seconds / 60) % 60), static_cast<unsigned>(seconds % 60),
+                static_cast<unsigned>((sequence * 37) % 1000), entry.Component, entry.Level);
+            output.append(prefix, static_cast<size_t>(length));
+            AppendCorpusMessage(output, entry.Pattern, random);
+            output.push_back('\n');
+            templates.push_back(static_cast<uint16_t>(index));
+        }
+    }
+
+    size_t TemplateCorpusSize()
+    {
+        return std::size(c_corpus);
+    }
+
+    std::filesystem::path EnsureSyntheticFile(size_t bytes, SyntheticLayout layout)
+    {
+        auto path = std::filesystem::temp_directory_path() /
+            ("logminds-synthetic-" + std::to_string(static_cast<int>(layout)) + "-" + std::to_string(bytes) + ".log");
+
+        std::error_code error;
+        if (std::filesystem::exists(path, error) && std::filesystem::file_size(path, error) >= bytes)
+        {
+            return path;
+        }
+
+        constexpr size_t c_blockBytes = 64 << 20;
+        std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+        std::string block;
+        uint64_t seed = 1;
+        for (size_t written = 0; written < bytes; ++seed)
+        {
+            block.clear();
+            AppendSyntheticLog(block, std::min(c_blockBytes, bytes - written), layout, seed);
+            stream.write(block.data(), static_cast<std::streamsize>(block.size()));
+            written += block.size();
+        }
+        return path;
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace LogMinds::Cli
+{
+    enum class SyntheticLayout
+    {
+        Mixed,
+        Iso,
+        Syslog,
+        KeyValue,
+        Level,
+        Json,
+        Plain,
+    };
+
+    bool TryParseLayout(std::string_view name, SyntheticLayout& layout);
+
+    // Appends roughly `bytes` of deterministic log lines in the given layout.
+    void AppendSyntheticLog(std::string& output, size_t bytes, SyntheticLayout layout, uint64_t seed = 1);
+
+    // Appends roughly `bytes` of ISO lines whose messages follow event
+    // templates of public log collections (HDFS, OpenSSH, BGL, Spark), a few
+    // templates far more common than the rest and one burst of errors, and
+    // the index of every line's template to templates.
+    void AppendTemplateCorpus(std::string& output, size_t bytes, std::vector<uint16_t>& templates, uint64_t seed = 1);
+    size_t TemplateCorpusSize();
+
+    // Writes a synthetic file once and reuses it while its size still matches.
+    std::filesystem::path EnsureSyntheticFile(size_t bytes, SyntheticLayout layout);
+}
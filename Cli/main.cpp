@@ -0,0 +1,671 @@
+#include "Benchmarks.h"
+#include "ParserCheck.h"
+#include "SearchCheck.h"
+#include "StandInLlm.h"
+
+#include "Engine/ContextPacker.h"
+#include "Engine/Decompressor.h"
+#include "Engine/Filter.h"
+#include "Engine/LogCache.h"
+#include "Engine/LogDocument.h"
+#include "Engine/LlmClient.h"
+#include "Engine/LogFollower.h"
+#include "Engine/LogMerge.h"
+#include "Engine/MappedFile.h"
+#include "Engine/RowAggregates.h"
+#include "Engine/Summary.h"
+#include "Engine/TemplateMiner.h"
+#include "Engine/Text.h"
+#include "Engine/Timestamp.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace LogMinds::Cli;
+using namespace LogMinds::Engine;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Options
+    {
+        std::string Command;
+        // The first of Paths.
+        std::string Path;
+        std::vector<std::string> Paths;
+        FilterQuery Query;
+        // Empty: no cache.
+        std::string CacheDirectory;
+        size_t Limit{ 0 };
+        unsigned Threads{ 0 };
+        BenchOptions Bench;
+        LlmSettings Llm{ LlmSettings::FromEnvironment() };
+        uint16_t Port{ 8080 };
+    };
+
+    double ElapsedMilliseconds(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    void PrintUsage()
+    {
+        std::cerr <<
+            "usage: logminds-cli <command> [options] <file|folder>...\n"
+            "\n"
+            "several files, or a folder, are merged into one timeline\n"
+            "\n"
+            "commands:\n"
+            "  stats     parse the file and print record and level counts\n"
+            "  filter    print the records matching the filter options\n"
+            "  summary   print the heuristic summary shown in the app\n"
+            "  interpret stream an LLM's reading of the records matching the filter options\n"
+            "  serve-llm run a stand-in OpenAI-compatible server on --port for interpret and the app\n"
+            "  templates group the records matching the filter options by message template\n"
+            "  follow    print matching records as they are appended to the file\n"
+            "  bench-load [file]   time mapping, newline scanning and parsing\n"
+            "  bench-parse         compare ParseLine with the std::regex reference per layout\n"
+            "  bench-store [file]  load time and memory of LogStore against vector<LogRecord>\n"
+            "  bench-search [file] type --search one character at a time, full vs incremental filter\n"
+            "  bench-index [file]  trigram index build time, memory and search latency\n"
+            "  bench-match [file]  case-insensitive matching against ToLower + find\n"
+            "  bench-range [file]  level bitmaps and time index against a full scan\n"
+            "  bench-timestamp     timestamp decoding against std::get_time\n"
+            "  bench-filter [file] filter scan time from 1 to --threads workers\n"
+            "  bench-typing [file] type --search into the background filter, keystroke-to-result latency\n"
+            "  bench-follow        tail a 64 MB file written at --rate lines/s, then rotate it\n"
+            "  bench-decompress [file] load .gz/.zst directly against decompressing to disk first\n"
+            "  bench-cache [file]  cold open against reopening through the cache, then growing the file\n"
+            "  bench-progressive [file] time to the first row of a batched load, and cancelling it\n"
+            "  bench-summary [file] summary aggregates kept while parsing against counting every row\n"
+            "  bench-keywords [file] keyword sketch against counting every word exactly\n"
+            "  bench-templates     parse and mine a corpus of known templates, throughput and grouping accuracy\n"
+            "  bench-interpret [file] context packing time and budget, then time to first token from a stand-in\n"
+            "  bench-merge         load --files time-ordered files as one folder against concatenate + sort\n"
+            "  verify-parser [file]  check ParseLine against the std::regex reference\n"
+            "  verify-search [file]  check the case-insensitive matcher against ToLower + find\n"
+            "\n"
+            "common options:\n"
+            "  --threads <n>     worker threads, 0 = all cores (default)\n"
+            "  --cache <dir>     reuse parsed files kept in dir (\"default\" for the app's cache)\n"
+            "\n"
+            "interpret options (defaults from LOGMINDS_LLM_URL, _MODEL, _API_KEY, _CONTEXT_TOKENS):\n"
+            "  --endpoint <url>  http:// chat completions endpoint, default http://127.0.0.1:8080/v1/chat/completions\n"
+            "  --model <name>    model name sent with the request, default local\n"
+            "  --budget <n>      estimated tokens of log context, default 3000\n"
+            "  --port <n>        port of serve-llm, default 8080\n"
+            "\n"
+            "benchmark options (a synthetic file is generated when no file is given):\n"
+            "  --size-mb <n>     synthetic file size, default 1024\n"
+            "  --parse-mb <n>    prefix parsed by the parse rows, default 64\n"
+            "  --layout <name>   mixed, iso, syslog, kv, level, json or plain\n"
+            "  --keystroke-ms <n> delay between keys in bench-typing, default 60\n"
+            "  --rate <n>        lines per second written in bench-follow, default 50000\n"
+            "  --seconds <n>     how long bench-follow writes, default 5\n"
+            "  --files <n>       files written by bench-merge, default 8\n"
+            "\n"
+            "filter options:\n"
+            "  --search <text>   case-insensitive substring over message/context/source/raw\n"
+            "  --level <level>   TRACE, DEBUG, INFO, WARN, ERROR, FATAL, CRITICAL, ...\n"
+            "  --origin <name>   only records from this file of a merged load\n"
+            "  --template <id>   only records of this message template (see templates)\n"
+            "  --from <time>     inclusive lower bound, yyyy-mm-dd hh:mm:ss\n"
+            "  --to <time>       inclusive upper bound, yyyy-mm-dd hh:mm:ss\n"
+            "  --limit <n>       print at most n records (n templates for templates)\n";
+    }
+
+    bool ParseArguments(int argc, char** argv, Options& options)
+    {
+        if (argc < 2)
+        {
+            return false;
+        }
+
+        options.Command = argv[1];
+        for (int i = 2; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            auto next = [&]() -> char const*
+            {
+                return i + 1 < argc ? argv[++i] : nullptr;
+            };
+
+            if (arg == "--search" || arg == "--level" || arg == "--from" || arg == "--to" || arg == "--limit" ||
+                arg == "--threads" || arg == "--size-mb" || arg == "--parse-mb" || arg == "--layout" ||
+                arg == "--keystroke-ms" || arg == "--rate" || arg == "--seconds" || arg == "--files" || arg == "--origin" ||
+                arg == "--cache" || arg == "--template" || arg == "--endpoint" || arg == "--model" || arg == "--budget" ||
+                arg == "--port")
+            {
+                auto value = next();
+                if (!value)
+                {
+                    std::cerr << "missing value for " << arg << "\n";
+                    return false;
+                }
+
+                if (arg == "--search")
+                {
+                    options.Query.SearchTerm = ToLower(value);
+                }
+                else if (arg == "--level")
+                {
+                    options.Query.Level = NormalizeLevel(value);
+                }
+                else if (arg == "--cache")
+                {
+                    options.CacheDirectory = std::string(value) == "default" ? LogCache::DefaultDirectory().u8string() : value;
+                }
+                else if (arg == "--origin")
+                {
+                    options.Query.Origin = value;
+                }
+                else if (arg == "--template")
+                {
+                    options.Query.Template = static_cast<uint32_t>(std::stoul(value));
+                }
+                else if (arg == "--endpoint")
+                {
+                    options.Llm.Url = value;
+                }
+                else if (arg == "--model")
+                {
+                    options.Llm.Model = value;
+                }
+                else if (arg == "--budget")
+                {
+                    options.Llm.ContextTokens = std::stoul(value);
+                }
+                else if (arg == "--port")
+                {
+                    options.Port = static_cast<uint16_t>(std::stoul(value));
+                }
+                else if (arg == "--limit")
+                {
+                    options.Limit = std::stoul(value);
+                }
+                else if (arg == "--threads")
+                {
+                    options.Threads = static_cast<unsigned>(std::stoul(value));
+                }
+                else if (arg == "--size-mb")
+                {
+                    options.Bench.SizeMb = std::stoul(value);
+                }
+                else if (arg == "--parse-mb")
+                {
+                    options.Bench.ParseMb = std::stoul(value);
+                }
+                else if (arg == "--keystroke-ms")
+                {
+                    options.Bench.KeystrokeMs = std::stoul(value);
+                }
+                else if (arg == "--rate")
+                {
+                    options.Bench.FollowRate = std::stoul(value);
+                }
+                else if (arg == "--seconds")
+                {
+                    options.Bench.FollowSeconds = std::stoul(value);
+                }
+                else if (arg == "--files")
+                {
+                    options.Bench.MergeFiles = std::stoul(value);
+                }
+                else if (arg == "--layout")
+                {
+                    if (!TryParseLayout(value, options.Bench.Layout))
+                    {
+                        std::cerr << "unknown layout: " << value << "\n";
+                        return false;
+                    }
+                }
+                else
+                {
+                    auto ticks = ParseTimestamp(value);
+                    if (!ticks)
+                    {
+                        std::cerr << "invalid timestamp: " << value << "\n";
+                        return false;
+                    }
+                    (arg == "--from" ? options.Query.StartTime : options.Query.EndTime) = ticks;
+                }
+            }
+            else if (arg.rfind("--", 0) == 0)
+            {
+                std::cerr << "unexpected argument: " << arg << "\n";
+                return false;
+            }
+            else
+            {
+                options.Paths.push_back(arg);
+            }
+        }
+
+        options.Path = options.Paths.empty() ? std::string() : options.Paths.front();
+        options.Bench.Path = options.Path;
+        options.Bench.Threads = options.Threads;
+        return !options.Path.empty() || options.Command.rfind("bench-", 0) == 0 || options.Command.rfind("verify-", 0) == 0 ||
+            options.Command == "serve-llm";
+    }
+
+    bool IsFiltered(FilterQuery const& query)
+    {
+        return !query.SearchTerm.empty() || !query.Level.empty() || !query.Origin.empty() || query.Template ||
+            query.StartTime || query.EndTime;
+    }
+
+    // A merged load prefixes every record with its origin file.
+    void PrintRecord(LogStore const& store, size_t row)
+    {
+        if (store.OriginNames().size() > 1)
+        {
+            std::cout << store.Origin(row) << '\t';
+        }
+        std::cout << store.Timestamp(row) << '\t' << store.Level(row) << '\t' << store.Source(row) << '\t'
+            << store.Message(row) << '\t' << store.Context(row) << '\n';
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseArguments(argc, argv, options))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    if (options.Command == "bench-load")
+    {
+        return RunLoadBenchmark(options.Bench);
+    }
+    if (options.Command == "bench-parse")
+    {
+        return RunParseBenchmark(options.Bench);
+    }
+    if (options.Command == "bench-store")
+    {
+        return RunStoreBenchmark(options.Bench);
+    }
+    if (options.Command == "bench-search")
+    {
+        return RunSearchBenchmark(options.Bench, options.Query.SearchTerm.empty() ? "timeout" : options.Query.SearchTerm);
+    }
+    if (options.Command == "bench-index")
+    {
+        return RunIndexBenchmark(options.Bench, options.Query.SearchTerm);
+    }
+    if (options.Command == "bench-match")
+    {
+        return RunMatchBenchmark(options.Bench, options.Query.SearchTerm);
+    }
+    if (options.Command == "bench-range")
+    {
+        return RunAttributeIndexBenchmark(options.Bench, options.Query);
+    }
+    if (options.Command == "bench-timestamp")
+    {
+        return RunTimestampBenchmark(options.Bench);
+    }
+    if (options.Command == "bench-filter")
+    {
+        return RunFilterScalingBenchmark(options.Bench, options.Query);
+    }
+    if (options.Command == "bench-typing")
+    {
+        return RunTypingBenchmark(options.Bench, options.Query.SearchTerm.empty() ? "timeout waiting" : options.Query.SearchTerm);
+    }
+    if (options.Command == "bench-follow")
+    {
+        return RunFollowBenchmark(options.Bench, options.Query);
+    }
+    if (options.Command == "bench-decompress")
+    {
+        return RunDecompressBenchmark(options.Bench);
+    }
+    if (options.Command == "bench-cache")
+    {
+        return RunCacheBenchmark(options.Bench);
+    }
+    if (options.Command == "bench-progressive")
+    {
+        return RunProgressiveBenchmark(options.Bench);
+    }
+    if (options.Command == "bench-summary")
+    {
+        return RunSummaryBenchmark(options.Bench);
+    }
+    if (options.Command == "bench-keywords")
+    {
+        return RunKeywordBenchmark(options.Bench);
+    }
+    if (options.Command == "bench-templates")
+    {
+        return RunTemplateBenchmark(options.Bench);
+    }
+    if (options.Command == "bench-interpret")
+    {
+        return RunInterpretBenchmark(options.Bench);
+    }
+    if (options.Command == "serve-llm")
+    {
+        StandInLlmServer server;
+        std::string error;
+        if (!server.Start(options.Port, error))
+        {
+            std::cerr << error << "\n";
+            return 1;
+        }
+        std::cerr << "serving a stand-in chat completions endpoint at " << server.Url() << "\n";
+        while (true)
+        {
+            std::this_thread::sleep_for(std::chrono::hours(1));
+        }
+    }
+    if (options.Command == "bench-merge")
+    {
+        return RunMergeBenchmark(options.Bench);
+    }
+    if (options.Command == "verify-parser")
+    {
+        return RunParserVerification(options.Path, 200000);
+    }
+    if (options.Command == "verify-search")
+    {
+        return RunSearchVerification(options.Path, 500000);
+    }
+
+    auto start = Clock::now();
+    MappedFile file;
+    // What the records are parsed from: the file, or for follow its
+    // complete lines.
+    std::string_view text;
+    std::string error;
+    ParseReport report;
+    LogStore records;
+    std::error_code code;
+    if (options.Paths.size() > 1 || std::filesystem::is_directory(options.Path, code))
+    {
+        if (options.Command == "follow")
+        {
+            std::cerr << "follow takes a single file\n";
+            return 2;
+        }
+
+        std::vector<std::filesystem::path> paths(options.Paths.begin(), options.Paths.end());
+        paths = ExpandLogPaths(paths, error);
+        records = ParseLogFiles(paths, options.Threads, &report, error);
+        if (!error.empty())
+        {
+            std::cerr << "cannot read " << error;
+            if (records.Empty())
+            {
+                return 1;
+            }
+        }
+        std::fprintf(stderr, "merged %zu files, %zu records in %.1f ms (%s, %zu hits, %zu misses)\n", paths.size(),
+            records.Size(), ElapsedMilliseconds(start), std::string(LineFormatName(report.Format)).c_str(),
+            report.Hits, report.Misses);
+    }
+    else
+    {
+        if (!file.Open(options.Path, error))
+        {
+            std::cerr << "cannot read " << options.Path << ": " << error << "\n";
+            return 1;
+        }
+        auto mapMs = ElapsedMilliseconds(start);
+
+        start = Clock::now();
+        if (options.Command == "follow" && DetectCompression(file.Text()) != Compression::None)
+        {
+            std::cerr << "cannot follow a compressed file\n";
+            return 2;
+        }
+        text = file.Text();
+        if (options.Command == "follow" && IsLineOriented(text))
+        {
+            // A last line still being written is left to the follower, which
+            // reads it once its newline arrives.
+            auto newline = text.rfind('\n');
+            text = text.substr(0, newline == std::string_view::npos ? 0 : newline + 1);
+        }
+        std::optional<LogCache> cache;
+        auto state = CacheState::Missing;
+        if (!options.CacheDirectory.empty())
+        {
+            cache.emplace(options.CacheDirectory);
+            CachedLog cached;
+            state = cache->Load(options.Path, text, options.Threads, cached);
+            if (state == CacheState::Fresh || state == CacheState::Extended)
+            {
+                records = std::move(cached.Store);
+                report = std::move(cached.Report);
+            }
+        }
+        if (state != CacheState::Fresh && state != CacheState::Extended)
+        {
+            records = ParseDocument(text, options.Threads, &report,
+                ParseContext{ LastWriteTicks(options.Path) });
+        }
+        auto parseMs = ElapsedMilliseconds(start);
+        if (cache && state != CacheState::Fresh && report.Error.empty())
+        {
+            std::string cacheError;
+            if (!cache->Save(options.Path, SourceStamp::Of(options.Path, text), records, report, nullptr,
+                nullptr, cacheError))
+            {
+                std::cerr << "cache not written: " << cacheError << "\n";
+            }
+        }
+        if (cache)
+        {
+            std::fprintf(stderr, "cache entry %s\n", std::string(CacheStateName(state)).c_str());
+        }
+        if (!report.Error.empty())
+        {
+            std::cerr << "cannot read all of " << options.Path << ": " << report.Error << "\n";
+            if (records.Empty())
+            {
+                return 1;
+            }
+        }
+        std::fprintf(stderr, "mapped %zu bytes in %.1f ms, parsed %zu records in %.1f ms (%s, %zu hits, %zu misses)\n",
+            file.Size(), mapMs, records.Size(), parseMs, std::string(LineFormatName(report.Format)).c_str(),
+            report.Hits, report.Misses);
+    }
+
+    if (options.Command == "stats")
+    {
+        auto const& aggregates = records.Aggregates();
+        std::map<std::string, size_t> levels(aggregates.OverflowLevelRows().begin(),
+            aggregates.OverflowLevelRows().end());
+        for (size_t id = 0; id < aggregates.LevelRows().size(); ++id)
+        {
+            if (auto rows = aggregates.LevelRows()[id]; rows != 0)
+            {
+                auto const& level = records.LevelNames()[id];
+                levels[level.empty() ? std::string("-") : level] += rows;
+            }
+        }
+
+        std::cout << "records\t" << records.Size() << "\n";
+        std::cout << "timestamped\t" << aggregates.TimedRows() << "\n";
+        std::cout << "format\t" << LineFormatName(report.Format) << "\n";
+        std::cout << "format.hits\t" << report.Hits << "\n";
+        std::cout << "format.misses\t" << report.Misses << "\n";
+        std::cout << "memory.bytes\t" << records.MemoryUsage() << "\n";
+        std::cout << "dictionary.levels\t" << records.LevelNames().size() - 1 << "\n";
+        std::cout << "dictionary.sources\t" << records.SourceNames().size() - 1 << "\n";
+        if (records.OriginNames().size() > 1)
+        {
+            std::cout << "dictionary.origins\t" << records.OriginNames().size() - 1 << "\n";
+        }
+        std::cout << "dictionary.saved.bytes\t" << records.DictionarySavings() << "\n";
+        std::cout << "templates\t" << records.Templates().Size() << "\n";
+        for (auto const& [level, count] : levels)
+        {
+            std::cout << "level." << level << "\t" << count << "\n";
+        }
+        return 0;
+    }
+
+    if (options.Command == "filter")
+    {
+        start = Clock::now();
+        auto selection = ApplyFilter(records, options.Query, options.Threads);
+        std::fprintf(stderr, "matched %zu records in %.1f ms\n", selection.size(), ElapsedMilliseconds(start));
+
+        size_t printed = 0;
+        for (auto row : selection)
+        {
+            if (options.Limit != 0 && printed++ >= options.Limit)
+            {
+                break;
+            }
+            PrintRecord(records, row);
+        }
+        return 0;
+    }
+
+    if (options.Command == "follow")
+    {
+        // Runs until interrupted; every batch of new rows goes through the
+        // same filter.
+        std::mutex mutex;
+        LogFollower follower(options.Path, std::make_shared<LogStore const>(std::move(records)), text.size(),
+            [&](FollowUpdate&& update)
+        {
+            if (update.Restarted)
+            {
+                std::fprintf(stderr, "file was truncated or replaced, reading it again\n");
+            }
+            std::vector<uint32_t> fresh;
+            for (auto row = update.FirstNewRow; row < update.Store->Size(); ++row)
+            {
+                fresh.push_back(static_cast<uint32_t>(row));
+            }
+            std::lock_guard lock(mutex);
+            for (auto row : ApplyFilter(*update.Store, options.Query, fresh, options.Threads))
+            {
+                PrintRecord(*update.Store, row);
+            }
+            std::cout.flush();
+        }, LogFollower::c_defaultInterval, options.Threads);
+        file.Close();
+        while (true)
+        {
+            std::this_thread::sleep_for(std::chrono::hours(1));
+        }
+    }
+
+    if (options.Command == "summary")
+    {
+        // With filter options the summary describes the matching rows.
+        auto const& query = options.Query;
+        std::string summary;
+        if (IsFiltered(query))
+        {
+            start = Clock::now();
+            auto selection = ApplyFilter(records, query, options.Threads);
+            auto aggregates = RowAggregates::Of(records, selection, options.Threads);
+            std::fprintf(stderr, "matched %zu records and counted them in %.1f ms\n", selection.size(),
+                ElapsedMilliseconds(start));
+            start = Clock::now();
+            summary = BuildSummary(records, aggregates, selection);
+        }
+        else
+        {
+            start = Clock::now();
+            summary = BuildSummary(records);
+        }
+        std::fprintf(stderr, "summarized in %.1f ms\n", ElapsedMilliseconds(start));
+        std::cout << summary;
+        return 0;
+    }
+
+    if (options.Command == "templates")
+    {
+        start = Clock::now();
+        auto selection = ApplyFilter(records, options.Query, options.Threads);
+        auto groups = GroupByTemplate(records, selection, options.Threads);
+        std::fprintf(stderr, "matched %zu records in %zu of %zu templates in %.1f ms\n", selection.size(),
+            groups.size(), records.Templates().Size(), ElapsedMilliseconds(start));
+
+        auto formatTime = [](std::optional<int64_t> ticks)
+        {
+            return ticks ? FormatTimestamp(*ticks) : std::string("-");
+        };
+        size_t printed = 0;
+        for (auto const& group : groups)
+        {
+            if (options.Limit != 0 && printed++ >= options.Limit)
+            {
+                break;
+            }
+            std::cout << group.Template << '\t' << group.Rows << '\t' << formatTime(group.FirstTime) << '\t'
+                << formatTime(group.LastTime) << '\t' << records.Templates().Text(group.Template) << '\n';
+        }
+        return 0;
+    }
+
+    if (options.Command == "interpret")
+    {
+        // Like summary, the filter options narrow what is described.
+        start = Clock::now();
+        PackedContext context;
+        if (IsFiltered(options.Query))
+        {
+            auto selection = ApplyFilter(records, options.Query, options.Threads);
+            auto aggregates = RowAggregates::Of(records, selection, options.Threads);
+            context = PackContext(records, aggregates, selection, options.Llm.ContextTokens, options.Threads);
+        }
+        else
+        {
+            context = PackContext(records, options.Llm.ContextTokens, options.Threads);
+        }
+        std::fprintf(stderr, "packed %zu of %zu templates, %zu bursts and %zu lines into %zu of %zu tokens in %.1f ms\n",
+            context.Templates, context.TemplateCount, context.Bursts, context.Examples, context.Tokens,
+            options.Llm.ContextTokens, ElapsedMilliseconds(start));
+
+        auto body = BuildChatRequest(options.Llm, {
+            { "system", std::string(InterpretInstructions()) },
+            { "user", context.Text },
+        });
+        start = Clock::now();
+        std::optional<double> firstTokenMs;
+        std::string streamError;
+        auto streamed = StreamChatCompletion(options.Llm, body, [&](std::string_view text)
+        {
+            if (!firstTokenMs)
+            {
+                firstTokenMs = ElapsedMilliseconds(start);
+            }
+            std::cout << text;
+            std::cout.flush();
+            return true;
+        }, streamError);
+        std::cout << "\n";
+        if (!streamed)
+        {
+            std::cerr << "interpretation failed: " << streamError << "\n";
+            return 1;
+        }
+        std::fprintf(stderr, "first token after %.1f ms, reply complete after %.1f ms\n", firstTokenMs.value_or(0.0),
+            ElapsedMilliseconds(start));
+        return 0;
+    }
+
+    PrintUsage();
+    return 2;
+}
@@ -0,0 +1,297 @@
+#include "AttributeIndex.h"
+
+#include "BinaryIo.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace LogMinds::Engine
+{
+    namespace
+    {
+        // Zones prune well while their ranges add up to no more than a few
+        // times the span of the whole file; a shuffled file makes every zone
+        // cover nearly all of it.
+        constexpr double c_zoneSpreadLimit = 4.0;
+
+        int64_t RangeStart(FilterQuery const& query)
+        {
+            return query.StartTime.value_or(std::numeric_limits<int64_t>::min() + 1);
+        }
+
+        int64_t RangeEnd(FilterQuery const& query)
+        {
+            return query.EndTime.value_or(std::numeric_limits<int64_t>::max());
+        }
+
+        bool InTimeRange(LogStore const& store, uint32_t row, FilterQuery const& query)
+        {
+            auto occurredOn = store.OccurredOn(row);
+            return occurredOn && *occurredOn >= RangeStart(query) && *occurredOn <= RangeEnd(query);
+        }
+    }
+
+    AttributeIndex AttributeIndex::Build(LogStore const& store)
+    {
+        AttributeIndex index;
+        index.m_rows = store.Size();
+
+        index.m_levels.resize(store.LevelNames().size());
+        for (size_t row = 0; row < store.Size(); ++row)
+        {
+            auto id = store.LevelId(row);
+            if (id != LogStore::c_overflowLevel)
+            {
+                index.m_levels[id].Add(static_cast<uint32_t>(row));
+            }
+        }
+        for (auto& bitmap : index.m_levels)
+        {
+            bitmap.ShrinkToFit();
+        }
+
+        auto first = std::numeric_limits<int64_t>::max();
+        auto last = std::numeric_limits<int64_t>::min();
+        double zoneSpread = 0;
+        index.m_zones.resize((store.Size() + c_zoneRows - 1) / c_zoneRows);
+        for (size_t zoneIndex = 0; zoneIndex < index.m_zones.size(); ++zoneIndex)
+        {
+            auto& zone = index.m_zones[zoneIndex];
+            zone.Min = std::numeric_limits<int64_t>::max();
+            zone.Max = std::numeric_limits<int64_t>::min();
+            auto end = std::min(store.Size(), (zoneIndex + 1) * c_zoneRows);
+            for (auto row = zoneIndex * c_zoneRows; row < end; ++row)
+            {
+                if (auto occurredOn = store.OccurredOn(row))
+                {
+                    zone.Min = std::min(zone.Min, *occurredOn);
+                    zone.Max = std::max(zone.Max, *occurredOn);
+                    ++zone.Timestamped;
+                }
+            }
+            if (zone.Timestamped != 0)
+            {
+                first = std::min(first, zone.Min);
+                last = std::max(last, zone.Max);
+                zoneSpread += static_cast<double>(zone.Max - zone.Min);
+            }
+        }
+
+        index.m_zonesSelective = first >= last ||
+            zoneSpread <= c_zoneSpreadLimit * static_cast<double>(last - first);
+        if (!index.m_zonesSelective)
+        {
+            for (size_t row = 0; row < store.Size(); ++row)
+            {
+                if (store.OccurredOn(row))
+                {
+                    index.m_timeOrder.push_back(static_cast<uint32_t>(row));
+                }
+            }
+            std::sort(index.m_timeOrder.begin(), index.m_timeOrder.end(), [&](uint32_t left, uint32_t right)
+            {
+                auto leftTime = *store.OccurredOn(left);
+                auto rightTime = *store.OccurredOn(right);
+                return leftTime != rightTime ? leftTime < rightTime : left < right;
+            });
+        }
+        return index;
+    }
+
+    std::optional<std::vector<uint32_t>> AttributeIndex::Select(LogStore const& store, FilterQuery const& query) const
+    {
+        auto byTime = query.StartTime || query.EndTime;
+        if (query.Level.empty() && !byTime)
+        {
+            return std::nullopt;
+        }
+
+        RowBitmap const* levelRows = nullptr;
+        if (!query.Level.empty())
+        {
+            if (store.HasLevelOverflow())
+            {
+                return std::nullopt;
+            }
+            auto id = store.FindLevel(query.Level);
+            if (!id || *id >= m_levels.size())
+            {
+                return std::vector<uint32_t>();
+            }
+            levelRows = &m_levels[*id];
+            if (!byTime)
+            {
+                return levelRows->Rows();
+            }
+        }
+
+        // Walk whichever side is smaller and probe the other one.
+        if (levelRows && levelRows->Count() <= CountInTimeRange(store, query))
+        {
+            std::vector<uint32_t> rows;
+            levelRows->ForEach([&](uint32_t row)
+            {
+                if (InTimeRange(store, row, query))
+                {
+                    rows.push_back(row);
+                }
+            });
+            return rows;
+        }
+        return RowsInTimeRange(store, query, levelRows);
+    }
+
+    size_t AttributeIndex::CountInTimeRange(LogStore const& store, FilterQuery const& query) const
+    {
+        auto start = RangeStart(query);
+        auto end = RangeEnd(query);
+        if (m_zonesSelective)
+        {
+            // An upper bound: zones that overlap the range count in full.
+            size_t count = 0;
+            for (auto const& zone : m_zones)
+            {
+                if (zone.Timestamped != 0 && zone.Max >= start && zone.Min <= end)
+                {
+                    count += zone.Timestamped;
+                }
+            }
+            return count;
+        }
+
+        auto time = [&](uint32_t row)
+        {
+            return *store.OccurredOn(row);
+        };
+        auto lower = std::partition_point(m_timeOrder.begin(), m_timeOrder.end(), [&](uint32_t row)
+        {
+            return time(row) < start;
+        });
+        auto upper = std::partition_point(lower, m_timeOrder.end(), [&](uint32_t row)
+        {
+            return time(row) <= end;
+        });
+        return static_cast<size_t>(upper - lower);
+    }
+
+    std::vector<uint32_t> AttributeIndex::RowsInTimeRange(LogStore const& store, FilterQuery const& query,
+        RowBitmap const* levelRows) const
+    {
+        auto start = RangeStart(query);
+        auto end = RangeEnd(query);
+        std::vector<uint32_t> rows;
+        auto keep = [&](uint32_t row)
+        {
+            if (!levelRows || levelRows->Contains(row))
+            {
+                rows.push_back(row);
+            }
+        };
+
+        if (m_zonesSelective)
+        {
+            for (size_t zoneIndex = 0; zoneIndex < m_zones.size(); ++zoneIndex)
+            {
+                auto const& zone = m_zones[zoneIndex];
+                if (zone.Timestamped == 0 || zone.Max < start || zone.Min > end)
+                {
+                    continue;
+                }
+                auto first = zoneIndex * c_zoneRows;
+                auto last = std::min(m_rows, first + c_zoneRows);
+                auto whole = zone.Min >= start && zone.Max <= end && zone.Timestamped == last - first;
+                for (auto row = first; row < last; ++row)
+                {
+                    if (whole || InTimeRange(store, static_cast<uint32_t>(row), query))
+                    {
+                        keep(static_cast<uint32_t>(row));
+                    }
+                }
+            }
+            return rows;
+        }
+
+        // The permutation slice is in time order; a bitset over all rows puts
+        // it back into row order.
+        auto time = [&](uint32_t row)
+        {
+            return *store.OccurredOn(row);
+        };
+        auto lower = std::partition_point(m_timeOrder.begin(), m_timeOrder.end(), [&](uint32_t row)
+        {
+            return time(row) < start;
+        });
+        auto upper = std::partition_point(lower, m_timeOrder.end(), [&](uint32_t row)
+        {
+            return time(row) <= end;
+        });
+        std::vector<uint64_t> bits((m_rows + 63) / 64);
+        for (auto it = lower; it != upper; ++it)
+        {
+            bits[*it >> 6] |= uint64_t{ 1 } << (*it & 63);
+        }
+        for (size_t word = 0; word < bits.size(); ++word)
+        {
+            for (auto value = bits[word]; value != 0; value &= value - 1)
+            {
+                keep(static_cast<uint32_t>(word * 64 + CountTrailingZeros(value)));
+            }
+        }
+        return rows;
+    }
+
+    size_t AttributeIndex::MemoryUsage() const
+    {
+        auto bytes = sizeof(AttributeIndex) + m_zones.capacity() * sizeof(Zone) +
+            m_timeOrder.capacity() * sizeof(uint32_t) + m_levels.capacity() * sizeof(RowBitmap);
+        for (auto const& bitmap : m_levels)
+        {
+            bytes += bitmap.MemoryUsage() - sizeof(RowBitmap);
+        }
+        return bytes;
+    }
+
+    void AttributeIndex::Write(BinaryWriter& writer) const
+    {
+        writer.Vector(m_zones);
+        writer.Value<uint8_t>(m_zonesSelective ? 1 : 0);
+        writer.Vector(m_timeOrder);
+        writer.Value<uint64_t>(m_levels.size());
+        for (auto const& level : m_levels)
+        {
+            level.Write(writer);
+        }
+        writer.Value<uint64_t>(m_rows);
+    }
+
+    bool AttributeIndex::Read(BinaryReader& reader, LogStore const& store)
+    {
+        *this = AttributeIndex();
+        uint8_t zonesSelective = 0;
+        uint64_t levels = 0;
+        if (!reader.Vector(m_zones) || !reader.Value(zonesSelective) || !reader.Vector(m_timeOrder) ||
+            !reader.Value(levels) || levels != store.LevelNames().size())
+        {
+            return false;
+        }
+        m_zonesSelective = zonesSelective != 0;
+        m_levels.resize(static_cast<size_t>(levels));
+        for (auto& level : m_levels)
+        {
+            if (!level.Read(reader))
+            {
+                return false;
+            }
+        }
+        uint64_t rows = 0;
+        if (!reader.Value(rows) || rows != store.Size() || m_zones.size() != (store.Size() + c_zoneRows - 1) / c_zoneRows)
+        {
+            return false;
+        }
+        m_rows = static_cast<size_t>(rows);
+        return std::all_of(m_timeOrder.begin(), m_timeOrder.end(), [&](uint32_t row)
+        {
+            return row < m_rows;
+        });
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Filter.h"
+#include "LogStore.h"
+#include "RowBitmap.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace LogMinds::Engine
+{
+    // Level and time lookups for a store, built right after parsing. Every
+    // level id gets a RowBitmap. Timestamps get a min/max zone map over
+    // fixed row blocks; when the file is too far out of order for the zones
+    // to prune anything, a permutation of the timestamped rows sorted by
+    // time is kept as well and ranges resolve by binary search.
+    class AttributeIndex
+    {
+    public:
+        static AttributeIndex Build(LogStore const& store);
+
+        // Ascending rows whose level and time range match the query; the
+        // search term is not looked at. std::nullopt when the query sets
+        // neither, or when the store has more levels than its level table.
+        std::optional<std::vector<uint32_t>> Select(LogStore const& store, FilterQuery const& query) const;
+
+        size_t Rows() const
+        {
+            return m_rows;
+        }
+
+        // False when time ranges go through the sorted permutation.
+        bool UsesZoneMap() const
+        {
+            return m_zonesSelective;
+        }
+
+        size_t MemoryUsage() const;
+
+        void Write(BinaryWriter& writer) const;
+        // False when the input is inconsistent with store.
+        bool Read(BinaryReader& reader, LogStore const& store);
+
+    private:
+        struct Zone
+        {
+            int64_t Min{ 0 };
+            int64_t Max{ 0 };
+            // Rows of the block that have a timestamp.
+            uint32_t Timestamped{ 0 };
+        };
+
+        static constexpr size_t c_zoneRows = 4096;
+
+        std::vector<Zone> m_zones;
+        bool m_zonesSelective{ true };
+        std::vector<uint32_t> m_timeOrder;
+        std::vector<RowBitmap> m_levels;
+        size_t m_rows{ 0 };
+
+        size_t CountInTimeRange(LogStore const& store, FilterQuery const& query) const;
+        std::vector<uint32_t> RowsInTimeRange(LogStore const& store, FilterQuery const& query,
+            RowBitmap const* levelRows) const;
+    };
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace LogMinds::Engine
+{
+    // Values are written in host byte order and layout; whoever stores the
+    // bytes versions them.
+    class BinaryWriter
+    {
+    public:
+        explicit BinaryWriter(std::ostream& stream) : m_stream(stream) {}
+
+        void Bytes(void const* data, size_t size)
+        {
+            m_stream.write(static_cast<char const*>(data), static_cast<std::streamsize>(size));
+            m_offset += size;
+        }
+
+        // Pads with zeros up to a multiple of alignment, counted from where
+        // the writer started, so that a reader over the same bytes can view
+        // what follows in place.
+        void Align(size_t alignment)
+        {
+            static constexpr char c_zeros[16]{};
+            Bytes(c_zeros, (alignment - m_offset % alignment) % alignment);
+        }
+
+        template <typename T>
+        void Value(T const& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            Bytes(&value, sizeof(T));
+        }
+
+        template <typename T>
+        void Vector(std::vector<T> const& values)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            Value<uint64_t>(values.size());
+            Bytes(values.data(), values.size() * sizeof(T));
+        }
+
+        void String(std::string_view text)
+        {
+            Value<uint64_t>(text.size());
+            Bytes(text.data(), text.size());
+        }
+
+        bool Ok() const
+        {
+            return static_cast<bool>(m_stream);
+        }
+
+    private:
+        std::ostream& m_stream;
+        size_t m_offset{ 0 };
+    };
+
+    // Reads what BinaryWriter wrote. Every read is bounds checked; after the
+    // first one that runs past the end, all of them fail.
+    class BinaryReader
+    {
+    public:
+        explicit BinaryReader(std::string_view data) : m_data(data) {}
+
+        bool Bytes(void* data, size_t size)
+        {
+            if (m_failed || size > m_data.size() - m_offset)
+            {
+                m_failed = true;
+                return false;
+            }
+            std::memcpy(data, m_data.data() + m_offset, size);
+            m_offset += size;
+            return true;
+        }
+
+        template <typename T>
+        bool Value(T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            return Bytes(&value, sizeof(T));
+        }
+
+        template <typename T>
+        bool Vector(std::vector<T>& values)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            uint64_t count = 0;
+            if (!Value(count) || count > (m_data.size() - m_offset) / sizeof(T))
+            {
+                m_failed = true;
+                return false;
+            }
+            values.resize(static_cast<size_t>(count));
+            return Bytes(values.data(), values.size() * sizeof(T));
+        }
+
+        bool String(std::string& text)
+        {
+            uint64_t size = 0;
+            if (!Value(size) || size > m_data.size() - m_offset)
+            {
+                m_failed = true;
+                return false;
+            }
+            text.assign(m_data.data() + m_offset, static_cast<size_t>(size));
+            m_offset += static_cast<size_t>(size);
+            return true;
+        }
+
+        bool Align(size_t alignment)
+        {
+            char const* padding = nullptr;
+            return View((alignment - m_offset % alignment) % alignment, padding);
+        }
+
+        // The next size bytes where they are, for callers that keep the
+        // underlying data alive themselves.
+        bool View(size_t size, char const*& data)
+        {
+            if (m_failed || size > m_data.size() - m_offset)
+            {
+                m_failed = true;
+                return false;
+            }
+            data = m_data.data() + m_offset;
+            m_offset += size;
+            return true;
+        }
+
+        size_t Remaining() const
+        {
+            return m_data.size() - m_offset;
+        }
+
+        bool Failed() const
+        {
+            return m_failed;
+        }
+
+    private:
+        std::string_view m_data;
+        size_t m_offset{ 0 };
+        bool m_failed{ false };
+    };
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace LogMinds::Engine
+{
+    // Cancelled as soon as the generation it was issued for is no longer the
+    // current one. A default-constructed token is never cancelled.
+    class CancellationToken
+    {
+    public:
+        CancellationToken() = default;
+
+        CancellationToken(std::atomic<uint64_t> const& current, uint64_t generation) :
+            m_current(&current), m_generation(generation)
+        {
+        }
+
+        bool IsCancelled() const
+        {
+            return m_current && m_current->load(std::memory_order_relaxed) != m_generation;
+        }
+
+    private:
+        std::atomic<uint64_t> const* m_current{ nullptr };
+        uint64_t m_generation{ 0 };
+    };
+
+    // Hands out increasing generations; issuing one cancels the tokens of
+    // every older one.
+    class GenerationCounter
+    {
+    public:
+        uint64_t Advance()
+        {
+            return m_current.fetch_add(1, std::memory_order_acq_rel) + 1;
+        }
+
+        bool IsCurrent(uint64_t generation) const
+        {
+            return m_current.load(std::memory_order_acquire) == generation;
+        }
+
+        CancellationToken Token(uint64_t generation) const
+        {
+            return CancellationToken(m_current, generation);
+        }
+
+    private:
+        std::atomic<uint64_t> m_current{ 0 };
+    };
+}
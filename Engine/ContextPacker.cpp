@@ -0,0 +1,389 @@
+#include "ContextPacker.h"
+
+#include "LogStore.h"
+#include "Parallel.h"
+#include "RowAggregates.h"
+#include "TemplateMiner.h"
+#include "Text.h"
+#include "Timestamp.h"
+
+#include <algorithm>
+#include <map>
+
+namespace LogMinds::Engine
+{
+    namespace
+    {
+        constexpr size_t c_minimumRowsPerChunk = 1 << 16;
+        // Error rows are counted in this many equal slices of the time
+        // range (or of the rows, when they carry no times).
+        constexpr size_t c_burstSlices = 256;
+        // A slice is part of a burst with this many times its share of the
+        // error rows, and at least c_minimumBurstRows of them.
+        constexpr size_t c_burstFactor = 4;
+        constexpr size_t c_minimumBurstRows = 3;
+        constexpr size_t c_maxBursts = 5;
+        // Share of the budget the sections up to and including bursts and
+        // rare templates may fill; the common templates get the rest.
+        constexpr double c_burstShare = 0.3;
+        constexpr double c_rareShare = 0.75;
+        // Kept back for the line that counts the templates left out.
+        constexpr size_t c_closingTokens = 24;
+        constexpr size_t c_maxQuoteBytes = 240;
+
+        // Error rows of a slice, or of a run of slices.
+        struct Burst
+        {
+            size_t Rows{ 0 };
+            uint32_t FirstRow{ 0 };
+            uint32_t LastRow{ 0 };
+        };
+
+        template <typename RowAt>
+        std::vector<Burst> FindBursts(LogStore const& store, RowAggregates const& aggregates, size_t count, RowAt rowAt,
+            unsigned threadCount)
+        {
+            if (aggregates.CriticalRows() < c_minimumBurstRows)
+            {
+                return {};
+            }
+
+            std::vector<uint8_t> critical(store.LevelNames().size());
+            for (size_t id = 0; id < critical.size(); ++id)
+            {
+                critical[id] = RowAggregates::IsCritical(store.LevelNames()[id]) ? 1 : 0;
+            }
+            auto first = aggregates.FirstTime();
+            auto last = aggregates.LastTime();
+            auto timed = first && last && *last > *first;
+            // Width of a slice in ticks, or in rows.
+            auto width = timed ? static_cast<uint64_t>(*last - *first) / c_burstSlices + 1 : count / c_burstSlices + 1;
+
+            auto threads = ResolveThreadCount(threadCount);
+            auto chunkCount = std::max<size_t>(1, std::min<size_t>(threads * 4, count / c_minimumRowsPerChunk));
+            auto perChunk = (count + chunkCount - 1) / chunkCount;
+            std::vector<std::vector<Burst>> partials(chunkCount);
+            ParallelFor(chunkCount, threads, [&](size_t chunk)
+            {
+                auto& slices = partials[chunk];
+                slices.resize(c_burstSlices);
+                auto begin = std::min(count, chunk * perChunk);
+                auto end = std::min(count, begin + perChunk);
+                for (auto index = begin; index < end; ++index)
+                {
+                    auto row = rowAt(index);
+                    auto level = store.LevelId(row);
+                    if (level == LogStore::c_overflowLevel ? !RowAggregates::IsCritical(store.Level(row)) : !critical[level])
+                    {
+                        continue;
+                    }
+                    uint64_t position = index;
+                    if (timed)
+                    {
+                        auto occurredOn = store.OccurredOn(row);
+                        if (!occurredOn)
+                        {
+                            continue;
+                        }
+                        position = static_cast<uint64_t>(*occurredOn - *first);
+                    }
+                    auto& slice = slices[std::min<size_t>(c_burstSlices - 1, position / width)];
+                    if (slice.Rows++ == 0)
+                    {
+                        slice.FirstRow = row;
+                    }
+                    slice.LastRow = row;
+                }
+            });
+
+            std::vector<Burst> slices(c_burstSlices);
+            size_t total = 0;
+            for (auto const& partial : partials)
+            {
+                for (size_t index = 0; index < c_burstSlices; ++index)
+                {
+                    auto const& part = partial[index];
+                    auto& slice = slices[index];
+                    if (part.Rows == 0)
+                    {
+                        continue;
+                    }
+                    // Rows come in chunk order, but times need not.
+                    slice.FirstRow = slice.Rows == 0 ? part.FirstRow : std::min(slice.FirstRow, part.FirstRow);
+                    slice.LastRow = std::max(slice.LastRow, part.LastRow);
+                    slice.Rows += part.Rows;
+                    total += part.Rows;
+                }
+            }
+
+            // Neighbouring slices above the threshold make one burst.
+            auto threshold = std::max(c_minimumBurstRows, c_burstFactor * total / c_burstSlices);
+            std::vector<Burst> bursts;
+            auto open = false;
+            for (auto const& slice : slices)
+            {
+                if (slice.Rows < threshold)
+                {
+                    open = false;
+                    continue;
+                }
+                if (!open)
+                {
+                    bursts.push_back({ 0, slice.FirstRow, slice.LastRow });
+                    open = true;
+                }
+                auto& burst = bursts.back();
+                burst.Rows += slice.Rows;
+                burst.FirstRow = std::min(burst.FirstRow, slice.FirstRow);
+                burst.LastRow = std::max(burst.LastRow, slice.LastRow);
+            }
+            std::sort(bursts.begin(), bursts.end(), [](Burst const& left, Burst const& right)
+            {
+                return left.Rows != right.Rows ? left.Rows > right.Rows : left.FirstRow < right.FirstRow;
+            });
+            bursts.resize(std::min(bursts.size(), c_maxBursts));
+            return bursts;
+        }
+
+        // The row's line, cut to c_maxQuoteBytes on a character boundary.
+        std::string Quote(LogStore const& store, uint32_t row)
+        {
+            auto line = TrimView(store.Raw(row));
+            if (line.empty())
+            {
+                line = TrimView(store.Message(row));
+            }
+            if (line.size() <= c_maxQuoteBytes)
+            {
+                return std::string(line);
+            }
+            auto cut = c_maxQuoteBytes;
+            while (cut > 0 && (static_cast<unsigned char>(line[cut]) & 0xC0) == 0x80)
+            {
+                --cut;
+            }
+            return std::string(line.substr(0, cut)) + "…";
+        }
+
+        std::string Overview(LogStore const& store, RowAggregates const& aggregates, size_t templateCount)
+        {
+            std::map<std::string, size_t> levelCount(aggregates.OverflowLevelRows().begin(),
+                aggregates.OverflowLevelRows().end());
+            auto const& levelRows = aggregates.LevelRows();
+            for (size_t id = 0; id < levelRows.size(); ++id)
+            {
+                if (levelRows[id] != 0)
+                {
+                    auto const& name = store.LevelNames()[id];
+                    levelCount[name.empty() ? std::string("未标记") : name] += levelRows[id];
+                }
+            }
+
+            std::string text = "概况：";
+            if (aggregates.Rows() == store.Size())
+            {
+                text += "共 " + std::to_string(store.Size()) + " 条日志";
+            }
+            else
+            {
+                text += "当前筛选 " + std::to_string(aggregates.Rows()) + " 条日志（共 " + std::to_string(store.Size()) + " 条）";
+            }
+            text += "，" + std::to_string(templateCount) + " 个消息模板";
+            if (aggregates.FirstTime() || aggregates.LastTime())
+            {
+                text += "，时间 " + FormatDateRange(aggregates.FirstTime(), aggregates.LastTime());
+            }
+            if (!levelCount.empty())
+            {
+                text += "；级别";
+                for (auto const& [name, rows] : levelCount)
+                {
+                    text += " " + name + "=" + std::to_string(rows);
+                }
+            }
+            text += "。\n";
+            return text;
+        }
+
+        std::string When(LogStore const& store, uint32_t row)
+        {
+            auto occurredOn = store.OccurredOn(row);
+            return occurredOn ? FormatTimestamp(*occurredOn) : "第 " + std::to_string(row + 1) + " 行";
+        }
+
+        class Packer
+        {
+        public:
+            explicit Packer(size_t budget) : m_budget(budget)
+            {
+            }
+
+            // Appends block when it fits within limit tokens in all.
+            bool Append(std::string const& block, size_t limit)
+            {
+                auto tokens = EstimateTokens(block);
+                if (m_tokens + tokens > std::min(limit, m_budget))
+                {
+                    return false;
+                }
+                m_text += block;
+                m_tokens += tokens;
+                return true;
+            }
+
+            size_t Limit(double share) const
+            {
+                auto limit = static_cast<size_t>(static_cast<double>(m_budget) * share);
+                return limit > c_closingTokens ? limit - c_closingTokens : 0;
+            }
+
+            PackedContext Finish()
+            {
+                PackedContext context;
+                context.Text = std::move(m_text);
+                context.Tokens = m_tokens;
+                return context;
+            }
+
+        private:
+            size_t m_budget;
+            std::string m_text;
+            size_t m_tokens{ 0 };
+        };
+
+        template <typename RowAt>
+        PackedContext Pack(LogStore const& store, RowAggregates const& aggregates, std::vector<TemplateGroup> const& groups,
+            size_t count, RowAt rowAt, size_t tokenBudget, unsigned threadCount)
+        {
+            Packer packer(tokenBudget);
+            std::vector<uint8_t> quoted(store.Templates().Size());
+            std::vector<uint8_t> listed(store.Templates().Size());
+            size_t bursts = 0;
+            size_t templates = 0;
+            size_t examples = 0;
+            packer.Append(Overview(store, aggregates, groups.size()), packer.Limit(1.0));
+
+            std::string heading = "错误集中的时段：\n";
+            for (auto const& burst : FindBursts(store, aggregates, count, rowAt, threadCount))
+            {
+                auto block = heading + "- " + When(store, burst.FirstRow) + " 至 " + When(store, burst.LastRow) + "：" +
+                    std::to_string(burst.Rows) + " 条错误\n";
+                auto id = store.TemplateId(burst.FirstRow);
+                auto quote = !quoted[id];
+                if (quote)
+                {
+                    block += "  首条：" + Quote(store, burst.FirstRow) + "\n";
+                }
+                if (!packer.Append(block, packer.Limit(c_burstShare)))
+                {
+                    break;
+                }
+                heading.clear();
+                ++bursts;
+                if (quote)
+                {
+                    quoted[id] = 1;
+                    ++examples;
+                }
+            }
+
+            // Groups come most rows first.
+            heading = "罕见模板（由少到多，附首次出现的原文）：\n";
+            auto rare = groups.size();
+            for (; rare > 0; --rare)
+            {
+                auto const& group = groups[rare - 1];
+                auto block = heading + "- [" + std::to_string(group.Rows) + " 次] " + store.Templates().Text(group.Template) +
+                    "\n";
+                auto quote = !quoted[group.Template];
+                if (quote)
+                {
+                    block += "  首次：" + Quote(store, group.FirstRow) + "\n";
+                }
+                if (!packer.Append(block, packer.Limit(c_rareShare)))
+                {
+                    break;
+                }
+                heading.clear();
+                listed[group.Template] = 1;
+                ++templates;
+                if (quote)
+                {
+                    quoted[group.Template] = 1;
+                    ++examples;
+                }
+            }
+
+            heading = "常见模板（由多到少）：\n";
+            for (size_t index = 0; index < rare; ++index)
+            {
+                auto const& group = groups[index];
+                auto block = heading + "- [" + std::to_string(group.Rows) + " 次] " + store.Templates().Text(group.Template) +
+                    "\n";
+                if (!packer.Append(block, packer.Limit(1.0)))
+                {
+                    break;
+                }
+                heading.clear();
+                listed[group.Template] = 1;
+                ++templates;
+            }
+
+            if (templates < groups.size())
+            {
+                packer.Append("（另有 " + std::to_string(groups.size() - templates) + " 个模板未列出）\n", tokenBudget);
+            }
+
+            auto context = packer.Finish();
+            context.Bursts = bursts;
+            context.Templates = templates;
+            context.TemplateCount = groups.size();
+            context.Examples = examples;
+            return context;
+        }
+    }
+
+    size_t EstimateTokens(std::string_view text)
+    {
+        size_t asciiBytes = 0;
+        size_t characters = 0;
+        for (auto ch : text)
+        {
+            auto byte = static_cast<unsigned char>(ch);
+            if (byte < 0x80)
+            {
+                ++asciiBytes;
+            }
+            else if (byte >= 0xC0)
+            {
+                ++characters;
+            }
+        }
+        return (asciiBytes + 3) / 4 + characters;
+    }
+
+    std::string_view InterpretInstructions()
+    {
+        return "你是一名资深运维工程师。用户会给出一份日志的压缩视图：概况、错误集中的时段、"
+            "罕见与常见的消息模板（<*> 为变量）及其原文示例。请用中文给出：1. 整体运行状况；"
+            "2. 最值得关注的异常及可能原因，引用相关模板或原文；3. 建议的排查步骤。"
+            "只依据给出的内容，不确定时请说明。";
+    }
+
+    PackedContext PackContext(LogStore const& store, RowAggregates const& aggregates, std::vector<uint32_t> const& rows,
+        size_t tokenBudget, unsigned threadCount)
+    {
+        return Pack(store, aggregates, GroupByTemplate(store, rows, threadCount), rows.size(), [&](size_t index)
+        {
+            return rows[index];
+        }, tokenBudget, threadCount);
+    }
+
+    PackedContext PackContext(LogStore const& store, size_t tokenBudget, unsigned threadCount)
+    {
+        return Pack(store, store.Aggregates(), GroupByTemplate(store, threadCount), store.Size(), [](size_t index)
+        {
+            return static_cast<uint32_t>(index);
+        }, tokenBudget, threadCount);
+    }
+}
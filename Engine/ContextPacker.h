@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace LogMinds::Engine
+{
+    class LogStore;
+    class RowAggregates;
+
+    struct PackedContext
+    {
+        std::string Text;
+        // EstimateTokens of Text; at most the budget it was packed for.
+        size_t Tokens{ 0 };
+        size_t Bursts{ 0 };
+        // Templates listed, out of TemplateCount among the rows.
+        size_t Templates{ 0 };
+        size_t TemplateCount{ 0 };
+        // Log lines quoted, each the first of its template.
+        size_t Examples{ 0 };
+    };
+
+    // About what a BPE tokenizer makes of text: a token per four bytes of
+    // ASCII and one per other character, so CJK text is not undercounted.
+    size_t EstimateTokens(std::string_view text);
+
+    // The system prompt a packed context is sent with.
+    std::string_view InterpretInstructions();
+
+    // Describes the (ascending) rows of store for an LLM in at most
+    // tokenBudget tokens: an overview from the aggregates, the time windows
+    // where error rows cluster most, then the rarest templates with the
+    // first line of each, then the most common ones. No line or template
+    // is given twice. Apart from the lines quoted, the rows are only read
+    // through their template id, level and time, split across threadCount
+    // workers (0 = one per hardware thread).
+    PackedContext PackContext(LogStore const& store, RowAggregates const& aggregates, std::vector<uint32_t> const& rows,
+        size_t tokenBudget, unsigned threadCount = 0);
+    // Same, over every row.
+    PackedContext PackContext(LogStore const& store, size_t tokenBudget, unsigned threadCount = 0);
+}
@@ -0,0 +1,271 @@
+#include "Decompressor.h"
+
+#if defined(LOGMINDS_HAVE_ZLIB)
+#include <zlib.h>
+#endif
+#if defined(LOGMINDS_HAVE_ZSTD)
+#include <zstd.h>
+#endif
+
+#include <algorithm>
+#include <climits>
+
+namespace LogMinds::Engine
+{
+    Compression DetectCompression(std::string_view data)
+    {
+        if (data.substr(0, 2) == "\x1F\x8B")
+        {
+            return Compression::Gzip;
+        }
+        if (data.substr(0, 4) == "\x28\xB5\x2F\xFD")
+        {
+            return Compression::Zstd;
+        }
+        return Compression::None;
+    }
+
+    std::string_view CompressionName(Compression compression)
+    {
+        switch (compression)
+        {
+        case Compression::Gzip:
+            return "gzip";
+        case Compression::Zstd:
+            return "zstd";
+        default:
+            return "none";
+        }
+    }
+
+    bool IsCompressionSupported(Compression compression)
+    {
+        switch (compression)
+        {
+        case Compression::None:
+            return true;
+        case Compression::Gzip:
+#if defined(LOGMINDS_HAVE_ZLIB)
+            return true;
+#else
+            return false;
+#endif
+        case Compression::Zstd:
+#if defined(LOGMINDS_HAVE_ZSTD)
+            return true;
+#else
+            return false;
+#endif
+        }
+        return false;
+    }
+
+    Decompressor::Decompressor(std::string_view compressed, Compression compression) :
+        m_compressed(compressed), m_compression(compression)
+    {
+        m_thread = std::thread([this]()
+        {
+            Run();
+        });
+    }
+
+    Decompressor::~Decompressor()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopping = true;
+        }
+        m_changed.notify_all();
+        m_thread.join();
+    }
+
+    bool Decompressor::Next(std::string& buffer)
+    {
+        std::unique_lock lock(m_mutex);
+        if (buffer.capacity() != 0)
+        {
+            buffer.clear();
+            m_free.push_back(std::move(buffer));
+            m_changed.notify_all();
+        }
+        m_changed.wait(lock, [this]()
+        {
+            return !m_full.empty() || m_finished;
+        });
+        if (m_full.empty())
+        {
+            buffer.clear();
+            return false;
+        }
+        buffer = std::move(m_full.front());
+        m_full.pop_front();
+        m_changed.notify_all();
+        return true;
+    }
+
+    bool Decompressor::Publish(std::string& buffer)
+    {
+        std::unique_lock lock(m_mutex);
+        m_changed.wait(lock, [this]()
+        {
+            return m_stopping || m_full.size() < c_queueDepth;
+        });
+        if (m_stopping)
+        {
+            return false;
+        }
+        m_full.push_back(std::move(buffer));
+        m_changed.notify_all();
+
+        if (!m_free.empty())
+        {
+            buffer = std::move(m_free.back());
+            m_free.pop_back();
+        }
+        else
+        {
+            buffer = std::string();
+            buffer.reserve(c_bufferBytes);
+        }
+        return true;
+    }
+
+    void Decompressor::Run()
+    {
+        std::string buffer;
+        buffer.reserve(c_bufferBytes);
+        std::string error;
+        bool delivered = true;
+        switch (m_compression)
+        {
+        case Compression::Gzip:
+            delivered = InflateGzip(buffer, error);
+            break;
+        case Compression::Zstd:
+            delivered = DecompressZstd(buffer, error);
+            break;
+        default:
+            error = "not a compressed stream";
+            break;
+        }
+        if (delivered && !buffer.empty())
+        {
+            Publish(buffer);
+        }
+
+        std::lock_guard lock(m_mutex);
+        m_error = std::move(error);
+        m_finished = true;
+        m_changed.notify_all();
+    }
+
+    // Both decoders write straight into the spare capacity of buffer and
+    // publish it once full. They return false when the reader stopped.
+
+    bool Decompressor::InflateGzip(std::string& buffer, std::string& error)
+    {
+#if defined(LOGMINDS_HAVE_ZLIB)
+        z_stream stream{};
+        // 15 + 32: a 32 KB window, gzip or zlib header detected automatically.
+        if (inflateInit2(&stream, 15 + 32) != Z_OK)
+        {
+            error = "inflateInit2 failed";
+            return true;
+        }
+
+        auto input = m_compressed;
+        auto status = Z_OK;
+        while (true)
+        {
+            if (stream.avail_in == 0)
+            {
+                auto take = std::min<size_t>(input.size(), UINT_MAX);
+                stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+                stream.avail_in = static_cast<uInt>(take);
+                input.remove_prefix(take);
+            }
+
+            auto used = buffer.size();
+            buffer.resize(c_bufferBytes);
+            stream.next_out = reinterpret_cast<Bytef*>(buffer.data() + used);
+            stream.avail_out = static_cast<uInt>(c_bufferBytes - used);
+            status = inflate(&stream, Z_NO_FLUSH);
+            buffer.resize(c_bufferBytes - stream.avail_out);
+
+            if (buffer.size() == c_bufferBytes && !Publish(buffer))
+            {
+                inflateEnd(&stream);
+                return false;
+            }
+            if (status == Z_STREAM_END)
+            {
+                // Another gzip member may follow (as `cat a.gz b.gz` makes);
+                // anything else after the end, such as padding, is ignored.
+                auto rest = stream.avail_in != 0
+                    ? std::string_view(reinterpret_cast<char const*>(stream.next_in), stream.avail_in)
+                    : input;
+                if (DetectCompression(rest) != Compression::Gzip)
+                {
+                    break;
+                }
+                inflateReset(&stream);
+            }
+            else if (status == Z_BUF_ERROR && stream.avail_in == 0 && input.empty())
+            {
+                error = "gzip stream is truncated";
+                break;
+            }
+            else if (status != Z_OK && status != Z_BUF_ERROR)
+            {
+                error = std::string("gzip stream is corrupt: ") + (stream.msg ? stream.msg : "inflate failed");
+                break;
+            }
+        }
+        inflateEnd(&stream);
+        return true;
+#else
+        (void)buffer;
+        error = "this build cannot read gzip files";
+        return true;
+#endif
+    }
+
+    bool Decompressor::DecompressZstd(std::string& buffer, std::string& error)
+    {
+#if defined(LOGMINDS_HAVE_ZSTD)
+        auto* stream = ZSTD_createDStream();
+        ZSTD_inBuffer input{ m_compressed.data(), m_compressed.size(), 0 };
+        // Zero once the last frame was fully decoded and flushed.
+        size_t pending = 1;
+        while (input.pos < input.size || pending != 0)
+        {
+            auto used = buffer.size();
+            buffer.resize(c_bufferBytes);
+            ZSTD_outBuffer output{ buffer.data(), c_bufferBytes, used };
+            pending = ZSTD_decompressStream(stream, &output, &input);
+            buffer.resize(output.pos);
+            if (ZSTD_isError(pending))
+            {
+                error = std::string("zstd stream is corrupt: ") + ZSTD_getErrorName(pending);
+                break;
+            }
+            if (buffer.size() == c_bufferBytes && !Publish(buffer))
+            {
+                ZSTD_freeDStream(stream);
+                return false;
+            }
+            if (input.pos == input.size && pending != 0 && output.pos < output.size)
+            {
+                error = "zstd stream is truncated";
+                break;
+            }
+        }
+        ZSTD_freeDStream(stream);
+        return true;
+#else
+        (void)buffer;
+        error = "this build cannot read zstd files";
+        return true;
+#endif
+    }
+}
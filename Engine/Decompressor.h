@@ -0,0 +1,77 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace LogMinds::Engine
+{
+    enum class Compression
+    {
+        None,
+        Gzip,
+        Zstd,
+    };
+
+    // Recognized by the magic bytes at the start, not by the file extension.
+    Compression DetectCompression(std::string_view data);
+    std::string_view CompressionName(Compression compression);
+    // False when the engine was built without the library for it.
+    bool IsCompressionSupported(Compression compression);
+
+    // Decompresses a gzip or zstd stream (concatenated members and frames
+    // included) on a thread of its own into fixed-size buffers, which reach
+    // the reader through a bounded queue: the decompressor waits while
+    // c_queueDepth buffers are full, so the two overlap without the output
+    // piling up. Buffers are recycled between the two sides.
+    class Decompressor
+    {
+    public:
+        static constexpr size_t c_bufferBytes = 4 << 20;
+        static constexpr size_t c_queueDepth = 4;
+
+        // compressed must stay valid until the decompressor is destroyed.
+        Decompressor(std::string_view compressed, Compression compression);
+        ~Decompressor();
+
+        Decompressor(Decompressor const&) = delete;
+        Decompressor& operator=(Decompressor const&) = delete;
+
+        // Replaces buffer with the next piece of output; the old contents are
+        // handed back for reuse. False once the stream is done.
+        bool Next(std::string& buffer);
+
+        // Set when the stream was corrupt, truncated or not supported; the
+        // output up to that point was still delivered. Valid after Next
+        // returned false.
+        std::string const& Error() const
+        {
+            return m_error;
+        }
+
+    private:
+        std::string_view m_compressed;
+        Compression m_compression;
+
+        std::mutex m_mutex;
+        std::condition_variable m_changed;
+        std::deque<std::string> m_full;
+        std::vector<std::string> m_free;
+        bool m_finished{ false };
+        bool m_stopping{ false };
+        std::string m_error;
+        std::thread m_thread;
+
+        void Run();
+        // Hands a filled buffer to the reader and returns an empty one;
+        // false when the reader has gone away.
+        bool Publish(std::string& buffer);
+        bool InflateGzip(std::string& buffer, std::string& error);
+        bool DecompressZstd(std::string& buffer, std::string& error);
+    };
+}
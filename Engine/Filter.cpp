@@ -0,0 +1,368 @@
+#include "Filter.h"
+
+#include "AttributeIndex.h"
+#include "Parallel.h"
+#include "TextSearch.h"
+#include "TrigramIndex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+
+namespace LogMinds::Engine
+{
+    namespace
+    {
+        struct TermSearch
+        {
+            CaseInsensitiveMatcher Matcher;
+            // Per source id, whether the source contains the term; empty
+            // when sources are to be searched row by row.
+            std::vector<uint8_t> SourceMatches;
+        };
+
+        TermSearch PrepareSearch(LogStore const& store, std::string const& term)
+        {
+            TermSearch search{ CaseInsensitiveMatcher(term), {} };
+            if (!term.empty())
+            {
+                search.SourceMatches.reserve(store.SourceNames().size());
+                for (auto const& name : store.SourceNames())
+                {
+                    search.SourceMatches.push_back(search.Matcher.FoundIn(name) ? 1 : 0);
+                }
+            }
+            return search;
+        }
+
+        bool ContainsTerm(LogStore const& store, size_t row, TermSearch const& search)
+        {
+            auto const& matcher = search.Matcher;
+            if (search.SourceMatches.empty() ? matcher.FoundIn(store.Source(row)) :
+                search.SourceMatches[store.SourceId(row)] != 0)
+            {
+                return true;
+            }
+
+            // A field cut out of the raw line can only match where the raw
+            // line matches too, so only fields stored separately are searched
+            // besides it.
+            auto raw = store.Raw(row);
+            for (auto field : { LogField::Message, LogField::Context })
+            {
+                auto text = store.Text(row, field);
+                auto insideRaw = text.data() >= raw.data() && text.data() + text.size() <= raw.data() + raw.size();
+                if (!insideRaw && matcher.FoundIn(text))
+                {
+                    return true;
+                }
+            }
+            return matcher.FoundIn(raw);
+        }
+
+        // The query's level and origin as the store's dictionary ids, so that
+        // rows are compared by id rather than by name.
+        struct QueryIds
+        {
+            // Unset when no row that fits the level table has the level.
+            std::optional<uint8_t> Level;
+            std::optional<uint16_t> Origin;
+        };
+
+        // False when no row of store can match the level or the origin.
+        bool ResolveIds(LogStore const& store, FilterQuery const& query, QueryIds& ids)
+        {
+            if (!query.Level.empty())
+            {
+                ids.Level = store.FindLevel(query.Level);
+                if (!ids.Level && !store.HasLevelOverflow())
+                {
+                    return false;
+                }
+            }
+            if (!query.Origin.empty())
+            {
+                ids.Origin = store.FindOrigin(query.Origin);
+                if (!ids.Origin)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Only rows whose level did not fit the table are compared by name.
+        inline bool MatchesIds(LogStore const& store, size_t row, FilterQuery const& query, QueryIds const& ids)
+        {
+            if (!query.Level.empty())
+            {
+                auto level = store.LevelId(row);
+                if (level == LogStore::c_overflowLevel ? store.Level(row) != query.Level : ids.Level != level)
+                {
+                    return false;
+                }
+            }
+            return query.Origin.empty() || ids.Origin == store.OriginId(row);
+        }
+
+        // The rest of the query, for rows that passed MatchesIds.
+        bool MatchesRow(LogStore const& store, size_t row, FilterQuery const& query, TermSearch const& search)
+        {
+            if (query.Template && store.TemplateId(row) != *query.Template)
+            {
+                return false;
+            }
+
+            if (!query.SearchTerm.empty() && !ContainsTerm(store, row, search))
+            {
+                return false;
+            }
+
+            if (query.StartTime || query.EndTime)
+            {
+                auto occurredOn = store.OccurredOn(row);
+                if (!occurredOn)
+                {
+                    return false;
+                }
+                if (query.StartTime && *occurredOn < *query.StartTime)
+                {
+                    return false;
+                }
+                if (query.EndTime && *occurredOn > *query.EndTime)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        // Rows between two looks at the cancellation token.
+        constexpr size_t c_cancelCheckRows = 4096;
+        // Rows per unit of parallel work. Idle workers keep claiming the next
+        // morsel, so a slow stretch of rows does not hold the others back.
+        constexpr size_t c_morselRows = 16384;
+
+        template <typename RowAt>
+        std::optional<std::vector<uint32_t>> FilterRows(LogStore const& store, FilterQuery const& query, size_t count,
+            RowAt rowAt, CancellationToken const& cancel, unsigned threadCount)
+        {
+            QueryIds ids;
+            if (!ResolveIds(store, query, ids))
+            {
+                return std::vector<uint32_t>();
+            }
+
+            auto search = PrepareSearch(store, query.SearchTerm);
+            auto scan = [&](size_t begin, size_t end, std::vector<uint32_t>& selection)
+            {
+                for (auto index = begin; index < end; ++index)
+                {
+                    if ((index - begin) % c_cancelCheckRows == 0 && cancel.IsCancelled())
+                    {
+                        return false;
+                    }
+                    auto row = rowAt(index);
+                    if (MatchesIds(store, row, query, ids) && MatchesRow(store, row, query, search))
+                    {
+                        selection.push_back(row);
+                    }
+                }
+                return true;
+            };
+
+            auto morselCount = (count + c_morselRows - 1) / c_morselRows;
+            if (morselCount <= 1 || ResolveThreadCount(threadCount) == 1)
+            {
+                std::vector<uint32_t> selection;
+                if (!scan(0, count, selection))
+                {
+                    return std::nullopt;
+                }
+                return selection;
+            }
+
+            // Morsels are contiguous and in order, so concatenating their
+            // selections gives the same rows as the sequential scan.
+            std::vector<std::vector<uint32_t>> morsels(morselCount);
+            std::atomic<bool> cancelled{ false };
+            ParallelFor(morselCount, threadCount, [&](size_t morsel)
+            {
+                if (cancelled.load(std::memory_order_relaxed))
+                {
+                    return;
+                }
+                auto begin = morsel * c_morselRows;
+                if (!scan(begin, std::min(count, begin + c_morselRows), morsels[morsel]))
+                {
+                    cancelled.store(true, std::memory_order_relaxed);
+                }
+            });
+            if (cancelled.load())
+            {
+                return std::nullopt;
+            }
+
+            size_t total = 0;
+            for (auto const& part : morsels)
+            {
+                total += part.size();
+            }
+            std::vector<uint32_t> selection;
+            selection.reserve(total);
+            for (auto const& part : morsels)
+            {
+                selection.insert(selection.end(), part.begin(), part.end());
+            }
+            return selection;
+        }
+    }
+
+    bool Matches(LogStore const& store, size_t row, FilterQuery const& query)
+    {
+        QueryIds ids;
+        return ResolveIds(store, query, ids) && MatchesIds(store, row, query, ids) &&
+            MatchesRow(store, row, query, TermSearch{ CaseInsensitiveMatcher(query.SearchTerm), {} });
+    }
+
+    std::vector<uint32_t> ApplyFilter(LogStore const& store, FilterQuery const& query, unsigned threadCount)
+    {
+        return *FilterRows(store, query, store.Size(), [](size_t index)
+        {
+            return static_cast<uint32_t>(index);
+        }, CancellationToken(), threadCount);
+    }
+
+    std::vector<uint32_t> ApplyFilter(LogStore const& store, FilterQuery const& query,
+        std::vector<uint32_t> const& candidates, unsigned threadCount)
+    {
+        return *FilterRows(store, query, candidates.size(), [&](size_t index)
+        {
+            return candidates[index];
+        }, CancellationToken(), threadCount);
+    }
+
+    bool IsRefinement(FilterQuery const& narrower, FilterQuery const& wider)
+    {
+        if (narrower.SearchTerm.find(wider.SearchTerm) == std::string::npos)
+        {
+            return false;
+        }
+        if (!wider.Level.empty() && narrower.Level != wider.Level)
+        {
+            return false;
+        }
+        if (!wider.Origin.empty() && narrower.Origin != wider.Origin)
+        {
+            return false;
+        }
+        if (wider.Template && narrower.Template != wider.Template)
+        {
+            return false;
+        }
+        if (wider.StartTime && (!narrower.StartTime || *narrower.StartTime < *wider.StartTime))
+        {
+            return false;
+        }
+        if (wider.EndTime && (!narrower.EndTime || *narrower.EndTime > *wider.EndTime))
+        {
+            return false;
+        }
+        return true;
+    }
+
+    std::vector<uint32_t> IncrementalFilter::Apply(LogStore const& store, FilterQuery const& query,
+        TrigramIndex const* index, AttributeIndex const* attributes)
+    {
+        return *TryApply(store, query, index, attributes, CancellationToken());
+    }
+
+    std::optional<std::vector<uint32_t>> IncrementalFilter::TryApply(LogStore const& store, FilterQuery const& query,
+        TrigramIndex const* index, AttributeIndex const* attributes, CancellationToken const& cancel)
+    {
+        auto intersect = [](std::optional<std::vector<uint32_t>>& rows, std::vector<uint32_t> const& other)
+        {
+            std::vector<uint32_t> narrowed;
+            std::set_intersection(rows->begin(), rows->end(), other.begin(), other.end(), std::back_inserter(narrowed));
+            rows = std::move(narrowed);
+        };
+
+        std::optional<std::vector<uint32_t>> candidates;
+        if (index && index->Rows() == store.Size() && !query.SearchTerm.empty())
+        {
+            candidates = index->Candidates(query.SearchTerm);
+        }
+
+        // Level and time range rows from the attribute index are exact, so
+        // without a search term, origin or template they are the selection.
+        std::optional<std::vector<uint32_t>> attributeRows;
+        if (attributes && attributes->Rows() == store.Size())
+        {
+            attributeRows = attributes->Select(store, query);
+        }
+        auto exact = attributeRows && query.SearchTerm.empty() && query.Origin.empty() && !query.Template;
+        if (candidates && attributeRows)
+        {
+            intersect(candidates, *attributeRows);
+        }
+        else if (attributeRows)
+        {
+            candidates = std::move(attributeRows);
+        }
+
+        auto refines = m_query && m_store == &store && m_storeSize == store.Size() && IsRefinement(query, *m_query);
+        if (refines && candidates)
+        {
+            intersect(candidates, m_selection);
+        }
+
+        if (exact)
+        {
+            m_lastScannedRows = 0;
+            m_selection = std::move(*candidates);
+            m_query = query;
+            m_store = &store;
+            m_storeSize = store.Size();
+            return m_selection;
+        }
+
+        // m_selection stays intact until the scan has finished, so a
+        // cancelled scan leaves nothing to undo.
+        auto const* rows = candidates ? &*candidates : refines ? &m_selection : nullptr;
+        std::optional<std::vector<uint32_t>> selection;
+        if (rows)
+        {
+            selection = FilterRows(store, query, rows->size(), [&](size_t position)
+            {
+                return (*rows)[position];
+            }, cancel, m_threadCount);
+        }
+        else
+        {
+            selection = FilterRows(store, query, store.Size(), [](size_t position)
+            {
+                return static_cast<uint32_t>(position);
+            }, cancel, m_threadCount);
+        }
+        if (!selection)
+        {
+            return std::nullopt;
+        }
+
+        m_lastScannedRows = rows ? rows->size() : store.Size();
+        m_selection = std::move(*selection);
+        m_query = query;
+        m_store = &store;
+        m_storeSize = store.Size();
+        return m_selection;
+    }
+
+    void IncrementalFilter::Reset()
+    {
+        m_query.reset();
+        m_selection = {};
+        m_store = nullptr;
+        m_storeSize = 0;
+    }
+}
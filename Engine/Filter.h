@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Cancellation.h"
+#include "LogStore.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace LogMinds::Engine
+{
+    class AttributeIndex;
+    class TrigramIndex;
+
+    struct FilterQuery
+    {
+        // Already lower-cased; matched against message, context, source and raw text.
+        std::string SearchTerm;
+        // Normalized level name; empty selects every level.
+        std::string Level;
+        // Origin file name; empty selects every file.
+        std::string Origin;
+        // Template id in the store (LogStore::TemplateId); unset selects every template.
+        std::optional<uint32_t> Template;
+        std::optional<int64_t> StartTime;
+        std::optional<int64_t> EndTime;
+    };
+
+    bool Matches(LogStore const& store, size_t row, FilterQuery const& query);
+    // Rows are scanned in morsels spread over threadCount workers (0 = one
+    // per hardware thread); the selection is the same for any thread count.
+    std::vector<uint32_t> ApplyFilter(LogStore const& store, FilterQuery const& query, unsigned threadCount = 0);
+    // Same, but only the (ascending) candidate rows are tested.
+    std::vector<uint32_t> ApplyFilter(LogStore const& store, FilterQuery const& query,
+        std::vector<uint32_t> const& candidates, unsigned threadCount = 0);
+
+    // True when every row matching `narrower` also matches `wider`: the
+    // search term extends the old one, a level, origin or template was added
+    // or kept, and the time range shrank or stayed.
+    bool IsRefinement(FilterQuery const& narrower, FilterQuery const& wider);
+
+    // Remembers the last query and its selection so that a refining query
+    // (typing another character, narrowing the range, picking a level)
+    // rescans only the surviving rows. Anything else is a full scan. With a
+    // trigram index of the store, search terms of three or more bytes only
+    // test the index candidates; with an attribute index, level and time
+    // range conditions resolve without a scan.
+    class IncrementalFilter
+    {
+    public:
+        explicit IncrementalFilter(unsigned threadCount = 0) : m_threadCount(threadCount)
+        {
+        }
+
+        std::vector<uint32_t> Apply(LogStore const& store, FilterQuery const& query,
+            TrigramIndex const* index = nullptr, AttributeIndex const* attributes = nullptr);
+        // Same, but gives up with std::nullopt once cancel fires; the
+        // previous result is then kept for the next query to refine.
+        std::optional<std::vector<uint32_t>> TryApply(LogStore const& store, FilterQuery const& query,
+            TrigramIndex const* index, AttributeIndex const* attributes, CancellationToken const& cancel);
+
+        // Forgets the previous result; call whenever the store is replaced.
+        void Reset();
+
+        // Rows tested by the last Apply, for diagnostics.
+        size_t LastScannedRows() const
+        {
+            return m_lastScannedRows;
+        }
+
+    private:
+        std::optional<FilterQuery> m_query;
+        std::vector<uint32_t> m_selection;
+        LogStore const* m_store{ nullptr };
+        size_t m_storeSize{ 0 };
+        size_t m_lastScannedRows{ 0 };
+        unsigned m_threadCount;
+    };
+}
@@ -0,0 +1,95 @@
+#include "FilterWorker.h"
+
+namespace LogMinds::Engine
+{
+    FilterWorker::FilterWorker(ResultHandler onResult, Clock::duration debounce) :
+        m_onResult(std::move(onResult)), m_debounce(debounce)
+    {
+        m_thread = std::thread([this]()
+        {
+            Run();
+        });
+    }
+
+    FilterWorker::~FilterWorker()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopping = true;
+            m_pending.reset();
+        }
+        m_generations.Advance();
+        m_wake.notify_one();
+        m_thread.join();
+    }
+
+    uint64_t FilterWorker::Submit(std::shared_ptr<LogStore const> store, std::shared_ptr<TrigramIndex const> index,
+        std::shared_ptr<AttributeIndex const> attributes, FilterQuery query)
+    {
+        uint64_t generation = 0;
+        {
+            std::lock_guard lock(m_mutex);
+            generation = m_generations.Advance();
+            m_pending = Request{ generation, std::move(store), std::move(index), std::move(attributes), std::move(query),
+                Clock::now() };
+        }
+        m_wake.notify_one();
+        return generation;
+    }
+
+    void FilterWorker::Cancel()
+    {
+        std::lock_guard lock(m_mutex);
+        m_pending.reset();
+        m_generations.Advance();
+    }
+
+    void FilterWorker::Run()
+    {
+        std::unique_lock lock(m_mutex);
+        while (true)
+        {
+            m_wake.wait(lock, [this]()
+            {
+                return m_stopping || m_pending;
+            });
+
+            // Wait until the newest request has been left alone for the
+            // debounce window.
+            while (!m_stopping && m_pending && Clock::now() < m_pending->SubmittedAt + m_debounce)
+            {
+                m_wake.wait_until(lock, m_pending->SubmittedAt + m_debounce);
+            }
+            if (m_stopping)
+            {
+                return;
+            }
+
+            auto request = std::move(*m_pending);
+            m_pending.reset();
+            lock.unlock();
+
+            if (request.Store != m_filteredStore)
+            {
+                m_filter.Reset();
+                m_filteredStore = request.Store;
+            }
+            auto rows = m_filter.TryApply(*request.Store, request.Query, request.Index.get(), request.Attributes.get(),
+                m_generations.Token(request.Generation));
+            if (rows)
+            {
+                // Selecting every row needs no second look at them.
+                auto aggregates = rows->size() == request.Store->Size() ? request.Store->Aggregates() :
+                    RowAggregates::Of(*request.Store, *rows);
+                m_onResult(FilterResult{ request.Generation, std::move(*rows), m_filter.LastScannedRows(),
+                    std::move(aggregates), request.SubmittedAt });
+            }
+            else
+            {
+                m_cancelledScans.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            lock.lock();
+        }
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "AttributeIndex.h"
+#include "Cancellation.h"
+#include "Filter.h"
+#include "LogStore.h"
+#include "RowAggregates.h"
+#include "TrigramIndex.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace LogMinds::Engine
+{
+    struct FilterResult
+    {
+        uint64_t Generation{ 0 };
+        std::vector<uint32_t> Rows;
+        size_t ScannedRows{ 0 };
+        // Over Rows; what the summary of the filtered view is made of.
+        RowAggregates Aggregates;
+        // When the query was submitted; now minus this is the
+        // keystroke-to-result latency.
+        std::chrono::steady_clock::time_point SubmittedAt;
+    };
+
+    // Filters on a background thread, one query at a time. Every Submit
+    // starts a new generation: a query that was not picked up yet is
+    // replaced, queries arriving within the debounce window of each other
+    // are coalesced into the last one, and a scan still running for an older
+    // generation is cancelled. The handler runs on the worker thread and only
+    // sees completed scans; a result can still be overtaken by a Submit made
+    // while it was on its way, which IsCurrent tells.
+    class FilterWorker
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+        using ResultHandler = std::function<void(FilterResult&& result)>;
+
+        static constexpr std::chrono::milliseconds c_defaultDebounce{ 40 };
+
+        explicit FilterWorker(ResultHandler onResult, Clock::duration debounce = c_defaultDebounce);
+        ~FilterWorker();
+
+        FilterWorker(FilterWorker const&) = delete;
+        FilterWorker& operator=(FilterWorker const&) = delete;
+
+        // Either index may be null (not built yet); the store and the indexes
+        // are kept alive until the scan is done.
+        uint64_t Submit(std::shared_ptr<LogStore const> store, std::shared_ptr<TrigramIndex const> index,
+            std::shared_ptr<AttributeIndex const> attributes, FilterQuery query);
+
+        // Drops the query not picked up yet and cancels the running scan, for
+        // when the store is replaced without a new query; results already on
+        // their way stop being current.
+        void Cancel();
+
+        bool IsCurrent(uint64_t generation) const
+        {
+            return m_generations.IsCurrent(generation);
+        }
+
+        // Scans abandoned because a newer query arrived.
+        size_t CancelledScans() const
+        {
+            return m_cancelledScans.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Request
+        {
+            uint64_t Generation{ 0 };
+            std::shared_ptr<LogStore const> Store;
+            std::shared_ptr<TrigramIndex const> Index;
+            std::shared_ptr<AttributeIndex const> Attributes;
+            FilterQuery Query;
+            Clock::time_point SubmittedAt;
+        };
+
+        ResultHandler m_onResult;
+        Clock::duration m_debounce;
+        GenerationCounter m_generations;
+        std::atomic<size_t> m_cancelledScans{ 0 };
+
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::optional<Request> m_pending;
+        bool m_stopping{ false };
+
+        // Touched by the worker thread only. The store is held so that its
+        // address, which IncrementalFilter keys on, cannot be reused.
+        IncrementalFilter m_filter;
+        std::shared_ptr<LogStore const> m_filteredStore;
+
+        std::thread m_thread;
+
+        void Run();
+    };
+}
@@ -0,0 +1,743 @@
+#include "Json.h"
+
+#include "Text.h"
+
+#include <charconv>
+#include <cstdlib>
+
+namespace LogMinds::Engine
+{
+    namespace
+    {
+        constexpr int c_maxDepth = 256;
+
+        int HexValue(char ch)
+        {
+            if (ch >= '0' && ch <= '9')
+            {
+                return ch - '0';
+            }
+            if (ch >= 'a' && ch <= 'f')
+            {
+                return ch - 'a' + 10;
+            }
+            if (ch >= 'A' && ch <= 'F')
+            {
+                return ch - 'A' + 10;
+            }
+            return -1;
+        }
+
+        void AppendNumber(std::string& output, double value)
+        {
+            char buffer[32];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            output.append(buffer, result.ptr);
+        }
+    }
+
+    class JsonParser
+    {
+    public:
+        explicit JsonParser(std::string_view text) : m_text(text) {}
+
+        bool ParseDocument(JsonValue& value)
+        {
+            SkipWhitespace();
+            if (!ParseValue(value, 0))
+            {
+                return false;
+            }
+            SkipWhitespace();
+            return m_offset == m_text.size();
+        }
+
+        // Entry points for JsonObjectReader, which walks the object itself
+        // and hands only escaped strings and non-string values over.
+        bool ParseStringAt(size_t& offset, std::string& output)
+        {
+            m_offset = offset;
+            auto parsed = ParseString(output);
+            offset = m_offset;
+            return parsed;
+        }
+
+        bool ParseValueAt(size_t& offset, JsonValue& value, int depth)
+        {
+            m_offset = offset;
+            auto parsed = ParseValue(value, depth);
+            offset = m_offset;
+            return parsed;
+        }
+
+    private:
+        std::string_view m_text;
+        size_t m_offset{ 0 };
+
+        void SkipWhitespace()
+        {
+            while (m_offset < m_text.size())
+            {
+                char ch = m_text[m_offset];
+                if (ch != ' ' && ch != '\t' && ch != '\n' && ch != '\r')
+                {
+                    break;
+                }
+                ++m_offset;
+            }
+        }
+
+        bool Consume(std::string_view literal)
+        {
+            if (m_text.substr(m_offset, literal.size()) != literal)
+            {
+                return false;
+            }
+            m_offset += literal.size();
+            return true;
+        }
+
+        bool ParseValue(JsonValue& value, int depth)
+        {
+            if (m_offset >= m_text.size() || depth > c_maxDepth)
+            {
+                return false;
+            }
+
+            switch (m_text[m_offset])
+            {
+            case '{':
+                return ParseObject(value, depth);
+            case '[':
+                return ParseArray(value, depth);
+            case '"':
+                value.m_type = JsonValueType::String;
+                return ParseString(value.m_string);
+            case 't':
+                value.m_type = JsonValueType::Boolean;
+                value.m_boolean = true;
+                return Consume("true");
+            case 'f':
+                value.m_type = JsonValueType::Boolean;
+                value.m_boolean = false;
+                return Consume("false");
+            case 'n':
+                value.m_type = JsonValueType::Null;
+                return Consume("null");
+            default:
+                return ParseNumber(value);
+            }
+        }
+
+        bool ParseObject(JsonValue& value, int depth)
+        {
+            value.m_type = JsonValueType::Object;
+            ++m_offset;
+            SkipWhitespace();
+            if (m_offset < m_text.size() && m_text[m_offset] == '}')
+            {
+                ++m_offset;
+                return true;
+            }
+
+            while (true)
+            {
+                SkipWhitespace();
+                if (m_offset >= m_text.size() || m_text[m_offset] != '"')
+                {
+                    return false;
+                }
+
+                JsonMember member;
+                if (!ParseString(member.Key))
+                {
+                    return false;
+                }
+                SkipWhitespace();
+                if (m_offset >= m_text.size() || m_text[m_offset] != ':')
+                {
+                    return false;
+                }
+                ++m_offset;
+                SkipWhitespace();
+                if (!ParseValue(member.Value, depth + 1))
+                {
+                    return false;
+                }
+                value.m_members.push_back(std::move(member));
+
+                SkipWhitespace();
+                if (m_offset >= m_text.size())
+                {
+                    return false;
+                }
+                if (m_text[m_offset] == ',')
+                {
+                    ++m_offset;
+                    continue;
+                }
+                if (m_text[m_offset] == '}')
+                {
+                    ++m_offset;
+                    return true;
+                }
+                return false;
+            }
+        }
+
+        bool ParseArray(JsonValue& value, int depth)
+        {
+            value.m_type = JsonValueType::Array;
+            ++m_offset;
+            SkipWhitespace();
+            if (m_offset < m_text.size() && m_text[m_offset] == ']')
+            {
+                ++m_offset;
+                return true;
+            }
+
+            while (true)
+            {
+                SkipWhitespace();
+                JsonValue item;
+                if (!ParseValue(item, depth + 1))
+                {
+                    return false;
+                }
+                value.m_items.push_back(std::move(item));
+
+                SkipWhitespace();
+                if (m_offset >= m_text.size())
+                {
+                    return false;
+                }
+                if (m_text[m_offset] == ',')
+                {
+                    ++m_offset;
+                    continue;
+                }
+                if (m_text[m_offset] == ']')
+                {
+                    ++m_offset;
+                    return true;
+                }
+                return false;
+            }
+        }
+
+        bool ParseHex4(char32_t& codePoint)
+        {
+            if (m_offset + 4 > m_text.size())
+            {
+                return false;
+            }
+            codePoint = 0;
+            for (int i = 0; i < 4; ++i)
+            {
+                auto digit = HexValue(m_text[m_offset + i]);
+                if (digit < 0)
+                {
+                    return false;
+                }
+                codePoint = (codePoint << 4) | static_cast<char32_t>(digit);
+            }
+            m_offset += 4;
+            return true;
+        }
+
+        bool ParseString(std::string& output)
+        {
+            ++m_offset;
+            while (m_offset < m_text.size())
+            {
+                char ch = m_text[m_offset++];
+                if (ch == '"')
+                {
+                    return true;
+                }
+                if (static_cast<unsigned char>(ch) < 0x20)
+                {
+                    return false;
+                }
+                if (ch != '\\')
+                {
+                    output.push_back(ch);
+                    continue;
+                }
+
+                if (m_offset >= m_text.size())
+                {
+                    return false;
+                }
+                char escape = m_text[m_offset++];
+                switch (escape)
+                {
+                case '"':
+                case '\\':
+                case '/':
+                    output.push_back(escape);
+                    break;
+                case 'b':
+                    output.push_back('\b');
+                    break;
+                case 'f':
+                    output.push_back('\f');
+                    break;
+                case 'n':
+                    output.push_back('\n');
+                    break;
+                case 'r':
+                    output.push_back('\r');
+                    break;
+                case 't':
+                    output.push_back('\t');
+                    break;
+                case 'u':
+                {
+                    char32_t codePoint = 0;
+                    if (!ParseHex4(codePoint))
+                    {
+                        return false;
+                    }
+                    if (codePoint >= 0xD800 && codePoint <= 0xDBFF && Consume("\\u"))
+                    {
+                        char32_t low = 0;
+                        if (!ParseHex4(low) || low < 0xDC00 || low > 0xDFFF)
+                        {
+                            return false;
+                        }
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    AppendUtf8(output, codePoint);
+                    break;
+                }
+                default:
+                    return false;
+                }
+            }
+            return false;
+        }
+
+        bool ParseNumber(JsonValue& value)
+        {
+            auto start = m_offset;
+            if (m_offset < m_text.size() && m_text[m_offset] == '-')
+            {
+                ++m_offset;
+            }
+            auto digitsStart = m_offset;
+            while (m_offset < m_text.size())
+            {
+                char ch = m_text[m_offset];
+                if ((ch >= '0' && ch <= '9') || ch == '.' || ch == 'e' || ch == 'E' || ch == '+' || ch == '-')
+                {
+                    ++m_offset;
+                    continue;
+                }
+                break;
+            }
+            if (m_offset == digitsStart)
+            {
+                return false;
+            }
+
+            std::string number(m_text.substr(start, m_offset - start));
+            char* end = nullptr;
+            value.m_type = JsonValueType::Number;
+            value.m_number = std::strtod(number.c_str(), &end);
+            return end == number.c_str() + number.size();
+        }
+    };
+
+    JsonValue const* JsonValue::Lookup(std::string_view key) const
+    {
+        for (auto const& member : m_members)
+        {
+            if (member.Key == key)
+            {
+                return &member.Value;
+            }
+        }
+        return nullptr;
+    }
+
+    void AppendJsonString(std::string& output, std::string_view text)
+    {
+        static constexpr char c_hex[] = "0123456789ABCDEF";
+        output.push_back('"');
+        for (char ch : text)
+        {
+            switch (ch)
+            {
+            case '"':
+                output.append("\\\"");
+                break;
+            case '\\':
+                output.append("\\\\");
+                break;
+            case '\b':
+                output.append("\\b");
+                break;
+            case '\f':
+                output.append("\\f");
+                break;
+            case '\n':
+                output.append("\\n");
+                break;
+            case '\r':
+                output.append("\\r");
+                break;
+            case '\t':
+                output.append("\\t");
+                break;
+            default:
+                if (static_cast<unsigned char>(ch) < 0x20)
+                {
+                    output.append("\\u00");
+                    output.push_back(c_hex[(ch >> 4) & 0x0F]);
+                    output.push_back(c_hex[ch & 0x0F]);
+                }
+                else
+                {
+                    output.push_back(ch);
+                }
+                break;
+            }
+        }
+        output.push_back('"');
+    }
+
+    std::string JsonValue::Stringify() const
+    {
+        std::string output;
+        StringifyTo(output);
+        return output;
+    }
+
+    void JsonValue::StringifyTo(std::string& output) const
+    {
+        switch (m_type)
+        {
+        case JsonValueType::Null:
+            output.append("null");
+            break;
+        case JsonValueType::Boolean:
+            output.append(m_boolean ? "true" : "false");
+            break;
+        case JsonValueType::Number:
+            AppendNumber(output, m_number);
+            break;
+        case JsonValueType::String:
+            AppendJsonString(output, m_string);
+            break;
+        case JsonValueType::Array:
+            output.push_back('[');
+            for (size_t i = 0; i < m_items.size(); ++i)
+            {
+                if (i > 0)
+                {
+                    output.push_back(',');
+                }
+                m_items[i].StringifyTo(output);
+            }
+            output.push_back(']');
+            break;
+        case JsonValueType::Object:
+            output.push_back('{');
+            for (size_t i = 0; i < m_members.size(); ++i)
+            {
+                if (i > 0)
+                {
+                    output.push_back(',');
+                }
+                AppendJsonString(output, m_members[i].Key);
+                output.push_back(':');
+                m_members[i].Value.StringifyTo(output);
+            }
+            output.push_back('}');
+            break;
+        }
+    }
+
+    bool JsonValue::TryParse(std::string_view text, JsonValue& value)
+    {
+        value = JsonValue{};
+        JsonParser parser(text);
+        return parser.ParseDocument(value);
+    }
+
+    std::string JsonValueToText(JsonValue const& value)
+    {
+        switch (value.ValueType())
+        {
+        case JsonValueType::String:
+            return value.GetString();
+        case JsonValueType::Number:
+            return std::to_string(value.GetNumber());
+        case JsonValueType::Boolean:
+            return value.GetBoolean() ? "true" : "false";
+        default:
+            return value.Stringify();
+        }
+    }
+
+    size_t SkipJsonValue(std::string_view text, size_t offset)
+    {
+        if (offset >= text.size())
+        {
+            return std::string_view::npos;
+        }
+
+        auto ch = text[offset];
+        if (ch != '{' && ch != '[' && ch != '"')
+        {
+            // A scalar runs up to the next delimiter.
+            auto end = text.find_first_of(",]} \t\r\n", offset);
+            return end == std::string_view::npos ? text.size() : end;
+        }
+
+        size_t depth = 0;
+        while (offset < text.size())
+        {
+            ch = text[offset++];
+            if (ch == '"')
+            {
+                // Jump from quote or backslash to the next one.
+                while (true)
+                {
+                    offset = text.find_first_of("\"\\", offset);
+                    if (offset == std::string_view::npos)
+                    {
+                        return std::string_view::npos;
+                    }
+                    if (text[offset] == '"')
+                    {
+                        ++offset;
+                        break;
+                    }
+                    offset += 2;
+                }
+            }
+            else if (ch == '{' || ch == '[')
+            {
+                ++depth;
+                continue;
+            }
+            else if (ch == '}' || ch == ']')
+            {
+                if (depth == 0)
+                {
+                    return std::string_view::npos;
+                }
+                --depth;
+            }
+            if (depth == 0)
+            {
+                return offset;
+            }
+        }
+        return std::string_view::npos;
+    }
+
+    JsonArrayReader::JsonArrayReader(std::string_view text) : m_text(text)
+    {
+        SkipWhitespace();
+        if (m_offset >= m_text.size() || m_text[m_offset] != '[')
+        {
+            Fail();
+            return;
+        }
+        ++m_offset;
+        SkipWhitespace();
+        if (m_offset < m_text.size() && m_text[m_offset] == ']')
+        {
+            ++m_offset;
+            SkipWhitespace();
+            m_done = true;
+            m_failed = m_offset != m_text.size();
+        }
+    }
+
+    bool JsonArrayReader::Next(std::string_view& element)
+    {
+        if (m_done)
+        {
+            return false;
+        }
+
+        auto end = SkipJsonValue(m_text, m_offset);
+        if (end == std::string_view::npos || end == m_offset)
+        {
+            return Fail();
+        }
+        element = m_text.substr(m_offset, end - m_offset);
+        m_offset = end;
+
+        SkipWhitespace();
+        if (m_offset < m_text.size() && m_text[m_offset] == ',')
+        {
+            ++m_offset;
+            SkipWhitespace();
+            return true;
+        }
+        if (m_offset < m_text.size() && m_text[m_offset] == ']')
+        {
+            ++m_offset;
+            SkipWhitespace();
+            m_done = true;
+            if (m_offset != m_text.size())
+            {
+                return Fail();
+            }
+            return true;
+        }
+        return Fail();
+    }
+
+    void JsonArrayReader::SkipWhitespace()
+    {
+        while (m_offset < m_text.size())
+        {
+            auto ch = m_text[m_offset];
+            if (ch != ' ' && ch != '\t' && ch != '\n' && ch != '\r')
+            {
+                break;
+            }
+            ++m_offset;
+        }
+    }
+
+    bool JsonArrayReader::Fail()
+    {
+        m_done = true;
+        m_failed = true;
+        return false;
+    }
+
+    JsonObjectReader::JsonObjectReader(std::string_view text) : m_text(text)
+    {
+        SkipWhitespace();
+        if (m_offset >= m_text.size() || m_text[m_offset] != '{')
+        {
+            Fail();
+            return;
+        }
+        ++m_offset;
+        SkipWhitespace();
+        if (m_offset < m_text.size() && m_text[m_offset] == '}')
+        {
+            Finish();
+        }
+    }
+
+    bool JsonObjectReader::Next(std::string_view& key, std::string& keyBuffer, std::string_view& value,
+        std::string& valueBuffer)
+    {
+        if (m_done)
+        {
+            return false;
+        }
+
+        SkipWhitespace();
+        if (!m_first)
+        {
+            if (m_offset >= m_text.size())
+            {
+                return Fail();
+            }
+            if (m_text[m_offset] == '}')
+            {
+                return Finish();
+            }
+            if (m_text[m_offset] != ',')
+            {
+                return Fail();
+            }
+            ++m_offset;
+            SkipWhitespace();
+        }
+        m_first = false;
+
+        if (m_offset >= m_text.size() || m_text[m_offset] != '"' || !ReadString(key, keyBuffer))
+        {
+            return Fail();
+        }
+        SkipWhitespace();
+        if (m_offset >= m_text.size() || m_text[m_offset] != ':')
+        {
+            return Fail();
+        }
+        ++m_offset;
+        SkipWhitespace();
+
+        if (m_offset < m_text.size() && m_text[m_offset] == '"')
+        {
+            return ReadString(value, valueBuffer) || Fail();
+        }
+        JsonValue other;
+        JsonParser parser(m_text);
+        if (!parser.ParseValueAt(m_offset, other, 1))
+        {
+            return Fail();
+        }
+        valueBuffer = JsonValueToText(other);
+        value = valueBuffer;
+        return true;
+    }
+
+    bool JsonObjectReader::ReadString(std::string_view& view, std::string& buffer)
+    {
+        for (auto offset = m_offset + 1; offset < m_text.size(); ++offset)
+        {
+            auto ch = static_cast<unsigned char>(m_text[offset]);
+            if (ch == '"')
+            {
+                view = m_text.substr(m_offset + 1, offset - m_offset - 1);
+                m_offset = offset + 1;
+                return true;
+            }
+            if (ch == '\\' || ch < 0x20)
+            {
+                break;
+            }
+        }
+
+        buffer.clear();
+        JsonParser parser(m_text);
+        if (!parser.ParseStringAt(m_offset, buffer))
+        {
+            return false;
+        }
+        view = buffer;
+        return true;
+    }
+
+    void JsonObjectReader::SkipWhitespace()
+    {
+        while (m_offset < m_text.size())
+        {
+            auto ch = m_text[m_offset];
+            if (ch != ' ' && ch != '\t' && ch != '\n' && ch != '\r')
+            {
+                break;
+            }
+            ++m_offset;
+        }
+    }
+
+    bool JsonObjectReader::Finish()
+    {
+        ++m_offset;
+        SkipWhitespace();
+        m_done = true;
+        m_failed = m_offset != m_text.size();
+        return false;
+    }
+
+    bool JsonObjectReader::Fail()
+    {
+        m_done = true;
+        m_failed = true;
+        return false;
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace LogMinds::Engine
+{
+    struct JsonMember;
+
+    enum class JsonValueType : uint8_t
+    {
+        Null,
+        Boolean,
+        Number,
+        String,
+        Array,
+        Object,
+    };
+
+    class JsonValue
+    {
+    public:
+        JsonValue() = default;
+
+        JsonValueType ValueType() const { return m_type; }
+        bool GetBoolean() const { return m_boolean; }
+        double GetNumber() const { return m_number; }
+        std::string const& GetString() const { return m_string; }
+        std::vector<JsonValue> const& GetArray() const { return m_items; }
+        std::vector<JsonMember> const& GetObject() const { return m_members; }
+
+        JsonValue const* Lookup(std::string_view key) const;
+        std::string Stringify() const;
+
+        // Parses a complete document; trailing non-whitespace is an error.
+        static bool TryParse(std::string_view text, JsonValue& value);
+
+    private:
+        friend class JsonParser;
+
+        void StringifyTo(std::string& output) const;
+
+        JsonValueType m_type{ JsonValueType::Null };
+        bool m_boolean{ false };
+        double m_number{ 0 };
+        std::string m_string;
+        std::vector<JsonValue> m_items;
+        std::vector<JsonMember> m_members;
+    };
+
+    struct JsonMember
+    {
+        std::string Key;
+        JsonValue Value;
+    };
+
+    // Renders a scalar the way log fields display it; containers are stringified.
+    std::string JsonValueToText(JsonValue const& value);
+
+    // Appends text as a quoted JSON string.
+    void AppendJsonString(std::string& output, std::string_view text);
+
+    // End offset of the JSON value that starts at offset, found by matching
+    // quotes and brackets only; std::string_view::npos when the text ends
+    // first. The value itself is not validated.
+    size_t SkipJsonValue(std::string_view text, size_t offset);
+
+    // Streams the elements of a top-level JSON array as spans of the input,
+    // without parsing them. Anything that is not '[' value (',' value)* ']'
+    // followed by whitespace ends the walk with Failed() set.
+    class JsonArrayReader
+    {
+    public:
+        explicit JsonArrayReader(std::string_view text);
+
+        // False once the array is exhausted or malformed.
+        bool Next(std::string_view& element);
+
+        bool Failed() const
+        {
+            return m_failed;
+        }
+
+    private:
+        std::string_view m_text;
+        size_t m_offset{ 0 };
+        bool m_done{ false };
+        bool m_failed{ false };
+
+        void SkipWhitespace();
+        bool Fail();
+    };
+
+    // Walks the members of one JSON object without building a tree. Keys
+    // and string values without escapes come back as spans of the input;
+    // escaped strings are decoded into the given buffers and every other
+    // value is rendered there as JsonValueToText would. Accepts exactly what
+    // JsonValue::TryParse accepts for an object.
+    class JsonObjectReader
+    {
+    public:
+        explicit JsonObjectReader(std::string_view text);
+
+        // False once the object is exhausted or malformed.
+        bool Next(std::string_view& key, std::string& keyBuffer, std::string_view& value, std::string& valueBuffer);
+
+        bool Failed() const
+        {
+            return m_failed;
+        }
+
+    private:
+        std::string_view m_text;
+        size_t m_offset{ 0 };
+        bool m_first{ true };
+        bool m_done{ false };
+        bool m_failed{ false };
+
+        bool ReadString(std::string_view& view, std::string& buffer);
+        void SkipWhitespace();
+        bool Finish();
+        bool Fail();
+    };
+}
@@ -0,0 +1,550 @@
+#include "KeywordSketch.h"
+
+#include "BinaryIo.h"
+#include "LogStore.h"
+#include "Parallel.h"
+#include "Text.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace LogMinds::Engine
+{
+    namespace
+    {
+        constexpr uint64_t c_fnvOffset = 14695981039346656037ull;
+        constexpr uint64_t c_fnvPrime = 1099511628211ull;
+
+        // Tokenizing costs more per row than counting aggregates does.
+        constexpr size_t c_minimumRowsPerChunk = 1 << 14;
+
+        uint64_t Mix(uint64_t hash)
+        {
+            hash ^= hash >> 33;
+            hash *= 0xFF51AFD7ED558CCDull;
+            hash ^= hash >> 33;
+            hash *= 0xC4CEB9FE1A85EC53ull;
+            hash ^= hash >> 33;
+            return hash;
+        }
+
+        // Eight bytes at a time; words are short, and FNV's byte-by-byte
+        // multiply chain was the tokenizer's largest cost.
+        uint64_t HashWord(char const* word, size_t length)
+        {
+            auto hash = c_fnvOffset ^ (length * c_fnvPrime);
+            size_t offset = 0;
+            for (; offset + 8 <= length; offset += 8)
+            {
+                uint64_t block;
+                std::memcpy(&block, word + offset, 8);
+                hash = (hash ^ block) * 0x9E3779B97F4A7C15ull;
+                hash ^= hash >> 29;
+            }
+            if (offset < length)
+            {
+                uint64_t block = 0;
+                std::memcpy(&block, word + offset, length - offset);
+                hash = (hash ^ block) * 0x9E3779B97F4A7C15ull;
+                hash ^= hash >> 29;
+            }
+            // Slots and sketch columns are taken from the low bits.
+            return Mix(hash);
+        }
+
+        // Lower-cased ASCII letters, digits and '_'; 0 for everything else.
+        struct AsciiWordTable
+        {
+            unsigned char Lowered[128]{};
+
+            AsciiWordTable()
+            {
+                for (unsigned char byte = '0'; byte <= '9'; ++byte)
+                {
+                    Lowered[byte] = byte;
+                }
+                for (unsigned char byte = 'a'; byte <= 'z'; ++byte)
+                {
+                    Lowered[byte] = byte;
+                    Lowered[byte - ('a' - 'A')] = byte;
+                }
+                Lowered['_'] = '_';
+            }
+        };
+
+        AsciiWordTable const c_asciiWords;
+    }
+
+    KeywordSketch KeywordSketch::Of(LogStore const& store, std::vector<uint32_t> const& rows, unsigned threadCount)
+    {
+        auto threads = ResolveThreadCount(threadCount);
+        auto chunkCount = std::max<size_t>(1, std::min<size_t>(threads * 4, rows.size() / c_minimumRowsPerChunk));
+        auto perChunk = (rows.size() + chunkCount - 1) / chunkCount;
+        std::vector<KeywordSketch> partials(chunkCount);
+        ParallelFor(chunkCount, threads, [&](size_t chunk)
+        {
+            auto begin = std::min(rows.size(), chunk * perChunk);
+            auto end = std::min(rows.size(), begin + perChunk);
+            for (auto index = begin; index < end; ++index)
+            {
+                partials[chunk].Add(store.Message(rows[index]));
+            }
+        });
+
+        auto sketch = std::move(partials.front());
+        for (size_t chunk = 1; chunk < chunkCount; ++chunk)
+        {
+            sketch.Merge(partials[chunk]);
+        }
+        return sketch;
+    }
+
+    void KeywordSketch::Add(std::string_view message)
+    {
+        // The word is lower-cased into a buffer as it is read; bytes past
+        // c_maxWordBytes only go into the hash, and such a word is never
+        // tracked.
+        char word[c_maxWordBytes];
+        size_t bytes = 0;
+        size_t letters = 0;
+        auto overflow = c_fnvOffset;
+        auto append = [&](unsigned char byte)
+        {
+            if (bytes < c_maxWordBytes)
+            {
+                word[bytes] = static_cast<char>(byte);
+            }
+            else
+            {
+                overflow = (overflow ^ byte) * c_fnvPrime;
+            }
+            ++bytes;
+        };
+        auto finish = [&]()
+        {
+            if (letters > 3)
+            {
+                auto hash = HashWord(word, std::min(bytes, c_maxWordBytes));
+                if (bytes > c_maxWordBytes)
+                {
+                    hash = Mix(hash ^ overflow);
+                    overflow = c_fnvOffset;
+                }
+                AddWord(hash, word, bytes);
+            }
+            bytes = 0;
+            letters = 0;
+        };
+
+        size_t offset = 0;
+        while (offset < message.size())
+        {
+            auto byte = static_cast<unsigned char>(message[offset]);
+            if (byte < 0x80)
+            {
+                ++offset;
+                auto lowered = c_asciiWords.Lowered[byte];
+                if (lowered == 0)
+                {
+                    if (bytes != 0)
+                    {
+                        finish();
+                    }
+                    continue;
+                }
+                // The rest of an ASCII run without going through append.
+                while (true)
+                {
+                    if (bytes < c_maxWordBytes)
+                    {
+                        word[bytes++] = static_cast<char>(lowered);
+                    }
+                    else
+                    {
+                        append(lowered);
+                    }
+                    ++letters;
+                    if (offset == message.size() || static_cast<unsigned char>(message[offset]) >= 0x80 ||
+                        (lowered = c_asciiWords.Lowered[static_cast<unsigned char>(message[offset])]) == 0)
+                    {
+                        break;
+                    }
+                    ++offset;
+                }
+                continue;
+            }
+
+            auto codePoint = DecodeUtf8(message, offset);
+            if (codePoint == c_invalidCodePoint || !IsWordCodePoint(codePoint = ToLower(codePoint)))
+            {
+                finish();
+                continue;
+            }
+            if (codePoint < 0x80)
+            {
+                append(static_cast<unsigned char>(codePoint));
+            }
+            else if (codePoint < 0x800)
+            {
+                append(static_cast<unsigned char>(0xC0 | (codePoint >> 6)));
+                append(static_cast<unsigned char>(0x80 | (codePoint & 0x3F)));
+            }
+            else if (codePoint < 0x10000)
+            {
+                append(static_cast<unsigned char>(0xE0 | (codePoint >> 12)));
+                append(static_cast<unsigned char>(0x80 | ((codePoint >> 6) & 0x3F)));
+                append(static_cast<unsigned char>(0x80 | (codePoint & 0x3F)));
+            }
+            else
+            {
+                append(static_cast<unsigned char>(0xF0 | (codePoint >> 18)));
+                append(static_cast<unsigned char>(0x80 | ((codePoint >> 12) & 0x3F)));
+                append(static_cast<unsigned char>(0x80 | ((codePoint >> 6) & 0x3F)));
+                append(static_cast<unsigned char>(0x80 | (codePoint & 0x3F)));
+            }
+            ++letters;
+        }
+        finish();
+    }
+
+    void KeywordSketch::Merge(KeywordSketch const& other)
+    {
+        if (other.m_counters.empty())
+        {
+            return;
+        }
+        if (m_counters.empty())
+        {
+            *this = other;
+            return;
+        }
+
+        // A word one side does not track was either never seen there (when
+        // that side is exact) or is bounded by its sketch.
+        std::vector<Candidate> merged;
+        merged.reserve(m_candidates.size() + other.m_candidates.size());
+        for (auto const& candidate : m_candidates)
+        {
+            merged.push_back(candidate);
+            auto index = other.m_slots[other.FindSlot(candidate.Hash)];
+            if (index != c_emptySlot)
+            {
+                merged.back().Count += other.m_candidates[index].Count;
+            }
+            else if (!other.m_exact)
+            {
+                merged.back().Count += other.Estimate(candidate.Hash);
+            }
+        }
+        for (auto const& candidate : other.m_candidates)
+        {
+            if (m_slots[FindSlot(candidate.Hash)] == c_emptySlot)
+            {
+                merged.push_back(candidate);
+                if (!m_exact)
+                {
+                    merged.back().Count += Estimate(candidate.Hash);
+                }
+            }
+        }
+
+        for (size_t i = 0; i < m_counters.size(); ++i)
+        {
+            m_counters[i] += other.m_counters[i];
+        }
+        m_exact = m_exact && other.m_exact && merged.size() <= c_capacity;
+        if (merged.size() > c_capacity)
+        {
+            std::nth_element(merged.begin(), merged.begin() + c_capacity, merged.end(),
+                [](Candidate const& left, Candidate const& right)
+            {
+                return left.Count != right.Count ? left.Count > right.Count : left.Hash < right.Hash;
+            });
+            for (auto dropped = merged.begin() + c_capacity; dropped != merged.end(); ++dropped)
+            {
+                Raise(dropped->Hash, dropped->Count);
+            }
+            merged.resize(c_capacity);
+        }
+        m_candidates = std::move(merged);
+        Reindex();
+    }
+
+    std::vector<std::pair<std::string, uint64_t>> KeywordSketch::Top(size_t count) const
+    {
+        std::vector<std::pair<std::string, uint64_t>> words;
+        words.reserve(m_candidates.size());
+        for (auto const& candidate : m_candidates)
+        {
+            words.emplace_back(std::string(candidate.Word, candidate.Length), candidate.Count);
+        }
+        count = std::min(count, words.size());
+        std::partial_sort(words.begin(), words.begin() + count, words.end(), [](auto const& left, auto const& right)
+        {
+            if (left.second == right.second)
+            {
+                return left.first < right.first;
+            }
+            return left.second > right.second;
+        });
+        words.resize(count);
+        return words;
+    }
+
+    size_t KeywordSketch::MemoryUsage() const
+    {
+        return m_counters.capacity() * sizeof(uint32_t) + m_candidates.capacity() * sizeof(Candidate) +
+            (m_slots.capacity() + m_heap.capacity() + m_heapPositions.capacity()) * sizeof(uint16_t);
+    }
+
+    void KeywordSketch::Write(BinaryWriter& writer) const
+    {
+        writer.Value<uint8_t>(m_exact ? 1 : 0);
+        writer.Vector(m_counters);
+        writer.Vector(m_candidates);
+    }
+
+    bool KeywordSketch::Read(BinaryReader& reader)
+    {
+        *this = KeywordSketch();
+        uint8_t exact = 0;
+        if (!reader.Value(exact) || exact > 1 || !reader.Vector(m_counters) || !reader.Vector(m_candidates))
+        {
+            return false;
+        }
+        m_exact = exact != 0;
+        if (m_counters.empty())
+        {
+            return m_candidates.empty();
+        }
+        if (m_counters.size() != c_depth * c_width || m_candidates.size() > c_capacity)
+        {
+            return false;
+        }
+        for (auto const& candidate : m_candidates)
+        {
+            if (candidate.Length == 0 || candidate.Length > c_maxWordBytes || candidate.Count == 0 ||
+                HashWord(candidate.Word, candidate.Length) != candidate.Hash)
+            {
+                return false;
+            }
+        }
+        Reindex();
+        // Reindex keeps one candidate per hash.
+        return m_heap.size() == m_candidates.size();
+    }
+
+    void KeywordSketch::AddWord(uint64_t hash, char const* word, size_t length)
+    {
+        if (m_counters.empty())
+        {
+            m_counters.assign(c_depth * c_width, 0);
+            m_candidates.reserve(c_capacity);
+            Reindex();
+        }
+
+        // Tracked words are counted in their candidate only; the sketch
+        // bounds every word that is not tracked, which is all a merge or a
+        // new candidate reads from it.
+        if (auto index = m_slots[FindSlot(hash)]; index != c_emptySlot)
+        {
+            ++m_candidates[index].Count;
+            SiftDown(m_heapPositions[index]);
+            return;
+        }
+        auto estimate = Count(hash);
+        if (length > c_maxWordBytes)
+        {
+            return;
+        }
+        if (m_candidates.size() < c_capacity)
+        {
+            // While exact, a word that is not tracked was never seen.
+            Track(hash, m_exact ? 1 : estimate, word, length);
+            return;
+        }
+
+        m_exact = false;
+        auto least = m_heap.front();
+        if (estimate > m_candidates[least].Count)
+        {
+            Raise(m_candidates[least].Hash, m_candidates[least].Count);
+            Untrack(least);
+            Track(hash, estimate, word, length);
+        }
+    }
+
+    uint32_t KeywordSketch::Count(uint64_t hash)
+    {
+        // Conservative update: only the counters at the minimum grow, which
+        // keeps the other words' estimates tighter.
+        auto step = static_cast<uint32_t>(hash >> 32) | 1;
+        auto position = static_cast<uint32_t>(hash);
+        uint32_t* counters[c_depth];
+        auto least = UINT32_MAX;
+        for (size_t row = 0; row < c_depth; ++row, position += step)
+        {
+            counters[row] = &m_counters[row * c_width + (position & (c_width - 1))];
+            least = std::min(least, *counters[row]);
+        }
+        for (auto counter : counters)
+        {
+            if (*counter == least)
+            {
+                ++*counter;
+            }
+        }
+        return least + 1;
+    }
+
+    void KeywordSketch::Raise(uint64_t hash, uint64_t count)
+    {
+        auto floor = static_cast<uint32_t>(std::min<uint64_t>(count, UINT32_MAX));
+        auto step = static_cast<uint32_t>(hash >> 32) | 1;
+        auto position = static_cast<uint32_t>(hash);
+        for (size_t row = 0; row < c_depth; ++row, position += step)
+        {
+            auto& counter = m_counters[row * c_width + (position & (c_width - 1))];
+            counter = std::max(counter, floor);
+        }
+    }
+
+    uint32_t KeywordSketch::Estimate(uint64_t hash) const
+    {
+        auto step = static_cast<uint32_t>(hash >> 32) | 1;
+        auto position = static_cast<uint32_t>(hash);
+        auto least = UINT32_MAX;
+        for (size_t row = 0; row < c_depth; ++row, position += step)
+        {
+            least = std::min(least, m_counters[row * c_width + (position & (c_width - 1))]);
+        }
+        return least;
+    }
+
+    size_t KeywordSketch::FindSlot(uint64_t hash) const
+    {
+        auto slot = static_cast<size_t>(hash) & (c_slots - 1);
+        while (m_slots[slot] != c_emptySlot && m_candidates[m_slots[slot]].Hash != hash)
+        {
+            slot = (slot + 1) & (c_slots - 1);
+        }
+        return slot;
+    }
+
+    void KeywordSketch::Track(uint64_t hash, uint64_t count, char const* word, size_t length)
+    {
+        Candidate candidate{};
+        candidate.Hash = hash;
+        candidate.Count = count;
+        candidate.Length = static_cast<uint8_t>(length);
+        std::memcpy(candidate.Word, word, length);
+        auto index = static_cast<uint16_t>(m_candidates.size());
+        m_candidates.push_back(candidate);
+        m_slots[FindSlot(hash)] = index;
+        m_heapPositions.push_back(static_cast<uint16_t>(m_heap.size()));
+        m_heap.push_back(index);
+        SiftUp(m_heap.size() - 1);
+    }
+
+    void KeywordSketch::Untrack(size_t candidate)
+    {
+        // Backward-shift deletion keeps every probe sequence unbroken.
+        auto hole = FindSlot(m_candidates[candidate].Hash);
+        for (auto next = (hole + 1) & (c_slots - 1); m_slots[next] != c_emptySlot; next = (next + 1) & (c_slots - 1))
+        {
+            auto home = static_cast<size_t>(m_candidates[m_slots[next]].Hash) & (c_slots - 1);
+            if (((next - home) & (c_slots - 1)) >= ((next - hole) & (c_slots - 1)))
+            {
+                m_slots[hole] = m_slots[next];
+                hole = next;
+            }
+        }
+        m_slots[hole] = c_emptySlot;
+
+        auto position = m_heapPositions[candidate];
+        SwapHeap(position, m_heap.size() - 1);
+        m_heap.pop_back();
+        if (position < m_heap.size())
+        {
+            SiftDown(position);
+            SiftUp(position);
+        }
+
+        // The last candidate moves into the freed index.
+        auto last = m_candidates.size() - 1;
+        if (candidate != last)
+        {
+            m_candidates[candidate] = m_candidates[last];
+            m_slots[FindSlot(m_candidates[candidate].Hash)] = static_cast<uint16_t>(candidate);
+            m_heapPositions[candidate] = m_heapPositions[last];
+            m_heap[m_heapPositions[candidate]] = static_cast<uint16_t>(candidate);
+        }
+        m_candidates.pop_back();
+        m_heapPositions.pop_back();
+    }
+
+    void KeywordSketch::SiftDown(size_t position)
+    {
+        while (true)
+        {
+            auto smallest = position;
+            for (auto child = position * 2 + 1; child <= position * 2 + 2 && child < m_heap.size(); ++child)
+            {
+                if (m_candidates[m_heap[child]].Count < m_candidates[m_heap[smallest]].Count)
+                {
+                    smallest = child;
+                }
+            }
+            if (smallest == position)
+            {
+                return;
+            }
+            SwapHeap(position, smallest);
+            position = smallest;
+        }
+    }
+
+    void KeywordSketch::SiftUp(size_t position)
+    {
+        while (position > 0)
+        {
+            auto parent = (position - 1) / 2;
+            if (m_candidates[m_heap[parent]].Count <= m_candidates[m_heap[position]].Count)
+            {
+                return;
+            }
+            SwapHeap(position, parent);
+            position = parent;
+        }
+    }
+
+    void KeywordSketch::SwapHeap(size_t left, size_t right)
+    {
+        std::swap(m_heap[left], m_heap[right]);
+        m_heapPositions[m_heap[left]] = static_cast<uint16_t>(left);
+        m_heapPositions[m_heap[right]] = static_cast<uint16_t>(right);
+    }
+
+    void KeywordSketch::Reindex()
+    {
+        m_slots.assign(c_slots, c_emptySlot);
+        m_heap.clear();
+        m_heapPositions.clear();
+        for (size_t index = 0; index < m_candidates.size(); ++index)
+        {
+            auto slot = FindSlot(m_candidates[index].Hash);
+            if (m_slots[slot] != c_emptySlot)
+            {
+                // A duplicate hash; only possible in a corrupt cache.
+                return;
+            }
+            m_slots[slot] = static_cast<uint16_t>(index);
+            m_heap.push_back(static_cast<uint16_t>(index));
+            m_heapPositions.push_back(static_cast<uint16_t>(index));
+        }
+        for (auto position = m_heap.size() / 2; position-- > 0;)
+        {
+            SiftDown(position);
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace LogMinds::Engine
+{
+    class BinaryReader;
+    class BinaryWriter;
+    class LogStore;
+
+    // The most frequent keywords (words of more than three letters or digits,
+    // lower-cased) of a set of messages, in bounded memory however many
+    // distinct words there are. The c_capacity words with the highest counts
+    // are tracked by name in a space-saving table; every other word goes
+    // into a count-min sketch, and replaces the least frequent tracked word
+    // once its estimate there passes it. A tracked word is counted exactly
+    // from then on, so while no word was turned away (Exact) every count is
+    // exact, and afterwards counts can only be too high, by at most what the
+    // sketch overestimated when the word came in. Messages are tokenized in
+    // place, without allocating.
+    class KeywordSketch
+    {
+    public:
+        static constexpr size_t c_capacity = 512;
+        static constexpr size_t c_depth = 4;
+        static constexpr size_t c_width = 4096;
+        // Longer words still count in the sketch but are never tracked.
+        static constexpr size_t c_maxWordBytes = 64;
+
+        // Over the messages of the (ascending) rows of store, split across
+        // threadCount workers (0 = one per hardware thread).
+        static KeywordSketch Of(LogStore const& store, std::vector<uint32_t> const& rows, unsigned threadCount = 0);
+
+        void Add(std::string_view message);
+        // Adds the words counted by other.
+        void Merge(KeywordSketch const& other);
+
+        // Up to count tracked words by estimated count, ties by word.
+        std::vector<std::pair<std::string, uint64_t>> Top(size_t count) const;
+
+        bool Exact() const
+        {
+            return m_exact;
+        }
+
+        size_t MemoryUsage() const;
+
+        // Read replaces the contents and fails on input that does not
+        // describe a consistent sketch.
+        void Write(BinaryWriter& writer) const;
+        bool Read(BinaryReader& reader);
+
+    private:
+        struct Candidate
+        {
+            uint64_t Hash;
+            uint64_t Count;
+            uint8_t Length;
+            char Word[c_maxWordBytes];
+        };
+
+        static constexpr size_t c_slots = c_capacity * 2;
+        static constexpr uint16_t c_emptySlot = 0xFFFF;
+
+        // c_depth rows of c_width counters; empty until the first word.
+        std::vector<uint32_t> m_counters;
+        std::vector<Candidate> m_candidates;
+        // Open-addressed by hash: index into m_candidates, or c_emptySlot.
+        std::vector<uint16_t> m_slots;
+        // Min-heap of candidate indexes by count, and each candidate's place in it.
+        std::vector<uint16_t> m_heap;
+        std::vector<uint16_t> m_heapPositions;
+        bool m_exact{ true };
+
+        void AddWord(uint64_t hash, char const* word, size_t length);
+        // Adds one occurrence to the sketch; returns the new estimate.
+        uint32_t Count(uint64_t hash);
+        // Lifts the sketch's estimate of a word that stops being tracked to
+        // at least its count.
+        void Raise(uint64_t hash, uint64_t count);
+        uint32_t Estimate(uint64_t hash) const;
+        size_t FindSlot(uint64_t hash) const;
+        void Track(uint64_t hash, uint64_t count, char const* word, size_t length);
+        void Untrack(size_t candidate);
+        void SiftDown(size_t position);
+        void SiftUp(size_t position);
+        void SwapHeap(size_t left, size_t right);
+        // Rebuilds the slots and the heap from m_candidates.
+        void Reindex();
+    };
+}
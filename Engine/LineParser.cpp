@@ -0,0 +1,831 @@
+#include "LineParser.h"
+
+#include "LineSplitter.h"
+#include "Text.h"
+#include "Timestamp.h"
+
+#include <algorithm>
+#include <deque>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+namespace LogMinds::Engine
+{
+    namespace
+    {
+        struct LevelName
+        {
+            std::string_view Text;
+            std::string_view Normalized;
+        };
+
+        // Alternation order of the original patterns: WARN is tried before
+        // WARNING and ERROR before ERR. The key/value layout omits NOTICE.
+        constexpr LevelName c_levelNames[] = {
+            { "TRACE", "TRACE" },
+            { "DEBUG", "DEBUG" },
+            { "INFO", "INFO" },
+            { "WARN", "WARN" },
+            { "WARNING", "WARN" },
+            { "ERROR", "ERROR" },
+            { "ERR", "ERROR" },
+            { "FATAL", "FATAL" },
+            { "CRITICAL", "CRITICAL" },
+            { "NOTICE", "NOTICE" },
+        };
+        constexpr size_t c_keyValueLevelCount = 9;
+
+        constexpr size_t c_lineFormatCount = static_cast<size_t>(LineFormat::Plain) + 1;
+        // Upper bound on how far DetectLineFormat reads, so a file without
+        // newlines is not scanned end to end.
+        constexpr size_t c_detectionBytes = 4 << 20;
+
+        // Single-pass recognizer for the four text layouts. Each Try* method
+        // reproduces the captures the matching ECMAScript regex produced,
+        // including its backtracking order, so results stay bit-identical.
+        // The only thing that can make the regex backtrack away from the
+        // greedy path is a CR/LF inside the "(.*)$" message, which '.' cannot
+        // match; m_messageFloor is the first offset from which the rest of the
+        // line is free of them.
+        class LineScanner
+        {
+        public:
+            LineScanner(std::string_view text, ParseContext const& context) : m_text(text), m_context(context)
+            {
+                auto lastBreak = text.find_last_of("\r\n");
+                m_messageFloor = lastBreak == std::string_view::npos ? 0 : lastBreak + 1;
+            }
+
+            // ^(\d{4}-\d{2}-\d{2}[ T]\d{2}:\d{2}:\d{2}(?:[.,]\d+)?)(?:\s*(?:Z|[+-]\d{2}:\d{2})?)?
+            // (?:\s*\[([^\]]+)\])?\s*(LEVEL)?\s*[:-]?\s*(.*)$   (icase)
+            bool TryIso(LogRecord& record) const
+            {
+                if (!(Digits(0, 4) && At(4) == '-' && Digits(5, 2) && At(7) == '-' && Digits(8, 2) &&
+                    (At(10) == ' ' || At(10) == 'T' || At(10) == 't') && Digits(11, 2) && At(13) == ':' &&
+                    Digits(14, 2) && At(16) == ':' && Digits(17, 2)))
+                {
+                    return false;
+                }
+
+                size_t timestampEnd = 19;
+                if ((At(19) == '.' || At(19) == ',') && IsDigit(20))
+                {
+                    timestampEnd = 21;
+                    while (IsDigit(timestampEnd))
+                    {
+                        ++timestampEnd;
+                    }
+                }
+
+                size_t zoneCandidates[2];
+                size_t zoneCount = 0;
+                auto zone = SkipSpace(timestampEnd);
+                if (At(zone) == 'Z' || At(zone) == 'z')
+                {
+                    zoneCandidates[zoneCount++] = zone + 1;
+                }
+                else if ((At(zone) == '+' || At(zone) == '-') && Digits(zone + 1, 2) && At(zone + 3) == ':' &&
+                    Digits(zone + 4, 2))
+                {
+                    zoneCandidates[zoneCount++] = zone + 6;
+                }
+                zoneCandidates[zoneCount++] = timestampEnd;
+
+                for (size_t z = 0; z < zoneCount; ++z)
+                {
+                    auto afterZone = zoneCandidates[z];
+                    size_t sourceBegin = 0;
+                    size_t sourceEnd = 0;
+                    auto bracket = SkipSpace(afterZone);
+                    if (At(bracket) == '[')
+                    {
+                        auto close = m_text.find(']', bracket + 1);
+                        if (close != std::string_view::npos && close > bracket + 1)
+                        {
+                            sourceBegin = bracket + 1;
+                            sourceEnd = close;
+                        }
+                    }
+
+                    for (int withSource = sourceEnd != 0 ? 1 : 0; withSource >= 0; --withSource)
+                    {
+                        auto levelStart = SkipSpace(withSource ? sourceEnd + 1 : afterZone);
+                        for (size_t i = 0; i <= std::size(c_levelNames); ++i)
+                        {
+                            auto messageStart = levelStart;
+                            std::string_view level;
+                            if (i < std::size(c_levelNames))
+                            {
+                                if (!MatchesWord(levelStart, c_levelNames[i].Text))
+                                {
+                                    continue;
+                                }
+                                messageStart += c_levelNames[i].Text.size();
+                                level = c_levelNames[i].Normalized;
+                            }
+
+                            messageStart = SkipSeparator(messageStart, ":-");
+                            if (messageStart < m_messageFloor)
+                            {
+                                continue;
+                            }
+
+                            // The displayed stamp stops before the zone, but
+                            // the instant honours it.
+                            record.Timestamp = std::string(m_text.substr(0, timestampEnd));
+                            record.OccurredOn = ParseTimestamp(m_text.substr(0, afterZone));
+                            if (withSource)
+                            {
+                                record.Source = std::string(m_text.substr(sourceBegin, sourceEnd - sourceBegin));
+                            }
+                            record.Level = std::string(level);
+                            record.Message = std::string(m_text.substr(messageStart));
+                            return true;
+                        }
+                    }
+                }
+                return false;
+            }
+
+            // ^([A-Za-z]{3}\s+\d{1,2}\s+\d{2}:\d{2}:\d{2})\s+([^\s]+)\s+([^:]+):\s*(.*)$
+            bool TrySyslog(LogRecord& record) const
+            {
+                if (!(IsAlpha(0) && IsAlpha(1) && IsAlpha(2) && IsSpace(3)))
+                {
+                    return false;
+                }
+                auto day = SkipSpace(3);
+                if (!IsDigit(day))
+                {
+                    return false;
+                }
+                auto dayEnd = IsDigit(day + 1) ? day + 2 : day + 1;
+                if (!IsSpace(dayEnd))
+                {
+                    return false;
+                }
+                auto time = SkipSpace(dayEnd);
+                if (!(Digits(time, 2) && At(time + 2) == ':' && Digits(time + 3, 2) && At(time + 5) == ':' &&
+                    Digits(time + 6, 2)))
+                {
+                    return false;
+                }
+                auto timestampEnd = time + 8;
+                if (!IsSpace(timestampEnd))
+                {
+                    return false;
+                }
+
+                auto hostBegin = SkipSpace(timestampEnd);
+                auto hostEnd = hostBegin;
+                while (hostEnd < m_text.size() && !IsSpace(hostEnd))
+                {
+                    ++hostEnd;
+                }
+                if (hostEnd == hostBegin || !IsSpace(hostEnd))
+                {
+                    return false;
+                }
+
+                // ([^:]+) runs to the first ':'; if the gap after the host is
+                // followed directly by ':', \s+ gives back one blank to it.
+                auto processBegin = SkipSpace(hostEnd);
+                if (At(processBegin) == ':')
+                {
+                    if (processBegin - hostEnd < 2)
+                    {
+                        return false;
+                    }
+                    --processBegin;
+                }
+                auto colon = m_text.find(':', processBegin);
+                if (colon == std::string_view::npos)
+                {
+                    return false;
+                }
+
+                auto messageStart = SkipSpace(colon + 1);
+                if (messageStart < m_messageFloor)
+                {
+                    return false;
+                }
+
+                record.Timestamp = std::string(m_text.substr(0, timestampEnd));
+                record.Source = std::string(m_text.substr(hostBegin, hostEnd - hostBegin));
+                record.Source.push_back(' ');
+                record.Source.append(m_text.substr(processBegin, colon - processBegin));
+                record.Message = std::string(m_text.substr(messageStart));
+                record.OccurredOn = ParseSyslogTimestamp(record.Timestamp, m_context.ReferenceTime);
+                return true;
+            }
+
+            // ^\[?([^\]]+)\]?\s*[:|-]\s*(LEVEL)\s*[:-]?\s*(.*)$   (icase, no NOTICE)
+            bool TryKeyValue(LogRecord& record) const
+            {
+                for (size_t sourceBegin = At(0) == '[' ? 1 : 0;; --sourceBegin)
+                {
+                    auto close = m_text.find(']', sourceBegin);
+                    auto sourceLimit = close == std::string_view::npos ? m_text.size() : close;
+
+                    // ([^\]]+) is greedy: the last separator that is followed by
+                    // a level wins.
+                    for (auto sourceEnd = sourceLimit; sourceEnd > sourceBegin; --sourceEnd)
+                    {
+                        auto separator = SkipSpace(At(sourceEnd) == ']' ? sourceEnd + 1 : sourceEnd);
+                        if (At(separator) != ':' && At(separator) != '|' && At(separator) != '-')
+                        {
+                            continue;
+                        }
+
+                        auto levelStart = SkipSpace(separator + 1);
+                        for (size_t i = 0; i < c_keyValueLevelCount; ++i)
+                        {
+                            if (!MatchesWord(levelStart, c_levelNames[i].Text))
+                            {
+                                continue;
+                            }
+                            auto messageStart = SkipSeparator(levelStart + c_levelNames[i].Text.size(), ":-");
+                            if (messageStart < m_messageFloor)
+                            {
+                                continue;
+                            }
+
+                            record.Source = Trim(m_text.substr(sourceBegin, sourceEnd - sourceBegin));
+                            record.Level = std::string(c_levelNames[i].Normalized);
+                            record.Message = std::string(m_text.substr(messageStart));
+                            return true;
+                        }
+                    }
+
+                    if (sourceBegin == 0)
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            // ^\[?(LEVEL)\]?\s*[:-]?\s*(.*)$   (icase)
+            bool TrySimpleLevel(LogRecord& record) const
+            {
+                size_t levelStart = At(0) == '[' ? 1 : 0;
+                for (auto const& level : c_levelNames)
+                {
+                    if (!MatchesWord(levelStart, level.Text))
+                    {
+                        continue;
+                    }
+                    auto afterLevel = levelStart + level.Text.size();
+                    if (At(afterLevel) == ']')
+                    {
+                        ++afterLevel;
+                    }
+                    auto messageStart = SkipSeparator(afterLevel, ":-");
+                    if (messageStart < m_messageFloor)
+                    {
+                        continue;
+                    }
+
+                    record.Level = std::string(level.Normalized);
+                    record.Message = std::string(m_text.substr(messageStart));
+                    return true;
+                }
+                return false;
+            }
+
+        private:
+            std::string_view m_text;
+            ParseContext const& m_context;
+            size_t m_messageFloor{ 0 };
+
+            char At(size_t index) const
+            {
+                return index < m_text.size() ? m_text[index] : '\0';
+            }
+
+            bool IsDigit(size_t index) const
+            {
+                auto ch = At(index);
+                return ch >= '0' && ch <= '9';
+            }
+
+            bool IsAlpha(size_t index) const
+            {
+                auto ch = At(index);
+                return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z');
+            }
+
+            bool IsSpace(size_t index) const
+            {
+                return index < m_text.size() && IsAsciiSpace(m_text[index]);
+            }
+
+            bool Digits(size_t index, size_t count) const
+            {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    if (!IsDigit(index + i))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            size_t SkipSpace(size_t index) const
+            {
+                while (IsSpace(index))
+                {
+                    ++index;
+                }
+                return index;
+            }
+
+            // \s*[:-]?\s*
+            size_t SkipSeparator(size_t index, std::string_view separators) const
+            {
+                index = SkipSpace(index);
+                if (index < m_text.size() && separators.find(m_text[index]) != std::string_view::npos)
+                {
+                    ++index;
+                }
+                return SkipSpace(index);
+            }
+
+            // Case-insensitive match of an upper-case ASCII word at index.
+            bool MatchesWord(size_t index, std::string_view word) const
+            {
+                if (index + word.size() > m_text.size())
+                {
+                    return false;
+                }
+                for (size_t i = 0; i < word.size(); ++i)
+                {
+                    auto ch = m_text[index + i];
+                    if (ch >= 'a' && ch <= 'z')
+                    {
+                        ch = static_cast<char>(ch - ('a' - 'A'));
+                    }
+                    if (ch != word[i])
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+        };
+
+        enum class JsonSlot : uint8_t
+        {
+            Timestamp,
+            Level,
+            Source,
+            Message,
+        };
+
+        constexpr size_t c_jsonFieldSlots = 4;
+
+        // The keys ParseJsonObject reads, lower-cased, with the exact spelling
+        // its lookups use and their rank within the field's list. Every other
+        // key goes to Context; these never do, whatever their case.
+        struct JsonKey
+        {
+            std::string_view Lower;
+            std::string_view Exact;
+            JsonSlot Slot;
+            uint8_t Rank;
+        };
+
+        constexpr JsonKey c_jsonKeys[] = {
+            { "timestamp", "timestamp", JsonSlot::Timestamp, 0 },
+            { "time", "time", JsonSlot::Timestamp, 1 },
+            { "@timestamp", "@timestamp", JsonSlot::Timestamp, 2 },
+            { "datetime", "datetime", JsonSlot::Timestamp, 3 },
+            { "date", "date", JsonSlot::Timestamp, 4 },
+            { "eventtime", "eventTime", JsonSlot::Timestamp, 5 },
+            { "level", "level", JsonSlot::Level, 0 },
+            { "severity", "severity", JsonSlot::Level, 1 },
+            { "loglevel", "logLevel", JsonSlot::Level, 2 },
+            { "lvl", "lvl", JsonSlot::Level, 3 },
+            { "priority", "priority", JsonSlot::Level, 4 },
+            { "logger", "logger", JsonSlot::Source, 0 },
+            { "source", "source", JsonSlot::Source, 1 },
+            { "module", "module", JsonSlot::Source, 2 },
+            { "service", "service", JsonSlot::Source, 3 },
+            { "category", "category", JsonSlot::Source, 4 },
+            { "name", "name", JsonSlot::Source, 5 },
+            { "message", "message", JsonSlot::Message, 0 },
+            { "msg", "msg", JsonSlot::Message, 1 },
+            { "event", "event", JsonSlot::Message, 2 },
+            { "description", "description", JsonSlot::Message, 3 },
+            { "detail", "detail", JsonSlot::Message, 4 },
+        };
+
+        // Perfect hash over c_jsonKeys: length, first and last byte pick a
+        // distinct slot for every key, so a lookup is one string compare.
+        constexpr size_t c_jsonKeyBuckets = 64;
+
+        constexpr size_t JsonKeyBucket(std::string_view key)
+        {
+            return (key.size() + static_cast<uint8_t>(key.front()) + static_cast<uint8_t>(key.back()) * 15u) %
+                c_jsonKeyBuckets;
+        }
+
+        struct JsonKeyTable
+        {
+            int8_t Entries[c_jsonKeyBuckets];
+            bool Perfect;
+        };
+
+        constexpr JsonKeyTable BuildJsonKeyTable()
+        {
+            JsonKeyTable table{ {}, true };
+            for (auto& entry : table.Entries)
+            {
+                entry = -1;
+            }
+            for (size_t i = 0; i < std::size(c_jsonKeys); ++i)
+            {
+                auto& entry = table.Entries[JsonKeyBucket(c_jsonKeys[i].Lower)];
+                table.Perfect = table.Perfect && entry < 0;
+                entry = static_cast<int8_t>(i);
+            }
+            return table;
+        }
+
+        constexpr JsonKeyTable c_jsonKeyTable = BuildJsonKeyTable();
+        static_assert(c_jsonKeyTable.Perfect, "c_jsonKeys collide in the key hash");
+
+        JsonKey const* FindJsonKey(std::string_view lowerKey)
+        {
+            if (lowerKey.empty())
+            {
+                return nullptr;
+            }
+            auto index = c_jsonKeyTable.Entries[JsonKeyBucket(lowerKey)];
+            return index >= 0 && c_jsonKeys[index].Lower == lowerKey ? &c_jsonKeys[index] : nullptr;
+        }
+
+        bool IsReservedJsonKey(std::string_view lowerKey)
+        {
+            return FindJsonKey(lowerKey) != nullptr;
+        }
+
+        // Where a key lands and how it ranks within its field, as
+        // ParseJsonObject would place it.
+        JsonKey const* ClassifyJsonKey(std::string_view key, std::string& lowered, bool& reserved)
+        {
+            lowered.assign(key);
+            for (auto& ch : lowered)
+            {
+                if (static_cast<unsigned char>(ch) >= 0x80)
+                {
+                    // ToLower can map non-ASCII letters onto ASCII ones.
+                    lowered = ToLower(key);
+                    break;
+                }
+                ch = (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch + ('a' - 'A')) : ch;
+            }
+            auto found = FindJsonKey(lowered);
+            reserved = found != nullptr;
+            return found && found->Exact == key ? found : nullptr;
+        }
+
+        // NDJSON lines from one producer share their key layout. The
+        // extractor reads each line with JsonObjectReader and, while the keys
+        // come in the same order as on the line before, reuses the learned
+        // slot of every position; a new layout is classified once through
+        // the key table. The record is the one ParseJsonObject builds.
+        class JsonLineExtractor
+        {
+        public:
+            bool TryExtract(std::string_view line, LogRecord& result)
+            {
+                JsonObjectReader reader(line);
+                size_t count = 0;
+                while (true)
+                {
+                    if (count == m_members.size())
+                    {
+                        m_members.emplace_back();
+                    }
+                    auto& member = m_members[count];
+                    if (!reader.Next(member.Key, member.KeyBuffer, member.Value, member.ValueBuffer))
+                    {
+                        break;
+                    }
+                    ++count;
+                }
+                if (reader.Failed())
+                {
+                    return false;
+                }
+
+                if (!MatchesLayout(count))
+                {
+                    Learn(count);
+                }
+
+                result = LogRecord{};
+                result.Raw = std::string(line);
+                std::string_view fields[c_jsonFieldSlots];
+                for (size_t slot = 0; slot < c_jsonFieldSlots; ++slot)
+                {
+                    if (m_fieldPositions[slot] < count)
+                    {
+                        fields[slot] = m_members[m_fieldPositions[slot]].Value;
+                    }
+                }
+
+                auto timestamp = fields[static_cast<size_t>(JsonSlot::Timestamp)];
+                if (!timestamp.empty())
+                {
+                    result.OccurredOn = ParseTimestamp(timestamp);
+                    result.Timestamp = std::string(timestamp);
+                }
+                auto level = fields[static_cast<size_t>(JsonSlot::Level)];
+                if (!level.empty())
+                {
+                    result.Level = NormalizeLevel(level);
+                }
+                result.Source = std::string(fields[static_cast<size_t>(JsonSlot::Source)]);
+                auto message = fields[static_cast<size_t>(JsonSlot::Message)];
+                result.Message = message.empty() ? result.Raw : std::string(message);
+
+                for (auto position : m_contextPositions)
+                {
+                    auto const& member = m_members[position];
+                    if (!result.Context.empty())
+                    {
+                        result.Context.append(" | ");
+                    }
+                    result.Context.append(member.Key).append("=").append(member.Value);
+                }
+                return true;
+            }
+
+        private:
+            // Views point into the line or into this member's buffers, which
+            // a deque keeps in place as it grows.
+            struct Member
+            {
+                std::string_view Key;
+                std::string_view Value;
+                std::string KeyBuffer;
+                std::string ValueBuffer;
+            };
+
+            std::deque<Member> m_members;
+            std::vector<std::string> m_layout;
+            size_t m_fieldPositions[c_jsonFieldSlots]{};
+            std::vector<size_t> m_contextPositions;
+            std::string m_lowered;
+
+            bool MatchesLayout(size_t count) const
+            {
+                if (count != m_layout.size())
+                {
+                    return false;
+                }
+                for (size_t i = 0; i < count; ++i)
+                {
+                    if (m_members[i].Key != m_layout[i])
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            void Learn(size_t count)
+            {
+                m_layout.resize(count);
+                m_contextPositions.clear();
+                uint8_t ranks[c_jsonFieldSlots];
+                for (size_t slot = 0; slot < c_jsonFieldSlots; ++slot)
+                {
+                    m_fieldPositions[slot] = std::numeric_limits<size_t>::max();
+                    ranks[slot] = std::numeric_limits<uint8_t>::max();
+                }
+
+                for (size_t i = 0; i < count; ++i)
+                {
+                    auto key = m_members[i].Key;
+                    m_layout[i].assign(key);
+                    bool reserved = false;
+                    auto field = ClassifyJsonKey(key, m_lowered, reserved);
+                    if (!reserved)
+                    {
+                        m_contextPositions.push_back(i);
+                    }
+                    // Lookups take the first member with a key, and the
+                    // earliest key in the field's list wins.
+                    else if (field && field->Rank < ranks[static_cast<size_t>(field->Slot)])
+                    {
+                        ranks[static_cast<size_t>(field->Slot)] = field->Rank;
+                        m_fieldPositions[static_cast<size_t>(field->Slot)] = i;
+                    }
+                }
+            }
+        };
+
+        // Parses the layout-specific way; on success result holds the record
+        // exactly as the cascade would have filled it for that layout.
+        bool TryFormat(LineFormat format, std::string_view trimmed, LogRecord& result, ParseContext const& context)
+        {
+            if (format == LineFormat::Json)
+            {
+                thread_local JsonLineExtractor extractor;
+                return trimmed.front() == '{' && extractor.TryExtract(trimmed, result);
+            }
+
+            LineScanner scanner(trimmed, context);
+            bool matched = false;
+            switch (format)
+            {
+            case LineFormat::Iso:
+                matched = scanner.TryIso(result);
+                break;
+            case LineFormat::Syslog:
+                matched = scanner.TrySyslog(result);
+                break;
+            case LineFormat::KeyValue:
+                matched = scanner.TryKeyValue(result);
+                break;
+            case LineFormat::LevelPrefixed:
+                matched = scanner.TrySimpleLevel(result);
+                break;
+            default:
+                return false;
+            }
+            if (matched)
+            {
+                result.Raw = std::string(trimmed);
+            }
+            return matched;
+        }
+
+        // The JSON / ISO / syslog / kv / level cascade; `skip` names a layout
+        // the caller already tried.
+        LogRecord ParseTrimmed(std::string_view trimmed, LineFormat skip, LineFormat& format,
+            ParseContext const& context)
+        {
+            LogRecord result;
+            for (auto candidate : { LineFormat::Json, LineFormat::Iso, LineFormat::Syslog, LineFormat::KeyValue,
+                LineFormat::LevelPrefixed })
+            {
+                if (candidate != skip && TryFormat(candidate, trimmed, result, context))
+                {
+                    format = candidate;
+                    return result;
+                }
+            }
+
+            format = LineFormat::Plain;
+            result.Raw = std::string(trimmed);
+            result.Message = result.Raw;
+            return result;
+        }
+    }
+
+    std::string_view LineFormatName(LineFormat format)
+    {
+        switch (format)
+        {
+        case LineFormat::Json:
+            return "json";
+        case LineFormat::Iso:
+            return "iso";
+        case LineFormat::Syslog:
+            return "syslog";
+        case LineFormat::KeyValue:
+            return "kv";
+        case LineFormat::LevelPrefixed:
+            return "level";
+        case LineFormat::Plain:
+            return "plain";
+        default:
+            return "mixed";
+        }
+    }
+
+    std::optional<LogRecord> ParseLine(std::string_view line, ParseContext const& context)
+    {
+        LineFormat format;
+        return ParseLine(line, format, context);
+    }
+
+    std::optional<LogRecord> ParseLine(std::string_view line, LineFormat& format, ParseContext const& context)
+    {
+        auto trimmed = TrimView(line);
+        if (trimmed.empty())
+        {
+            return std::nullopt;
+        }
+        return ParseTrimmed(trimmed, LineFormat::Mixed, format, context);
+    }
+
+    std::optional<LogRecord> ParseLineAs(LineFormat expected, std::string_view line, bool& hit,
+        ParseContext const& context)
+    {
+        auto trimmed = TrimView(line);
+        if (trimmed.empty())
+        {
+            hit = true;
+            return std::nullopt;
+        }
+
+        LogRecord result;
+        if (TryFormat(expected, trimmed, result, context))
+        {
+            hit = true;
+            return result;
+        }
+
+        LineFormat format;
+        auto fallback = ParseTrimmed(trimmed, expected, format, context);
+        hit = format == expected;
+        return fallback;
+    }
+
+    LineFormat DetectLineFormat(std::string_view text, size_t sampleLines)
+    {
+        size_t counts[c_lineFormatCount] = {};
+        size_t sampled = 0;
+        ParseContext context;
+        ForEachLine(text.substr(0, c_detectionBytes), [&](std::string_view line)
+        {
+            LineFormat format;
+            if (sampled < sampleLines && ParseLine(line, format, context))
+            {
+                ++counts[static_cast<size_t>(format)];
+                ++sampled;
+            }
+        });
+
+        auto dominant = std::max_element(std::begin(counts), std::end(counts));
+        if (sampled == 0 || *dominant * 2 <= sampled)
+        {
+            return LineFormat::Mixed;
+        }
+        return static_cast<LineFormat>(dominant - std::begin(counts));
+    }
+
+    LogRecord ParseJsonObject(JsonValue const& object, std::string_view rawLine)
+    {
+        LogRecord result;
+        result.Raw = std::string(rawLine);
+
+        auto getValue = [&](std::initializer_list<std::string_view> keys) -> std::string
+        {
+            for (auto key : keys)
+            {
+                if (auto value = object.Lookup(key))
+                {
+                    return JsonValueToText(*value);
+                }
+            }
+            return "";
+        };
+
+        auto timestamp = getValue({ "timestamp", "time", "@timestamp", "datetime", "date", "eventTime" });
+        if (!timestamp.empty())
+        {
+            result.OccurredOn = ParseTimestamp(timestamp);
+            result.Timestamp = std::move(timestamp);
+        }
+
+        auto level = getValue({ "level", "severity", "logLevel", "lvl", "priority" });
+        if (!level.empty())
+        {
+            result.Level = NormalizeLevel(level);
+        }
+
+        result.Source = getValue({ "logger", "source", "module", "service", "category", "name" });
+
+        auto message = getValue({ "message", "msg", "event", "description", "detail" });
+        result.Message = message.empty() ? result.Raw : std::move(message);
+
+        std::vector<std::string> contextPairs;
+        for (auto const& member : object.GetObject())
+        {
+            if (IsReservedJsonKey(ToLower(member.Key)))
+            {
+                continue;
+            }
+            contextPairs.push_back(member.Key + "=" + JsonValueToText(member.Value));
+        }
+
+        for (size_t i = 0; i < contextPairs.size(); ++i)
+        {
+            result.Context.append(contextPairs[i]);
+            if (i + 1 < contextPairs.size())
+            {
+                result.Context.append(" | ");
+            }
+        }
+
+        return result;
+    }
+}
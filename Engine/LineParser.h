@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Json.h"
+#include "LogRecord.h"
+#include "Timestamp.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace LogMinds::Engine
+{
+    // The layouts ParseLine recognizes, in cascade order. Mixed stands for
+    // "no single layout", i.e. always run the cascade.
+    enum class LineFormat : uint8_t
+    {
+        Mixed,
+        Json,
+        Iso,
+        Syslog,
+        KeyValue,
+        LevelPrefixed,
+        Plain,
+    };
+
+    std::string_view LineFormatName(LineFormat format);
+
+    // What a line does not say about itself: the time its syslog stamp is
+    // placed near (see ParseSyslogTimestamp), normally the file's last write
+    // time.
+    struct ParseContext
+    {
+        int64_t ReferenceTime{ CurrentTicks() };
+    };
+
+    // Returns std::nullopt for blank lines; every other line yields a record.
+    // The second overload also reports which layout produced it.
+    std::optional<LogRecord> ParseLine(std::string_view line, ParseContext const& context = {});
+    std::optional<LogRecord> ParseLine(std::string_view line, LineFormat& format, ParseContext const& context = {});
+
+    // Tries the parser for `expected` first and only runs the cascade for
+    // lines it rejects; hit is false for those. A line that both `expected`
+    // and an earlier cascade layout accept is read as `expected`.
+    std::optional<LogRecord> ParseLineAs(LineFormat expected, std::string_view line, bool& hit,
+        ParseContext const& context = {});
+
+    // Classifies up to sampleLines non-blank lines from the start of text and
+    // returns the layout that more than half of them share, or Mixed.
+    LineFormat DetectLineFormat(std::string_view text, size_t sampleLines = 4096);
+
+    LogRecord ParseJsonObject(JsonValue const& object, std::string_view rawLine);
+}
@@ -0,0 +1,118 @@
+#include "LineSplitter.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define LOGMINDS_HAS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace LogMinds::Engine
+{
+    namespace
+    {
+#if defined(LOGMINDS_HAS_SSE2)
+        inline unsigned CountTrailingZeros(uint32_t mask)
+        {
+#if defined(_MSC_VER)
+            unsigned long index = 0;
+            _BitScanForward(&index, mask);
+            return static_cast<unsigned>(index);
+#else
+            return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+        }
+
+        inline unsigned PopCount(uint32_t mask)
+        {
+#if defined(_MSC_VER)
+            return static_cast<unsigned>(__popcnt(mask));
+#else
+            return static_cast<unsigned>(__builtin_popcount(mask));
+#endif
+        }
+#endif
+    }
+
+    char const* FindNewline(char const* begin, char const* end)
+    {
+#if defined(LOGMINDS_HAS_SSE2)
+        auto const newline = _mm_set1_epi8('\n');
+        auto cursor = begin;
+        while (end - cursor >= 32)
+        {
+            auto low = _mm_loadu_si128(reinterpret_cast<__m128i const*>(cursor));
+            auto high = _mm_loadu_si128(reinterpret_cast<__m128i const*>(cursor + 16));
+            auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(low, newline))) |
+                (static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(high, newline))) << 16);
+            if (mask != 0)
+            {
+                return cursor + CountTrailingZeros(mask);
+            }
+            cursor += 32;
+        }
+        while (cursor < end && *cursor != '\n')
+        {
+            ++cursor;
+        }
+        return cursor;
+#else
+        auto found = static_cast<char const*>(std::memchr(begin, '\n', static_cast<size_t>(end - begin)));
+        return found != nullptr ? found : end;
+#endif
+    }
+
+    size_t CountNewlines(std::string_view text)
+    {
+        auto cursor = text.data();
+        auto end = text.data() + text.size();
+        size_t count = 0;
+#if defined(LOGMINDS_HAS_SSE2)
+        auto const newline = _mm_set1_epi8('\n');
+        while (end - cursor >= 32)
+        {
+            auto low = _mm_loadu_si128(reinterpret_cast<__m128i const*>(cursor));
+            auto high = _mm_loadu_si128(reinterpret_cast<__m128i const*>(cursor + 16));
+            auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(low, newline))) |
+                (static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(high, newline))) << 16);
+            count += PopCount(mask);
+            cursor += 32;
+        }
+#endif
+        count += static_cast<size_t>(std::count(cursor, end, '\n'));
+        return count;
+    }
+
+    std::vector<std::string_view> SplitIntoChunks(std::string_view text, size_t chunkCount)
+    {
+        std::vector<std::string_view> chunks;
+        if (text.empty())
+        {
+            return chunks;
+        }
+
+        chunkCount = std::max<size_t>(1, chunkCount);
+        auto target = std::max<size_t>(1, text.size() / chunkCount);
+        auto begin = text.data();
+        auto end = text.data() + text.size();
+        auto cursor = begin;
+        while (cursor < end)
+        {
+            auto cut = cursor + std::min<size_t>(target, static_cast<size_t>(end - cursor));
+            if (cut < end)
+            {
+                auto newline = FindNewline(cut - 1, end);
+                cut = newline == end ? end : newline + 1;
+            }
+            chunks.emplace_back(cursor, static_cast<size_t>(cut - cursor));
+            cursor = cut;
+        }
+        return chunks;
+    }
+}
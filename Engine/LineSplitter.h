@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace LogMinds::Engine
+{
+    // Returns a pointer to the first '\n' in [begin, end), or end.
+    char const* FindNewline(char const* begin, char const* end);
+
+    // Counts '\n' bytes; used to size buffers and by the load benchmark.
+    size_t CountNewlines(std::string_view text);
+
+    // Cuts text into about chunkCount pieces, each ending just after a '\n'
+    // (except the last), so every line belongs to exactly one chunk.
+    std::vector<std::string_view> SplitIntoChunks(std::string_view text, size_t chunkCount);
+
+    // Calls handler(line) for every line in text, without the trailing '\n'.
+    template <typename Handler>
+    void ForEachLine(std::string_view text, Handler&& handler)
+    {
+        auto cursor = text.data();
+        auto end = text.data() + text.size();
+        while (cursor < end)
+        {
+            auto newline = FindNewline(cursor, end);
+            handler(std::string_view(cursor, static_cast<size_t>(newline - cursor)));
+            if (newline == end)
+            {
+                break;
+            }
+            cursor = newline + 1;
+        }
+    }
+}
@@ -0,0 +1,739 @@
+#include "LlmClient.h"
+
+#include "Json.h"
+#include "Text.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <optional>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace LogMinds::Engine
+{
+    namespace
+    {
+        // How often a stalled connect, send or read looks at the cancellation
+        // token, how long one address may take to accept the connection, and
+        // how long the server may stay silent before the request is given
+        // up. Local models can take minutes over a long prompt.
+        constexpr int c_pollMilliseconds = 200;
+        constexpr auto c_connectTimeout = std::chrono::seconds(10);
+        constexpr auto c_idleTimeout = std::chrono::minutes(5);
+        // Of an error reply, only this much is kept for the message.
+        constexpr size_t c_maxErrorBytes = 4096;
+        // Longest status line and headers, or chunk size line, accepted
+        // before the reply counts as malformed.
+        constexpr size_t c_maxHeadBytes = 64 * 1024;
+
+#if defined(_WIN32)
+        using SocketHandle = SOCKET;
+        constexpr SocketHandle c_invalidSocket = INVALID_SOCKET;
+#else
+        using SocketHandle = int;
+        constexpr SocketHandle c_invalidSocket = -1;
+#endif
+#if defined(MSG_NOSIGNAL)
+        // A server that hangs up must not raise SIGPIPE.
+        constexpr int c_sendFlags = MSG_NOSIGNAL;
+#else
+        constexpr int c_sendFlags = 0;
+#endif
+
+        std::optional<std::string> ReadEnvironment(char const* name)
+        {
+#if defined(_WIN32)
+            char* value = nullptr;
+            size_t length = 0;
+            if (_dupenv_s(&value, &length, name) != 0 || value == nullptr)
+            {
+                return std::nullopt;
+            }
+            std::string result(value);
+            std::free(value);
+            return result;
+#else
+            auto value = std::getenv(name);
+            return value ? std::optional<std::string>(value) : std::nullopt;
+#endif
+        }
+
+        struct Endpoint
+        {
+            std::string Host;
+            std::string Port;
+            std::string Path;
+        };
+
+        bool ParseUrl(std::string_view url, Endpoint& endpoint, std::string& error)
+        {
+            constexpr std::string_view c_scheme = "http://";
+            if (url.substr(0, c_scheme.size()) != c_scheme)
+            {
+                error = "only http:// endpoints are supported: " + std::string(url);
+                return false;
+            }
+            url.remove_prefix(c_scheme.size());
+            auto slash = url.find('/');
+            auto authority = url.substr(0, slash);
+            endpoint.Path = slash == std::string_view::npos ? "/" : std::string(url.substr(slash));
+            endpoint.Port = "80";
+            if (!authority.empty() && authority.front() == '[')
+            {
+                auto close = authority.find(']');
+                if (close == std::string_view::npos)
+                {
+                    error = "malformed host in " + std::string(url);
+                    return false;
+                }
+                endpoint.Host = std::string(authority.substr(1, close - 1));
+                authority.remove_prefix(close + 1);
+                if (!authority.empty() && authority.front() == ':')
+                {
+                    endpoint.Port = std::string(authority.substr(1));
+                }
+            }
+            else
+            {
+                auto colon = authority.rfind(':');
+                endpoint.Host = std::string(authority.substr(0, colon));
+                if (colon != std::string_view::npos)
+                {
+                    endpoint.Port = std::string(authority.substr(colon + 1));
+                }
+            }
+            if (endpoint.Host.empty() || endpoint.Port.empty())
+            {
+                error = "malformed endpoint " + std::string(url);
+                return false;
+            }
+            return true;
+        }
+
+        // A non-blocking socket. Every wait is a poll of c_pollMilliseconds
+        // at most, so that the cancellation token is looked at in between
+        // and no call is left blocking in the socket layer.
+        class Connection
+        {
+        public:
+            Connection() = default;
+            Connection(Connection const&) = delete;
+            Connection& operator=(Connection const&) = delete;
+
+            ~Connection()
+            {
+                Close();
+            }
+
+            // False with error empty when cancelled.
+            bool Open(Endpoint const& endpoint, CancellationToken const& cancel, std::string& error)
+            {
+#if defined(_WIN32)
+                static std::once_flag started;
+                std::call_once(started, []
+                {
+                    WSADATA data;
+                    WSAStartup(MAKEWORD(2, 2), &data);
+                });
+#endif
+                addrinfo hints{};
+                hints.ai_family = AF_UNSPEC;
+                hints.ai_socktype = SOCK_STREAM;
+                addrinfo* addresses = nullptr;
+                if (getaddrinfo(endpoint.Host.c_str(), endpoint.Port.c_str(), &hints, &addresses) != 0)
+                {
+                    error = "cannot resolve " + endpoint.Host;
+                    return false;
+                }
+                for (auto address = addresses; address != nullptr && m_socket == c_invalidSocket &&
+                    !cancel.IsCancelled(); address = address->ai_next)
+                {
+                    m_socket = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+                    if (m_socket != c_invalidSocket && !(MakeNonBlocking() && Connect(*address, cancel)))
+                    {
+                        Close();
+                    }
+                }
+                freeaddrinfo(addresses);
+                if (m_socket == c_invalidSocket && !cancel.IsCancelled())
+                {
+                    error = "cannot connect to " + endpoint.Host + ":" + endpoint.Port;
+                }
+                return m_socket != c_invalidSocket;
+            }
+
+            // False on an error, when cancelled, or when the server takes
+            // nothing for c_idleTimeout.
+            bool Send(std::string_view bytes, CancellationToken const& cancel)
+            {
+                auto lastProgress = std::chrono::steady_clock::now();
+                while (!bytes.empty())
+                {
+                    auto sent = send(m_socket, bytes.data(), static_cast<int>(std::min<size_t>(bytes.size(), 1 << 20)),
+                        c_sendFlags);
+                    if (sent > 0)
+                    {
+                        bytes.remove_prefix(static_cast<size_t>(sent));
+                        lastProgress = std::chrono::steady_clock::now();
+                        continue;
+                    }
+                    if (sent == 0 || !WouldBlock() || Wait(true) < 0 || cancel.IsCancelled() ||
+                        std::chrono::steady_clock::now() - lastProgress > c_idleTimeout)
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            // Bytes read, 0 once the server closed the connection, -1 on an
+            // error; timedOut is set when nothing arrived for a poll period.
+            long Receive(char* buffer, size_t size, bool& timedOut)
+            {
+                timedOut = false;
+                auto ready = Wait(false);
+                if (ready <= 0)
+                {
+                    timedOut = ready == 0;
+                    return -1;
+                }
+                auto received = recv(m_socket, buffer, static_cast<int>(size), 0);
+                if (received < 0)
+                {
+                    timedOut = WouldBlock();
+                }
+                return static_cast<long>(received);
+            }
+
+        private:
+            SocketHandle m_socket{ c_invalidSocket };
+
+            void Close()
+            {
+                if (m_socket != c_invalidSocket)
+                {
+#if defined(_WIN32)
+                    closesocket(m_socket);
+#else
+                    close(m_socket);
+#endif
+                    m_socket = c_invalidSocket;
+                }
+            }
+
+            bool MakeNonBlocking()
+            {
+#if defined(_WIN32)
+                u_long enabled = 1;
+                return ioctlsocket(m_socket, FIONBIO, &enabled) == 0;
+#else
+                auto flags = fcntl(m_socket, F_GETFL, 0);
+                return flags >= 0 && fcntl(m_socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+            }
+
+            // Whether the last call failed only because it would have had to
+            // wait.
+            static bool WouldBlock()
+            {
+#if defined(_WIN32)
+                auto code = WSAGetLastError();
+                return code == WSAEWOULDBLOCK || code == WSAEINPROGRESS || code == WSAEINTR;
+#else
+                return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINPROGRESS || errno == EINTR;
+#endif
+            }
+
+            // Waits at most c_pollMilliseconds for the socket to become
+            // readable (or writable); 1 when it is, 0 when the time ran out,
+            // -1 on an error. A failed connect counts as writable.
+            int Wait(bool writable)
+            {
+#if defined(_WIN32)
+                // WSAPoll misses failed connects on older Windows; select
+                // reports them as exceptions.
+                fd_set ready;
+                FD_ZERO(&ready);
+                FD_SET(m_socket, &ready);
+                fd_set failed;
+                FD_ZERO(&failed);
+                FD_SET(m_socket, &failed);
+                timeval timeout{ 0, c_pollMilliseconds * 1000 };
+                auto result = select(0, writable ? nullptr : &ready, writable ? &ready : nullptr, &failed, &timeout);
+                return result == SOCKET_ERROR ? -1 : result > 0 ? 1 : 0;
+#else
+                pollfd entry{ m_socket, static_cast<short>(writable ? POLLOUT : POLLIN), 0 };
+                auto result = poll(&entry, 1, c_pollMilliseconds);
+                if (result < 0)
+                {
+                    return errno == EINTR ? 0 : -1;
+                }
+                return result > 0 ? 1 : 0;
+#endif
+            }
+
+            bool Connect(addrinfo const& address, CancellationToken const& cancel)
+            {
+                if (connect(m_socket, address.ai_addr, static_cast<int>(address.ai_addrlen)) == 0)
+                {
+                    return true;
+                }
+                if (!WouldBlock())
+                {
+                    return false;
+                }
+                auto deadline = std::chrono::steady_clock::now() + c_connectTimeout;
+                while (!cancel.IsCancelled() && std::chrono::steady_clock::now() < deadline)
+                {
+                    auto ready = Wait(true);
+                    if (ready < 0)
+                    {
+                        return false;
+                    }
+                    if (ready > 0)
+                    {
+                        int failure = 0;
+                        socklen_t length = sizeof(failure);
+                        return getsockopt(m_socket, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&failure),
+                            &length) == 0 && failure == 0;
+                    }
+                }
+                return false;
+            }
+        };
+
+        // Undoes Transfer-Encoding: chunked.
+        class ChunkedDecoder
+        {
+        public:
+            // Appends the chunk data in bytes to output; false on malformed input.
+            bool Feed(std::string_view bytes, std::string& output)
+            {
+                for (size_t offset = 0; offset < bytes.size() && m_state != State::Finished;)
+                {
+                    if (m_state == State::Data)
+                    {
+                        auto take = std::min(m_remaining, bytes.size() - offset);
+                        output.append(bytes.substr(offset, take));
+                        offset += take;
+                        m_remaining -= take;
+                        if (m_remaining == 0)
+                        {
+                            m_state = State::DataEnd;
+                        }
+                        continue;
+                    }
+
+                    auto ch = bytes[offset++];
+                    if (ch != '\n')
+                    {
+                        if (m_line.size() == c_maxHeadBytes)
+                        {
+                            return false;
+                        }
+                        m_line.push_back(ch);
+                        continue;
+                    }
+                    auto line = TrimView(m_line);
+                    switch (m_state)
+                    {
+                    case State::Size:
+                    {
+                        line = line.substr(0, line.find(';'));
+                        if (line.empty() || line.size() > 15)
+                        {
+                            return false;
+                        }
+                        m_remaining = 0;
+                        for (auto digit : line)
+                        {
+                            auto value = digit >= '0' && digit <= '9' ? digit - '0' :
+                                digit >= 'a' && digit <= 'f' ? digit - 'a' + 10 :
+                                digit >= 'A' && digit <= 'F' ? digit - 'A' + 10 : -1;
+                            if (value < 0)
+                            {
+                                return false;
+                            }
+                            m_remaining = m_remaining * 16 + static_cast<size_t>(value);
+                        }
+                        m_state = m_remaining == 0 ? State::Trailer : State::Data;
+                        break;
+                    }
+                    case State::DataEnd:
+                        if (!line.empty())
+                        {
+                            return false;
+                        }
+                        m_state = State::Size;
+                        break;
+                    case State::Trailer:
+                        if (line.empty())
+                        {
+                            m_state = State::Finished;
+                        }
+                        break;
+                    default:
+                        break;
+                    }
+                    m_line.clear();
+                }
+                return true;
+            }
+
+            bool Finished() const
+            {
+                return m_state == State::Finished;
+            }
+
+        private:
+            enum class State
+            {
+                Size,
+                Data,
+                DataEnd,
+                Trailer,
+                Finished,
+            };
+
+            State m_state{ State::Size };
+            size_t m_remaining{ 0 };
+            std::string m_line;
+        };
+
+        bool StartsWithNoCase(std::string_view text, std::string_view prefix)
+        {
+            return text.size() >= prefix.size() && ToLower(text.substr(0, prefix.size())) == prefix;
+        }
+
+        // The message of an OpenAI-style {"error": {"message": ...}} object.
+        std::optional<std::string> ErrorMessage(JsonValue const& value)
+        {
+            auto error = value.Lookup("error");
+            if (!error)
+            {
+                return std::nullopt;
+            }
+            if (auto message = error->Lookup("message"); message && message->ValueType() == JsonValueType::String)
+            {
+                return message->GetString();
+            }
+            return JsonValueToText(*error);
+        }
+    }
+
+    LlmSettings LlmSettings::FromEnvironment()
+    {
+        LlmSettings settings;
+        if (auto url = ReadEnvironment("LOGMINDS_LLM_URL"); url && !url->empty())
+        {
+            settings.Url = *url;
+        }
+        if (auto model = ReadEnvironment("LOGMINDS_LLM_MODEL"); model && !model->empty())
+        {
+            settings.Model = *model;
+        }
+        if (auto key = ReadEnvironment("LOGMINDS_LLM_API_KEY"))
+        {
+            settings.ApiKey = *key;
+        }
+        if (auto tokens = ReadEnvironment("LOGMINDS_LLM_CONTEXT_TOKENS"))
+        {
+            auto value = std::strtoull(tokens->c_str(), nullptr, 10);
+            if (value != 0)
+            {
+                settings.ContextTokens = static_cast<size_t>(value);
+            }
+        }
+        return settings;
+    }
+
+    std::string BuildChatRequest(LlmSettings const& settings, std::vector<ChatMessage> const& messages)
+    {
+        std::string body = "{\"model\":";
+        AppendJsonString(body, settings.Model);
+        body += ",\"stream\":true,\"max_tokens\":" + std::to_string(settings.MaxReplyTokens) + ",\"messages\":[";
+        for (size_t index = 0; index < messages.size(); ++index)
+        {
+            body += index == 0 ? "{\"role\":" : ",{\"role\":";
+            AppendJsonString(body, messages[index].Role);
+            body += ",\"content\":";
+            AppendJsonString(body, messages[index].Content);
+            body.push_back('}');
+        }
+        body += "]}";
+        return body;
+    }
+
+    void ChatStreamParser::Feed(std::string_view bytes, std::function<void(std::string_view)> const& onText)
+    {
+        while (!bytes.empty() && !m_done)
+        {
+            auto newline = bytes.find('\n');
+            if (newline == std::string_view::npos)
+            {
+                m_line.append(bytes);
+                return;
+            }
+            if (m_line.empty())
+            {
+                ReadLine(bytes.substr(0, newline), onText);
+            }
+            else
+            {
+                m_line.append(bytes.substr(0, newline));
+                ReadLine(m_line, onText);
+                m_line.clear();
+            }
+            bytes.remove_prefix(newline + 1);
+        }
+    }
+
+    void ChatStreamParser::ReadLine(std::string_view line, std::function<void(std::string_view)> const& onText)
+    {
+        // Events other than data, comments and blank separators are ignored.
+        constexpr std::string_view c_data = "data:";
+        line = TrimView(line);
+        if (line.substr(0, c_data.size()) != c_data)
+        {
+            // A server that ignores "stream" answers with one JSON object.
+            JsonValue value;
+            if (!line.empty() && line.front() == '{' && JsonValue::TryParse(line, value))
+            {
+                if (auto error = ErrorMessage(value))
+                {
+                    m_error = *error;
+                    m_done = true;
+                }
+            }
+            return;
+        }
+        auto payload = TrimView(line.substr(c_data.size()));
+        if (payload == "[DONE]")
+        {
+            m_done = true;
+            return;
+        }
+
+        JsonValue value;
+        if (!JsonValue::TryParse(payload, value))
+        {
+            return;
+        }
+        if (auto error = ErrorMessage(value))
+        {
+            m_error = *error;
+            m_done = true;
+            return;
+        }
+        auto choices = value.Lookup("choices");
+        if (!choices || choices->ValueType() != JsonValueType::Array || choices->GetArray().empty())
+        {
+            return;
+        }
+        auto const& choice = choices->GetArray().front();
+        if (auto delta = choice.Lookup("delta"))
+        {
+            if (auto content = delta->Lookup("content"); content && content->ValueType() == JsonValueType::String &&
+                !content->GetString().empty())
+            {
+                onText(content->GetString());
+            }
+        }
+        if (auto reason = choice.Lookup("finish_reason"); reason && reason->ValueType() == JsonValueType::String)
+        {
+            m_done = true;
+        }
+    }
+
+    bool StreamChatCompletion(LlmSettings const& settings, std::string const& body,
+        std::function<bool(std::string_view)> const& onText, std::string& error, CancellationToken const& cancel)
+    {
+        Endpoint endpoint;
+        if (!ParseUrl(settings.Url, endpoint, error))
+        {
+            return false;
+        }
+        // A cancel before any reply ends the request like one during it:
+        // quietly, with whatever text was delivered.
+        Connection connection;
+        if (!connection.Open(endpoint, cancel, error))
+        {
+            return error.empty();
+        }
+
+        std::string request = "POST " + endpoint.Path + " HTTP/1.1\r\nHost: " + endpoint.Host + ":" + endpoint.Port +
+            "\r\nContent-Type: application/json\r\nAccept: text/event-stream\r\nConnection: close\r\nContent-Length: " +
+            std::to_string(body.size()) + "\r\n";
+        if (!settings.ApiKey.empty())
+        {
+            request += "Authorization: Bearer " + settings.ApiKey + "\r\n";
+        }
+        request += "\r\n";
+        if (!connection.Send(request, cancel) || !connection.Send(body, cancel))
+        {
+            if (cancel.IsCancelled())
+            {
+                return true;
+            }
+            error = "cannot send the request to " + settings.Url;
+            return false;
+        }
+
+        std::string head;
+        std::optional<int> status;
+        bool chunked = false;
+        ChunkedDecoder decoder;
+        ChatStreamParser parser;
+        std::string decoded;
+        std::string errorBody;
+        bool stopped = false;
+        auto deliver = [&](std::string_view text)
+        {
+            if (!stopped && !onText(text))
+            {
+                stopped = true;
+            }
+        };
+        // Passes body bytes on; false once nothing more is wanted.
+        auto consume = [&](std::string_view bytes)
+        {
+            if (chunked)
+            {
+                decoded.clear();
+                if (!decoder.Feed(bytes, decoded))
+                {
+                    error = "malformed chunked reply from " + settings.Url;
+                    return false;
+                }
+                bytes = decoded;
+            }
+            if (*status != 200)
+            {
+                errorBody.append(bytes.substr(0, c_maxErrorBytes - std::min(c_maxErrorBytes, errorBody.size())));
+                return !(chunked && decoder.Finished());
+            }
+            parser.Feed(bytes, deliver);
+            return !parser.Done() && !stopped && !(chunked && decoder.Finished());
+        };
+
+        char buffer[16 * 1024];
+        auto lastActivity = std::chrono::steady_clock::now();
+        bool broken = false;
+        for (;;)
+        {
+            if (cancel.IsCancelled())
+            {
+                return true;
+            }
+            bool timedOut = false;
+            auto received = connection.Receive(buffer, sizeof(buffer), timedOut);
+            if (received < 0 && timedOut)
+            {
+                if (std::chrono::steady_clock::now() - lastActivity > c_idleTimeout)
+                {
+                    error = "no reply from " + settings.Url;
+                    return false;
+                }
+                continue;
+            }
+            if (received <= 0)
+            {
+                // An error rather than the server closing the connection.
+                broken = received < 0;
+                break;
+            }
+            lastActivity = std::chrono::steady_clock::now();
+            std::string_view bytes(buffer, static_cast<size_t>(received));
+
+            if (!status)
+            {
+                head.append(bytes);
+                auto end = head.find("\r\n\r\n");
+                if (end == std::string::npos)
+                {
+                    if (head.size() > c_maxHeadBytes)
+                    {
+                        error = "malformed reply from " + settings.Url;
+                        return false;
+                    }
+                    continue;
+                }
+                // "HTTP/1.1 200 OK", then one header per line.
+                auto space = head.find(' ');
+                status = space == std::string::npos ? 0 : std::atoi(head.c_str() + space + 1);
+                for (size_t line = head.find("\r\n") + 2; line < end;)
+                {
+                    auto next = head.find("\r\n", line);
+                    auto header = std::string_view(head).substr(line, next - line);
+                    if (StartsWithNoCase(header, "transfer-encoding:") &&
+                        ToLower(header).find("chunked") != std::string::npos)
+                    {
+                        chunked = true;
+                    }
+                    line = next + 2;
+                }
+                bytes = std::string_view(head).substr(end + 4);
+                if (!consume(bytes))
+                {
+                    break;
+                }
+                continue;
+            }
+            if (!consume(bytes))
+            {
+                break;
+            }
+        }
+
+        if (!error.empty())
+        {
+            return false;
+        }
+        if (!status)
+        {
+            error = "no reply from " + settings.Url;
+            return false;
+        }
+        if (*status != 200)
+        {
+            JsonValue value;
+            auto message = JsonValue::TryParse(errorBody, value) ? ErrorMessage(value) : std::nullopt;
+            error = "HTTP " + std::to_string(*status) + " from " + settings.Url + ": " +
+                (message ? *message : std::string(TrimView(errorBody)));
+            return false;
+        }
+        if (!parser.Error().empty())
+        {
+            error = parser.Error();
+            return false;
+        }
+        // Text that stops without [DONE], a finish reason or the last chunk
+        // is a reply cut short, not a complete one.
+        if (!parser.Done() && !stopped && !(chunked && decoder.Finished()))
+        {
+            error = broken ? "the connection to " + settings.Url + " broke off during the reply" :
+                settings.Url + " closed the connection before the reply ended";
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Cancellation.h"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace LogMinds::Engine
+{
+    // Where LLM解读 sends its request: an OpenAI-compatible chat completions
+    // endpoint, such as a local llama.cpp, Ollama or vLLM server.
+    struct LlmSettings
+    {
+        // http://host[:port]/path; https is not supported.
+        std::string Url{ "http://127.0.0.1:8080/v1/chat/completions" };
+        std::string Model{ "local" };
+        // Sent as a bearer token when set.
+        std::string ApiKey;
+        // Budget of the packed log context, in estimated tokens.
+        size_t ContextTokens{ 3000 };
+        size_t MaxReplyTokens{ 1024 };
+
+        // The defaults, overridden by LOGMINDS_LLM_URL, LOGMINDS_LLM_MODEL,
+        // LOGMINDS_LLM_API_KEY and LOGMINDS_LLM_CONTEXT_TOKENS when set.
+        static LlmSettings FromEnvironment();
+    };
+
+    struct ChatMessage
+    {
+        std::string Role;
+        std::string Content;
+    };
+
+    // The JSON body of a streamed chat completion request.
+    std::string BuildChatRequest(LlmSettings const& settings, std::vector<ChatMessage> const& messages);
+
+    // Reads the server-sent events of a streamed chat completion as they
+    // arrive, in pieces of any size, and hands out the content of each
+    // chunk's first choice.
+    class ChatStreamParser
+    {
+    public:
+        void Feed(std::string_view bytes, std::function<void(std::string_view)> const& onText);
+
+        // After "data: [DONE]" or a chunk with a finish_reason.
+        bool Done() const
+        {
+            return m_done;
+        }
+
+        // The message of an error object the server sent instead of a chunk.
+        std::string const& Error() const
+        {
+            return m_error;
+        }
+
+    private:
+        std::string m_line;
+        bool m_done{ false };
+        std::string m_error;
+
+        void ReadLine(std::string_view line, std::function<void(std::string_view)> const& onText);
+    };
+
+    // Posts body to settings.Url and passes the reply's content to onText
+    // as it streams in, until the reply ends, onText returns false or
+    // cancel is set. False with error set when the endpoint could not be
+    // reached, answered with an error or broke off before the reply ended.
+    bool StreamChatCompletion(LlmSettings const& settings, std::string const& body,
+        std::function<bool(std::string_view)> const& onText, std::string& error, CancellationToken const& cancel = {});
+}
@@ -0,0 +1,266 @@
+#include "LogCache.h"
+
+#include "BinaryIo.h"
+#include "MappedFile.h"
+#include "Timestamp.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <system_error>
+#include <thread>
+
+namespace LogMinds::Engine
+{
+    namespace
+    {
+        constexpr char c_magic[8] = { 'L', 'M', 'C', 'A', 'C', 'H', 'E', '\x1A' };
+        constexpr uint32_t c_endMark = 0x444E454C; // "LEND"
+        constexpr size_t c_edgeBytes = 64 * 1024;
+        constexpr size_t c_sampleBytes = 4 * 1024;
+        constexpr size_t c_samples = 16;
+
+        constexpr uint8_t c_hasAttributes = 1;
+        constexpr uint8_t c_hasSearchIndex = 2;
+
+        uint64_t Fnv1a(std::string_view bytes, uint64_t hash = 14695981039346656037ull)
+        {
+            for (auto byte : bytes)
+            {
+                hash = (hash ^ static_cast<unsigned char>(byte)) * 1099511628211ull;
+            }
+            return hash;
+        }
+
+        uint64_t SampledHash(std::string_view text)
+        {
+            uint64_t size = text.size();
+            auto hash = Fnv1a(std::string_view(reinterpret_cast<char const*>(&size), sizeof(size)));
+            if (text.size() <= 2 * c_edgeBytes + c_samples * c_sampleBytes)
+            {
+                return Fnv1a(text, hash);
+            }
+            hash = Fnv1a(text.substr(0, c_edgeBytes), hash);
+            auto span = text.size() - 2 * c_edgeBytes - c_sampleBytes;
+            for (size_t sample = 0; sample < c_samples; ++sample)
+            {
+                hash = Fnv1a(text.substr(c_edgeBytes + span * sample / (c_samples - 1), c_sampleBytes), hash);
+            }
+            return Fnv1a(text.substr(text.size() - c_edgeBytes), hash);
+        }
+
+        int64_t LastWriteTime(std::filesystem::path const& path)
+        {
+            std::error_code code;
+            auto time = std::filesystem::last_write_time(path, code);
+            return code ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+        }
+
+        struct EntryHeader
+        {
+            std::string Source;
+            SourceStamp Stamp;
+            ParseReport Report;
+            uint8_t Sections{ 0 };
+        };
+
+        bool ReadHeader(BinaryReader& reader, EntryHeader& header)
+        {
+            char magic[sizeof(c_magic)];
+            uint32_t version = 0;
+            uint8_t extendable = 0;
+            uint8_t format = 0;
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            if (!reader.Bytes(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), c_magic) ||
+                !reader.Value(version) || version != LogCache::c_version || !reader.String(header.Source) ||
+                !reader.Value(header.Stamp.Size) || !reader.Value(header.Stamp.ModifiedTime) ||
+                !reader.Value(header.Stamp.ContentHash) || !reader.Value(extendable) || !reader.Value(format) ||
+                !reader.Value(hits) || !reader.Value(misses) || !reader.Value(header.Sections) ||
+                format > static_cast<uint8_t>(LineFormat::Plain))
+            {
+                return false;
+            }
+            header.Stamp.Extendable = extendable != 0;
+            header.Report.Format = static_cast<LineFormat>(format);
+            header.Report.Hits = static_cast<size_t>(hits);
+            header.Report.Misses = static_cast<size_t>(misses);
+            return true;
+        }
+    }
+
+    SourceStamp SourceStamp::Of(std::filesystem::path const& path, std::string_view text)
+    {
+        SourceStamp stamp;
+        stamp.Size = text.size();
+        stamp.ModifiedTime = LastWriteTime(path);
+        stamp.ContentHash = SampledHash(text);
+        stamp.Extendable = !text.empty() && text.back() == '\n' && IsLineOriented(text);
+        return stamp;
+    }
+
+    std::string_view CacheStateName(CacheState state)
+    {
+        switch (state)
+        {
+        case CacheState::Stale:
+            return "stale";
+        case CacheState::Fresh:
+            return "fresh";
+        case CacheState::Extended:
+            return "extended";
+        default:
+            return "missing";
+        }
+    }
+
+    LogCache::LogCache(std::filesystem::path directory) : m_directory(std::move(directory))
+    {
+    }
+
+    std::filesystem::path LogCache::DefaultDirectory()
+    {
+        std::error_code code;
+        return std::filesystem::temp_directory_path(code) / "LogMinds" / "cache";
+    }
+
+    std::filesystem::path LogCache::EntryPath(std::filesystem::path const& source) const
+    {
+        std::error_code code;
+        auto absolute = std::filesystem::absolute(source, code);
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.lmc",
+            static_cast<unsigned long long>(Fnv1a((code ? source : absolute).u8string())));
+        return m_directory / name;
+    }
+
+    CacheState LogCache::Load(std::filesystem::path const& source, std::string_view text, unsigned threadCount,
+        CachedLog& log) const
+    {
+        auto entry = std::make_shared<MappedFile>();
+        std::string error;
+        if (!entry->Open(EntryPath(source), error))
+        {
+            return CacheState::Missing;
+        }
+
+        BinaryReader reader(entry->Text());
+        EntryHeader header;
+        std::error_code code;
+        if (!ReadHeader(reader, header) || header.Source != std::filesystem::absolute(source, code).u8string())
+        {
+            return CacheState::Missing;
+        }
+
+        auto fresh = header.Stamp.Size == text.size() && header.Stamp.ModifiedTime == LastWriteTime(source) &&
+            header.Stamp.ContentHash == SampledHash(text);
+        auto grown = !fresh && header.Stamp.Extendable && text.size() > header.Stamp.Size &&
+            header.Stamp.ContentHash == SampledHash(text.substr(0, static_cast<size_t>(header.Stamp.Size)));
+        if (!fresh && !grown)
+        {
+            return CacheState::Stale;
+        }
+
+        CachedLog read;
+        read.Report = header.Report;
+        if (!read.Store.Read(reader, entry))
+        {
+            return CacheState::Stale;
+        }
+        if (fresh)
+        {
+            if (header.Sections & c_hasAttributes)
+            {
+                read.Attributes.emplace();
+                if (!read.Attributes->Read(reader, read.Store))
+                {
+                    return CacheState::Stale;
+                }
+            }
+            if (header.Sections & c_hasSearchIndex)
+            {
+                read.SearchIndex.emplace();
+                if (!read.SearchIndex->Read(reader, read.Store, threadCount))
+                {
+                    return CacheState::Stale;
+                }
+            }
+            uint32_t end = 0;
+            if (!reader.Value(end) || end != c_endMark)
+            {
+                return CacheState::Stale;
+            }
+            log = std::move(read);
+            return CacheState::Fresh;
+        }
+
+        ParseReport appended;
+        read.Store.Append(ParseLines(text.substr(static_cast<size_t>(header.Stamp.Size)), read.Report.Format,
+            threadCount, &appended, ParseContext{ LastWriteTicks(source) }));
+        read.Report.Hits += appended.Hits;
+        read.Report.Misses += appended.Misses;
+        log = std::move(read);
+        return CacheState::Extended;
+    }
+
+    bool LogCache::Save(std::filesystem::path const& source, SourceStamp const& stamp, LogStore const& store,
+        ParseReport const& report, AttributeIndex const* attributes, TrigramIndex const* searchIndex,
+        std::string& error) const
+    {
+        std::error_code code;
+        std::filesystem::create_directories(m_directory, code);
+        auto path = EntryPath(source);
+        auto temporary = path;
+        temporary += ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+        {
+            std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+            if (!stream)
+            {
+                error = "cannot create " + temporary.u8string();
+                return false;
+            }
+
+            BinaryWriter writer(stream);
+            writer.Bytes(c_magic, sizeof(c_magic));
+            writer.Value(c_version);
+            writer.String(std::filesystem::absolute(source, code).u8string());
+            writer.Value(stamp.Size);
+            writer.Value(stamp.ModifiedTime);
+            writer.Value(stamp.ContentHash);
+            writer.Value<uint8_t>(stamp.Extendable ? 1 : 0);
+            writer.Value(static_cast<uint8_t>(report.Format));
+            writer.Value<uint64_t>(report.Hits);
+            writer.Value<uint64_t>(report.Misses);
+            writer.Value<uint8_t>((attributes ? c_hasAttributes : 0) | (searchIndex ? c_hasSearchIndex : 0));
+            store.Write(writer);
+            if (attributes)
+            {
+                attributes->Write(writer);
+            }
+            if (searchIndex)
+            {
+                searchIndex->Write(writer);
+            }
+            writer.Value(c_endMark);
+            stream.flush();
+            if (!writer.Ok())
+            {
+                error = "cannot write " + temporary.u8string();
+                stream.close();
+                std::filesystem::remove(temporary, code);
+                return false;
+            }
+        }
+
+        std::filesystem::rename(temporary, path, code);
+        if (code)
+        {
+            error = "cannot replace " + path.u8string() + ": " + code.message();
+            std::filesystem::remove(temporary, code);
+            return false;
+        }
+        return true;
+    }
+}
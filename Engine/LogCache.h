@@ -0,0 +1,89 @@
+#pragma once
+
+#include "AttributeIndex.h"
+#include "LogDocument.h"
+#include "LogStore.h"
+#include "TrigramIndex.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace LogMinds::Engine
+{
+    // Identifies the contents of a source file without reading all of it:
+    // size, modification time and a hash of its first and last 64 KB plus
+    // 4 KB blocks spread evenly in between.
+    struct SourceStamp
+    {
+        uint64_t Size{ 0 };
+        int64_t ModifiedTime{ 0 };
+        uint64_t ContentHash{ 0 };
+        // Line-oriented text that ends with a newline, so that lines
+        // appended later can be parsed on their own.
+        bool Extendable{ false };
+
+        // text is the current contents of path.
+        static SourceStamp Of(std::filesystem::path const& path, std::string_view text);
+    };
+
+    // What a cache entry restores: the rows and how they were parsed, plus
+    // the indexes that had been built when it was saved.
+    struct CachedLog
+    {
+        LogStore Store;
+        ParseReport Report;
+        std::optional<AttributeIndex> Attributes;
+        std::optional<TrigramIndex> SearchIndex;
+    };
+
+    enum class CacheState
+    {
+        // No entry for the file, or one in an older format.
+        Missing,
+        // The file changed since the entry was saved.
+        Stale,
+        // The entry describes the file as it is.
+        Fresh,
+        // Lines were appended to the file; they were parsed onto the
+        // entry's rows. The indexes are not restored in this case.
+        Extended,
+    };
+
+    std::string_view CacheStateName(CacheState state);
+
+    // Parsed files kept as binary entries in a directory, one per source
+    // path: the store's columns, arena and dictionaries, the parse report
+    // and, when present, the attribute and trigram indexes. An entry is
+    // used while the source's stamp matches, and extended when the source
+    // only grew by whole lines. A loaded store reads its columns and arena
+    // in place from the mapped entry, which stays mapped until they are
+    // grown or released; entries are only ever replaced by renaming a new
+    // file over them, never rewritten.
+    class LogCache
+    {
+    public:
+        static constexpr uint32_t c_version = 4;
+
+        explicit LogCache(std::filesystem::path directory);
+
+        // <temp>/LogMinds/cache
+        static std::filesystem::path DefaultDirectory();
+
+        CacheState Load(std::filesystem::path const& source, std::string_view text, unsigned threadCount,
+            CachedLog& log) const;
+
+        // The entry is written to a temporary file and renamed into place,
+        // so that a reader never sees half of one. Either index may be null.
+        bool Save(std::filesystem::path const& source, SourceStamp const& stamp, LogStore const& store,
+            ParseReport const& report, AttributeIndex const* attributes, TrigramIndex const* searchIndex,
+            std::string& error) const;
+
+        std::filesystem::path EntryPath(std::filesystem::path const& source) const;
+
+    private:
+        std::filesystem::path m_directory;
+    };
+}
@@ -0,0 +1,322 @@
+#include "LogDocument.h"
+
+#include "Decompressor.h"
+#include "Json.h"
+#include "LineParser.h"
+#include "LineSplitter.h"
+#include "Parallel.h"
+#include "Text.h"
+
+#include <algorithm>
+#include <atomic>
+#include <optional>
+
+namespace LogMinds::Engine
+{
+    namespace
+    {
+        // Small files are not worth spreading across threads.
+        constexpr size_t c_minimumChunkBytes = 1 << 20;
+        constexpr size_t c_chunksPerThread = 8;
+
+        LogStore Concatenate(std::vector<LogStore>& partials)
+        {
+            if (partials.size() <= 1)
+            {
+                return partials.empty() ? LogStore() : std::move(partials.front());
+            }
+
+            size_t rows = 0;
+            size_t bytes = 0;
+            for (auto const& partial : partials)
+            {
+                rows += partial.Size();
+                bytes += partial.ArenaSize();
+            }
+
+            auto records = std::move(partials.front());
+            records.Reserve(rows, bytes);
+            for (size_t index = 1; index < partials.size(); ++index)
+            {
+                records.Append(std::move(partials[index]));
+            }
+            return records;
+        }
+
+        // Elements are located by a structural scan, then parsed one at a
+        // time in parallel batches; each element's Raw is its own text in the
+        // input, copied into the store's arena like any line. std::nullopt when
+        // the text is not a valid JSON array.
+        std::optional<LogStore> ParseJsonArray(std::string_view text, unsigned threadCount, ParseReport* report)
+        {
+            JsonArrayReader reader(text);
+            std::vector<std::string_view> elements;
+            std::string_view element;
+            while (reader.Next(element))
+            {
+                elements.push_back(element);
+            }
+            if (reader.Failed())
+            {
+                return std::nullopt;
+            }
+
+            auto threads = ResolveThreadCount(threadCount);
+            auto batchCount = std::max<size_t>(1, std::min<size_t>({ threads * c_chunksPerThread,
+                text.size() / c_minimumChunkBytes + 1, elements.size() }));
+            auto perBatch = (elements.size() + batchCount - 1) / batchCount;
+            std::vector<LogStore> partials(batchCount);
+            std::atomic<bool> invalid{ false };
+            ParallelFor(batchCount, threads, [&](size_t batch)
+            {
+                auto begin = std::min(elements.size(), batch * perBatch);
+                auto end = std::min(elements.size(), begin + perBatch);
+                auto& records = partials[batch];
+                if (begin < end)
+                {
+                    records.Reserve(end - begin, static_cast<size_t>(
+                        elements[end - 1].data() + elements[end - 1].size() - elements[begin].data()));
+                }
+                for (auto index = begin; index < end && !invalid.load(std::memory_order_relaxed); ++index)
+                {
+                    auto raw = elements[index];
+                    JsonValue item;
+                    if (!JsonValue::TryParse(raw, item))
+                    {
+                        invalid.store(true, std::memory_order_relaxed);
+                        return;
+                    }
+                    if (item.ValueType() == JsonValueType::Object)
+                    {
+                        records.Append(ParseJsonObject(item, raw));
+                    }
+                    else
+                    {
+                        LogRecord fallback;
+                        fallback.Raw = std::string(raw);
+                        fallback.Message = fallback.Raw;
+                        records.Append(fallback);
+                    }
+                }
+            });
+            if (invalid.load())
+            {
+                return std::nullopt;
+            }
+
+            auto records = Concatenate(partials);
+            if (report)
+            {
+                *report = { LineFormat::Json, records.Size(), 0, {} };
+            }
+            return records;
+        }
+    }
+
+    namespace
+    {
+        constexpr std::string_view c_utf8Bom = "\xEF\xBB\xBF";
+        constexpr std::string_view c_utf16LeBom = "\xFF\xFE";
+        constexpr std::string_view c_utf16BeBom = "\xFE\xFF";
+
+        // Whether ParseDocument would read text as something other than one
+        // entry per line, judging by its start: UTF-16, a JSON array, or an
+        // object that does not end on its first line.
+        bool NeedsWholeDocument(std::string_view start)
+        {
+            if (start.substr(0, 2) == c_utf16LeBom || start.substr(0, 2) == c_utf16BeBom)
+            {
+                return true;
+            }
+            auto first = TrimView(start.substr(0, 64));
+            if (first.empty() || (first.front() != '[' && first.front() != '{'))
+            {
+                return false;
+            }
+            if (first.front() == '[')
+            {
+                return true;
+            }
+            auto begin = start.find('{');
+            auto end = SkipJsonValue(start, begin);
+            return end == std::string_view::npos || start.substr(begin, end - begin).find('\n') != std::string_view::npos;
+        }
+
+        // Lines are parsed block by block as the decompressor delivers them;
+        // a line cut by a block boundary waits for the rest of it. Documents
+        // that need the whole text are gathered and parsed at the end.
+        LogStore ParseCompressed(std::string_view compressed, Compression compression, unsigned threadCount,
+            ParseReport* report, ParseContext const& context)
+        {
+            Decompressor decompressor(compressed, compression);
+            std::string block;
+            // The unfinished last line so far, or the whole document.
+            std::string carried;
+            std::vector<LogStore> partials;
+            ParseReport total;
+            std::optional<bool> whole;
+            auto parse = [&](std::string_view text)
+            {
+                ParseReport part;
+                partials.push_back(ParseLines(text, total.Format, threadCount, &part, context));
+                total.Hits += part.Hits;
+                total.Misses += part.Misses;
+            };
+
+            while (decompressor.Next(block))
+            {
+                std::string_view text(block);
+                if (!whole)
+                {
+                    if (text.substr(0, c_utf8Bom.size()) == c_utf8Bom)
+                    {
+                        text.remove_prefix(c_utf8Bom.size());
+                    }
+                    whole = NeedsWholeDocument(text);
+                    total.Format = DetectLineFormat(text);
+                }
+                if (*whole)
+                {
+                    carried.append(text);
+                    continue;
+                }
+
+                auto last = text.rfind('\n');
+                if (last == std::string_view::npos)
+                {
+                    carried.append(text);
+                    continue;
+                }
+                if (!carried.empty())
+                {
+                    auto first = text.find('\n');
+                    carried.append(text.substr(0, first + 1));
+                    parse(carried);
+                    carried.clear();
+                    text.remove_prefix(first + 1);
+                    last -= first + 1;
+                }
+                parse(text.substr(0, last + 1));
+                carried.assign(text.substr(last + 1));
+            }
+
+            LogStore records;
+            if (whole && *whole)
+            {
+                records = ParseDocument(carried, threadCount, &total, context);
+            }
+            else
+            {
+                if (!carried.empty())
+                {
+                    parse(carried);
+                }
+                records = Concatenate(partials);
+            }
+            total.Error = decompressor.Error();
+            if (report)
+            {
+                *report = std::move(total);
+            }
+            return records;
+        }
+    }
+
+    LogStore ParseDocument(std::string_view text, unsigned threadCount, ParseReport* report,
+        ParseContext const& context)
+    {
+        if (auto compression = DetectCompression(text); compression != Compression::None)
+        {
+            return ParseCompressed(text, compression, threadCount, report, context);
+        }
+
+        if (text.substr(0, c_utf8Bom.size()) == c_utf8Bom)
+        {
+            text.remove_prefix(c_utf8Bom.size());
+        }
+        else if (text.substr(0, 2) == c_utf16LeBom || text.substr(0, 2) == c_utf16BeBom)
+        {
+            auto utf8 = Utf16ToUtf8(text.substr(2), text.substr(0, 2) == c_utf16BeBom);
+            return ParseDocument(utf8, threadCount, report, context);
+        }
+
+        auto first = TrimView(text.substr(0, 64));
+        if (!first.empty() && first.front() == '[')
+        {
+            if (auto records = ParseJsonArray(text, threadCount, report))
+            {
+                return std::move(*records);
+            }
+        }
+        else if (!first.empty() && first.front() == '{')
+        {
+            // A single object spanning the file, as opposed to NDJSON.
+            auto end = SkipJsonValue(text, text.find('{'));
+            JsonValue json;
+            if (end != std::string_view::npos && TrimView(text.substr(end)).empty() && JsonValue::TryParse(text, json) &&
+                json.ValueType() == JsonValueType::Object)
+            {
+                LogStore records;
+                records.Append(ParseJsonObject(json, text));
+                if (report)
+                {
+                    *report = { LineFormat::Json, 1, 0, {} };
+                }
+                return records;
+            }
+        }
+
+        return ParseLines(text, threadCount, report, context);
+    }
+
+    bool IsLineOriented(std::string_view text)
+    {
+        if (text.substr(0, c_utf8Bom.size()) == c_utf8Bom)
+        {
+            text.remove_prefix(c_utf8Bom.size());
+        }
+        return DetectCompression(text) == Compression::None && !NeedsWholeDocument(text);
+    }
+
+    LogStore ParseLines(std::string_view text, unsigned threadCount, ParseReport* report, ParseContext const& context)
+    {
+        return ParseLines(text, DetectLineFormat(text), threadCount, report, context);
+    }
+
+    LogStore ParseLines(std::string_view text, LineFormat format, unsigned threadCount, ParseReport* report,
+        ParseContext const& context)
+    {
+        auto threads = ResolveThreadCount(threadCount);
+        auto chunkCount = std::min<size_t>(threads * c_chunksPerThread, text.size() / c_minimumChunkBytes + 1);
+        auto chunks = SplitIntoChunks(text, chunkCount);
+
+        std::vector<LogStore> partials(chunks.size());
+        std::vector<size_t> misses(chunks.size());
+        ParallelFor(chunks.size(), threads, [&](size_t index)
+        {
+            auto& records = partials[index];
+            records.Reserve(0, chunks[index].size());
+            ForEachLine(chunks[index], [&](std::string_view line)
+            {
+                bool hit = true;
+                if (auto parsed = ParseLineAs(format, line, hit, context))
+                {
+                    records.Append(*parsed);
+                    misses[index] += hit ? 0 : 1;
+                }
+            });
+        });
+
+        if (report)
+        {
+            *report = { format, 0, 0, {} };
+            for (size_t index = 0; index < chunks.size(); ++index)
+            {
+                report->Hits += partials[index].Size() - misses[index];
+                report->Misses += misses[index];
+            }
+        }
+
+        return Concatenate(partials);
+    }
+}
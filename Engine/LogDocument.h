@@ -0,0 +1,48 @@
+#pragma once
+
+#include "LineParser.h"
+#include "LogStore.h"
+
+#include <string>
+#include <string_view>
+
+namespace LogMinds::Engine
+{
+    // How a document was read: the layout picked from the first lines and
+    // how many lines its parser accepted (Hits) versus handed to the full
+    // cascade (Misses). A large miss rate means the file is mixed.
+    struct ParseReport
+    {
+        LineFormat Format{ LineFormat::Mixed };
+        size_t Hits{ 0 };
+        size_t Misses{ 0 };
+        // Set when compressed input could not be read to its end; the rows
+        // decoded before the problem are still returned.
+        std::string Error;
+    };
+
+    // Parses a whole log file: a JSON array/object document, or one entry per
+    // line. Line-oriented input is split into newline-aligned chunks that are
+    // parsed on threadCount workers (0 = all cores) and concatenated in order.
+    // UTF-8 and UTF-16 (with BOM) input is accepted, and so is gzip or zstd
+    // compressed input: it is decompressed on a thread of its own while the
+    // lines decoded so far are being parsed. Loads of a file pass a context
+    // made from its last write time. The rows' text, a JSON array element's
+    // Raw included, is copied into the store's arena rather than pointing
+    // into text: the store outlives the mapping it was parsed from (it is
+    // followed, cached and merged after the file is closed), and compressed
+    // or UTF-16 input has no mapped bytes to point at.
+    LogStore ParseDocument(std::string_view text, unsigned threadCount = 0,
+        ParseReport* report = nullptr, ParseContext const& context = {});
+
+    // True when ParseDocument reads text one entry per line, as opposed to
+    // one JSON document, UTF-16 or compressed data; only then can lines
+    // appended later be parsed on their own.
+    bool IsLineOriented(std::string_view text);
+
+    LogStore ParseLines(std::string_view text, unsigned threadCount = 0,
+        ParseReport* report = nullptr, ParseContext const& context = {});
+    // Same, with the layout already known.
+    LogStore ParseLines(std::string_view text, LineFormat format, unsigned threadCount = 0,
+        ParseReport* report = nullptr, ParseContext const& context = {});
+}
@@ -0,0 +1,200 @@
+#include "LogFollower.h"
+
+#include "LogDocument.h"
+#include "Timestamp.h"
+
+#include <algorithm>
+#include <fstream>
+#include <string_view>
+
+namespace LogMinds::Engine
+{
+    namespace
+    {
+        constexpr size_t c_fingerprintBytes = 64;
+        // Enough of the start of a file to tell whether it is line oriented.
+        constexpr uint64_t c_probeBytes = 1ull << 20;
+        // A backlog larger than this is parsed over several polls.
+        constexpr uint64_t c_maxBatchBytes = 64ull << 20;
+        constexpr std::string_view c_utf8Bom = "\xEF\xBB\xBF";
+
+        void ReadRange(std::ifstream& file, uint64_t offset, uint64_t count, std::string& buffer)
+        {
+            buffer.resize(static_cast<size_t>(count));
+            file.clear();
+            file.seekg(static_cast<std::streamoff>(offset));
+            file.read(buffer.data(), static_cast<std::streamsize>(count));
+            buffer.resize(static_cast<size_t>(std::max<std::streamsize>(file.gcount(), 0)));
+        }
+
+        // Just past the last newline in the first `end` bytes of file; 0 when
+        // there is none.
+        uint64_t LineStart(std::ifstream& file, uint64_t end, std::string& buffer)
+        {
+            constexpr uint64_t c_blockBytes = 64 << 10;
+            while (end != 0)
+            {
+                auto begin = end - std::min(end, c_blockBytes);
+                ReadRange(file, begin, end - begin, buffer);
+                if (auto newline = buffer.rfind('\n'); newline != std::string::npos)
+                {
+                    return begin + newline + 1;
+                }
+                end = begin;
+            }
+            return 0;
+        }
+    }
+
+    LogFollower::LogFollower(std::filesystem::path path, std::shared_ptr<LogStore const> store, uint64_t offset,
+        UpdateHandler onUpdate, Clock::duration interval, unsigned threadCount) :
+        m_path(std::move(path)), m_rows(*store), m_offset(offset), m_onUpdate(std::move(onUpdate)),
+        m_interval(interval), m_threadCount(threadCount)
+    {
+        std::ifstream file(m_path, std::ios::binary);
+        if (file)
+        {
+            ReadRange(file, 0, std::min<uint64_t>(c_probeBytes, m_offset), m_buffer);
+            m_fingerprint = m_buffer.substr(0, c_fingerprintBytes);
+            m_lineOriented = IsLineOriented(m_buffer);
+            if (m_lineOriented && m_offset != 0)
+            {
+                auto start = LineStart(file, m_offset, m_buffer);
+                m_unfinished = m_offset - start;
+                m_offset = start;
+            }
+        }
+        m_thread = std::thread([this]()
+        {
+            Run();
+        });
+    }
+
+    LogFollower::~LogFollower()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+    }
+
+    void LogFollower::Run()
+    {
+        std::unique_lock lock(m_mutex);
+        while (!m_stopping)
+        {
+            lock.unlock();
+            FollowUpdate update;
+            if (Poll(update))
+            {
+                m_onUpdate(std::move(update));
+            }
+            lock.lock();
+            m_wake.wait_for(lock, m_interval, [this]()
+            {
+                return m_stopping;
+            });
+        }
+    }
+
+    bool LogFollower::Poll(FollowUpdate& update)
+    {
+        update.PolledAt = Clock::now();
+
+        // Missing for a moment while a rotation renames and recreates it.
+        std::error_code error;
+        auto size = std::filesystem::file_size(m_path, error);
+        if (error)
+        {
+            return false;
+        }
+        std::ifstream file(m_path, std::ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+
+        std::string prefix;
+        ReadRange(file, 0, std::min<uint64_t>(c_fingerprintBytes, size), prefix);
+        auto restart = size < m_offset + m_unfinished ||
+            prefix.compare(0, m_fingerprint.size(), m_fingerprint) != 0;
+        if (!restart && m_unfinished != 0)
+        {
+            if (size == m_offset + m_unfinished)
+            {
+                return false;
+            }
+            // The line still being written when following began has grown.
+            // A newline ends it as it was parsed; anything else changes rows
+            // already handed out, which cannot be taken back.
+            ReadRange(file, m_offset + m_unfinished, 1, m_buffer);
+            if (m_buffer == "\n")
+            {
+                m_offset += m_unfinished + 1;
+                m_unfinished = 0;
+            }
+            else
+            {
+                restart = true;
+            }
+        }
+        if (restart)
+        {
+            m_offset = 0;
+            m_unfinished = 0;
+        }
+        else if (size == m_offset || !m_lineOriented)
+        {
+            return false;
+        }
+        m_fingerprint = std::move(prefix);
+
+        auto count = std::min<uint64_t>(size - m_offset, c_maxBatchBytes);
+        ReadRange(file, m_offset, count, m_buffer);
+        if (restart)
+        {
+            // The rows followed so far stay as they are; the new file's
+            // fingerprint keeps it from being taken for an append.
+            m_lineOriented = IsLineOriented(m_buffer);
+            if (!m_lineOriented)
+            {
+                return false;
+            }
+        }
+        auto lastNewline = m_buffer.rfind('\n');
+        size_t complete = lastNewline == std::string::npos ? 0 : lastNewline + 1;
+        if (complete == 0 && m_buffer.size() == c_maxBatchBytes)
+        {
+            // One line longer than a whole batch; take it in pieces.
+            complete = m_buffer.size();
+        }
+
+        std::string_view text(m_buffer.data(), complete);
+        if (m_offset == 0 && text.substr(0, c_utf8Bom.size()) == c_utf8Bom)
+        {
+            text.remove_prefix(c_utf8Bom.size());
+        }
+        auto batch = ParseLines(text, m_threadCount, nullptr, ParseContext{ LastWriteTicks(m_path) });
+        m_offset += complete;
+        if (!restart && batch.Empty())
+        {
+            return false;
+        }
+
+        update.FirstNewRow = restart ? 0 : m_rows.Size();
+        update.Restarted = restart;
+        if (restart)
+        {
+            m_rows = std::move(batch);
+        }
+        else
+        {
+            m_rows.Append(std::move(batch));
+        }
+        update.Store = std::make_shared<LogStore const>(m_rows);
+        update.Offset = m_offset;
+        return true;
+    }
+}
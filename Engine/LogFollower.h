@@ -0,0 +1,92 @@
+#pragma once
+
+#include "LogStore.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace LogMinds::Engine
+{
+    struct FollowUpdate
+    {
+        // Every row followed so far; rows from FirstNewRow on arrived with
+        // this update.
+        std::shared_ptr<LogStore const> Store;
+        size_t FirstNewRow{ 0 };
+        // Bytes of the file behind Store; where a new follower would resume.
+        uint64_t Offset{ 0 };
+        // The file shrank or was replaced, so Store was read again from its
+        // first byte and FirstNewRow is 0.
+        bool Restarted{ false };
+        // When the poll that produced this update started.
+        std::chrono::steady_clock::time_point PolledAt;
+    };
+
+    // Watches a log file for appended lines on a background thread. Each
+    // poll reads the complete lines written since the last one, parses only
+    // those and hands over the grown store; a line still being written waits
+    // for its newline. A file smaller than the followed offset, or one whose
+    // first bytes changed, was truncated or rotated and is read again from
+    // the start. Polls are an interval apart and pick up everything written
+    // in between as one batch (up to a cap), so updates stay at a bounded
+    // rate however fast the file grows. Each update's store is a copy that
+    // shares its rows with the ones before it (see SharedColumn), so a poll
+    // costs the new rows rather than all of them. A file that is not line
+    // oriented (a JSON array, a compressed file) is not followed until it is
+    // replaced by one that is: appended bytes are no rows of their own. The
+    // handler runs on the follower thread.
+    class LogFollower
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+        using UpdateHandler = std::function<void(FollowUpdate&& update)>;
+
+        static constexpr std::chrono::milliseconds c_defaultInterval{ 250 };
+
+        // store holds the rows parsed from the first `offset` bytes of path.
+        // When those end inside a line, the line's rows are kept as long as
+        // the next byte written is its newline; should the line grow
+        // instead, the file is read again from the start.
+        LogFollower(std::filesystem::path path, std::shared_ptr<LogStore const> store, uint64_t offset,
+            UpdateHandler onUpdate, Clock::duration interval = c_defaultInterval, unsigned threadCount = 0);
+        ~LogFollower();
+
+        LogFollower(LogFollower const&) = delete;
+        LogFollower& operator=(LogFollower const&) = delete;
+
+    private:
+        std::filesystem::path m_path;
+        // Updates hand out copies of it. The first append moves it off the
+        // buffers it shares with the store it started from; later ones
+        // write past the end of every copy.
+        LogStore m_rows;
+        uint64_t m_offset;
+        // Bytes past m_offset that m_rows was parsed from, a line that had no
+        // newline yet when following began.
+        uint64_t m_unfinished{ 0 };
+        bool m_lineOriented{ true };
+        // The first bytes of the file as last read; a different prefix means
+        // a different file.
+        std::string m_fingerprint;
+        std::string m_buffer;
+        UpdateHandler m_onUpdate;
+        Clock::duration m_interval;
+        unsigned m_threadCount;
+
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        bool m_stopping{ false };
+        std::thread m_thread;
+
+        void Run();
+        // False when no new rows were read.
+        bool Poll(FollowUpdate& update);
+    };
+}
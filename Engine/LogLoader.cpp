@@ -0,0 +1,110 @@
+#include "LogLoader.h"
+
+#include "LineParser.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <string_view>
+
+namespace LogMinds::Engine
+{
+    namespace
+    {
+        constexpr std::string_view c_utf8Bom = "\xEF\xBB\xBF";
+    }
+
+    LogLoader::LogLoader(MappedFile file, UpdateHandler onUpdate, unsigned threadCount, ParseContext context) :
+        m_file(std::move(file)), m_onUpdate(std::move(onUpdate)), m_threadCount(threadCount), m_context(context)
+    {
+        m_thread = std::thread([this]()
+        {
+            Run();
+        });
+    }
+
+    LogLoader::~LogLoader()
+    {
+        Cancel();
+        m_thread.join();
+    }
+
+    void LogLoader::Run()
+    {
+        auto text = m_file.Text();
+        LoadUpdate update;
+        update.BytesTotal = text.size();
+        if (!IsLineOriented(text))
+        {
+            update.Store = std::make_shared<LogStore const>(ParseDocument(text, m_threadCount, &update.Report,
+                m_context));
+            update.BytesParsed = text.size();
+            update.Finished = true;
+            m_onUpdate(std::move(update));
+            return;
+        }
+
+        size_t offset = text.substr(0, c_utf8Bom.size()) == c_utf8Bom ? c_utf8Bom.size() : 0;
+        ParseReport report{ DetectLineFormat(text.substr(offset)), 0, 0, {} };
+        // The rows of the last update are a prefix of loaded; each update
+        // copies loaded so that its readers never see it grow.
+        LogStore loaded;
+        size_t shared = 0;
+
+        auto cancelled = false;
+        auto batchBytes = c_firstBatchBytes;
+        auto maxBatchBytes = c_batchBytesPerThread * ResolveThreadCount(m_threadCount);
+        while (offset < text.size())
+        {
+            if (m_cancelled.load(std::memory_order_relaxed))
+            {
+                cancelled = true;
+                break;
+            }
+
+            // Batches end after a newline, unless one line is longer than the
+            // batch and runs to the end of the text.
+            auto end = std::min(text.size(), offset + batchBytes);
+            if (end < text.size())
+            {
+                auto newline = text.rfind('\n', end - 1);
+                if (newline == std::string_view::npos || newline < offset)
+                {
+                    newline = text.find('\n', end);
+                }
+                end = newline == std::string_view::npos ? text.size() : newline + 1;
+            }
+
+            ParseReport part;
+            auto batch = ParseLines(text.substr(offset, end - offset), report.Format, m_threadCount, &part, m_context);
+            report.Hits += part.Hits;
+            report.Misses += part.Misses;
+            loaded.Append(std::move(batch));
+            offset = end;
+            batchBytes = std::min(batchBytes * 2, maxBatchBytes);
+            if (offset == text.size())
+            {
+                break;
+            }
+
+            LoadUpdate progress;
+            progress.BytesParsed = offset;
+            progress.BytesTotal = text.size();
+            if (loaded.Size() > shared * c_publishGrowth)
+            {
+                progress.Store = std::make_shared<LogStore const>(loaded);
+                progress.FirstNewRow = shared;
+                shared = loaded.Size();
+            }
+            m_onUpdate(std::move(progress));
+        }
+
+        // Rows parsed before a cancel are kept.
+        update.Store = std::make_shared<LogStore const>(std::move(loaded));
+        update.FirstNewRow = shared;
+        update.BytesParsed = offset;
+        update.Finished = true;
+        update.Cancelled = cancelled;
+        update.Report = std::move(report);
+        m_onUpdate(std::move(update));
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "LogDocument.h"
+#include "LogStore.h"
+#include "MappedFile.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+
+namespace LogMinds::Engine
+{
+    struct LoadUpdate
+    {
+        // Every row parsed so far; rows from FirstNewRow on arrived with this
+        // update. Null when only the progress moved.
+        std::shared_ptr<LogStore const> Store;
+        size_t FirstNewRow{ 0 };
+        uint64_t BytesParsed{ 0 };
+        uint64_t BytesTotal{ 0 };
+        // The last update of the load; Report covers every row in Store.
+        bool Finished{ false };
+        // Finished early through Cancel; Store holds the rows parsed until then.
+        bool Cancelled{ false };
+        ParseReport Report;
+    };
+
+    // Parses a file on a background thread and hands the rows over while the
+    // rest is still being read. Line-oriented text is parsed in batches that
+    // start small, so the first rows arrive within milliseconds, and grow to
+    // c_batchBytesPerThread per worker; every batch reports progress. Rows
+    // are handed over as a copy of the store, which shares its rows with it,
+    // once it has grown by c_publishGrowth since the last one, so the view
+    // takes them in a handful of times rather than once per batch. Anything
+    // that needs the whole document (JSON arrays, UTF-16, compressed input)
+    // arrives in one final update. The handler runs on the loader thread.
+    class LogLoader
+    {
+    public:
+        using UpdateHandler = std::function<void(LoadUpdate&& update)>;
+
+        static constexpr size_t c_firstBatchBytes = 256 << 10;
+        static constexpr size_t c_batchBytesPerThread = 8 << 20;
+        static constexpr size_t c_publishGrowth = 4;
+
+        LogLoader(MappedFile file, UpdateHandler onUpdate, unsigned threadCount = 0, ParseContext context = {});
+        // Cancels the load and waits for the batch being parsed.
+        ~LogLoader();
+
+        LogLoader(LogLoader const&) = delete;
+        LogLoader& operator=(LogLoader const&) = delete;
+
+        // Stops after the batch being parsed; the final update follows.
+        void Cancel()
+        {
+            m_cancelled.store(true, std::memory_order_relaxed);
+        }
+
+    private:
+        MappedFile m_file;
+        UpdateHandler m_onUpdate;
+        unsigned m_threadCount;
+        ParseContext m_context;
+        std::atomic<bool> m_cancelled{ false };
+        std::thread m_thread;
+
+        void Run();
+    };
+}
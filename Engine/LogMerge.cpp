@@ -0,0 +1,287 @@
+#include "LogMerge.h"
+
+#include "MappedFile.h"
+#include "Parallel.h"
+#include "Timestamp.h"
+
+#include <algorithm>
+#include <optional>
+#include <queue>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+
+namespace LogMinds::Engine
+{
+    namespace
+    {
+        std::vector<std::string> OriginNames(std::vector<std::filesystem::path> const& paths)
+        {
+            std::unordered_map<std::string, size_t> counts;
+            for (auto const& path : paths)
+            {
+                ++counts[path.filename().u8string()];
+            }
+
+            std::vector<std::string> names;
+            names.reserve(paths.size());
+            for (auto const& path : paths)
+            {
+                auto name = path.filename().u8string();
+                names.push_back(counts[name] > 1 ? path.u8string() : name);
+            }
+            return names;
+        }
+
+        constexpr std::string_view c_utf8Bom = "\xEF\xBB\xBF";
+        // Text of a line-oriented file parsed at a time while merging.
+        constexpr size_t c_sliceBytes = 1 << 20;
+        // Headroom over the estimated merged size, for files whose first
+        // slice has shorter lines than the rest.
+        constexpr double c_reserveSlack = 1.0625;
+
+        // One file as the merge reads it. Line-oriented text is parsed a slice
+        // at a time in the layout detected from its start, so that only the
+        // slice being merged is held; other documents (JSON, UTF-16,
+        // compressed data) are parsed whole as the only slice.
+        struct MergeInput
+        {
+            MappedFile File;
+            // Line-oriented text not parsed yet.
+            std::string_view Unparsed;
+            size_t ParsedBytes{ 0 };
+            ParseContext Context;
+            ParseReport Report;
+            std::string Error;
+            // The slice being merged.
+            LogStore Rows;
+        };
+
+        // Replaces input.Rows with the next slice that has rows; false once
+        // the text runs out.
+        bool ParseNextSlice(MergeInput& input, unsigned threadCount)
+        {
+            input.Rows = LogStore();
+            while (input.Rows.Empty() && !input.Unparsed.empty())
+            {
+                // Slices end after a newline, unless one line is longer than
+                // the slice and runs to the end of the text.
+                auto text = input.Unparsed;
+                auto end = std::min(text.size(), c_sliceBytes);
+                if (end < text.size())
+                {
+                    auto newline = text.rfind('\n', end - 1);
+                    if (newline == std::string_view::npos)
+                    {
+                        newline = text.find('\n', end);
+                    }
+                    end = newline == std::string_view::npos ? text.size() : newline + 1;
+                }
+
+                ParseReport part;
+                input.Rows = ParseLines(text.substr(0, end), input.Report.Format, threadCount, &part, input.Context);
+                input.Report.Hits += part.Hits;
+                input.Report.Misses += part.Misses;
+                input.Unparsed.remove_prefix(end);
+                input.ParsedBytes += end;
+            }
+            return !input.Rows.Empty();
+        }
+
+        struct Cursor
+        {
+            // The row's time, or the last time before it in its file.
+            int64_t Key;
+            size_t Input;
+            size_t Row;
+
+            bool operator>(Cursor const& other) const
+            {
+                return Key != other.Key ? Key > other.Key : Input > other.Input;
+            }
+        };
+
+        // Merges the inputs' rows by time, parsing each input's next slice
+        // once the merge has taken every row of the current one.
+        LogStore Merge(std::vector<MergeInput>& inputs, std::vector<std::string> const& names, unsigned threadCount)
+        {
+            // The merged store is reserved for what the first slices suggest
+            // the whole files hold, so that it is not regrown near its final
+            // size.
+            LogStore merged;
+            std::vector<uint16_t> origins(inputs.size());
+            double rows = 0;
+            double bytes = 0;
+            for (size_t index = 0; index < inputs.size(); ++index)
+            {
+                auto const& input = inputs[index];
+                origins[index] = *merged.InternOrigin(names[index]);
+                auto scale = input.Unparsed.empty() ? 1.0 :
+                    1.0 + static_cast<double>(input.Unparsed.size()) / static_cast<double>(input.ParsedBytes);
+                rows += static_cast<double>(input.Rows.Size()) * scale;
+                bytes += static_cast<double>(input.Rows.ArenaSize()) * scale;
+            }
+            merged.Reserve(static_cast<size_t>(rows * c_reserveSlack), static_cast<size_t>(bytes * c_reserveSlack));
+
+            std::vector<std::optional<LogStore::RowImporter>> importers(inputs.size());
+            std::priority_queue<Cursor, std::vector<Cursor>, std::greater<Cursor>> heap;
+            for (size_t index = 0; index < inputs.size(); ++index)
+            {
+                auto const& input = inputs[index].Rows;
+                if (!input.Empty())
+                {
+                    importers[index].emplace(merged, input);
+                    heap.push({ input.OccurredOn(0).value_or(LogStore::c_noTimestamp), index, 0 });
+                }
+            }
+
+            while (!heap.empty())
+            {
+                auto cursor = heap.top();
+                heap.pop();
+                auto& input = inputs[cursor.Input];
+                auto& importer = *importers[cursor.Input];
+                importer.Append(cursor.Row, origins[cursor.Input]);
+
+                // Take every following row that still sorts first without
+                // going back through the heap; consecutive rows of one file
+                // usually do.
+                auto row = cursor.Row + 1;
+                auto key = cursor.Key;
+                for (; row < input.Rows.Size(); ++row)
+                {
+                    key = input.Rows.OccurredOn(row).value_or(key);
+                    Cursor next{ key, cursor.Input, row };
+                    if (!heap.empty() && next > heap.top())
+                    {
+                        break;
+                    }
+                    importer.Append(row, origins[cursor.Input]);
+                }
+
+                // A slice that ran dry is released before the next one is
+                // parsed; rows without a time keep the last time of the slice
+                // before.
+                if (row < input.Rows.Size())
+                {
+                    heap.push({ key, cursor.Input, row });
+                }
+                else
+                {
+                    importers[cursor.Input].reset();
+                    if (ParseNextSlice(input, threadCount))
+                    {
+                        importers[cursor.Input].emplace(merged, input.Rows);
+                        heap.push({ input.Rows.OccurredOn(0).value_or(key), cursor.Input, 0 });
+                    }
+                    else
+                    {
+                        input.File.Close();
+                    }
+                }
+            }
+            return merged;
+        }
+    }
+
+    std::vector<std::filesystem::path> ExpandLogPaths(std::vector<std::filesystem::path> const& paths,
+        std::string& error)
+    {
+        std::vector<std::filesystem::path> files;
+        for (auto const& path : paths)
+        {
+            std::error_code code;
+            if (!std::filesystem::is_directory(path, code))
+            {
+                files.push_back(path);
+                continue;
+            }
+
+            std::vector<std::filesystem::path> entries;
+            for (std::filesystem::directory_iterator it(path, code), end; !code && it != end; it.increment(code))
+            {
+                std::error_code entryCode;
+                if (it->is_regular_file(entryCode))
+                {
+                    entries.push_back(it->path());
+                }
+            }
+            if (code)
+            {
+                error += path.u8string() + ": " + code.message() + "\n";
+            }
+            std::sort(entries.begin(), entries.end());
+            files.insert(files.end(), entries.begin(), entries.end());
+        }
+        return files;
+    }
+
+    LogStore ParseLogFiles(std::vector<std::filesystem::path> const& paths, unsigned threadCount,
+        ParseReport* report, std::string& error)
+    {
+        if (paths.size() > LogStore::c_maxOrigins)
+        {
+            error = "too many files (" + std::to_string(paths.size()) + ")";
+            return LogStore();
+        }
+
+        // Files start side by side; whatever threads are left over go to the
+        // chunks inside each file. Later slices are parsed on every thread as
+        // the merge reaches them.
+        auto threads = ResolveThreadCount(threadCount);
+        auto perFile = std::max<unsigned>(1, threads / static_cast<unsigned>(std::max<size_t>(1, paths.size())));
+        auto single = paths.size() == 1;
+        std::vector<MergeInput> inputs(paths.size());
+        ParallelFor(paths.size(), threads, [&](size_t index)
+        {
+            auto& input = inputs[index];
+            if (!input.File.Open(paths[index], input.Error))
+            {
+                return;
+            }
+            input.Context = ParseContext{ LastWriteTicks(paths[index]) };
+            auto text = input.File.Text();
+            if (!single && IsLineOriented(text))
+            {
+                if (text.substr(0, c_utf8Bom.size()) == c_utf8Bom)
+                {
+                    text.remove_prefix(c_utf8Bom.size());
+                }
+                input.Unparsed = text;
+                input.Report = { DetectLineFormat(text), 0, 0, {} };
+                ParseNextSlice(input, perFile);
+                return;
+            }
+            input.Rows = ParseDocument(text, perFile, &input.Report, input.Context);
+            input.Error = std::move(input.Report.Error);
+            input.File.Close();
+        });
+
+        for (size_t index = 0; index < paths.size(); ++index)
+        {
+            if (!inputs[index].Error.empty())
+            {
+                error += paths[index].u8string() + ": " + inputs[index].Error + "\n";
+            }
+        }
+        auto merged = single ? std::move(inputs.front().Rows) : Merge(inputs, OriginNames(paths), threads);
+        if (report)
+        {
+            *report = {};
+            bool first = true;
+            for (auto const& input : inputs)
+            {
+                if (input.Report.Hits + input.Report.Misses == 0 && !input.Error.empty())
+                {
+                    continue;
+                }
+                report->Format = first || report->Format == input.Report.Format ? input.Report.Format :
+                    LineFormat::Mixed;
+                report->Hits += input.Report.Hits;
+                report->Misses += input.Report.Misses;
+                first = false;
+            }
+        }
+        return merged;
+    }
+}
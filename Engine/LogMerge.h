@@ -0,0 +1,30 @@
+#pragma once
+
+#include "LogDocument.h"
+#include "LogStore.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace LogMinds::Engine
+{
+    // Replaces each directory with the regular files directly inside it,
+    // sorted by name; other paths are kept as given.
+    std::vector<std::filesystem::path> ExpandLogPaths(std::vector<std::filesystem::path> const& paths,
+        std::string& error);
+
+    // Parses every file and merges the rows into one timeline ordered by
+    // OccurredOn; ties keep the order of paths. Rows without a timestamp stay
+    // behind the row before them in their file. Line-oriented files are
+    // parsed a slice at a time as the merge reaches them, and each slice is
+    // released once merged, so besides the merged store only one slice per
+    // file is held; other documents (JSON, UTF-16, compressed) are parsed
+    // whole first. With more than one file each row is tagged with its
+    // origin (the file name, or the full path where names repeat). Files
+    // that fail to open, or whose compressed data breaks off, are listed in
+    // error with what could be read kept; the report sums the per-file
+    // counts and names a format only when every file shares it.
+    LogStore ParseLogFiles(std::vector<std::filesystem::path> const& paths, unsigned threadCount,
+        ParseReport* report, std::string& error);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace LogMinds::Engine
+{
+    struct LogRecord
+    {
+        std::string Timestamp;
+        std::string Level;
+        std::string Source;
+        std::string Message;
+        std::string Context;
+        std::string Raw;
+        std::optional<int64_t> OccurredOn;
+    };
+}
@@ -0,0 +1,550 @@
+#include "LogStore.h"
+
+#include "BinaryIo.h"
+
+#include <cstring>
+#include <memory>
+
+namespace LogMinds::Engine
+{
+    namespace
+    {
+        template <typename T>
+        void WriteColumn(BinaryWriter& writer, SharedColumn<T> const& column)
+        {
+            writer.Value<uint64_t>(column.Size());
+            writer.Align(alignof(T));
+            writer.Bytes(column.Data(), column.Size() * sizeof(T));
+        }
+
+        // Views the items in place when owner keeps the reader's bytes alive
+        // and they are aligned for T; copies them otherwise.
+        template <typename T>
+        bool ReadColumn(BinaryReader& reader, SharedColumn<T>& column, std::shared_ptr<void const> const& owner)
+        {
+            uint64_t count = 0;
+            char const* items = nullptr;
+            if (!reader.Value(count) || !reader.Align(alignof(T)) || count > reader.Remaining() / sizeof(T) ||
+                !reader.View(static_cast<size_t>(count) * sizeof(T), items))
+            {
+                return false;
+            }
+            auto size = static_cast<size_t>(count);
+            if (owner && size != 0 && reinterpret_cast<uintptr_t>(items) % alignof(T) == 0)
+            {
+                column = SharedColumn<T>(owner, reinterpret_cast<T const*>(items), size);
+            }
+            else if (size != 0)
+            {
+                std::memcpy(column.Extend(size), items, size * sizeof(T));
+            }
+            return true;
+        }
+    }
+
+    std::string_view LogStore::Level(size_t row) const
+    {
+        auto id = m_levels[row];
+        if (id == c_overflowLevel)
+        {
+            return m_levelOverflow.at(row);
+        }
+        return m_levelNames[id];
+    }
+
+    std::optional<uint8_t> LogStore::FindLevel(std::string const& level) const
+    {
+        auto found = m_levelIds.find(level);
+        if (found == m_levelIds.end())
+        {
+            return std::nullopt;
+        }
+        return found->second;
+    }
+
+    std::optional<uint16_t> LogStore::FindOrigin(std::string const& origin) const
+    {
+        auto found = m_originIds.find(origin);
+        if (found == m_originIds.end())
+        {
+            return std::nullopt;
+        }
+        return found->second;
+    }
+
+    std::optional<uint16_t> LogStore::InternOrigin(std::string const& origin)
+    {
+        auto found = m_originIds.find(origin);
+        if (found != m_originIds.end())
+        {
+            return found->second;
+        }
+        if (m_originNames.size() >= c_maxOrigins)
+        {
+            return std::nullopt;
+        }
+
+        auto id = static_cast<uint16_t>(m_originNames.size());
+        m_originNames.push_back(origin);
+        m_originIds.emplace(origin, id);
+        return id;
+    }
+
+    LogRecord LogStore::Record(size_t row) const
+    {
+        LogRecord record;
+        record.Timestamp = std::string(Timestamp(row));
+        record.Level = std::string(Level(row));
+        record.Source = std::string(Source(row));
+        record.Message = std::string(Message(row));
+        record.Context = std::string(Context(row));
+        record.Raw = std::string(Raw(row));
+        record.OccurredOn = OccurredOn(row);
+        return record;
+    }
+
+    void LogStore::Reserve(size_t rows, size_t arenaBytes)
+    {
+        m_arena.Reserve(arenaBytes);
+        m_rowBases.Reserve(rows);
+        m_fields.Reserve(rows * c_textFieldCount);
+        m_timestamps.Reserve(rows);
+        m_levels.Reserve(rows);
+        m_sources.Reserve(rows);
+        m_templateIds.Reserve(rows);
+    }
+
+    void LogStore::Append(LogRecord const& record)
+    {
+        auto base = m_arena.Size();
+        std::string_view raw(record.Raw);
+        m_arena.Append(raw.data(), raw.size());
+
+        auto place = [&](std::string const& text) -> TextRef
+        {
+            auto length = static_cast<uint32_t>(text.size());
+            if (text.empty())
+            {
+                return { 0, 0 };
+            }
+            if (text.size() <= raw.size())
+            {
+                if (raw.compare(raw.size() - text.size(), text.size(), text) == 0)
+                {
+                    return { static_cast<uint32_t>(raw.size() - text.size()), length };
+                }
+                if (raw.compare(0, text.size(), text) == 0)
+                {
+                    return { 0, length };
+                }
+            }
+            auto offset = static_cast<uint32_t>(m_arena.Size() - base);
+            m_arena.Append(text.data(), text.size());
+            return { offset, length };
+        };
+
+        m_rowBases.Push(base);
+        m_fields.Push(place(record.Timestamp));
+        m_fields.Push(place(record.Message));
+        m_fields.Push(place(record.Context));
+        m_fields.Push({ 0, static_cast<uint32_t>(raw.size()) });
+        m_timestamps.Push(record.OccurredOn.value_or(c_noTimestamp));
+
+        auto level = InternLevel(record.Level);
+        if (level == c_overflowLevel)
+        {
+            m_levelOverflow.emplace(m_levels.Size(), record.Level);
+        }
+        m_levels.Push(level);
+        m_sources.Push(InternSource(record.Source));
+        m_templateIds.Push(m_templates.Add(record.Message));
+        if (!m_origins.Empty())
+        {
+            m_origins.Push(0);
+        }
+        m_internedTextBytes += record.Level.size() + record.Source.size();
+        m_aggregates.Add(*this, m_levels.Size() - 1);
+        m_keywords.Add(record.Message);
+    }
+
+    void LogStore::Append(LogStore&& other)
+    {
+        if (Empty())
+        {
+            *this = std::move(other);
+            return;
+        }
+
+        auto arenaShift = m_arena.Size();
+        auto rowShift = Size();
+        auto rows = other.Size();
+        m_arena.Append(other.m_arena.Data(), other.m_arena.Size());
+        auto bases = m_rowBases.Extend(rows);
+        for (size_t row = 0; row < rows; ++row)
+        {
+            bases[row] = other.m_rowBases[row] + arenaShift;
+        }
+        m_fields.Append(other.m_fields.Data(), other.m_fields.Size());
+        m_timestamps.Append(other.m_timestamps.Data(), rows);
+
+        std::vector<uint8_t> remap(other.m_levelNames.size());
+        for (size_t id = 0; id < other.m_levelNames.size(); ++id)
+        {
+            remap[id] = InternLevel(other.m_levelNames[id]);
+        }
+
+        auto levels = m_levels.Extend(rows);
+        for (size_t row = 0; row < rows; ++row)
+        {
+            auto id = other.m_levels[row];
+            if (id != c_overflowLevel)
+            {
+                id = remap[id];
+                if (id == c_overflowLevel)
+                {
+                    m_levelOverflow.emplace(rowShift + row, other.m_levelNames[other.m_levels[row]]);
+                }
+            }
+            else
+            {
+                auto& name = other.m_levelOverflow.at(row);
+                id = InternLevel(name);
+                if (id == c_overflowLevel)
+                {
+                    m_levelOverflow.emplace(rowShift + row, std::move(name));
+                }
+            }
+            levels[row] = id;
+        }
+
+        std::vector<uint32_t> sourceRemap(other.m_sourceNames.size());
+        for (size_t id = 0; id < other.m_sourceNames.size(); ++id)
+        {
+            sourceRemap[id] = InternSource(other.m_sourceNames[id]);
+        }
+        auto sources = m_sources.Extend(rows);
+        for (size_t row = 0; row < rows; ++row)
+        {
+            sources[row] = sourceRemap[other.m_sources[row]];
+        }
+
+        // Per template rather than per row, so parse workers do the mining
+        // and joining their stores stays cheap.
+        auto templateRemap = m_templates.Merge(other.m_templates);
+        auto templateIds = m_templateIds.Extend(rows);
+        for (size_t row = 0; row < rows; ++row)
+        {
+            templateIds[row] = templateRemap[other.m_templateIds[row]];
+        }
+
+        if (!other.m_origins.Empty())
+        {
+            std::vector<uint16_t> originRemap(other.m_originNames.size());
+            for (size_t id = 0; id < other.m_originNames.size(); ++id)
+            {
+                originRemap[id] = InternOrigin(other.m_originNames[id]).value_or(0);
+            }
+            m_origins.Resize(rowShift, 0);
+            auto origins = m_origins.Extend(rows);
+            for (size_t row = 0; row < rows; ++row)
+            {
+                origins[row] = originRemap[other.m_origins[row]];
+            }
+        }
+        else if (!m_origins.Empty())
+        {
+            m_origins.Resize(Size(), 0);
+        }
+        m_internedTextBytes += other.m_internedTextBytes;
+        m_aggregates.Merge(other.m_aggregates, rowShift, other.m_levelNames, remap, sourceRemap);
+        m_keywords.Merge(other.m_keywords);
+
+        other = LogStore();
+    }
+
+    LogStore::RowImporter::RowImporter(LogStore& target, LogStore const& source) :
+        m_target(target), m_source(source)
+    {
+        m_levels.reserve(source.m_levelNames.size());
+        for (auto const& name : source.m_levelNames)
+        {
+            m_levels.push_back(target.InternLevel(name));
+        }
+        m_sources.reserve(source.m_sourceNames.size());
+        for (auto const& name : source.m_sourceNames)
+        {
+            m_sources.push_back(target.InternSource(name));
+        }
+        m_templates = target.m_templates.Merge(source.m_templates);
+    }
+
+    void LogStore::RowImporter::Append(size_t row, uint16_t origin)
+    {
+        auto& target = m_target;
+        auto const& source = m_source;
+
+        // A row owns the arena bytes up to the next row's base.
+        auto begin = source.m_rowBases[row];
+        auto end = row + 1 < source.Size() ? source.m_rowBases[row + 1] : source.m_arena.Size();
+        auto targetRow = target.Size();
+        target.m_rowBases.Push(target.m_arena.Size());
+        target.m_arena.Append(source.m_arena.Data() + begin, end - begin);
+        target.m_fields.Append(source.m_fields.Data() + row * c_textFieldCount, c_textFieldCount);
+        target.m_timestamps.Push(source.m_timestamps[row]);
+
+        auto level = source.m_levels[row];
+        if (level != c_overflowLevel)
+        {
+            auto id = m_levels[level];
+            if (id == c_overflowLevel)
+            {
+                target.m_levelOverflow.emplace(targetRow, source.m_levelNames[level]);
+            }
+            level = id;
+        }
+        else
+        {
+            auto const& name = source.m_levelOverflow.at(row);
+            level = target.InternLevel(name);
+            if (level == c_overflowLevel)
+            {
+                target.m_levelOverflow.emplace(targetRow, name);
+            }
+        }
+        target.m_levels.Push(level);
+
+        auto sourceId = source.m_sources[row];
+        target.m_sources.Push(m_sources[sourceId]);
+        target.m_templateIds.Push(m_templates[source.m_templateIds[row]]);
+        if (origin != 0 || !target.m_origins.Empty())
+        {
+            target.m_origins.Resize(targetRow, 0);
+            target.m_origins.Push(origin);
+        }
+        target.m_internedTextBytes += source.Level(row).size() + source.m_sourceNames[sourceId].size();
+        target.m_aggregates.Add(target, targetRow);
+        target.m_keywords.Add(target.Message(targetRow));
+    }
+
+    void LogStore::Write(BinaryWriter& writer) const
+    {
+        WriteColumn(writer, m_arena);
+        WriteColumn(writer, m_rowBases);
+        WriteColumn(writer, m_fields);
+        WriteColumn(writer, m_timestamps);
+        WriteColumn(writer, m_levels);
+        writer.Value<uint64_t>(m_levelNames.size());
+        for (auto const& name : m_levelNames)
+        {
+            writer.String(name);
+        }
+        writer.Value<uint64_t>(m_levelOverflow.size());
+        for (auto const& [row, name] : m_levelOverflow)
+        {
+            writer.Value<uint64_t>(row);
+            writer.String(name);
+        }
+        WriteColumn(writer, m_sources);
+        writer.Value<uint64_t>(m_sourceNames.size());
+        for (auto const& name : m_sourceNames)
+        {
+            writer.String(name);
+        }
+        WriteColumn(writer, m_templateIds);
+        m_templates.Write(writer);
+        WriteColumn(writer, m_origins);
+        writer.Value<uint64_t>(m_originNames.size());
+        for (auto const& name : m_originNames)
+        {
+            writer.String(name);
+        }
+        writer.Value<uint64_t>(m_internedTextBytes);
+        m_keywords.Write(writer);
+        m_aggregates.Write(writer);
+    }
+
+    bool LogStore::Read(BinaryReader& reader, std::shared_ptr<void const> const& owner)
+    {
+        *this = LogStore();
+        auto readNames = [&](std::vector<std::string>& names, size_t limit)
+        {
+            // Each name takes at least its length, so a count the input
+            // cannot hold is rejected before anything is allocated for it.
+            uint64_t count = 0;
+            if (!reader.Value(count) || count == 0 || count > limit || count > reader.Remaining() / sizeof(uint64_t))
+            {
+                return false;
+            }
+            names.resize(static_cast<size_t>(count));
+            for (auto& name : names)
+            {
+                if (!reader.String(name))
+                {
+                    return false;
+                }
+            }
+            return names.front().empty();
+        };
+        auto readColumn = [&](auto& column)
+        {
+            return ReadColumn(reader, column, owner);
+        };
+
+        uint64_t overflowCount = 0;
+        uint64_t internedBytes = 0;
+        if (!readColumn(m_arena) || !readColumn(m_rowBases) || !readColumn(m_fields) || !readColumn(m_timestamps) ||
+            !readColumn(m_levels) || !readNames(m_levelNames, c_overflowLevel) || !reader.Value(overflowCount))
+        {
+            return false;
+        }
+        for (uint64_t i = 0; i < overflowCount; ++i)
+        {
+            uint64_t row = 0;
+            std::string name;
+            if (!reader.Value(row) || !reader.String(name))
+            {
+                return false;
+            }
+            m_levelOverflow.emplace(static_cast<size_t>(row), std::move(name));
+        }
+        if (!readColumn(m_sources) || !readNames(m_sourceNames, std::numeric_limits<uint32_t>::max()) ||
+            !readColumn(m_templateIds) || !m_templates.Read(reader) || !readColumn(m_origins) ||
+            !readNames(m_originNames, c_maxOrigins) || !reader.Value(internedBytes) || !m_keywords.Read(reader))
+        {
+            return false;
+        }
+        m_internedTextBytes = static_cast<size_t>(internedBytes);
+
+        // Every id and offset must stay inside what was read, so that the
+        // accessors never need to check.
+        auto rows = m_timestamps.Size();
+        if (m_rowBases.Size() != rows || m_fields.Size() != rows * c_textFieldCount || m_levels.Size() != rows ||
+            m_sources.Size() != rows || m_templateIds.Size() != rows ||
+            (!m_origins.Empty() && m_origins.Size() != rows))
+        {
+            return false;
+        }
+        for (size_t row = 0; row < rows; ++row)
+        {
+            auto end = row + 1 < rows ? m_rowBases[row + 1] : m_arena.Size();
+            if (m_rowBases[row] > end || end > m_arena.Size())
+            {
+                return false;
+            }
+            for (size_t field = 0; field < c_textFieldCount; ++field)
+            {
+                auto const& ref = m_fields[row * c_textFieldCount + field];
+                if (static_cast<uint64_t>(ref.Offset) + ref.Length > end - m_rowBases[row])
+                {
+                    return false;
+                }
+            }
+            auto level = m_levels[row];
+            if (level == c_overflowLevel ? m_levelOverflow.count(row) == 0 : level >= m_levelNames.size())
+            {
+                return false;
+            }
+            if (m_sources[row] >= m_sourceNames.size() || m_templateIds[row] >= m_templates.Size() ||
+                (!m_origins.Empty() && m_origins[row] >= m_originNames.size()))
+            {
+                return false;
+            }
+        }
+
+        m_levelIds.clear();
+        for (size_t id = 0; id < m_levelNames.size(); ++id)
+        {
+            m_levelIds.emplace(m_levelNames[id], static_cast<uint8_t>(id));
+        }
+        m_sourceIds.clear();
+        for (size_t id = 0; id < m_sourceNames.size(); ++id)
+        {
+            m_sourceIds.emplace(m_sourceNames[id], static_cast<uint32_t>(id));
+        }
+        m_originIds.clear();
+        for (size_t id = 0; id < m_originNames.size(); ++id)
+        {
+            m_originIds.emplace(m_originNames[id], static_cast<uint16_t>(id));
+        }
+        if (m_levelIds.size() != m_levelNames.size() || m_sourceIds.size() != m_sourceNames.size() ||
+            m_originIds.size() != m_originNames.size())
+        {
+            return false;
+        }
+
+        return m_aggregates.Read(reader, *this);
+    }
+
+    size_t LogStore::MemoryUsage() const
+    {
+        auto bytes = m_arena.Capacity() + m_rowBases.Capacity() * sizeof(uint64_t) +
+            m_fields.Capacity() * sizeof(TextRef) + m_timestamps.Capacity() * sizeof(int64_t) + m_levels.Capacity() +
+            m_sources.Capacity() * sizeof(uint32_t) + m_templateIds.Capacity() * sizeof(uint32_t) +
+            m_origins.Capacity() * sizeof(uint16_t) + DictionaryBytes() + m_templates.MemoryUsage() +
+            m_keywords.MemoryUsage();
+        for (auto const& [row, name] : m_levelOverflow)
+        {
+            bytes += sizeof(row) + sizeof(name) + name.capacity();
+        }
+        return bytes;
+    }
+
+    size_t LogStore::DictionarySavings() const
+    {
+        // Per-row text would also need a TextRef each for level and source.
+        auto perRow = m_internedTextBytes + Size() * 2 * sizeof(TextRef);
+        auto dictionary = DictionaryBytes() + m_levels.Size() + m_sources.Size() * sizeof(uint32_t);
+        return perRow > dictionary ? perRow - dictionary : 0;
+    }
+
+    size_t LogStore::DictionaryBytes() const
+    {
+        // Hash nodes are approximated as key + value + next pointer + hash.
+        size_t bytes = 0;
+        for (auto const& name : m_levelNames)
+        {
+            bytes += 2 * (sizeof(name) + name.capacity()) + 2 * sizeof(void*);
+        }
+        for (auto const& name : m_sourceNames)
+        {
+            bytes += 2 * (sizeof(name) + name.capacity()) + sizeof(uint32_t) + 2 * sizeof(void*);
+        }
+        for (auto const& name : m_originNames)
+        {
+            bytes += 2 * (sizeof(name) + name.capacity()) + sizeof(uint16_t) + 2 * sizeof(void*);
+        }
+        return bytes;
+    }
+
+    uint8_t LogStore::InternLevel(std::string const& level)
+    {
+        auto found = m_levelIds.find(level);
+        if (found != m_levelIds.end())
+        {
+            return found->second;
+        }
+        if (m_levelNames.size() >= c_overflowLevel)
+        {
+            return c_overflowLevel;
+        }
+
+        auto id = static_cast<uint8_t>(m_levelNames.size());
+        m_levelNames.push_back(level);
+        m_levelIds.emplace(level, id);
+        return id;
+    }
+
+    uint32_t LogStore::InternSource(std::string const& source)
+    {
+        auto found = m_sourceIds.find(source);
+        if (found != m_sourceIds.end())
+        {
+            return found->second;
+        }
+
+        auto id = static_cast<uint32_t>(m_sourceNames.size());
+        m_sourceNames.push_back(source);
+        m_sourceIds.emplace(source, id);
+        return id;
+    }
+}
@@ -0,0 +1,269 @@
+#pragma once
+
+#include "KeywordSketch.h"
+#include "LogRecord.h"
+#include "RowAggregates.h"
+#include "SharedColumn.h"
+#include "TemplateMiner.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace LogMinds::Engine
+{
+    class BinaryReader;
+    class BinaryWriter;
+
+    // Per-row text fields; the level and the source are dictionary encoded
+    // instead.
+    enum class LogField : uint8_t
+    {
+        Timestamp,
+        Message,
+        Context,
+        Raw,
+    };
+
+    constexpr size_t c_textFieldCount = 4;
+
+    // Parsed entries stored column by column. All text lives in one arena;
+    // each row owns the contiguous bytes from its base offset, and a field is
+    // an (offset, length) pair relative to that base. Fields that are a
+    // prefix or suffix of the raw line (the common case for text layouts)
+    // point into the raw bytes instead of being copied. Levels and sources
+    // are interned into per-store dictionaries and kept as one byte and four
+    // bytes per row; timestamps are a plain int64 column with c_noTimestamp
+    // for "none", and each message's template id takes four more bytes. Rows
+    // merged from several files also carry the id of their origin file; a
+    // store read from one file keeps no origin column. The columns and the
+    // arena are SharedColumns, so a copy costs the dictionaries, templates
+    // and counters but not the rows, and stays unchanged while the original
+    // is appended to.
+    class LogStore
+    {
+    public:
+        static constexpr int64_t c_noTimestamp = std::numeric_limits<int64_t>::min();
+
+        size_t Size() const
+        {
+            return m_timestamps.Size();
+        }
+
+        bool Empty() const
+        {
+            return m_timestamps.Empty();
+        }
+
+        std::string_view Text(size_t row, LogField field) const
+        {
+            auto const& ref = m_fields[row * c_textFieldCount + static_cast<size_t>(field)];
+            return std::string_view(m_arena.Data() + m_rowBases[row] + ref.Offset, ref.Length);
+        }
+
+        std::string_view Timestamp(size_t row) const
+        {
+            return Text(row, LogField::Timestamp);
+        }
+
+        std::string_view Source(size_t row) const
+        {
+            return m_sourceNames[m_sources[row]];
+        }
+
+        uint32_t SourceId(size_t row) const
+        {
+            return m_sources[row];
+        }
+
+        // Interned source names; id 0 is the empty source.
+        std::vector<std::string> const& SourceNames() const
+        {
+            return m_sourceNames;
+        }
+
+        std::string_view Message(size_t row) const
+        {
+            return Text(row, LogField::Message);
+        }
+
+        std::string_view Context(size_t row) const
+        {
+            return Text(row, LogField::Context);
+        }
+
+        std::string_view Raw(size_t row) const
+        {
+            return Text(row, LogField::Raw);
+        }
+
+        std::string_view Level(size_t row) const;
+
+        uint8_t LevelId(size_t row) const
+        {
+            return m_levels[row];
+        }
+
+        // Interned level names; id 0 is the empty level.
+        std::vector<std::string> const& LevelNames() const
+        {
+            return m_levelNames;
+        }
+
+        // Id of an interned level name, or std::nullopt when no row that fits
+        // the table has it.
+        std::optional<uint8_t> FindLevel(std::string const& level) const;
+
+        bool HasLevelOverflow() const
+        {
+            return !m_levelOverflow.empty();
+        }
+
+        static constexpr uint8_t c_overflowLevel = 0xFF;
+
+        uint16_t OriginId(size_t row) const
+        {
+            return m_origins.Empty() ? uint16_t{ 0 } : m_origins[row];
+        }
+
+        std::string_view Origin(size_t row) const
+        {
+            return m_originNames[OriginId(row)];
+        }
+
+        // Interned origin file names; id 0 is "no file recorded".
+        std::vector<std::string> const& OriginNames() const
+        {
+            return m_originNames;
+        }
+
+        std::optional<uint16_t> FindOrigin(std::string const& origin) const;
+        // Returns std::nullopt once c_maxOrigins names are interned.
+        std::optional<uint16_t> InternOrigin(std::string const& origin);
+
+        static constexpr size_t c_maxOrigins = std::numeric_limits<uint16_t>::max();
+
+        std::optional<int64_t> OccurredOn(size_t row) const
+        {
+            auto ticks = m_timestamps[row];
+            return ticks == c_noTimestamp ? std::nullopt : std::optional<int64_t>(ticks);
+        }
+
+        // Id of the row's message template in Templates().
+        uint32_t TemplateId(size_t row) const
+        {
+            return m_templateIds[row];
+        }
+
+        // Templates of every message, mined as rows are appended.
+        TemplateMiner const& Templates() const
+        {
+            return m_templates;
+        }
+
+        // The variable tokens of the row's message under its template.
+        std::vector<std::string_view> Parameters(size_t row) const
+        {
+            return m_templates.Parameters(m_templateIds[row], Message(row));
+        }
+
+        LogRecord Record(size_t row) const;
+
+        void Reserve(size_t rows, size_t arenaBytes);
+        void Append(LogRecord const& record);
+        // Moves every row of other to the end of this store.
+        void Append(LogStore&& other);
+
+        // Copies single rows of one store to the end of another, tagged with
+        // an origin. Level and source ids are translated once per id rather
+        // than looked up by text for every row.
+        class RowImporter
+        {
+        public:
+            RowImporter(LogStore& target, LogStore const& source);
+
+            void Append(size_t row, uint16_t origin);
+
+        private:
+            LogStore& m_target;
+            LogStore const& m_source;
+            std::vector<uint8_t> m_levels;
+            std::vector<uint32_t> m_sources;
+            std::vector<uint32_t> m_templates;
+        };
+
+        // Over every row, kept up to date as rows are appended.
+        RowAggregates const& Aggregates() const
+        {
+            return m_aggregates;
+        }
+
+        // Keywords of every message, kept up to date like Aggregates.
+        KeywordSketch const& Keywords() const
+        {
+            return m_keywords;
+        }
+
+        size_t ArenaSize() const
+        {
+            return m_arena.Size();
+        }
+
+        // Bytes held by the columns, the arena, the dictionaries, the
+        // templates and the keywords.
+        size_t MemoryUsage() const;
+
+        // Bytes the dictionaries save over keeping every row's level and
+        // source as text of its own.
+        size_t DictionarySavings() const;
+
+        // The columns, arena, dictionaries, templates, keywords and aggregates
+        // as they are in memory. Read replaces the contents and fails on input
+        // that does not describe a consistent store. When owner keeps the
+        // reader's bytes alive, the columns and the arena refer to them in
+        // place rather than being copied.
+        void Write(BinaryWriter& writer) const;
+        bool Read(BinaryReader& reader, std::shared_ptr<void const> const& owner = nullptr);
+
+    private:
+        struct TextRef
+        {
+            uint32_t Offset;
+            uint32_t Length;
+        };
+
+        SharedColumn<char> m_arena;
+        SharedColumn<uint64_t> m_rowBases;
+        SharedColumn<TextRef> m_fields;
+        SharedColumn<int64_t> m_timestamps;
+        SharedColumn<uint8_t> m_levels;
+        std::vector<std::string> m_levelNames{ std::string() };
+        std::unordered_map<std::string, uint8_t> m_levelIds{ { std::string(), uint8_t{ 0 } } };
+        // Rows whose level did not fit the one-byte table (id c_overflowLevel);
+        // in practice files have a handful of levels.
+        std::unordered_map<size_t, std::string> m_levelOverflow;
+        SharedColumn<uint32_t> m_sources;
+        std::vector<std::string> m_sourceNames{ std::string() };
+        std::unordered_map<std::string, uint32_t> m_sourceIds{ { std::string(), 0u } };
+        SharedColumn<uint32_t> m_templateIds;
+        TemplateMiner m_templates;
+        // Empty while every row has origin 0.
+        SharedColumn<uint16_t> m_origins;
+        std::vector<std::string> m_originNames{ std::string() };
+        std::unordered_map<std::string, uint16_t> m_originIds{ { std::string(), uint16_t{ 0 } } };
+        // Level and source text over all rows, for DictionarySavings.
+        size_t m_internedTextBytes{ 0 };
+        RowAggregates m_aggregates;
+        KeywordSketch m_keywords;
+
+        uint8_t InternLevel(std::string const& level);
+        uint32_t InternSource(std::string const& source);
+        size_t DictionaryBytes() const;
+    };
+}
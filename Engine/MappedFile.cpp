@@ -0,0 +1,171 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace LogMinds::Engine
+{
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Close();
+            std::swap(m_data, other.m_data);
+            std::swap(m_size, other.m_size);
+#if defined(_WIN32)
+            std::swap(m_file, other.m_file);
+            std::swap(m_mapping, other.m_mapping);
+#else
+            std::swap(m_descriptor, other.m_descriptor);
+#endif
+        }
+        return *this;
+    }
+
+    MappedFile::~MappedFile()
+    {
+        Close();
+    }
+
+#if defined(_WIN32)
+    bool MappedFile::Open(std::filesystem::path const& path, std::string& error)
+    {
+        Close();
+
+        auto file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            error = "CreateFile failed (" + std::to_string(GetLastError()) + ")";
+            return false;
+        }
+        m_file = file;
+
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(file, &size))
+        {
+            error = "GetFileSizeEx failed (" + std::to_string(GetLastError()) + ")";
+            Close();
+            return false;
+        }
+        if (size.QuadPart == 0)
+        {
+            return true;
+        }
+
+        m_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping == nullptr)
+        {
+            error = "CreateFileMapping failed (" + std::to_string(GetLastError()) + ")";
+            Close();
+            return false;
+        }
+
+        auto view = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+        if (view == nullptr)
+        {
+            error = "MapViewOfFile failed (" + std::to_string(GetLastError()) + ")";
+            Close();
+            return false;
+        }
+
+        m_data = static_cast<char const*>(view);
+        m_size = static_cast<size_t>(size.QuadPart);
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_data != nullptr)
+        {
+            UnmapViewOfFile(m_data);
+        }
+        if (m_mapping != nullptr)
+        {
+            CloseHandle(m_mapping);
+        }
+        if (m_file != nullptr)
+        {
+            CloseHandle(m_file);
+        }
+        m_data = nullptr;
+        m_size = 0;
+        m_mapping = nullptr;
+        m_file = nullptr;
+    }
+#else
+    bool MappedFile::Open(std::filesystem::path const& path, std::string& error)
+    {
+        Close();
+
+        m_descriptor = ::open(path.c_str(), O_RDONLY);
+        if (m_descriptor < 0)
+        {
+            error = std::string("open failed: ") + std::strerror(errno);
+            return false;
+        }
+
+        struct stat info{};
+        if (::fstat(m_descriptor, &info) != 0)
+        {
+            error = std::string("fstat failed: ") + std::strerror(errno);
+            Close();
+            return false;
+        }
+        if (info.st_size == 0)
+        {
+            return true;
+        }
+
+        auto size = static_cast<size_t>(info.st_size);
+        auto view = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, m_descriptor, 0);
+        if (view == MAP_FAILED)
+        {
+            error = std::string("mmap failed: ") + std::strerror(errno);
+            Close();
+            return false;
+        }
+        ::madvise(view, size, MADV_SEQUENTIAL);
+
+        m_data = static_cast<char const*>(view);
+        m_size = size;
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_data != nullptr)
+        {
+            ::munmap(const_cast<char*>(m_data), m_size);
+        }
+        if (m_descriptor >= 0)
+        {
+            ::close(m_descriptor);
+        }
+        m_data = nullptr;
+        m_size = 0;
+        m_descriptor = -1;
+    }
+#endif
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace LogMinds::Engine
+{
+    // Read-only view of a whole file. Empty files map to an empty view.
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        MappedFile(MappedFile const&) = delete;
+        MappedFile& operator=(MappedFile const&) = delete;
+        ~MappedFile();
+
+        bool Open(std::filesystem::path const& path, std::string& error);
+        void Close();
+
+        std::string_view Text() const { return std::string_view(m_data, m_size); }
+        size_t Size() const { return m_size; }
+
+    private:
+        char const* m_data{ nullptr };
+        size_t m_size{ 0 };
+#if defined(_WIN32)
+        void* m_file{ nullptr };
+        void* m_mapping{ nullptr };
+#else
+        int m_descriptor{ -1 };
+#endif
+    };
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace LogMinds::Engine
+{
+    // 0 means one worker per hardware thread.
+    inline unsigned ResolveThreadCount(unsigned requested)
+    {
+        if (requested != 0)
+        {
+            return requested;
+        }
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Runs body(index) for every index in [0, count). Workers claim indices
+    // dynamically, so uneven chunks still balance across threads.
+    template <typename Body>
+    void ParallelFor(size_t count, unsigned threadCount, Body&& body)
+    {
+        auto workers = std::min<size_t>(ResolveThreadCount(threadCount), count);
+        if (workers <= 1)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                body(i);
+            }
+            return;
+        }
+
+        std::atomic<size_t> next{ 0 };
+        auto worker = [&]()
+        {
+            for (auto i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+            {
+                body(i);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(workers - 1);
+        for (size_t i = 1; i < workers; ++i)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+}
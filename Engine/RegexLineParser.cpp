@@ -0,0 +1,181 @@
+#include "RegexLineParser.h"
+
+#include "Json.h"
+#include "LineParser.h"
+#include "Text.h"
+#include "Timestamp.h"
+
+#include <ctime>
+#include <iomanip>
+#include <regex>
+#include <sstream>
+#include <string>
+
+namespace LogMinds::Engine
+{
+    namespace
+    {
+        std::string MatchText(std::ssub_match const& match)
+        {
+            return std::string(match.first, match.second);
+        }
+
+        std::optional<int64_t> ToTicks(std::tm tm)
+        {
+#if defined(_WIN32)
+            auto seconds = _mkgmtime(&tm);
+#else
+            auto seconds = timegm(&tm);
+#endif
+            if (seconds == -1)
+            {
+                return std::nullopt;
+            }
+            return static_cast<int64_t>(seconds) * c_ticksPerSecond;
+        }
+
+        int UtcYear(int64_t ticks)
+        {
+            auto seconds = static_cast<std::time_t>(ticks / c_ticksPerSecond - (ticks % c_ticksPerSecond < 0 ? 1 : 0));
+            std::tm tm{};
+#if defined(_WIN32)
+            gmtime_s(&tm, &seconds);
+#else
+            gmtime_r(&seconds, &tm);
+#endif
+            return tm.tm_year;
+        }
+    }
+
+    std::optional<int64_t> ParseTimestampWithGetTime(std::string_view text)
+    {
+        static const std::regex pattern(
+            R"(^(\d{4}-\d{1,2}-\d{1,2})(?:[Tt]| *)(\d{1,2}:\d{1,2}:\d{1,2})(?:[.,](\d+))?(?:\s*([+-])(\d{2})(?::?(\d{2}))?)?)");
+        std::string stamp(text);
+        std::smatch match;
+        if (!std::regex_search(stamp, match, pattern, std::regex_constants::match_continuous))
+        {
+            return std::nullopt;
+        }
+
+        std::istringstream stream(MatchText(match[1]) + " " + MatchText(match[2]));
+        std::tm tm{};
+        stream >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
+        if (stream.fail() || tm.tm_sec > 60)
+        {
+            return std::nullopt;
+        }
+        auto ticks = ToTicks(tm);
+        if (!ticks)
+        {
+            return std::nullopt;
+        }
+
+        auto fraction = MatchText(match[3]).substr(0, 7);
+        fraction.resize(7, '0');
+        *ticks += std::stoll(fraction);
+        if (match[4].matched)
+        {
+            auto hours = std::stoi(MatchText(match[5]));
+            auto minutes = match[6].matched ? std::stoi(MatchText(match[6])) : 0;
+            if (hours <= 23 && minutes <= 59)
+            {
+                *ticks -= (MatchText(match[4]) == "-" ? -1 : 1) * (hours * 60 + minutes) * 60 * c_ticksPerSecond;
+            }
+        }
+        return ticks;
+    }
+
+    std::optional<int64_t> ParseSyslogTimestampWithGetTime(std::string_view text, int64_t reference)
+    {
+        std::istringstream stream{ std::string(text) };
+        std::tm tm{};
+        stream >> std::get_time(&tm, "%b %d %H:%M:%S");
+        if (stream.fail())
+        {
+            return std::nullopt;
+        }
+        tm.tm_year = UtcYear(reference);
+        auto ticks = ToTicks(tm);
+        if (ticks && *ticks > reference + c_ticksPerDay)
+        {
+            --tm.tm_year;
+            ticks = ToTicks(tm);
+        }
+        return ticks;
+    }
+
+    std::optional<LogRecord> ParseLineWithRegex(std::string_view line, ParseContext const& context)
+    {
+        auto trimmedView = TrimView(line);
+        if (trimmedView.empty())
+        {
+            return std::nullopt;
+        }
+
+        if (trimmedView.front() == '{')
+        {
+            JsonValue json;
+            if (JsonValue::TryParse(trimmedView, json) && json.ValueType() == JsonValueType::Object)
+            {
+                return ParseJsonObject(json, trimmedView);
+            }
+        }
+
+        std::string trimmed(trimmedView);
+        LogRecord result;
+        result.Raw = trimmed;
+
+        static const std::regex isoPattern(
+            R"(^\s*(\d{4}-\d{2}-\d{2}[ T]\d{2}:\d{2}:\d{2}(?:[.,]\d+)?)(?:\s*(Z|[+-]\d{2}:\d{2})?)?(?:\s*\[([^\]]+)\])?\s*(TRACE|DEBUG|INFO|WARN|WARNING|ERROR|ERR|FATAL|CRITICAL|NOTICE)?\s*[:-]?\s*(.*)$)",
+            std::regex_constants::icase);
+        std::smatch isoMatch;
+        if (std::regex_match(trimmed, isoMatch, isoPattern))
+        {
+            result.Timestamp = MatchText(isoMatch[1]);
+            result.OccurredOn = ParseTimestampWithGetTime(result.Timestamp + MatchText(isoMatch[2]));
+            result.Source = MatchText(isoMatch[3]);
+            result.Message = Trim(MatchText(isoMatch[5]));
+            result.Level = NormalizeLevel(MatchText(isoMatch[4]));
+            return result;
+        }
+
+        static const std::regex syslogPattern(
+            R"(^\s*([A-Za-z]{3}\s+\d{1,2}\s+\d{2}:\d{2}:\d{2})\s+([^\s]+)\s+([^:]+):\s*(.*)$)");
+        std::smatch syslogMatch;
+        if (std::regex_match(trimmed, syslogMatch, syslogPattern))
+        {
+            result.Timestamp = MatchText(syslogMatch[1]);
+            result.Source = MatchText(syslogMatch[2]) + " " + MatchText(syslogMatch[3]);
+            result.Message = Trim(MatchText(syslogMatch[4]));
+            result.OccurredOn = ParseSyslogTimestampWithGetTime(result.Timestamp, context.ReferenceTime);
+            return result;
+        }
+
+        static const std::regex kvPattern(
+            R"(^\s*\[?([^\]]+)\]?\s*[:|-]\s*(TRACE|DEBUG|INFO|WARN|WARNING|ERROR|ERR|FATAL|CRITICAL)\s*[:-]?\s*(.*)$)",
+            std::regex_constants::icase);
+        std::smatch kvMatch;
+        if (std::regex_match(trimmed, kvMatch, kvPattern))
+        {
+            result.Source = Trim(MatchText(kvMatch[1]));
+            result.Level = NormalizeLevel(MatchText(kvMatch[2]));
+            result.Message = Trim(MatchText(kvMatch[3]));
+            return result;
+        }
+
+        static const std::regex simpleLevelPattern(
+            R"(^\s*\[?(TRACE|DEBUG|INFO|WARN|WARNING|ERROR|ERR|FATAL|CRITICAL|NOTICE)\]?\s*[:-]?\s*(.*)$)",
+            std::regex_constants::icase);
+        std::smatch simpleMatch;
+        if (std::regex_match(trimmed, simpleMatch, simpleLevelPattern))
+        {
+            result.Level = NormalizeLevel(MatchText(simpleMatch[1]));
+            result.Message = Trim(MatchText(simpleMatch[2]));
+            return result;
+        }
+
+        result.Message = std::move(trimmed);
+        return result;
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "LineParser.h"
+#include "LogRecord.h"
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace LogMinds::Engine
+{
+    // The original std::regex cascade. ParseLine must produce identical
+    // records; this is kept only as the reference for verify-parser and
+    // bench-parse in the CLI and is not used on any load path.
+    std::optional<LogRecord> ParseLineWithRegex(std::string_view line, ParseContext const& context = {});
+
+    // The std::get_time decoders the regex cascade reads its stamps with,
+    // written apart from ParseTimestamp and ParseSyslogTimestamp so that
+    // verify-parser checks those too; bench-timestamp times them against
+    // each other.
+    std::optional<int64_t> ParseTimestampWithGetTime(std::string_view text);
+    std::optional<int64_t> ParseSyslogTimestampWithGetTime(std::string_view text, int64_t reference);
+}
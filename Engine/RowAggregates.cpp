@@ -0,0 +1,286 @@
+#include "RowAggregates.h"
+
+#include "BinaryIo.h"
+#include "LogStore.h"
+#include "Parallel.h"
+
+#include <algorithm>
+
+namespace LogMinds::Engine
+{
+    namespace
+    {
+        // Selections smaller than this are counted on the calling thread.
+        constexpr size_t c_minimumRowsPerChunk = 1 << 16;
+    }
+
+    bool RowAggregates::IsCritical(std::string_view level)
+    {
+        return level == "ERROR" || level == "FATAL" || level == "CRITICAL";
+    }
+
+    RowAggregates RowAggregates::Of(LogStore const& store, std::vector<uint32_t> const& rows, unsigned threadCount)
+    {
+        auto threads = ResolveThreadCount(threadCount);
+        auto chunkCount = std::max<size_t>(1, std::min<size_t>(threads * 4, rows.size() / c_minimumRowsPerChunk));
+        auto perChunk = (rows.size() + chunkCount - 1) / chunkCount;
+        std::vector<RowAggregates> partials(chunkCount);
+        ParallelFor(chunkCount, threads, [&](size_t chunk)
+        {
+            auto begin = std::min(rows.size(), chunk * perChunk);
+            auto end = std::min(rows.size(), begin + perChunk);
+            for (auto index = begin; index < end; ++index)
+            {
+                partials[chunk].Add(store, rows[index]);
+            }
+        });
+
+        auto aggregates = std::move(partials.front());
+        for (size_t chunk = 1; chunk < chunkCount; ++chunk)
+        {
+            aggregates.Merge(partials[chunk]);
+        }
+        return aggregates;
+    }
+
+    void RowAggregates::Add(LogStore const& store, size_t row)
+    {
+        ++m_rows;
+        auto level = store.LevelId(row);
+        bool critical = false;
+        if (level == LogStore::c_overflowLevel)
+        {
+            auto name = store.Level(row);
+            ++m_overflowLevelRows[std::string(name)];
+            critical = IsCritical(name);
+        }
+        else
+        {
+            if (level >= m_levelRows.size())
+            {
+                m_levelRows.resize(level + 1);
+                m_criticalLevels.resize(level + 1, -1);
+            }
+            ++m_levelRows[level];
+            if (m_criticalLevels[level] < 0)
+            {
+                m_criticalLevels[level] = IsCritical(store.LevelNames()[level]) ? 1 : 0;
+            }
+            critical = m_criticalLevels[level] != 0;
+        }
+
+        auto source = store.SourceId(row);
+        if (source >= m_sourceRows.size())
+        {
+            m_sourceRows.resize(source + 1);
+        }
+        ++m_sourceRows[source];
+
+        if (auto occurredOn = store.OccurredOn(row))
+        {
+            ++m_timedRows;
+            AddTimes(occurredOn, occurredOn);
+        }
+
+        if (critical)
+        {
+            if (m_criticalSamples.size() < c_criticalSamples)
+            {
+                m_criticalSamples.push_back(static_cast<uint32_t>(row));
+            }
+            ++m_criticalRows;
+        }
+    }
+
+    void RowAggregates::Merge(RowAggregates const& other)
+    {
+        m_rows += other.m_rows;
+        if (m_levelRows.size() < other.m_levelRows.size())
+        {
+            m_levelRows.resize(other.m_levelRows.size());
+            m_criticalLevels.resize(other.m_levelRows.size(), -1);
+        }
+        for (size_t id = 0; id < other.m_levelRows.size(); ++id)
+        {
+            m_levelRows[id] += other.m_levelRows[id];
+            if (m_criticalLevels[id] < 0)
+            {
+                m_criticalLevels[id] = other.m_criticalLevels[id];
+            }
+        }
+        for (auto const& [name, rows] : other.m_overflowLevelRows)
+        {
+            m_overflowLevelRows[name] += rows;
+        }
+        if (m_sourceRows.size() < other.m_sourceRows.size())
+        {
+            m_sourceRows.resize(other.m_sourceRows.size());
+        }
+        for (size_t id = 0; id < other.m_sourceRows.size(); ++id)
+        {
+            m_sourceRows[id] += other.m_sourceRows[id];
+        }
+        m_timedRows += other.m_timedRows;
+        AddTimes(other.m_firstTime, other.m_lastTime);
+        m_criticalRows += other.m_criticalRows;
+        AddCriticalSamples(other.m_criticalSamples, 0);
+    }
+
+    void RowAggregates::Merge(RowAggregates const& other, size_t rowShift, std::vector<std::string> const& otherLevelNames,
+        std::vector<uint8_t> const& levelRemap, std::vector<uint32_t> const& sourceRemap)
+    {
+        m_rows += other.m_rows;
+        for (size_t id = 0; id < other.m_levelRows.size(); ++id)
+        {
+            if (other.m_levelRows[id] == 0)
+            {
+                continue;
+            }
+            auto target = levelRemap[id];
+            if (target == LogStore::c_overflowLevel)
+            {
+                m_overflowLevelRows[otherLevelNames[id]] += other.m_levelRows[id];
+                continue;
+            }
+            if (target >= m_levelRows.size())
+            {
+                m_levelRows.resize(target + 1);
+                m_criticalLevels.resize(target + 1, -1);
+            }
+            m_levelRows[target] += other.m_levelRows[id];
+        }
+        for (auto const& [name, rows] : other.m_overflowLevelRows)
+        {
+            m_overflowLevelRows[name] += rows;
+        }
+        for (size_t id = 0; id < other.m_sourceRows.size(); ++id)
+        {
+            if (other.m_sourceRows[id] == 0)
+            {
+                continue;
+            }
+            auto target = sourceRemap[id];
+            if (target >= m_sourceRows.size())
+            {
+                m_sourceRows.resize(target + 1);
+            }
+            m_sourceRows[target] += other.m_sourceRows[id];
+        }
+        m_timedRows += other.m_timedRows;
+        AddTimes(other.m_firstTime, other.m_lastTime);
+        m_criticalRows += other.m_criticalRows;
+        AddCriticalSamples(other.m_criticalSamples, rowShift);
+    }
+
+    void RowAggregates::Write(BinaryWriter& writer) const
+    {
+        writer.Value<uint64_t>(m_rows);
+        writer.Vector(m_levelRows);
+        writer.Value<uint64_t>(m_overflowLevelRows.size());
+        for (auto const& [name, rows] : m_overflowLevelRows)
+        {
+            writer.String(name);
+            writer.Value<uint64_t>(rows);
+        }
+        writer.Vector(m_sourceRows);
+        writer.Value<uint64_t>(m_timedRows);
+        writer.Value<int64_t>(m_firstTime.value_or(0));
+        writer.Value<int64_t>(m_lastTime.value_or(0));
+        writer.Value<uint64_t>(m_criticalRows);
+        writer.Vector(m_criticalSamples);
+    }
+
+    bool RowAggregates::Read(BinaryReader& reader, LogStore const& store)
+    {
+        *this = RowAggregates();
+        uint64_t rows = 0;
+        uint64_t overflowCount = 0;
+        if (!reader.Value(rows) || rows != store.Size() || !reader.Vector(m_levelRows) || !reader.Value(overflowCount))
+        {
+            return false;
+        }
+        m_rows = store.Size();
+
+        // The per-level and per-source counts must each add up to the rows,
+        // over ids the store has.
+        auto sumsToRows = [&](std::vector<size_t> const& counts, size_t total)
+        {
+            for (auto count : counts)
+            {
+                if (count > m_rows - total)
+                {
+                    return false;
+                }
+                total += count;
+            }
+            return total == m_rows;
+        };
+        size_t overflowRows = 0;
+        for (uint64_t i = 0; i < overflowCount; ++i)
+        {
+            std::string name;
+            uint64_t count = 0;
+            if (!reader.String(name) || !reader.Value(count) || count == 0 || count > m_rows - overflowRows)
+            {
+                return false;
+            }
+            overflowRows += static_cast<size_t>(count);
+            m_overflowLevelRows.emplace(std::move(name), static_cast<size_t>(count));
+        }
+        if (m_levelRows.size() > store.LevelNames().size() || !sumsToRows(m_levelRows, overflowRows) ||
+            !reader.Vector(m_sourceRows) || m_sourceRows.size() > store.SourceNames().size() ||
+            !sumsToRows(m_sourceRows, 0))
+        {
+            return false;
+        }
+
+        uint64_t timedRows = 0;
+        int64_t firstTime = 0;
+        int64_t lastTime = 0;
+        uint64_t criticalRows = 0;
+        if (!reader.Value(timedRows) || timedRows > m_rows || !reader.Value(firstTime) || !reader.Value(lastTime) ||
+            firstTime > lastTime || !reader.Value(criticalRows) || criticalRows > m_rows ||
+            !reader.Vector(m_criticalSamples) ||
+            m_criticalSamples.size() != std::min<uint64_t>(criticalRows, c_criticalSamples))
+        {
+            return false;
+        }
+        m_timedRows = static_cast<size_t>(timedRows);
+        if (m_timedRows != 0)
+        {
+            m_firstTime = firstTime;
+            m_lastTime = lastTime;
+        }
+        m_criticalRows = static_cast<size_t>(criticalRows);
+        for (size_t index = 0; index < m_criticalSamples.size(); ++index)
+        {
+            auto row = m_criticalSamples[index];
+            if (row >= m_rows || (index != 0 && row <= m_criticalSamples[index - 1]) || !IsCritical(store.Level(row)))
+            {
+                return false;
+            }
+        }
+        m_criticalLevels.assign(m_levelRows.size(), -1);
+        return true;
+    }
+
+    void RowAggregates::AddTimes(std::optional<int64_t> first, std::optional<int64_t> last)
+    {
+        if (first && (!m_firstTime || *first < *m_firstTime))
+        {
+            m_firstTime = first;
+        }
+        if (last && (!m_lastTime || *last > *m_lastTime))
+        {
+            m_lastTime = last;
+        }
+    }
+
+    void RowAggregates::AddCriticalSamples(std::vector<uint32_t> const& samples, size_t rowShift)
+    {
+        for (size_t index = 0; index < samples.size() && m_criticalSamples.size() < c_criticalSamples; ++index)
+        {
+            m_criticalSamples.push_back(static_cast<uint32_t>(samples[index] + rowShift));
+        }
+    }
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace LogMinds::Engine
+{
+    class BinaryReader;
+    class BinaryWriter;
+    class LogStore;
+
+    // What the summary reports about a set of rows of one store: rows per
+    // level and per source (indexed by the store's dictionary ids), the time
+    // range, and the error rows with the first few of them by row number.
+    // Every store keeps one over all of its rows, updated as rows are
+    // appended; the filter worker makes one for each selection.
+    class RowAggregates
+    {
+    public:
+        static constexpr size_t c_criticalSamples = 16;
+
+        static bool IsCritical(std::string_view level);
+
+        // Over the (ascending) rows of store, split across threadCount
+        // workers (0 = one per hardware thread).
+        static RowAggregates Of(LogStore const& store, std::vector<uint32_t> const& rows, unsigned threadCount = 0);
+
+        void Add(LogStore const& store, size_t row);
+        // Adds the counts of other, taken over rows of the same store that
+        // all follow the rows counted here.
+        void Merge(RowAggregates const& other);
+        // Same, for the rows of another store appended to this one's store
+        // from row rowShift on. Ids are translated through the remaps;
+        // levels left without an id (c_overflowLevel) are counted by name.
+        void Merge(RowAggregates const& other, size_t rowShift, std::vector<std::string> const& otherLevelNames,
+            std::vector<uint8_t> const& levelRemap, std::vector<uint32_t> const& sourceRemap);
+
+        size_t Rows() const
+        {
+            return m_rows;
+        }
+
+        // By level id; shorter than the store's dictionary when the last ids
+        // were not seen.
+        std::vector<size_t> const& LevelRows() const
+        {
+            return m_levelRows;
+        }
+
+        // Rows whose level did not fit the store's id table, by name. A name
+        // can also have an id when stores were appended.
+        std::map<std::string, size_t> const& OverflowLevelRows() const
+        {
+            return m_overflowLevelRows;
+        }
+
+        // By source id, shorter like LevelRows.
+        std::vector<size_t> const& SourceRows() const
+        {
+            return m_sourceRows;
+        }
+
+        size_t TimedRows() const
+        {
+            return m_timedRows;
+        }
+
+        std::optional<int64_t> FirstTime() const
+        {
+            return m_firstTime;
+        }
+
+        std::optional<int64_t> LastTime() const
+        {
+            return m_lastTime;
+        }
+
+        // Rows at ERROR, FATAL or CRITICAL.
+        size_t CriticalRows() const
+        {
+            return m_criticalRows;
+        }
+
+        // The first c_criticalSamples of them, in row order.
+        std::vector<uint32_t> const& CriticalSamples() const
+        {
+            return m_criticalSamples;
+        }
+
+        // Read replaces the contents and fails unless they could be the
+        // aggregates over every row of store.
+        void Write(BinaryWriter& writer) const;
+        bool Read(BinaryReader& reader, LogStore const& store);
+
+    private:
+        size_t m_rows{ 0 };
+        std::vector<size_t> m_levelRows;
+        std::map<std::string, size_t> m_overflowLevelRows;
+        std::vector<size_t> m_sourceRows;
+        size_t m_timedRows{ 0 };
+        std::optional<int64_t> m_firstTime;
+        std::optional<int64_t> m_lastTime;
+        size_t m_criticalRows{ 0 };
+        std::vector<uint32_t> m_criticalSamples;
+        // Whether each level id is critical: -1 until first seen.
+        std::vector<int8_t> m_criticalLevels;
+
+        void AddTimes(std::optional<int64_t> first, std::optional<int64_t> last);
+        void AddCriticalSamples(std::vector<uint32_t> const& samples, size_t rowShift);
+    };
+}
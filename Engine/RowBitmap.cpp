@@ -0,0 +1,128 @@
+#include "RowBitmap.h"
+
+#include "BinaryIo.h"
+
+#include <algorithm>
+
+namespace LogMinds::Engine
+{
+    void RowBitmap::Add(uint32_t row)
+    {
+        auto key = static_cast<uint16_t>(row >> 16);
+        auto low = static_cast<uint16_t>(row & 0xFFFF);
+        if (m_chunks.empty() || m_chunks.back().Key != key)
+        {
+            m_chunks.push_back(Chunk{ key, {}, {} });
+        }
+
+        auto& chunk = m_chunks.back();
+        if (chunk.Bits.empty() && chunk.Values.size() == c_arrayLimit)
+        {
+            chunk.Bits.assign(c_bitsetWords, 0);
+            for (auto value : chunk.Values)
+            {
+                chunk.Bits[value >> 6] |= uint64_t{ 1 } << (value & 63);
+            }
+            chunk.Values = {};
+        }
+
+        if (chunk.Bits.empty())
+        {
+            chunk.Values.push_back(low);
+        }
+        else
+        {
+            chunk.Bits[low >> 6] |= uint64_t{ 1 } << (low & 63);
+        }
+        ++m_count;
+    }
+
+    bool RowBitmap::Contains(uint32_t row) const
+    {
+        auto key = static_cast<uint16_t>(row >> 16);
+        auto low = static_cast<uint16_t>(row & 0xFFFF);
+        auto chunk = std::lower_bound(m_chunks.begin(), m_chunks.end(), key, [](Chunk const& item, uint16_t value)
+        {
+            return item.Key < value;
+        });
+        if (chunk == m_chunks.end() || chunk->Key != key)
+        {
+            return false;
+        }
+        if (chunk->Bits.empty())
+        {
+            return std::binary_search(chunk->Values.begin(), chunk->Values.end(), low);
+        }
+        return (chunk->Bits[low >> 6] >> (low & 63)) & 1;
+    }
+
+    std::vector<uint32_t> RowBitmap::Rows() const
+    {
+        std::vector<uint32_t> rows;
+        rows.reserve(m_count);
+        ForEach([&](uint32_t row)
+        {
+            rows.push_back(row);
+        });
+        return rows;
+    }
+
+    void RowBitmap::ShrinkToFit()
+    {
+        m_chunks.shrink_to_fit();
+        for (auto& chunk : m_chunks)
+        {
+            chunk.Values.shrink_to_fit();
+        }
+    }
+
+    size_t RowBitmap::MemoryUsage() const
+    {
+        auto bytes = sizeof(RowBitmap) + m_chunks.capacity() * sizeof(Chunk);
+        for (auto const& chunk : m_chunks)
+        {
+            bytes += chunk.Values.capacity() * sizeof(uint16_t) + chunk.Bits.capacity() * sizeof(uint64_t);
+        }
+        return bytes;
+    }
+
+    void RowBitmap::Write(BinaryWriter& writer) const
+    {
+        writer.Value<uint64_t>(m_chunks.size());
+        for (auto const& chunk : m_chunks)
+        {
+            writer.Value(chunk.Key);
+            writer.Vector(chunk.Values);
+            writer.Vector(chunk.Bits);
+        }
+        writer.Value<uint64_t>(m_count);
+    }
+
+    bool RowBitmap::Read(BinaryReader& reader)
+    {
+        *this = RowBitmap();
+        uint64_t chunks = 0;
+        if (!reader.Value(chunks) || chunks > 65536)
+        {
+            return false;
+        }
+        m_chunks.resize(static_cast<size_t>(chunks));
+        for (auto& chunk : m_chunks)
+        {
+            if (!reader.Value(chunk.Key) || !reader.Vector(chunk.Values) || !reader.Vector(chunk.Bits) ||
+                (!chunk.Bits.empty() && (chunk.Bits.size() != c_bitsetWords || !chunk.Values.empty())))
+            {
+                *this = RowBitmap();
+                return false;
+            }
+        }
+        uint64_t count = 0;
+        if (!reader.Value(count))
+        {
+            *this = RowBitmap();
+            return false;
+        }
+        m_count = static_cast<size_t>(count);
+        return true;
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace LogMinds::Engine
+{
+    class BinaryReader;
+    class BinaryWriter;
+
+    inline unsigned CountTrailingZeros(uint64_t bits)
+    {
+#if defined(_MSC_VER)
+        unsigned long index = 0;
+        _BitScanForward64(&index, bits);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctzll(bits));
+#endif
+    }
+
+    // Compressed set of row ids, laid out like a Roaring bitmap: rows are
+    // grouped by their upper 16 bits, and each group is a sorted array of
+    // the lower 16 bits while it is sparse and a 65536-bit bitset once it
+    // holds more than c_arrayLimit rows.
+    class RowBitmap
+    {
+    public:
+        // Rows must be added in ascending order.
+        void Add(uint32_t row);
+
+        bool Contains(uint32_t row) const;
+
+        size_t Count() const
+        {
+            return m_count;
+        }
+
+        bool Empty() const
+        {
+            return m_count == 0;
+        }
+
+        // The rows in ascending order.
+        std::vector<uint32_t> Rows() const;
+
+        template <typename Visit>
+        void ForEach(Visit&& visit) const
+        {
+            for (auto const& chunk : m_chunks)
+            {
+                auto base = static_cast<uint32_t>(chunk.Key) << 16;
+                if (chunk.Bits.empty())
+                {
+                    for (auto low : chunk.Values)
+                    {
+                        visit(base | low);
+                    }
+                    continue;
+                }
+                for (size_t word = 0; word < chunk.Bits.size(); ++word)
+                {
+                    for (auto bits = chunk.Bits[word]; bits != 0; bits &= bits - 1)
+                    {
+                        visit(base | static_cast<uint32_t>(word * 64 + CountTrailingZeros(bits)));
+                    }
+                }
+            }
+        }
+
+        // Drops the slack left by growing the arrays; call once built.
+        void ShrinkToFit();
+
+        size_t MemoryUsage() const;
+
+        void Write(BinaryWriter& writer) const;
+        // False, leaving the bitmap empty, when the input is inconsistent.
+        bool Read(BinaryReader& reader);
+
+    private:
+        static constexpr size_t c_arrayLimit = 4096;
+        static constexpr size_t c_bitsetWords = 65536 / 64;
+
+        struct Chunk
+        {
+            uint16_t Key{ 0 };
+            // Exactly one of the two is in use.
+            std::vector<uint16_t> Values;
+            std::vector<uint64_t> Bits;
+        };
+
+        std::vector<Chunk> m_chunks;
+        size_t m_count{ 0 };
+    };
+}
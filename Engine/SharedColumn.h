@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace LogMinds::Engine
+{
+    // An append-only array whose copies share its items. A copy sees the
+    // items that existed when it was made and nothing after, so it can be
+    // handed to readers on other threads while the original keeps growing:
+    // the original appends into the free space past the end of every copy,
+    // and only once the buffer is full moves to one twice its size, leaving
+    // the copies on the old buffer. A copy is a read-only view until it
+    // grows itself, which first gives it a buffer of its own. Items already
+    // in a buffer are never written again.
+    template <typename T>
+    class SharedColumn
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+    public:
+        SharedColumn() = default;
+
+        // A read-only view of count items that owner keeps alive, such as a
+        // mapped file. Like a copy, it moves to a buffer of its own to grow.
+        SharedColumn(std::shared_ptr<void const> const& owner, T const* items, size_t count) :
+            m_items(owner, const_cast<T*>(items)), m_size(count), m_room(count), m_capacity(count)
+        {
+        }
+
+        SharedColumn(SharedColumn const& other) :
+            m_items(other.m_items), m_size(other.m_size), m_room(other.m_size), m_capacity(other.m_capacity)
+        {
+        }
+
+        SharedColumn(SharedColumn&& other) noexcept :
+            m_items(std::move(other.m_items)), m_size(std::exchange(other.m_size, 0)),
+            m_room(std::exchange(other.m_room, 0)), m_capacity(std::exchange(other.m_capacity, 0))
+        {
+        }
+
+        SharedColumn& operator=(SharedColumn const& other)
+        {
+            if (this != &other)
+            {
+                *this = SharedColumn(other);
+            }
+            return *this;
+        }
+
+        SharedColumn& operator=(SharedColumn&& other) noexcept
+        {
+            m_items = std::move(other.m_items);
+            m_size = std::exchange(other.m_size, 0);
+            m_room = std::exchange(other.m_room, 0);
+            m_capacity = std::exchange(other.m_capacity, 0);
+            return *this;
+        }
+
+        size_t Size() const
+        {
+            return m_size;
+        }
+
+        bool Empty() const
+        {
+            return m_size == 0;
+        }
+
+        // Of the whole buffer, shared or not.
+        size_t Capacity() const
+        {
+            return m_capacity;
+        }
+
+        T const* Data() const
+        {
+            return m_items.get();
+        }
+
+        T const& operator[](size_t index) const
+        {
+            return m_items[index];
+        }
+
+        void Push(T const& item)
+        {
+            if (m_size == m_room)
+            {
+                Grow(GrownCapacity(m_size + 1));
+            }
+            m_items[m_size++] = item;
+        }
+
+        void Append(T const* items, size_t count)
+        {
+            if (count != 0)
+            {
+                std::memcpy(Extend(count), items, count * sizeof(T));
+            }
+        }
+
+        // Grows by count items and returns the first of them, for the caller
+        // to fill in before anyone copies the column.
+        T* Extend(size_t count)
+        {
+            if (count > m_room - m_size)
+            {
+                Grow(GrownCapacity(m_size + count));
+            }
+            auto first = m_items.get() + m_size;
+            m_size += count;
+            return first;
+        }
+
+        // Only ever grows; the new items are value.
+        void Resize(size_t size, T const& value)
+        {
+            if (size > m_size)
+            {
+                std::fill_n(Extend(size - m_size), size - m_size, value);
+            }
+        }
+
+        void Reserve(size_t capacity)
+        {
+            if (capacity > m_room)
+            {
+                Grow(capacity);
+            }
+        }
+
+    private:
+        static constexpr size_t c_minCapacity = 16;
+
+        std::shared_ptr<T[]> m_items;
+        size_t m_size{ 0 };
+        // Items this column may write in place: the capacity when it made
+        // the buffer's newest items, its size when it is a copy.
+        size_t m_room{ 0 };
+        size_t m_capacity{ 0 };
+
+        size_t GrownCapacity(size_t needed) const
+        {
+            return std::max({ needed, 2 * m_size, c_minCapacity });
+        }
+
+        void Grow(size_t capacity)
+        {
+            std::shared_ptr<T[]> items(new T[capacity]);
+            if (m_size != 0)
+            {
+                std::memcpy(items.get(), m_items.get(), m_size * sizeof(T));
+            }
+            m_items = std::move(items);
+            m_room = capacity;
+            m_capacity = capacity;
+        }
+    };
+}
@@ -0,0 +1,176 @@
+#include "Summary.h"
+
+#include "KeywordSketch.h"
+#include "Timestamp.h"
+
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <vector>
+
+namespace LogMinds::Engine
+{
+    namespace
+    {
+        std::string Summarize(LogStore const& store, RowAggregates const& aggregates, KeywordSketch const& keywordSketch)
+        {
+            std::map<std::string, size_t> levelCount(aggregates.OverflowLevelRows().begin(),
+                aggregates.OverflowLevelRows().end());
+            auto const& levelRows = aggregates.LevelRows();
+            for (size_t id = 0; id < levelRows.size(); ++id)
+            {
+                if (levelRows[id] != 0)
+                {
+                    auto const& name = store.LevelNames()[id];
+                    levelCount[name.empty() ? std::string("未标记") : name] += levelRows[id];
+                }
+            }
+            std::map<std::string, size_t> sourceCount;
+            auto const& sourceRows = aggregates.SourceRows();
+            for (size_t id = 1; id < sourceRows.size(); ++id)
+            {
+                if (sourceRows[id] != 0)
+                {
+                    sourceCount.emplace(store.SourceNames()[id], sourceRows[id]);
+                }
+            }
+            auto firstTimestamp = aggregates.FirstTime();
+            auto lastTimestamp = aggregates.LastTime();
+
+            auto keywords = keywordSketch.Top(5);
+
+            std::ostringstream summary;
+            summary << "📊 日志总览" << std::endl;
+            if (aggregates.Rows() == store.Size())
+            {
+                summary << "  • 共解析 " << store.Size() << " 条记录";
+            }
+            else
+            {
+                summary << "  • 当前筛选 " << aggregates.Rows() << " 条记录（共 " << store.Size() << " 条）";
+            }
+            if (!levelCount.empty())
+            {
+                summary << "，级别分布：";
+                bool first = true;
+                for (auto const& pair : levelCount)
+                {
+                    if (!first)
+                    {
+                        summary << "，";
+                    }
+                    summary << pair.first << "=" << pair.second;
+                    first = false;
+                }
+            }
+            summary << std::endl;
+
+            if (firstTimestamp || lastTimestamp)
+            {
+                summary << "  • 时间范围：" << FormatDateRange(firstTimestamp, lastTimestamp) << std::endl;
+            }
+
+            if (!sourceCount.empty())
+            {
+                std::vector<std::pair<std::string, size_t>> sortedSources(sourceCount.begin(), sourceCount.end());
+                std::sort(sortedSources.begin(), sortedSources.end(), [](auto const& left, auto const& right)
+                {
+                    if (left.second == right.second)
+                    {
+                        return left.first < right.first;
+                    }
+                    return left.second > right.second;
+                });
+                summary << "  • 主要来源：";
+                size_t count = std::min<size_t>(3, sortedSources.size());
+                for (size_t i = 0; i < count; ++i)
+                {
+                    if (i > 0)
+                    {
+                        summary << "，";
+                    }
+                    summary << sortedSources[i].first << "(" << sortedSources[i].second << ")";
+                }
+                summary << std::endl;
+            }
+
+            auto const& criticalRows = aggregates.CriticalSamples();
+            if (aggregates.CriticalRows() != 0)
+            {
+                summary << "⚠️ 关键异常" << std::endl;
+                size_t count = std::min<size_t>(3, criticalRows.size());
+                for (size_t i = 0; i < count; ++i)
+                {
+                    summary << "  • " << store.Message(criticalRows[i]) << std::endl;
+                }
+                if (aggregates.CriticalRows() > count)
+                {
+                    summary << "  • 其余 " << (aggregates.CriticalRows() - count) << " 条错误已省略" << std::endl;
+                }
+            }
+
+            if (!keywords.empty())
+            {
+                summary << "🧠 主题洞察" << std::endl;
+                summary << "  • 高频关键词：";
+                for (size_t i = 0; i < keywords.size(); ++i)
+                {
+                    if (i > 0)
+                    {
+                        summary << "，";
+                    }
+                    summary << keywords[i].first << "(" << keywords[i].second << ")";
+                }
+                summary << std::endl;
+            }
+
+            summary << "✅ 建议操作" << std::endl;
+            size_t warnCount = 0;
+            if (auto it = levelCount.find("WARN"); it != levelCount.end())
+            {
+                warnCount = it->second;
+            }
+
+            if (aggregates.CriticalRows() != 0)
+            {
+                summary << "  • 优先处理上述关键异常，必要时增加告警阈值监控" << std::endl;
+            }
+            else if (warnCount == 0)
+            {
+                summary << "  • 当前日志未发现严重异常，可继续监控趋势" << std::endl;
+            }
+            else
+            {
+                summary << "  • 聚焦 WARN 级别日志，确认潜在风险是否可复现" << std::endl;
+            }
+
+            return summary.str();
+        }
+    }
+
+    std::string BuildSummary(LogStore const& store)
+    {
+        if (store.Empty())
+        {
+            return "尚未加载日志数据。";
+        }
+
+        return Summarize(store, store.Aggregates(), store.Keywords());
+    }
+
+    std::string BuildSummary(LogStore const& store, RowAggregates const& aggregates, std::vector<uint32_t> const& rows)
+    {
+        if (store.Empty())
+        {
+            return "尚未加载日志数据。";
+        }
+        if (rows.empty())
+        {
+            return "当前筛选条件下没有日志。";
+        }
+
+        // Only the keywords of a selection are not kept up to date.
+        return Summarize(store, aggregates, KeywordSketch::Of(store, rows));
+    }
+}
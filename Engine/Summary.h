@@ -0,0 +1,16 @@
+#pragma once
+
+#include "LogStore.h"
+#include "RowAggregates.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace LogMinds::Engine
+{
+    std::string BuildSummary(LogStore const& store);
+    // Describes a selection of the store's rows, such as the current filter
+    // result, given its aggregates.
+    std::string BuildSummary(LogStore const& store, RowAggregates const& aggregates, std::vector<uint32_t> const& rows);
+}
@@ -0,0 +1,417 @@
+#include "TemplateMiner.h"
+
+#include "BinaryIo.h"
+#include "LogStore.h"
+#include "Parallel.h"
+#include "Text.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace LogMinds::Engine
+{
+    namespace
+    {
+        // Each chunk keeps a slot per template, so chunks stay large.
+        constexpr size_t c_minimumRowsPerChunk = 1 << 16;
+
+        bool IsDigit(char ch)
+        {
+            return ch >= '0' && ch <= '9';
+        }
+
+        template <typename RowAt>
+        std::vector<TemplateGroup> GroupRows(LogStore const& store, size_t count, RowAt rowAt, unsigned threadCount)
+        {
+            auto templates = store.Templates().Size();
+            auto threads = ResolveThreadCount(threadCount);
+            auto chunkCount = std::max<size_t>(1, std::min<size_t>(threads, count / c_minimumRowsPerChunk));
+            auto perChunk = (count + chunkCount - 1) / chunkCount;
+            std::vector<std::vector<TemplateGroup>> partials(chunkCount);
+            ParallelFor(chunkCount, threads, [&](size_t chunk)
+            {
+                auto& groups = partials[chunk];
+                groups.resize(templates);
+                auto begin = std::min(count, chunk * perChunk);
+                auto end = std::min(count, begin + perChunk);
+                for (auto index = begin; index < end; ++index)
+                {
+                    auto row = rowAt(index);
+                    auto& group = groups[store.TemplateId(row)];
+                    if (group.Rows++ == 0)
+                    {
+                        group.FirstRow = row;
+                    }
+                    group.LastRow = row;
+                    if (auto occurredOn = store.OccurredOn(row))
+                    {
+                        group.FirstTime = group.FirstTime ? std::min(*group.FirstTime, *occurredOn) : *occurredOn;
+                        group.LastTime = group.LastTime ? std::max(*group.LastTime, *occurredOn) : *occurredOn;
+                    }
+                }
+            });
+
+            // Chunks are in row order, so the first chunk with a template
+            // holds its first row and the last one its last row.
+            std::vector<TemplateGroup> groups;
+            for (uint32_t id = 0; id < templates; ++id)
+            {
+                TemplateGroup merged;
+                merged.Template = id;
+                for (auto const& partial : partials)
+                {
+                    auto const& group = partial[id];
+                    if (group.Rows == 0)
+                    {
+                        continue;
+                    }
+                    if (merged.Rows == 0)
+                    {
+                        merged.FirstRow = group.FirstRow;
+                    }
+                    merged.Rows += group.Rows;
+                    merged.LastRow = group.LastRow;
+                    if (group.FirstTime && (!merged.FirstTime || *group.FirstTime < *merged.FirstTime))
+                    {
+                        merged.FirstTime = group.FirstTime;
+                    }
+                    if (group.LastTime && (!merged.LastTime || *group.LastTime > *merged.LastTime))
+                    {
+                        merged.LastTime = group.LastTime;
+                    }
+                }
+                if (merged.Rows != 0)
+                {
+                    groups.push_back(merged);
+                }
+            }
+            std::sort(groups.begin(), groups.end(), [](TemplateGroup const& left, TemplateGroup const& right)
+            {
+                return left.Rows != right.Rows ? left.Rows > right.Rows : left.Template < right.Template;
+            });
+            return groups;
+        }
+    }
+
+    uint32_t TemplateMiner::Add(std::string_view message)
+    {
+        Tokenize(message, m_tokens);
+        return Place(m_tokens);
+    }
+
+    std::vector<uint32_t> TemplateMiner::Merge(TemplateMiner const& other)
+    {
+        std::vector<uint32_t> remap;
+        remap.reserve(other.m_templates.size());
+        std::vector<Token> tokens;
+        for (auto const& tokensOfOther : other.m_templates)
+        {
+            tokens.clear();
+            for (auto const& token : tokensOfOther)
+            {
+                tokens.push_back({ token.Text, token.Kind, token.KeyLength });
+            }
+            remap.push_back(Place(tokens));
+        }
+        return remap;
+    }
+
+    std::string TemplateMiner::Text(uint32_t id) const
+    {
+        std::string text;
+        for (auto const& token : m_templates[id])
+        {
+            if (!text.empty())
+            {
+                text.push_back(' ');
+            }
+            text.append(token.Text);
+        }
+        return text;
+    }
+
+    std::vector<std::string_view> TemplateMiner::Parameters(uint32_t id, std::string_view message) const
+    {
+        std::vector<Token> tokens;
+        Tokenize(message, tokens);
+        auto const& tokensOfTemplate = m_templates[id];
+        std::vector<std::string_view> parameters;
+        if (tokens.size() != tokensOfTemplate.size())
+        {
+            return parameters;
+        }
+        for (size_t position = 0; position < tokens.size(); ++position)
+        {
+            auto const& token = tokensOfTemplate[position];
+            auto text = tokens[position].Text;
+            if (token.Kind == TokenKind::Parameter)
+            {
+                parameters.push_back(text);
+            }
+            else if (token.Kind == TokenKind::KeyParameter)
+            {
+                auto key = std::string_view(token.Text).substr(0, token.KeyLength);
+                parameters.push_back(text.substr(0, key.size()) == key ? text.substr(key.size()) : text);
+            }
+        }
+        return parameters;
+    }
+
+    size_t TemplateMiner::MemoryUsage() const
+    {
+        // Hash nodes are approximated as key + value + next pointer + hash.
+        auto bytes = m_templates.capacity() * sizeof(std::vector<TemplateToken>) + m_nodes.capacity() * sizeof(Node) +
+            m_lengths.size() * 4 * sizeof(size_t) + m_tokens.capacity() * sizeof(Token);
+        for (auto const& tokens : m_templates)
+        {
+            bytes += tokens.capacity() * sizeof(TemplateToken);
+            for (auto const& token : tokens)
+            {
+                bytes += token.Text.capacity() > std::string().capacity() ? token.Text.capacity() + 1 : 0;
+            }
+        }
+        for (auto const& node : m_nodes)
+        {
+            bytes += node.Children.size() * 4 * sizeof(size_t) + node.Children.bucket_count() * sizeof(void*) +
+                node.Templates.capacity() * sizeof(uint32_t);
+        }
+        return bytes;
+    }
+
+    void TemplateMiner::Write(BinaryWriter& writer) const
+    {
+        writer.Value<uint64_t>(m_templates.size());
+        for (auto const& tokens : m_templates)
+        {
+            writer.Value<uint64_t>(tokens.size());
+            for (auto const& token : tokens)
+            {
+                writer.Value(static_cast<uint8_t>(token.Kind));
+                writer.Value(token.KeyLength);
+                writer.String(token.Text);
+            }
+        }
+    }
+
+    bool TemplateMiner::Read(BinaryReader& reader)
+    {
+        *this = TemplateMiner();
+        uint64_t count = 0;
+        if (!reader.Value(count) || count > UINT32_MAX)
+        {
+            return false;
+        }
+        std::vector<Token> tokens;
+        for (uint64_t id = 0; id < count; ++id)
+        {
+            uint64_t length = 0;
+            if (!reader.Value(length))
+            {
+                return false;
+            }
+            std::vector<TemplateToken> tokensOfTemplate;
+            for (uint64_t position = 0; position < length; ++position)
+            {
+                uint8_t kind = 0;
+                TemplateToken token;
+                if (!reader.Value(kind) || !reader.Value(token.KeyLength) || !reader.String(token.Text) ||
+                    kind > static_cast<uint8_t>(TokenKind::KeyParameter) || token.KeyLength > token.Text.size())
+                {
+                    return false;
+                }
+                token.Kind = static_cast<TokenKind>(kind);
+                tokensOfTemplate.push_back(std::move(token));
+            }
+
+            // Templates go back to the leaf their tokens lead to; they are
+            // not matched against each other again.
+            m_templates.push_back(std::move(tokensOfTemplate));
+            tokens.clear();
+            for (auto const& token : m_templates.back())
+            {
+                tokens.push_back({ token.Text, token.Kind, token.KeyLength });
+            }
+            m_nodes[Leaf(tokens)].Templates.push_back(static_cast<uint32_t>(id));
+        }
+        return true;
+    }
+
+    void TemplateMiner::Tokenize(std::string_view message, std::vector<Token>& tokens)
+    {
+        tokens.clear();
+        size_t offset = 0;
+        while (offset < message.size())
+        {
+            if (IsAsciiSpace(message[offset]))
+            {
+                ++offset;
+                continue;
+            }
+
+            auto start = offset;
+            auto equals = std::string_view::npos;
+            auto digitInKey = false;
+            auto digit = false;
+            for (; offset < message.size() && !IsAsciiSpace(message[offset]); ++offset)
+            {
+                auto ch = message[offset];
+                if (IsDigit(ch))
+                {
+                    digit = true;
+                    digitInKey = digitInKey || equals == std::string_view::npos;
+                }
+                else if (ch == '=' && equals == std::string_view::npos)
+                {
+                    equals = offset - start;
+                }
+            }
+
+            Token token{ message.substr(start, offset - start), TokenKind::Literal, 0 };
+            if (digit)
+            {
+                auto keyed = equals != std::string_view::npos && equals > 0 && !digitInKey;
+                token.Kind = keyed ? TokenKind::KeyParameter : TokenKind::Parameter;
+                token.KeyLength = keyed ? static_cast<uint32_t>(equals + 1) : 0;
+            }
+            tokens.push_back(token);
+        }
+    }
+
+    bool TemplateMiner::Agrees(TemplateToken const& left, Token const& right)
+    {
+        if (left.Kind != right.Kind)
+        {
+            return false;
+        }
+        switch (left.Kind)
+        {
+        case TokenKind::Literal:
+            return left.Text == right.Text;
+        case TokenKind::KeyParameter:
+            return left.KeyLength == right.KeyLength &&
+                std::string_view(left.Text).substr(0, left.KeyLength) == right.Text.substr(0, right.KeyLength);
+        default:
+            return true;
+        }
+    }
+
+    uint32_t TemplateMiner::Place(std::vector<Token> const& tokens)
+    {
+        auto leaf = Leaf(tokens);
+        auto best = c_noNode;
+        size_t bestAgreeing = 0;
+        for (auto id : m_nodes[leaf].Templates)
+        {
+            auto const& tokensOfTemplate = m_templates[id];
+            size_t agreeing = 0;
+            for (size_t position = 0; position < tokens.size(); ++position)
+            {
+                agreeing += Agrees(tokensOfTemplate[position], tokens[position]) ? 1 : 0;
+            }
+            if (best == c_noNode || agreeing > bestAgreeing)
+            {
+                best = id;
+                bestAgreeing = agreeing;
+            }
+            if (agreeing == tokens.size())
+            {
+                break;
+            }
+        }
+
+        if (best != c_noNode && bestAgreeing >= c_similarity * static_cast<double>(tokens.size()))
+        {
+            auto& tokensOfTemplate = m_templates[best];
+            for (size_t position = 0; position < tokens.size(); ++position)
+            {
+                auto& token = tokensOfTemplate[position];
+                if (token.Kind != TokenKind::Parameter && !Agrees(token, tokens[position]))
+                {
+                    token = { std::string(c_wildcard), TokenKind::Parameter, 0 };
+                }
+            }
+            return best;
+        }
+
+        std::vector<TemplateToken> tokensOfTemplate;
+        tokensOfTemplate.reserve(tokens.size());
+        for (auto const& token : tokens)
+        {
+            switch (token.Kind)
+            {
+            case TokenKind::Literal:
+                tokensOfTemplate.push_back({ std::string(token.Text), token.Kind, 0 });
+                break;
+            case TokenKind::KeyParameter:
+                tokensOfTemplate.push_back(
+                    { std::string(token.Text.substr(0, token.KeyLength)).append(c_wildcard), token.Kind, token.KeyLength });
+                break;
+            default:
+                tokensOfTemplate.push_back({ std::string(c_wildcard), token.Kind, 0 });
+                break;
+            }
+        }
+        auto id = static_cast<uint32_t>(m_templates.size());
+        m_templates.push_back(std::move(tokensOfTemplate));
+        m_nodes[leaf].Templates.push_back(id);
+        return id;
+    }
+
+    uint32_t TemplateMiner::Leaf(std::vector<Token> const& tokens)
+    {
+        auto [length, added] = m_lengths.try_emplace(tokens.size(), static_cast<uint32_t>(m_nodes.size()));
+        if (added)
+        {
+            m_nodes.emplace_back();
+        }
+        auto node = length->second;
+        for (size_t position = 0; position < std::min(c_routingTokens, tokens.size()); ++position)
+        {
+            node = Child(node, tokens[position]);
+        }
+        return node;
+    }
+
+    uint32_t TemplateMiner::Child(uint32_t node, Token const& token)
+    {
+        auto next = static_cast<uint32_t>(m_nodes.size());
+        if (token.Kind == TokenKind::Literal)
+        {
+            auto hash = std::hash<std::string_view>()(token.Text);
+            auto& children = m_nodes[node].Children;
+            if (auto found = children.find(hash); found != children.end())
+            {
+                return found->second;
+            }
+            if (children.size() < c_maxChildren)
+            {
+                children.emplace(hash, next);
+                m_nodes.emplace_back();
+                return next;
+            }
+        }
+        if (m_nodes[node].Wildcard == c_noNode)
+        {
+            m_nodes[node].Wildcard = next;
+            m_nodes.emplace_back();
+        }
+        return m_nodes[node].Wildcard;
+    }
+
+    std::vector<TemplateGroup> GroupByTemplate(LogStore const& store, std::vector<uint32_t> const& rows,
+        unsigned threadCount)
+    {
+        return GroupRows(store, rows.size(), [&](size_t index)
+        {
+            return rows[index];
+        }, threadCount);
+    }
+
+    std::vector<TemplateGroup> GroupByTemplate(LogStore const& store, unsigned threadCount)
+    {
+        return GroupRows(store, store.Size(), [](size_t index)
+        {
+            return static_cast<uint32_t>(index);
+        }, threadCount);
+    }
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace LogMinds::Engine
+{
+    class BinaryReader;
+    class BinaryWriter;
+    class LogStore;
+
+    // Groups messages into templates as they arrive, in the manner of Drain:
+    // a message is split into whitespace-separated tokens, routed by its
+    // token count and its first c_routingTokens tokens to a leaf, and joins
+    // the leaf's most similar template when at least c_similarity of the
+    // positions agree; positions that disagree become wildcards. Tokens with
+    // a digit are parameters from the start ("<*>", or "key=<*>" for a
+    // key=value pair), so ids, counters and addresses never split a template.
+    // Templates only ever generalize, so a message keeps its id and its
+    // parameters are the tokens at the template's wildcards.
+    class TemplateMiner
+    {
+    public:
+        static constexpr size_t c_routingTokens = 2;
+        // Further distinct tokens at one routing position share its wildcard branch.
+        static constexpr size_t c_maxChildren = 64;
+        static constexpr double c_similarity = 0.5;
+        static constexpr std::string_view c_wildcard = "<*>";
+
+        // The id of the template message joined or started.
+        uint32_t Add(std::string_view message);
+        // Adds the templates of other, each joining a similar one here or
+        // starting its own; returns the id here of every id of other.
+        std::vector<uint32_t> Merge(TemplateMiner const& other);
+
+        size_t Size() const
+        {
+            return m_templates.size();
+        }
+
+        // The template's tokens joined by spaces, wildcards as c_wildcard.
+        std::string Text(uint32_t id) const;
+        // The tokens of message (one of the template's) at its wildcards;
+        // for "key=<*>" only the value.
+        std::vector<std::string_view> Parameters(uint32_t id, std::string_view message) const;
+
+        size_t MemoryUsage() const;
+
+        // Read replaces the contents and fails on input that does not
+        // describe a consistent set of templates.
+        void Write(BinaryWriter& writer) const;
+        bool Read(BinaryReader& reader);
+
+    private:
+        enum class TokenKind : uint8_t
+        {
+            Literal,
+            Parameter,
+            // "key=<*>"; KeyLength covers the key and the '='.
+            KeyParameter,
+        };
+
+        struct Token
+        {
+            std::string_view Text;
+            TokenKind Kind;
+            uint32_t KeyLength;
+        };
+
+        struct TemplateToken
+        {
+            std::string Text;
+            TokenKind Kind;
+            uint32_t KeyLength;
+        };
+
+        struct Node
+        {
+            // Keyed by the hash of a literal token; a collision only shares a branch.
+            std::unordered_map<size_t, uint32_t> Children;
+            uint32_t Wildcard{ c_noNode };
+            std::vector<uint32_t> Templates;
+        };
+
+        static constexpr uint32_t c_noNode = UINT32_MAX;
+
+        std::vector<std::vector<TemplateToken>> m_templates;
+        std::vector<Node> m_nodes;
+        // First node by token count.
+        std::unordered_map<size_t, uint32_t> m_lengths;
+        // Reused by Add, so that a message allocates nothing once its
+        // template exists.
+        std::vector<Token> m_tokens;
+
+        static void Tokenize(std::string_view message, std::vector<Token>& tokens);
+        static bool Agrees(TemplateToken const& left, Token const& right);
+        uint32_t Place(std::vector<Token> const& tokens);
+        uint32_t Leaf(std::vector<Token> const& tokens);
+        uint32_t Child(uint32_t node, Token const& token);
+    };
+
+    struct TemplateGroup
+    {
+        uint32_t Template{ 0 };
+        size_t Rows{ 0 };
+        uint32_t FirstRow{ 0 };
+        uint32_t LastRow{ 0 };
+        // Earliest and latest timestamps among the rows.
+        std::optional<int64_t> FirstTime;
+        std::optional<int64_t> LastTime;
+    };
+
+    // One group per template among the (ascending) rows of store, most rows
+    // first, split across threadCount workers (0 = one per hardware thread).
+    std::vector<TemplateGroup> GroupByTemplate(LogStore const& store, std::vector<uint32_t> const& rows,
+        unsigned threadCount = 0);
+    // Same, over every row.
+    std::vector<TemplateGroup> GroupByTemplate(LogStore const& store, unsigned threadCount = 0);
+}
@@ -0,0 +1,232 @@
+#include "Text.h"
+
+#include <cwctype>
+
+namespace LogMinds::Engine
+{
+    namespace
+    {
+        template <typename Transform>
+        void MapCodePoints(std::string_view text, Transform transform, std::string& result)
+        {
+            result.clear();
+            result.reserve(text.size());
+            size_t offset = 0;
+            while (offset < text.size())
+            {
+                auto byte = static_cast<unsigned char>(text[offset]);
+                if (byte < 0x80)
+                {
+                    result.push_back(static_cast<char>(transform(byte)));
+                    ++offset;
+                    continue;
+                }
+
+                auto start = offset;
+                auto codePoint = DecodeUtf8(text, offset);
+                if (codePoint == c_invalidCodePoint)
+                {
+                    result.append(text.substr(start, offset - start));
+                    continue;
+                }
+                AppendUtf8(result, transform(codePoint));
+            }
+        }
+
+        bool FitsWchar(char32_t codePoint)
+        {
+            return sizeof(wchar_t) >= 4 || codePoint <= 0xFFFF;
+        }
+    }
+
+    char32_t DecodeUtf8(std::string_view text, size_t& offset)
+    {
+        auto lead = static_cast<unsigned char>(text[offset]);
+        if (lead < 0x80)
+        {
+            ++offset;
+            return lead;
+        }
+
+        size_t length = 0;
+        char32_t codePoint = 0;
+        if ((lead & 0xE0) == 0xC0)
+        {
+            length = 2;
+            codePoint = lead & 0x1F;
+        }
+        else if ((lead & 0xF0) == 0xE0)
+        {
+            length = 3;
+            codePoint = lead & 0x0F;
+        }
+        else if ((lead & 0xF8) == 0xF0)
+        {
+            length = 4;
+            codePoint = lead & 0x07;
+        }
+        else
+        {
+            ++offset;
+            return c_invalidCodePoint;
+        }
+
+        if (offset + length > text.size())
+        {
+            ++offset;
+            return c_invalidCodePoint;
+        }
+
+        for (size_t i = 1; i < length; ++i)
+        {
+            auto next = static_cast<unsigned char>(text[offset + i]);
+            if ((next & 0xC0) != 0x80)
+            {
+                ++offset;
+                return c_invalidCodePoint;
+            }
+            codePoint = (codePoint << 6) | (next & 0x3F);
+        }
+
+        offset += length;
+        return codePoint;
+    }
+
+    void AppendUtf8(std::string& output, char32_t codePoint)
+    {
+        if (codePoint < 0x80)
+        {
+            output.push_back(static_cast<char>(codePoint));
+        }
+        else if (codePoint < 0x800)
+        {
+            output.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+            output.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        }
+        else if (codePoint < 0x10000)
+        {
+            output.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+            output.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        }
+        else
+        {
+            output.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+            output.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        }
+    }
+
+    std::string Utf16ToUtf8(std::string_view bytes, bool bigEndian)
+    {
+        auto unitAt = [&](size_t index) -> char32_t
+        {
+            auto first = static_cast<unsigned char>(bytes[index * 2]);
+            auto second = static_cast<unsigned char>(bytes[index * 2 + 1]);
+            return bigEndian ? (first << 8) | second : (second << 8) | first;
+        };
+
+        std::string result;
+        result.reserve(bytes.size());
+        auto units = bytes.size() / 2;
+        for (size_t i = 0; i < units; ++i)
+        {
+            auto unit = unitAt(i);
+            if (unit >= 0xD800 && unit <= 0xDBFF && i + 1 < units)
+            {
+                auto low = unitAt(i + 1);
+                if (low >= 0xDC00 && low <= 0xDFFF)
+                {
+                    AppendUtf8(result, 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00));
+                    ++i;
+                    continue;
+                }
+            }
+            AppendUtf8(result, (unit >= 0xD800 && unit <= 0xDFFF) ? 0xFFFD : unit);
+        }
+        return result;
+    }
+
+    std::string_view TrimView(std::string_view text)
+    {
+        size_t start = 0;
+        size_t end = text.size();
+        while (start < end && IsAsciiSpace(text[start]))
+        {
+            ++start;
+        }
+        while (end > start && IsAsciiSpace(text[end - 1]))
+        {
+            --end;
+        }
+        return text.substr(start, end - start);
+    }
+
+    std::string Trim(std::string_view text)
+    {
+        return std::string(TrimView(text));
+    }
+
+    std::string ToLower(std::string_view text)
+    {
+        std::string result;
+        ToLowerInto(text, result);
+        return result;
+    }
+
+    void ToLowerInto(std::string_view text, std::string& output)
+    {
+        MapCodePoints(text, [](char32_t ch)
+        {
+            return ToLower(ch);
+        }, output);
+    }
+
+    char32_t ToLower(char32_t codePoint)
+    {
+        if (codePoint < 0x80)
+        {
+            return (codePoint >= 'A' && codePoint <= 'Z') ? codePoint + ('a' - 'A') : codePoint;
+        }
+        return FitsWchar(codePoint) ? static_cast<char32_t>(std::towlower(static_cast<wint_t>(codePoint))) : codePoint;
+    }
+
+    std::string ToUpper(std::string_view text)
+    {
+        std::string result;
+        MapCodePoints(text, [](char32_t ch) -> char32_t
+        {
+            if (ch < 0x80)
+            {
+                return (ch >= 'a' && ch <= 'z') ? ch - ('a' - 'A') : ch;
+            }
+            return FitsWchar(ch) ? static_cast<char32_t>(std::towupper(static_cast<wint_t>(ch))) : ch;
+        }, result);
+        return result;
+    }
+
+    bool IsWordCodePoint(char32_t codePoint)
+    {
+        if (codePoint < 0x80)
+        {
+            return (codePoint >= 'a' && codePoint <= 'z') || (codePoint >= 'A' && codePoint <= 'Z') ||
+                (codePoint >= '0' && codePoint <= '9') || codePoint == '_';
+        }
+        return FitsWchar(codePoint) && std::iswalnum(static_cast<wint_t>(codePoint)) != 0;
+    }
+
+    std::string NormalizeLevel(std::string_view level)
+    {
+        auto normalized = ToUpper(level);
+        if (normalized == "WARNING")
+        {
+            normalized = "WARN";
+        }
+        else if (normalized == "ERR")
+        {
+            normalized = "ERROR";
+        }
+        return normalized;
+    }
+}
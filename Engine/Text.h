@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace LogMinds::Engine
+{
+    // All engine text is UTF-8. Invalid sequences are passed through byte by byte.
+    constexpr char32_t c_invalidCodePoint = 0xFFFFFFFF;
+
+    char32_t DecodeUtf8(std::string_view text, size_t& offset);
+    void AppendUtf8(std::string& output, char32_t codePoint);
+
+    inline bool IsAsciiSpace(char ch)
+    {
+        return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == '\v' || ch == '\f';
+    }
+
+    // Converts UTF-16 bytes (no BOM) to UTF-8; unpaired surrogates become U+FFFD.
+    std::string Utf16ToUtf8(std::string_view bytes, bool bigEndian);
+
+    std::string_view TrimView(std::string_view text);
+    std::string Trim(std::string_view text);
+    std::string ToLower(std::string_view text);
+    // ToLower into a caller-owned buffer, so a reused buffer stops allocating.
+    void ToLowerInto(std::string_view text, std::string& output);
+    char32_t ToLower(char32_t codePoint);
+    std::string ToUpper(std::string_view text);
+    bool IsWordCodePoint(char32_t codePoint);
+
+    // Upper-cases a level name and folds the WARNING/ERR aliases.
+    std::string NormalizeLevel(std::string_view level);
+}
@@ -0,0 +1,454 @@
+#include "TextSearch.h"
+
+#include "Text.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define LOGMINDS_HAS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(LOGMINDS_HAS_SSE2) && (defined(__GNUC__) || defined(_MSC_VER))
+#define LOGMINDS_HAS_AVX2 1
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__GNUC__)
+#define LOGMINDS_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define LOGMINDS_TARGET_AVX2
+#endif
+
+namespace LogMinds::Engine
+{
+    namespace
+    {
+        constexpr size_t c_slots = 4;
+
+        inline unsigned CountTrailingZeros(uint32_t mask)
+        {
+#if defined(_MSC_VER)
+            unsigned long index = 0;
+            _BitScanForward(&index, mask);
+            return static_cast<unsigned>(index);
+#else
+            return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+        }
+
+        inline bool InSlots(char const* slots, char ch)
+        {
+            return slots[0] == ch || slots[1] == ch || slots[2] == ch || slots[3] == ch;
+        }
+
+        // (lower case, code point) for every code point whose lower case
+        // differs, ordered; filled under the locale current on first use.
+        std::vector<std::pair<char32_t, char32_t>> const& LowerCaseSources()
+        {
+            static auto const sources = []
+            {
+                std::vector<std::pair<char32_t, char32_t>> result;
+                char32_t const last = sizeof(wchar_t) >= 4 ? 0x10FFFF : 0xFFFF;
+                for (char32_t codePoint = 0; codePoint <= last; ++codePoint)
+                {
+                    if (codePoint >= 0xD800 && codePoint <= 0xDFFF)
+                    {
+                        continue;
+                    }
+                    auto lower = ToLower(codePoint);
+                    if (lower != codePoint)
+                    {
+                        result.emplace_back(lower, codePoint);
+                    }
+                }
+                std::sort(result.begin(), result.end());
+                return result;
+            }();
+            return sources;
+        }
+
+        // Every code point whose lower case is lower.
+        std::vector<char32_t> CaseVariants(char32_t lower)
+        {
+            std::vector<char32_t> variants;
+            if (ToLower(lower) == lower)
+            {
+                variants.push_back(lower);
+            }
+            auto const& sources = LowerCaseSources();
+            for (auto it = std::lower_bound(sources.begin(), sources.end(), std::make_pair(lower, char32_t{ 0 }));
+                it != sources.end() && it->first == lower; ++it)
+            {
+                variants.push_back(it->second);
+            }
+            return variants;
+        }
+
+        bool AddSlot(char* slots, size_t& used, char ch)
+        {
+            if (std::find(slots, slots + used, ch) != slots + used)
+            {
+                return true;
+            }
+            if (used == c_slots)
+            {
+                return false;
+            }
+            slots[used++] = ch;
+            return true;
+        }
+
+        // Offset of the first byte >= 0x80 at or after from, or text.size().
+        size_t NextNonAscii(std::string_view text, size_t from)
+        {
+            auto i = from;
+#if defined(LOGMINDS_HAS_SSE2)
+            for (; i + 16 <= text.size(); i += 16)
+            {
+                auto mask = static_cast<uint32_t>(_mm_movemask_epi8(
+                    _mm_loadu_si128(reinterpret_cast<__m128i const*>(text.data() + i))));
+                if (mask != 0)
+                {
+                    return i + CountTrailingZeros(mask);
+                }
+            }
+#endif
+            for (; i < text.size(); ++i)
+            {
+                if (static_cast<unsigned char>(text[i]) >= 0x80)
+                {
+                    return i;
+                }
+            }
+            return text.size();
+        }
+
+        // True at a lead byte that starts a longer encoding than its code
+        // point needs; DecodeUtf8 accepts those, so their lower case can be
+        // shorter than the text.
+        inline bool IsOverlongAt(std::string_view text, size_t offset)
+        {
+            auto lead = static_cast<unsigned char>(text[offset]);
+            auto next = offset + 1 < text.size() ? static_cast<unsigned char>(text[offset + 1]) : 0;
+            return lead == 0xC0 || lead == 0xC1 || (lead == 0xE0 && next >= 0x80 && next < 0xA0) ||
+                (lead == 0xF0 && next >= 0x80 && next < 0x90);
+        }
+
+        bool HasOverlong(std::string_view text, size_t from)
+        {
+            auto i = from;
+#if defined(LOGMINDS_HAS_SSE2)
+            // C0/C1, E0 and F0 are the only leads that can start one.
+            auto const folded = _mm_set1_epi8(static_cast<char>(0xFE));
+            for (; i + 16 <= text.size(); i += 16)
+            {
+                auto bytes = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(text.data() + i)), folded);
+                auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(static_cast<char>(0xC0))),
+                        _mm_cmpeq_epi8(bytes, _mm_set1_epi8(static_cast<char>(0xE0)))),
+                    _mm_cmpeq_epi8(bytes, _mm_set1_epi8(static_cast<char>(0xF0))))));
+                while (mask != 0)
+                {
+                    if (IsOverlongAt(text, i + CountTrailingZeros(mask)))
+                    {
+                        return true;
+                    }
+                    mask &= mask - 1;
+                }
+            }
+#endif
+            for (; i < text.size(); ++i)
+            {
+                if (IsOverlongAt(text, i))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Offset of the first candidate at or after from: a start whose byte
+        // is in first and whose byte lastOffset further on is in last.
+        size_t NextScalar(std::string_view text, size_t from, size_t lastOffset, char const* first, char const* last)
+        {
+            for (auto i = from; i + lastOffset < text.size(); ++i)
+            {
+                if (InSlots(first, text[i]) && InSlots(last, text[i + lastOffset]))
+                {
+                    return i;
+                }
+            }
+            return std::string_view::npos;
+        }
+
+#if defined(LOGMINDS_HAS_SSE2)
+        inline __m128i AnyOf128(__m128i bytes, __m128i const* slots)
+        {
+            return _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, slots[0]), _mm_cmpeq_epi8(bytes, slots[1])),
+                _mm_or_si128(_mm_cmpeq_epi8(bytes, slots[2]), _mm_cmpeq_epi8(bytes, slots[3])));
+        }
+
+        size_t NextSse2(std::string_view text, size_t from, size_t lastOffset, char const* first, char const* last)
+        {
+            __m128i const heads[c_slots] = { _mm_set1_epi8(first[0]), _mm_set1_epi8(first[1]), _mm_set1_epi8(first[2]),
+                _mm_set1_epi8(first[3]) };
+            __m128i const tails[c_slots] = { _mm_set1_epi8(last[0]), _mm_set1_epi8(last[1]), _mm_set1_epi8(last[2]),
+                _mm_set1_epi8(last[3]) };
+            auto i = from;
+            for (; i + lastOffset + 16 <= text.size(); i += 16)
+            {
+                auto head = _mm_loadu_si128(reinterpret_cast<__m128i const*>(text.data() + i));
+                auto tail = _mm_loadu_si128(reinterpret_cast<__m128i const*>(text.data() + i + lastOffset));
+                auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(AnyOf128(head, heads),
+                    AnyOf128(tail, tails))));
+                if (mask != 0)
+                {
+                    return i + CountTrailingZeros(mask);
+                }
+            }
+            return NextScalar(text, i, lastOffset, first, last);
+        }
+#endif
+
+#if defined(LOGMINDS_HAS_AVX2)
+        LOGMINDS_TARGET_AVX2 inline __m256i AnyOf256(__m256i bytes, __m256i const* slots)
+        {
+            return _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(bytes, slots[0]), _mm256_cmpeq_epi8(bytes, slots[1])),
+                _mm256_or_si256(_mm256_cmpeq_epi8(bytes, slots[2]), _mm256_cmpeq_epi8(bytes, slots[3])));
+        }
+
+        LOGMINDS_TARGET_AVX2 size_t NextAvx2(std::string_view text, size_t from, size_t lastOffset, char const* first,
+            char const* last)
+        {
+            __m256i const heads[c_slots] = { _mm256_set1_epi8(first[0]), _mm256_set1_epi8(first[1]),
+                _mm256_set1_epi8(first[2]), _mm256_set1_epi8(first[3]) };
+            __m256i const tails[c_slots] = { _mm256_set1_epi8(last[0]), _mm256_set1_epi8(last[1]),
+                _mm256_set1_epi8(last[2]), _mm256_set1_epi8(last[3]) };
+            auto i = from;
+            for (; i + lastOffset + 32 <= text.size(); i += 32)
+            {
+                auto head = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(text.data() + i));
+                auto tail = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(text.data() + i + lastOffset));
+                auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(AnyOf256(head, heads),
+                    AnyOf256(tail, tails))));
+                if (mask != 0)
+                {
+                    return i + CountTrailingZeros(mask);
+                }
+            }
+            return NextScalar(text, i, lastOffset, first, last);
+        }
+
+        bool CpuHasAvx2()
+        {
+#if defined(_MSC_VER)
+            int info[4] = {};
+            __cpuid(info, 0);
+            if (info[0] < 7)
+            {
+                return false;
+            }
+            __cpuid(info, 1);
+            bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+            __cpuidex(info, 7, 0);
+            return osSavesYmm && (info[1] & (1 << 5)) != 0;
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+#endif
+
+        using NextFunction = size_t (*)(std::string_view text, size_t from, size_t lastOffset, char const* first,
+            char const* last);
+
+        struct ScanKernel
+        {
+            NextFunction Next;
+            char const* Name;
+        };
+
+        ScanKernel SelectScan()
+        {
+#if defined(LOGMINDS_HAS_AVX2)
+            if (CpuHasAvx2())
+            {
+                return { NextAvx2, "avx2" };
+            }
+#endif
+#if defined(LOGMINDS_HAS_SSE2)
+            return { NextSse2, "sse2" };
+#else
+            return { NextScalar, "scalar" };
+#endif
+        }
+
+        ScanKernel const c_kernel = SelectScan();
+    }
+
+    CaseInsensitiveMatcher::CaseInsensitiveMatcher(std::string_view loweredTerm) :
+        m_term(loweredTerm)
+    {
+        std::string encoded;
+        for (size_t offset = 0; offset < m_term.size();)
+        {
+            auto start = offset;
+            auto codePoint = DecodeUtf8(m_term, offset);
+            encoded.clear();
+            if (codePoint != c_invalidCodePoint)
+            {
+                AppendUtf8(encoded, codePoint);
+            }
+            if (encoded != m_term.substr(start, offset - start))
+            {
+                m_codePoints.clear();
+                return;
+            }
+            m_codePoints.push_back(codePoint);
+        }
+        if (m_codePoints.empty())
+        {
+            return;
+        }
+
+        // A variant as long as its lower case lines up with the term byte for
+        // byte, so the term's length separates its first and last bytes.
+        size_t firstUsed = 0;
+        size_t lastUsed = 0;
+        auto fits = true;
+        for (size_t i = 0; i < m_codePoints.size(); ++i)
+        {
+            encoded.clear();
+            AppendUtf8(encoded, m_codePoints[i]);
+            auto length = encoded.size();
+            auto variants = CaseVariants(m_codePoints[i]);
+            if (std::all_of(variants.begin(), variants.end(), [](char32_t variant)
+            {
+                return variant >= 0x80;
+            }))
+            {
+                m_needsNonAscii = true;
+            }
+            for (auto variant : variants)
+            {
+                encoded.clear();
+                AppendUtf8(encoded, variant);
+                if (encoded.size() != length)
+                {
+                    if (std::find(m_resizingVariants.begin(), m_resizingVariants.end(), encoded) == m_resizingVariants.end())
+                    {
+                        m_resizingVariants.push_back(encoded);
+                    }
+                    continue;
+                }
+                if (i == 0)
+                {
+                    fits = AddSlot(m_firstBytes, firstUsed, encoded.front()) && fits;
+                }
+                if (i + 1 == m_codePoints.size())
+                {
+                    fits = AddSlot(m_lastBytes, lastUsed, encoded.back()) && fits;
+                }
+            }
+        }
+        m_filtered = fits && firstUsed > 0 && lastUsed > 0;
+        for (auto i = firstUsed; m_filtered && i < c_slots; ++i)
+        {
+            m_firstBytes[i] = m_firstBytes[0];
+        }
+        for (auto i = lastUsed; m_filtered && i < c_slots; ++i)
+        {
+            m_lastBytes[i] = m_lastBytes[0];
+        }
+    }
+
+    bool CaseInsensitiveMatcher::FoundIn(std::string_view text) const
+    {
+        if (m_term.empty())
+        {
+            return true;
+        }
+        if (m_codePoints.empty())
+        {
+            thread_local std::string lowered;
+            ToLowerInto(text, lowered);
+            return lowered.find(m_term) != std::string::npos;
+        }
+        auto firstNonAscii = m_needsNonAscii ? NextNonAscii(text, 0) : 0;
+        if (firstNonAscii == text.size())
+        {
+            return false;
+        }
+        if (!m_filtered)
+        {
+            return MatchesAnywhere(text);
+        }
+
+        // Candidates start on a lead byte, so on a code point boundary.
+        auto lastOffset = m_term.size() - 1;
+        for (size_t from = 0; (from = c_kernel.Next(text, from, lastOffset, m_firstBytes, m_lastBytes)) != std::string_view::npos;
+            ++from)
+        {
+            if (MatchesAt(text, from))
+            {
+                return true;
+            }
+        }
+
+        // A hit the filter cannot see spans a variant of another length,
+        // which plain ASCII text does not hold.
+        if (!m_needsNonAscii && (firstNonAscii = NextNonAscii(text, 0)) == text.size())
+        {
+            return false;
+        }
+        for (auto const& variant : m_resizingVariants)
+        {
+            if (text.find(variant) != std::string_view::npos)
+            {
+                return MatchesAnywhere(text);
+            }
+        }
+        return HasOverlong(text, firstNonAscii) && MatchesAnywhere(text);
+    }
+
+    bool CaseInsensitiveMatcher::MatchesAt(std::string_view text, size_t offset) const
+    {
+        for (auto expected : m_codePoints)
+        {
+            if (offset >= text.size())
+            {
+                return false;
+            }
+            auto codePoint = DecodeUtf8(text, offset);
+            if (codePoint == c_invalidCodePoint || ToLower(codePoint) != expected)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool CaseInsensitiveMatcher::MatchesAnywhere(std::string_view text) const
+    {
+        for (size_t offset = 0; offset < text.size(); DecodeUtf8(text, offset))
+        {
+            if (MatchesAt(text, offset))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    char const* CaseInsensitiveMatcher::Kernel()
+    {
+        return c_kernel.Name;
+    }
+}
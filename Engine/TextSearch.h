@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace LogMinds::Engine
+{
+    // Answers ToLower(text).find(term) != npos for an already lower-cased
+    // term without building the lower-cased copy. Text is scanned in place
+    // with an SSE2/AVX2 filter on the bytes a case variant of the term can
+    // start and end with, and each candidate is compared code point by code
+    // point. Only variants that change length when lower-cased (the Kelvin
+    // sign, overlong encodings) need a slower pass, taken when the text holds
+    // one. A term that is not valid UTF-8 is still matched against a
+    // lower-cased copy in a reused per-thread buffer.
+    class CaseInsensitiveMatcher
+    {
+    public:
+        explicit CaseInsensitiveMatcher(std::string_view loweredTerm);
+
+        bool FoundIn(std::string_view text) const;
+
+        // Name of the scan kernel picked for this CPU ("avx2", "sse2" or "scalar").
+        static char const* Kernel();
+
+    private:
+        std::string_view m_term;
+        // The term's code points; empty when it is not valid UTF-8.
+        std::u32string m_codePoints;
+        // First bytes of the variants of the first code point and last bytes
+        // of the variants of the last one, repeated to fill the four slots.
+        // Without m_filtered every code point boundary is a candidate.
+        char m_firstBytes[4]{};
+        char m_lastBytes[4]{};
+        bool m_filtered{ false };
+        // Set when some code point of the term has no ASCII variant, so plain
+        // ASCII text cannot hold it.
+        bool m_needsNonAscii{ false };
+        // Code points that lower-case into one of the term's in a different
+        // number of bytes, UTF-8 encoded.
+        std::vector<std::string> m_resizingVariants;
+
+        bool MatchesAt(std::string_view text, size_t offset) const;
+        bool MatchesAnywhere(std::string_view text) const;
+    };
+}
@@ -0,0 +1,359 @@
+#include "Timestamp.h"
+
+#include "Text.h"
+
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+
+namespace LogMinds::Engine
+{
+    namespace
+    {
+        constexpr int64_t c_secondsPerDay = 24 * 60 * 60;
+
+        // Days since 1970-01-01 in the proleptic Gregorian calendar. A day
+        // past the end of its month carries into the next one, as with
+        // timegm.
+        int64_t DaysFromCivil(int64_t year, unsigned month, unsigned day)
+        {
+            year -= month <= 2 ? 1 : 0;
+            auto era = (year >= 0 ? year : year - 399) / 400;
+            auto yearOfEra = static_cast<unsigned>(year - era * 400);
+            auto dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+            auto dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+            return era * 146097 + static_cast<int64_t>(dayOfEra) - 719468;
+        }
+
+        // The year of a day counted as DaysFromCivil counts them.
+        int YearFromDays(int64_t days)
+        {
+            days += 719468;
+            auto era = (days >= 0 ? days : days - 146096) / 146097;
+            auto dayOfEra = static_cast<unsigned>(days - era * 146097);
+            auto yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+            auto dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+            auto shiftedMonth = (5 * dayOfYear + 2) / 153;
+            return static_cast<int>(static_cast<int64_t>(yearOfEra) + era * 400 + (shiftedMonth >= 10 ? 1 : 0));
+        }
+
+        // Consecutive lines almost always share their date.
+        int64_t CachedDaysFromCivil(int year, unsigned month, unsigned day)
+        {
+            struct LastDate
+            {
+                int Year{ 0 };
+                unsigned Month{ 0 };
+                unsigned Day{ 0 };
+                int64_t Days{ 0 };
+            };
+            thread_local LastDate last;
+            if (year != last.Year || month != last.Month || day != last.Day)
+            {
+                last = { year, month, day, DaysFromCivil(year, month, day) };
+            }
+            return last.Days;
+        }
+
+        bool IsDigit(char ch)
+        {
+            return static_cast<unsigned char>(ch - '0') <= 9;
+        }
+
+        unsigned TwoDigits(char const* text)
+        {
+            return static_cast<unsigned>(text[0] - '0') * 10 + static_cast<unsigned>(text[1] - '0');
+        }
+
+        // Reads one or two digits at offset.
+        bool ReadField(std::string_view text, size_t& offset, unsigned& value)
+        {
+            if (offset >= text.size() || !IsDigit(text[offset]))
+            {
+                return false;
+            }
+            value = static_cast<unsigned>(text[offset++] - '0');
+            if (offset < text.size() && IsDigit(text[offset]))
+            {
+                value = value * 10 + static_cast<unsigned>(text[offset++] - '0');
+            }
+            return true;
+        }
+
+        bool Expect(std::string_view text, size_t& offset, char ch)
+        {
+            if (offset >= text.size() || text[offset] != ch)
+            {
+                return false;
+            }
+            ++offset;
+            return true;
+        }
+
+        size_t SkipBlanks(std::string_view text, size_t offset)
+        {
+            while (offset < text.size() && IsAsciiSpace(text[offset]))
+            {
+                ++offset;
+            }
+            return offset;
+        }
+
+        size_t SkipSpaces(std::string_view text, size_t offset)
+        {
+            while (offset < text.size() && text[offset] == ' ')
+            {
+                ++offset;
+            }
+            return offset;
+        }
+
+        // hh:mm:ss with one or two digits per field; fast for the fixed width.
+        bool ReadTimeOfDay(std::string_view text, size_t& offset, int64_t& seconds)
+        {
+            unsigned hour = 0;
+            unsigned minute = 0;
+            unsigned second = 0;
+            if (offset + 8 <= text.size() && IsDigit(text[offset]) && IsDigit(text[offset + 1]) &&
+                text[offset + 2] == ':' && IsDigit(text[offset + 3]) && IsDigit(text[offset + 4]) &&
+                text[offset + 5] == ':' && IsDigit(text[offset + 6]) && IsDigit(text[offset + 7]) &&
+                (offset + 8 == text.size() || !IsDigit(text[offset + 8])))
+            {
+                hour = TwoDigits(text.data() + offset);
+                minute = TwoDigits(text.data() + offset + 3);
+                second = TwoDigits(text.data() + offset + 6);
+                offset += 8;
+            }
+            else if (!(ReadField(text, offset, hour) && Expect(text, offset, ':') &&
+                ReadField(text, offset, minute) && Expect(text, offset, ':') && ReadField(text, offset, second)))
+            {
+                return false;
+            }
+            if (hour > 23 || minute > 59 || second > 60)
+            {
+                return false;
+            }
+            seconds = (static_cast<int64_t>(hour) * 60 + minute) * 60 + second;
+            return true;
+        }
+
+        // [.,]digits as ticks; digits past 100ns are dropped.
+        int64_t ReadFraction(std::string_view text, size_t& offset)
+        {
+            if (offset >= text.size() || (text[offset] != '.' && text[offset] != ','))
+            {
+                return 0;
+            }
+            ++offset;
+            int64_t ticks = 0;
+            int64_t scale = c_ticksPerSecond;
+            while (offset < text.size() && IsDigit(text[offset]))
+            {
+                if (scale > 1)
+                {
+                    scale /= 10;
+                    ticks += (text[offset] - '0') * scale;
+                }
+                ++offset;
+            }
+            return ticks;
+        }
+
+        // Z or +hh, +hhmm, +hh:mm after optional blanks, as seconds east of
+        // UTC; anything else is trailing text and means UTC.
+        int64_t ReadUtcOffset(std::string_view text, size_t offset)
+        {
+            offset = SkipBlanks(text, offset);
+            if (offset >= text.size() || (text[offset] != '+' && text[offset] != '-'))
+            {
+                return 0;
+            }
+            auto sign = text[offset++] == '-' ? -1 : 1;
+            if (offset + 2 > text.size() || !IsDigit(text[offset]) || !IsDigit(text[offset + 1]))
+            {
+                return 0;
+            }
+            auto hours = TwoDigits(text.data() + offset);
+            offset += 2;
+            unsigned minutes = 0;
+            if (offset < text.size() && text[offset] == ':')
+            {
+                ++offset;
+                if (offset + 2 > text.size() || !IsDigit(text[offset]) || !IsDigit(text[offset + 1]))
+                {
+                    return 0;
+                }
+            }
+            if (offset + 2 <= text.size() && IsDigit(text[offset]) && IsDigit(text[offset + 1]))
+            {
+                minutes = TwoDigits(text.data() + offset);
+            }
+            if (hours > 23 || minutes > 59)
+            {
+                return 0;
+            }
+            return sign * static_cast<int64_t>(hours * 60 + minutes) * 60;
+        }
+
+        int MonthFromAbbreviation(std::string_view name)
+        {
+            static constexpr std::string_view c_months[] = {
+                "jan", "feb", "mar", "apr", "may", "jun", "jul", "aug", "sep", "oct", "nov", "dec",
+            };
+            char lowered[3];
+            for (size_t i = 0; i < 3; ++i)
+            {
+                auto ch = name[i];
+                lowered[i] = (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch + ('a' - 'A')) : ch;
+            }
+            for (size_t i = 0; i < std::size(c_months); ++i)
+            {
+                if (std::string_view(lowered, 3) == c_months[i])
+                {
+                    return static_cast<int>(i) + 1;
+                }
+            }
+            return 0;
+        }
+    }
+
+    std::optional<int64_t> ParseTimestamp(std::string_view text)
+    {
+        // yyyy-m-d, then T or blanks, then h:m:s; the fixed-width
+        // yyyy-mm-dd takes the branch-free path.
+        if (text.size() < 4 || !IsDigit(text[0]) || !IsDigit(text[1]) || !IsDigit(text[2]) || !IsDigit(text[3]))
+        {
+            return std::nullopt;
+        }
+        auto year = static_cast<int>(TwoDigits(text.data()) * 100 + TwoDigits(text.data() + 2));
+        unsigned month = 0;
+        unsigned day = 0;
+        size_t offset = 4;
+        if (text.size() >= 10 && text[4] == '-' && IsDigit(text[5]) && IsDigit(text[6]) && text[7] == '-' &&
+            IsDigit(text[8]) && IsDigit(text[9]) && (text.size() == 10 || !IsDigit(text[10])))
+        {
+            month = TwoDigits(text.data() + 5);
+            day = TwoDigits(text.data() + 8);
+            offset = 10;
+        }
+        else if (!(Expect(text, offset, '-') && ReadField(text, offset, month) && Expect(text, offset, '-') &&
+            ReadField(text, offset, day)))
+        {
+            return std::nullopt;
+        }
+        if (month < 1 || month > 12 || day < 1 || day > 31)
+        {
+            return std::nullopt;
+        }
+
+        if (offset < text.size() && (text[offset] == 'T' || text[offset] == 't'))
+        {
+            ++offset;
+        }
+        else
+        {
+            offset = SkipSpaces(text, offset);
+        }
+
+        int64_t seconds = 0;
+        if (!ReadTimeOfDay(text, offset, seconds))
+        {
+            return std::nullopt;
+        }
+        auto fraction = ReadFraction(text, offset);
+        seconds += CachedDaysFromCivil(year, month, day) * c_secondsPerDay - ReadUtcOffset(text, offset);
+        return seconds * c_ticksPerSecond + fraction;
+    }
+
+    std::optional<int64_t> ParseSyslogTimestamp(std::string_view text, int64_t reference)
+    {
+        // Mmm d hh:mm:ss with blanks between the parts.
+        if (text.size() < 3)
+        {
+            return std::nullopt;
+        }
+        auto month = MonthFromAbbreviation(text);
+        size_t offset = SkipSpaces(text, 3);
+        unsigned day = 0;
+        if (month == 0 || offset == 3 || !ReadField(text, offset, day) || day < 1 || day > 31)
+        {
+            return std::nullopt;
+        }
+        auto timeStart = SkipSpaces(text, offset);
+        int64_t seconds = 0;
+        if (timeStart == offset || !ReadTimeOfDay(text, timeStart, seconds))
+        {
+            return std::nullopt;
+        }
+
+        auto referenceDays = reference / c_ticksPerDay - (reference % c_ticksPerDay < 0 ? 1 : 0);
+        auto year = YearFromDays(referenceDays);
+        auto ticks = (CachedDaysFromCivil(year, static_cast<unsigned>(month), day) * c_secondsPerDay + seconds) *
+            c_ticksPerSecond;
+        if (ticks > reference + c_ticksPerDay)
+        {
+            ticks = (CachedDaysFromCivil(year - 1, static_cast<unsigned>(month), day) * c_secondsPerDay + seconds) *
+                c_ticksPerSecond;
+        }
+        return ticks;
+    }
+
+    int64_t CurrentTicks()
+    {
+        return std::chrono::duration_cast<std::chrono::duration<int64_t, std::ratio<1, c_ticksPerSecond>>>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    int64_t LastWriteTicks(std::filesystem::path const& path)
+    {
+        // The file clock's epoch is unspecified; both clocks are read now to
+        // carry the time across.
+        std::error_code code;
+        auto written = std::filesystem::last_write_time(path, code);
+        if (code)
+        {
+            return CurrentTicks();
+        }
+        auto age = std::chrono::duration_cast<std::chrono::duration<int64_t, std::ratio<1, c_ticksPerSecond>>>(
+            std::filesystem::file_time_type::clock::now() - written);
+        return CurrentTicks() - age.count();
+    }
+
+    std::string FormatTimestamp(int64_t ticks)
+    {
+        auto seconds = ticks / c_ticksPerSecond;
+        if (ticks % c_ticksPerSecond < 0)
+        {
+            --seconds;
+        }
+        auto tt = static_cast<std::time_t>(seconds);
+        std::tm tm{};
+#if defined(_WIN32)
+        gmtime_s(&tm, &tt);
+#else
+        gmtime_r(&tt, &tm);
+#endif
+        std::ostringstream ss;
+        ss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
+        return ss.str();
+    }
+
+    std::string FormatDateRange(std::optional<int64_t> const& start, std::optional<int64_t> const& end)
+    {
+        if (start && end)
+        {
+            return FormatTimestamp(*start) + " 至 " + FormatTimestamp(*end);
+        }
+        if (start)
+        {
+            return "自 " + FormatTimestamp(*start);
+        }
+        if (end)
+        {
+            return "截至 " + FormatTimestamp(*end);
+        }
+        return "";
+    }
+}
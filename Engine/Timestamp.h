@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace LogMinds::Engine
+{
+    // Engine timestamps are 100ns ticks since the Unix epoch (UTC).
+    constexpr int64_t c_ticksPerMillisecond = 10'000;
+    constexpr int64_t c_ticksPerSecond = 10'000'000;
+    constexpr int64_t c_ticksPerDay = 24 * 60 * 60 * c_ticksPerSecond;
+
+    // yyyy-mm-dd[T| ]hh:mm:ss with an optional [.,] fraction (kept to
+    // 100ns) and an optional Z / +hh:mm / +hhmm offset; one-digit fields are
+    // accepted and trailing text is ignored. Without an offset the time is
+    // read as UTC.
+    std::optional<int64_t> ParseTimestamp(std::string_view text);
+
+    // Mmm d hh:mm:ss. Syslog stamps carry no year; they are placed in the
+    // year of reference, normally the file's last write time, or in the year
+    // before when that would put them more than a day after it (local time
+    // runs at most a day ahead of UTC).
+    std::optional<int64_t> ParseSyslogTimestamp(std::string_view text, int64_t reference);
+
+    int64_t CurrentTicks();
+    // The current time when path cannot be read.
+    int64_t LastWriteTicks(std::filesystem::path const& path);
+
+    std::string FormatTimestamp(int64_t ticks);
+    std::string FormatDateRange(std::optional<int64_t> const& start, std::optional<int64_t> const& end);
+}
@@ -0,0 +1,399 @@
+#include "TrigramIndex.h"
+
+#include "BinaryIo.h"
+
+#include "Parallel.h"
+#include "Text.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+
+namespace LogMinds::Engine
+{
+    namespace
+    {
+        constexpr size_t c_trigramLength = 3;
+        constexpr size_t c_shardsPerThread = 4;
+        constexpr size_t c_minimumShardRows = 16384;
+        // The fifth byte of a 32-bit varint holds its top four bits.
+        constexpr int c_lastVarintShift = 28;
+
+        uint32_t TrigramAt(std::string_view text, size_t offset)
+        {
+            return (static_cast<uint32_t>(static_cast<uint8_t>(text[offset])) << 16) |
+                (static_cast<uint32_t>(static_cast<uint8_t>(text[offset + 1])) << 8) |
+                static_cast<uint32_t>(static_cast<uint8_t>(text[offset + 2]));
+        }
+
+        // Lower-cases exactly like the filter does (ToLower), without the
+        // allocation for the all-ASCII common case.
+        std::string_view Lowered(std::string_view text, std::string& buffer)
+        {
+            buffer.resize(text.size());
+            for (size_t i = 0; i < text.size(); ++i)
+            {
+                auto ch = text[i];
+                if (static_cast<unsigned char>(ch) >= 0x80)
+                {
+                    buffer = ToLower(text);
+                    return buffer;
+                }
+                buffer[i] = (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch + ('a' - 'A')) : ch;
+            }
+            return buffer;
+        }
+
+        void AddTrigrams(std::string_view text, std::string& buffer, std::vector<uint32_t>& trigrams)
+        {
+            if (text.size() < c_trigramLength)
+            {
+                return;
+            }
+            auto lowered = Lowered(text, buffer);
+            for (size_t offset = 0; offset + c_trigramLength <= lowered.size(); ++offset)
+            {
+                trigrams.push_back(TrigramAt(lowered, offset));
+            }
+        }
+
+        bool IsWithin(std::string_view part, std::string_view whole)
+        {
+            return part.data() >= whole.data() && part.data() + part.size() <= whole.data() + whole.size();
+        }
+
+        void AppendVarint(std::vector<uint8_t>& bytes, uint32_t value)
+        {
+            while (value >= 0x80)
+            {
+                bytes.push_back(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            bytes.push_back(static_cast<uint8_t>(value));
+        }
+
+        class PostingReader
+        {
+        public:
+            PostingReader(std::vector<uint8_t> const& bytes, uint32_t firstRow) :
+                m_cursor(bytes.data()), m_end(bytes.data() + bytes.size()), m_row(firstRow)
+            {
+            }
+
+            // False at the end of the list, and at a varint that runs past it
+            // or past 32 bits, which only a damaged cache entry could hold.
+            bool Next(uint32_t& row)
+            {
+                if (m_cursor == m_end)
+                {
+                    return false;
+                }
+                uint32_t delta = 0;
+                for (int shift = 0;; shift += 7)
+                {
+                    if (m_cursor == m_end || (shift == c_lastVarintShift && *m_cursor > 0x0F))
+                    {
+                        m_cursor = m_end;
+                        return false;
+                    }
+                    auto byte = *m_cursor++;
+                    delta |= static_cast<uint32_t>(byte & 0x7F) << shift;
+                    if ((byte & 0x80) == 0)
+                    {
+                        break;
+                    }
+                }
+                m_row += delta;
+                row = m_row;
+                return true;
+            }
+
+        private:
+            uint8_t const* m_cursor;
+            uint8_t const* m_end;
+            uint32_t m_row;
+        };
+
+        // Whether bytes decode to count ascending rows of [firstRow, endRow)
+        // that end at lastRow, as BuildShard writes them. Deltas add up in
+        // 64 bits, so a sum that lands on lastRow keeps every row in range;
+        // most are a single byte and take the short path.
+        bool IsValidPostingList(std::vector<uint8_t> const& bytes, uint32_t count, uint32_t lastRow,
+            uint32_t firstRow, uint64_t endRow)
+        {
+            auto cursor = bytes.data();
+            auto end = cursor + bytes.size();
+            uint64_t total = 0;
+            uint64_t decoded = 0;
+            while (cursor != end)
+            {
+                uint32_t delta = *cursor++;
+                if (delta >= 0x80)
+                {
+                    delta &= 0x7F;
+                    for (int shift = 7;; shift += 7)
+                    {
+                        if (cursor == end || (shift == c_lastVarintShift && *cursor > 0x0F))
+                        {
+                            return false;
+                        }
+                        auto byte = *cursor++;
+                        delta |= static_cast<uint32_t>(byte & 0x7F) << shift;
+                        if ((byte & 0x80) == 0)
+                        {
+                            break;
+                        }
+                    }
+                }
+                // Only the first row may sit on firstRow itself.
+                if (delta == 0 && decoded != 0)
+                {
+                    return false;
+                }
+                total += delta;
+                ++decoded;
+            }
+            return decoded != 0 && decoded == count && firstRow + total == lastRow && lastRow < endRow;
+        }
+    }
+
+    TrigramIndex TrigramIndex::Build(LogStore const& store, unsigned threadCount)
+    {
+        TrigramIndex index;
+        index.m_rows = store.Size();
+        if (store.Empty())
+        {
+            return index;
+        }
+
+        auto threads = ResolveThreadCount(threadCount);
+        auto shardCount = std::max<size_t>(1, std::min(threads * c_shardsPerThread, store.Size() / c_minimumShardRows));
+        auto rowsPerShard = (store.Size() + shardCount - 1) / shardCount;
+        index.m_shards.resize((store.Size() + rowsPerShard - 1) / rowsPerShard);
+        ParallelFor(index.m_shards.size(), threads, [&](size_t shardIndex)
+        {
+            auto& shard = index.m_shards[shardIndex];
+            shard.FirstRow = static_cast<uint32_t>(shardIndex * rowsPerShard);
+            auto endRow = static_cast<uint32_t>(std::min(store.Size(), (shardIndex + 1) * rowsPerShard));
+            BuildShard(store, shard, endRow);
+        });
+        return index;
+    }
+
+    void TrigramIndex::BuildShard(LogStore const& store, Shard& shard, uint32_t endRow)
+    {
+        std::string buffer;
+        std::vector<uint32_t> trigrams;
+        // Sources repeat across rows; lower-case and split each one once.
+        std::unordered_map<uint32_t, std::vector<uint32_t>> sourceTrigrams;
+        for (auto row = shard.FirstRow; row < endRow; ++row)
+        {
+            trigrams.clear();
+            auto raw = store.Raw(row);
+            AddTrigrams(raw, buffer, trigrams);
+            // Fields cut out of the raw line add no trigrams of their own.
+            for (auto field : { LogField::Message, LogField::Context })
+            {
+                auto text = store.Text(row, field);
+                if (!IsWithin(text, raw))
+                {
+                    AddTrigrams(text, buffer, trigrams);
+                }
+            }
+            auto [source, added] = sourceTrigrams.try_emplace(store.SourceId(row));
+            if (added)
+            {
+                AddTrigrams(store.Source(row), buffer, source->second);
+            }
+            trigrams.insert(trigrams.end(), source->second.begin(), source->second.end());
+
+            std::sort(trigrams.begin(), trigrams.end());
+            trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+            for (auto trigram : trigrams)
+            {
+                auto& list = shard.Postings[trigram];
+                AppendVarint(list.Bytes, row - (list.Count == 0 ? shard.FirstRow : list.LastRow));
+                list.LastRow = row;
+                ++list.Count;
+            }
+        }
+
+        for (auto& [trigram, list] : shard.Postings)
+        {
+            list.Bytes.shrink_to_fit();
+        }
+    }
+
+    std::optional<std::vector<uint32_t>> TrigramIndex::Candidates(std::string_view term) const
+    {
+        if (term.size() < c_trigramLength)
+        {
+            return std::nullopt;
+        }
+
+        std::vector<uint32_t> trigrams;
+        for (size_t offset = 0; offset + c_trigramLength <= term.size(); ++offset)
+        {
+            trigrams.push_back(TrigramAt(term, offset));
+        }
+        std::sort(trigrams.begin(), trigrams.end());
+        trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+        std::vector<uint32_t> candidates;
+        std::vector<PostingList const*> lists;
+        std::vector<uint32_t> merged;
+        for (auto const& shard : m_shards)
+        {
+            lists.clear();
+            for (auto trigram : trigrams)
+            {
+                auto found = shard.Postings.find(trigram);
+                if (found == shard.Postings.end())
+                {
+                    lists.clear();
+                    break;
+                }
+                lists.push_back(&found->second);
+            }
+            if (lists.empty())
+            {
+                continue;
+            }
+
+            // Start from the rarest trigram and narrow with the others.
+            std::sort(lists.begin(), lists.end(), [](auto left, auto right)
+            {
+                return left->Count < right->Count;
+            });
+
+            auto shardBegin = candidates.size();
+            PostingReader first(lists.front()->Bytes, shard.FirstRow);
+            uint32_t row = 0;
+            while (first.Next(row))
+            {
+                candidates.push_back(row);
+            }
+
+            for (size_t i = 1; i < lists.size() && candidates.size() > shardBegin; ++i)
+            {
+                merged.clear();
+                PostingReader reader(lists[i]->Bytes, shard.FirstRow);
+                auto cursor = candidates.begin() + static_cast<ptrdiff_t>(shardBegin);
+                uint32_t other = 0;
+                bool hasOther = reader.Next(other);
+                while (cursor != candidates.end() && hasOther)
+                {
+                    if (*cursor < other)
+                    {
+                        ++cursor;
+                    }
+                    else if (other < *cursor)
+                    {
+                        hasOther = reader.Next(other);
+                    }
+                    else
+                    {
+                        merged.push_back(*cursor++);
+                        hasOther = reader.Next(other);
+                    }
+                }
+                candidates.resize(shardBegin);
+                candidates.insert(candidates.end(), merged.begin(), merged.end());
+            }
+        }
+        return candidates;
+    }
+
+    size_t TrigramIndex::MemoryUsage() const
+    {
+        // Node size approximates an unordered_map node: the pair plus a next
+        // pointer and the cached hash.
+        constexpr size_t c_nodeBytes = sizeof(std::pair<uint32_t const, PostingList>) + 2 * sizeof(void*);
+        auto bytes = sizeof(TrigramIndex) + m_shards.capacity() * sizeof(Shard);
+        for (auto const& shard : m_shards)
+        {
+            bytes += shard.Postings.bucket_count() * sizeof(void*) + shard.Postings.size() * c_nodeBytes;
+            for (auto const& [trigram, list] : shard.Postings)
+            {
+                bytes += list.Bytes.capacity();
+            }
+        }
+        return bytes;
+    }
+
+    void TrigramIndex::Write(BinaryWriter& writer) const
+    {
+        writer.Value<uint64_t>(m_rows);
+        writer.Value<uint64_t>(m_shards.size());
+        for (auto const& shard : m_shards)
+        {
+            writer.Value(shard.FirstRow);
+            writer.Value<uint64_t>(shard.Postings.size());
+            for (auto const& [trigram, list] : shard.Postings)
+            {
+                writer.Value(trigram);
+                writer.Value(list.LastRow);
+                writer.Value(list.Count);
+                writer.Vector(list.Bytes);
+            }
+        }
+    }
+
+    bool TrigramIndex::Read(BinaryReader& reader, LogStore const& store, unsigned threadCount)
+    {
+        *this = TrigramIndex();
+        uint64_t rows = 0;
+        uint64_t shards = 0;
+        if (!reader.Value(rows) || rows != store.Size() || !reader.Value(shards) || shards > rows)
+        {
+            return false;
+        }
+        m_rows = static_cast<size_t>(rows);
+        m_shards.resize(static_cast<size_t>(shards));
+        for (size_t index = 0; index < m_shards.size(); ++index)
+        {
+            auto& shard = m_shards[index];
+            uint64_t postings = 0;
+            // A list takes at least its trigram, rows and byte count.
+            if (!reader.Value(shard.FirstRow) || shard.FirstRow >= m_rows ||
+                (index != 0 && shard.FirstRow <= m_shards[index - 1].FirstRow) || !reader.Value(postings) ||
+                postings > reader.Remaining() / (3 * sizeof(uint32_t) + sizeof(uint64_t)))
+            {
+                return false;
+            }
+            shard.Postings.reserve(static_cast<size_t>(postings));
+            for (uint64_t i = 0; i < postings; ++i)
+            {
+                uint32_t trigram = 0;
+                PostingList list;
+                if (!reader.Value(trigram) || !reader.Value(list.LastRow) || !reader.Value(list.Count) ||
+                    !reader.Vector(list.Bytes) || list.LastRow >= m_rows)
+                {
+                    return false;
+                }
+                shard.Postings.emplace(trigram, std::move(list));
+            }
+        }
+
+        // Decoding every list once lets Candidates rely on the rows being
+        // ascending and inside their shard.
+        std::atomic<bool> valid{ true };
+        ParallelFor(m_shards.size(), threadCount, [&](size_t index)
+        {
+            auto const& shard = m_shards[index];
+            uint64_t endRow = index + 1 < m_shards.size() ? m_shards[index + 1].FirstRow : m_rows;
+            for (auto const& [trigram, list] : shard.Postings)
+            {
+                if (!valid.load(std::memory_order_relaxed))
+                {
+                    return;
+                }
+                if (!IsValidPostingList(list.Bytes, list.Count, list.LastRow, shard.FirstRow, endRow))
+                {
+                    valid.store(false, std::memory_order_relaxed);
+                }
+            }
+        });
+        return valid.load();
+    }
+}
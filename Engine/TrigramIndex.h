@@ -0,0 +1,61 @@
+#pragma once
+
+#include "LogStore.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace LogMinds::Engine
+{
+    // Inverted index from byte trigrams of the lower-cased searchable fields
+    // (message, context, source, raw) to the rows containing them. Posting
+    // lists are delta + varint encoded. Rows are split into contiguous shards
+    // that are built in parallel and queried independently, so results come
+    // out in row order without a merge.
+    class TrigramIndex
+    {
+    public:
+        static TrigramIndex Build(LogStore const& store, unsigned threadCount = 0);
+
+        // Ascending rows that contain every trigram of the (already
+        // lower-cased) term; a superset of the rows whose fields contain the
+        // term. std::nullopt when the term is shorter than a trigram.
+        std::optional<std::vector<uint32_t>> Candidates(std::string_view term) const;
+
+        size_t Rows() const
+        {
+            return m_rows;
+        }
+
+        size_t MemoryUsage() const;
+
+        void Write(BinaryWriter& writer) const;
+        // False when the input is inconsistent with store, including a
+        // posting list that does not decode to ascending rows of its shard.
+        // The lists are checked on threadCount workers.
+        bool Read(BinaryReader& reader, LogStore const& store, unsigned threadCount = 0);
+
+    private:
+        struct PostingList
+        {
+            std::vector<uint8_t> Bytes;
+            uint32_t LastRow{ 0 };
+            uint32_t Count{ 0 };
+        };
+
+        struct Shard
+        {
+            uint32_t FirstRow{ 0 };
+            std::unordered_map<uint32_t, PostingList> Postings;
+        };
+
+        std::vector<Shard> m_shards;
+        size_t m_rows{ 0 };
+
+        static void BuildShard(LogStore const& store, Shard& shard, uint32_t endRow);
+    };
+}
@@ -66,6 +66,21 @@ namespace winrt::LogMinds::implementation
         m_raw = value;
     }
 
+    winrt::hstring LogEntry::Origin() const
+    {
+        return m_origin;
+    }
+
+    void LogEntry::Origin(winrt::hstring const& value)
+    {
+        m_origin = value;
+    }
+
+    bool LogEntry::HasOrigin() const
+    {
+        return !m_origin.empty();
+    }
+
     winrt::Windows::Foundation::IReference<winrt::Windows::Foundation::DateTime> LogEntry::OccurredOn() const
     {
         return m_occurredOn;
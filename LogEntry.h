@@ -26,6 +26,10 @@ namespace winrt::LogMinds::implementation
         winrt::hstring Raw() const;
         void Raw(winrt::hstring const& value);
 
+        winrt::hstring Origin() const;
+        void Origin(winrt::hstring const& value);
+        bool HasOrigin() const;
+
         winrt::Windows::Foundation::IReference<winrt::Windows::Foundation::DateTime> OccurredOn() const;
         void OccurredOn(winrt::Windows::Foundation::IReference<winrt::Windows::Foundation::DateTime> const& value);
 
@@ -36,6 +40,7 @@ namespace winrt::LogMinds::implementation
         winrt::hstring m_message{};
         winrt::hstring m_context{};
         winrt::hstring m_raw{};
+        winrt::hstring m_origin{};
         winrt::Windows::Foundation::IReference<winrt::Windows::Foundation::DateTime> m_occurredOn{ nullptr };
     };
 }
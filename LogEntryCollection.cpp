@@ -0,0 +1,271 @@
+#include "pch.h"
+#include "LogEntryCollection.h"
+
+using namespace winrt;
+using namespace Windows::Foundation;
+using namespace Windows::Foundation::Collections;
+using namespace Microsoft::UI::Xaml::Data;
+
+namespace
+{
+    // Past this many appended rows one Reset is cheaper for the list than
+    // an ItemInserted per row.
+    constexpr size_t c_maxInsertNotifications = 64;
+
+    struct ChangedEventArgs : implements<ChangedEventArgs, IVectorChangedEventArgs>
+    {
+        ChangedEventArgs(Windows::Foundation::Collections::CollectionChange change, uint32_t index) :
+            m_change(change), m_index(index)
+        {
+        }
+
+        Windows::Foundation::Collections::CollectionChange CollectionChange() const
+        {
+            return m_change;
+        }
+
+        uint32_t Index() const
+        {
+            return m_index;
+        }
+
+    private:
+        Windows::Foundation::Collections::CollectionChange m_change;
+        uint32_t m_index;
+    };
+
+    struct EntryIterator : implements<EntryIterator, IIterator<IInspectable>>
+    {
+        explicit EntryIterator(IVectorView<IInspectable> const& owner) : m_owner(owner)
+        {
+        }
+
+        IInspectable Current() const
+        {
+            if (m_index >= m_owner.Size())
+            {
+                throw hresult_out_of_bounds();
+            }
+            return m_owner.GetAt(m_index);
+        }
+
+        bool HasCurrent() const
+        {
+            return m_index < m_owner.Size();
+        }
+
+        bool MoveNext()
+        {
+            if (m_index < m_owner.Size())
+            {
+                ++m_index;
+            }
+            return HasCurrent();
+        }
+
+        uint32_t GetMany(array_view<IInspectable> items)
+        {
+            auto count = m_owner.GetMany(m_index, items);
+            m_index += count;
+            return count;
+        }
+
+    private:
+        IVectorView<IInspectable> m_owner;
+        uint32_t m_index{ 0 };
+    };
+}
+
+namespace winrt::LogMinds::implementation
+{
+    LogEntryCollection::LogEntryCollection(EntryFactory factory) : m_factory(std::move(factory))
+    {
+    }
+
+    void LogEntryCollection::Reset(std::vector<uint32_t> rows)
+    {
+        m_rows = std::move(rows);
+        m_vectorChanged(*this, make<ChangedEventArgs>(Windows::Foundation::Collections::CollectionChange::Reset, 0u));
+    }
+
+    void LogEntryCollection::AppendRows(std::vector<uint32_t> const& rows)
+    {
+        if (rows.empty())
+        {
+            return;
+        }
+        auto first = static_cast<uint32_t>(m_rows.size());
+        m_rows.insert(m_rows.end(), rows.begin(), rows.end());
+        if (rows.size() > c_maxInsertNotifications)
+        {
+            m_vectorChanged(*this, make<ChangedEventArgs>(Windows::Foundation::Collections::CollectionChange::Reset, 0u));
+            return;
+        }
+        for (auto index = first; index < m_rows.size(); ++index)
+        {
+            m_vectorChanged(*this,
+                make<ChangedEventArgs>(Windows::Foundation::Collections::CollectionChange::ItemInserted, index));
+        }
+    }
+
+    void LogEntryCollection::DiscardEntries()
+    {
+        m_entries.clear();
+    }
+
+    std::vector<uint32_t> const& LogEntryCollection::Rows() const
+    {
+        return m_rows;
+    }
+
+    uint32_t LogEntryCollection::Size() const
+    {
+        return static_cast<uint32_t>(m_rows.size());
+    }
+
+    IInspectable LogEntryCollection::GetAt(uint32_t index)
+    {
+        if (index >= m_rows.size())
+        {
+            throw hresult_out_of_bounds();
+        }
+
+        auto row = m_rows[index];
+        auto found = m_entries.find(row);
+        if (found == m_entries.end())
+        {
+            found = m_entries.emplace(row, m_factory(row)).first;
+        }
+        return found->second;
+    }
+
+    bool LogEntryCollection::IndexOf(IInspectable const& value, uint32_t& index) const
+    {
+        // Only created entries can be asked for; rows are sorted, so the
+        // position follows from the row id.
+        for (auto const& [row, entry] : m_entries)
+        {
+            if (entry == value)
+            {
+                auto position = std::lower_bound(m_rows.begin(), m_rows.end(), row);
+                if (position != m_rows.end() && *position == row)
+                {
+                    index = static_cast<uint32_t>(position - m_rows.begin());
+                    return true;
+                }
+                break;
+            }
+        }
+        index = 0;
+        return false;
+    }
+
+    uint32_t LogEntryCollection::GetMany(uint32_t startIndex, array_view<IInspectable> items)
+    {
+        uint32_t count = 0;
+        for (auto index = startIndex; index < m_rows.size() && count < items.size(); ++index, ++count)
+        {
+            items[count] = GetAt(index);
+        }
+        return count;
+    }
+
+    IVectorView<IInspectable> LogEntryCollection::GetView()
+    {
+        return *this;
+    }
+
+    void LogEntryCollection::SetAt(uint32_t, IInspectable const&)
+    {
+        throw hresult_illegal_method_call();
+    }
+
+    void LogEntryCollection::InsertAt(uint32_t, IInspectable const&)
+    {
+        throw hresult_illegal_method_call();
+    }
+
+    void LogEntryCollection::RemoveAt(uint32_t)
+    {
+        throw hresult_illegal_method_call();
+    }
+
+    void LogEntryCollection::Append(IInspectable const&)
+    {
+        throw hresult_illegal_method_call();
+    }
+
+    void LogEntryCollection::RemoveAtEnd()
+    {
+        throw hresult_illegal_method_call();
+    }
+
+    void LogEntryCollection::Clear()
+    {
+        Reset({});
+    }
+
+    void LogEntryCollection::ReplaceAll(array_view<IInspectable const>)
+    {
+        throw hresult_illegal_method_call();
+    }
+
+    IIterator<IInspectable> LogEntryCollection::First()
+    {
+        return make<EntryIterator>(*this);
+    }
+
+    event_token LogEntryCollection::VectorChanged(VectorChangedEventHandler<IInspectable> const& handler)
+    {
+        return m_vectorChanged.add(handler);
+    }
+
+    void LogEntryCollection::VectorChanged(event_token const& token) noexcept
+    {
+        m_vectorChanged.remove(token);
+    }
+
+    void LogEntryCollection::RangesChanged(ItemIndexRange const& visibleRange, IVectorView<ItemIndexRange> const& trackedItems)
+    {
+        std::vector<std::pair<int32_t, int32_t>> keep;
+        auto addRange = [&](ItemIndexRange const& range)
+        {
+            if (range && range.Length() != 0)
+            {
+                keep.emplace_back(range.FirstIndex(), range.LastIndex());
+            }
+        };
+        addRange(visibleRange);
+        if (trackedItems)
+        {
+            for (auto const& range : trackedItems)
+            {
+                addRange(range);
+            }
+        }
+
+        auto isKept = [&](uint32_t row)
+        {
+            auto position = std::lower_bound(m_rows.begin(), m_rows.end(), row);
+            if (position == m_rows.end() || *position != row)
+            {
+                return false;
+            }
+            auto index = static_cast<int32_t>(position - m_rows.begin());
+            return std::any_of(keep.begin(), keep.end(), [&](auto const& range)
+            {
+                return index >= range.first && index <= range.second;
+            });
+        };
+
+        for (auto it = m_entries.begin(); it != m_entries.end();)
+        {
+            it = isKept(it->first) ? std::next(it) : m_entries.erase(it);
+        }
+    }
+
+    void LogEntryCollection::Close()
+    {
+        m_entries.clear();
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace winrt::LogMinds::implementation
+{
+    // Read-only, virtualized ItemsSource over a selection of row ids. Items
+    // are created through the factory only when the list asks for them, and
+    // IItemsRangeInfo lets the collection drop every LogEntry that is no
+    // longer in a visible or tracked range. Replacing the selection raises a
+    // single Reset notification.
+    struct LogEntryCollection : winrt::implements<LogEntryCollection,
+        winrt::Windows::Foundation::Collections::IObservableVector<winrt::Windows::Foundation::IInspectable>,
+        winrt::Windows::Foundation::Collections::IVector<winrt::Windows::Foundation::IInspectable>,
+        winrt::Windows::Foundation::Collections::IVectorView<winrt::Windows::Foundation::IInspectable>,
+        winrt::Windows::Foundation::Collections::IIterable<winrt::Windows::Foundation::IInspectable>,
+        winrt::Microsoft::UI::Xaml::Data::IItemsRangeInfo>
+    {
+        using IInspectable = winrt::Windows::Foundation::IInspectable;
+        using EntryFactory = std::function<winrt::LogMinds::LogEntry(uint32_t row)>;
+
+        explicit LogEntryCollection(EntryFactory factory);
+
+        void Reset(std::vector<uint32_t> rows);
+        // Adds rows past every current one (new rows of a followed file),
+        // with one notification per batch once the batch is large.
+        void AppendRows(std::vector<uint32_t> const& rows);
+        // Forgets every created entry; call when the rows themselves change.
+        void DiscardEntries();
+        std::vector<uint32_t> const& Rows() const;
+
+        // IVector / IVectorView
+        uint32_t Size() const;
+        IInspectable GetAt(uint32_t index);
+        bool IndexOf(IInspectable const& value, uint32_t& index) const;
+        uint32_t GetMany(uint32_t startIndex, winrt::array_view<IInspectable> items);
+        winrt::Windows::Foundation::Collections::IVectorView<IInspectable> GetView();
+        void SetAt(uint32_t index, IInspectable const& value);
+        void InsertAt(uint32_t index, IInspectable const& value);
+        void RemoveAt(uint32_t index);
+        void Append(IInspectable const& value);
+        void RemoveAtEnd();
+        void Clear();
+        void ReplaceAll(winrt::array_view<IInspectable const> items);
+
+        // IIterable
+        winrt::Windows::Foundation::Collections::IIterator<IInspectable> First();
+
+        // IObservableVector
+        winrt::event_token VectorChanged(winrt::Windows::Foundation::Collections::VectorChangedEventHandler<IInspectable> const& handler);
+        void VectorChanged(winrt::event_token const& token) noexcept;
+
+        // IItemsRangeInfo
+        void RangesChanged(winrt::Microsoft::UI::Xaml::Data::ItemIndexRange const& visibleRange,
+            winrt::Windows::Foundation::Collections::IVectorView<winrt::Microsoft::UI::Xaml::Data::ItemIndexRange> const& trackedItems);
+        void Close();
+
+    private:
+        EntryFactory m_factory;
+        std::vector<uint32_t> m_rows;
+        // Created entries keyed by row id, so rows that survive a Reset keep
+        // their object (and with it the list's selection state).
+        std::unordered_map<uint32_t, winrt::LogMinds::LogEntry> m_entries;
+        winrt::event<winrt::Windows::Foundation::Collections::VectorChangedEventHandler<IInspectable>> m_vectorChanged;
+    };
+}
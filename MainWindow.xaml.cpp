@@ -6,23 +6,43 @@
 #endif
 #include <microsoft.ui.xaml.window.h>
 
+#include "Engine/ContextPacker.h"
+#include "Engine/Decompressor.h"
+#include "Engine/LogCache.h"
+#include "Engine/LogDocument.h"
+#include "Engine/LogMerge.h"
+#include "Engine/MappedFile.h"
+#include "Engine/Summary.h"
+#include "Engine/Text.h"
+#include "Engine/Timestamp.h"
+
 using namespace winrt;
 using namespace Microsoft::UI::Xaml;
 using namespace Microsoft::UI::Xaml::Controls;
 using namespace Microsoft::UI::Xaml::Controls::Primitives;
-using namespace Windows::Data::Json;
 using namespace Windows::Foundation;
 using namespace Windows::Storage;
 using namespace Windows::Storage::Pickers;
 
+namespace Engine = ::LogMinds::Engine;
+
 namespace
 {
-    constexpr int64_t c_ticksPerSecond = 10'000'000;
-    constexpr int64_t c_ticksPerDay = 24 * 60 * 60 * c_ticksPerSecond;
+    // Smaller files parse in a blink; entries for them would only fill the
+    // cache directory.
+    constexpr uint64_t c_minimumCachedBytes = 8 << 20;
 
-    bool IsWordChar(wchar_t ch)
+    // Offset between the WinRT DateTime epoch (1601-01-01) and the engine's Unix epoch, in 100ns ticks.
+    constexpr int64_t c_unixEpochTicks = 116'444'736'000'000'000;
+
+    int64_t ToEngineTicks(DateTime const& value)
     {
-        return std::iswalnum(ch) != 0 || ch == L'_';
+        return value.time_since_epoch().count() - c_unixEpochTicks;
+    }
+
+    DateTime ToDateTime(int64_t ticks)
+    {
+        return DateTime{ TimeSpan{ ticks + c_unixEpochTicks } };
     }
 }
 
@@ -32,8 +52,15 @@ namespace winrt::LogMinds::implementation
     {
         InitializeComponent();
 
-        m_filteredEntries = single_threaded_observable_vector<LogEntry>();
-        LogListView().ItemsSource(m_filteredEntries);
+        m_filteredEntries = winrt::make_self<LogEntryCollection>([this](uint32_t row)
+        {
+            return CreateEntry(row);
+        });
+        m_templateEntries = winrt::make_self<LogEntryCollection>([this](uint32_t group)
+        {
+            return CreateGroupEntry(group);
+        });
+        LogListView().ItemsSource(m_filteredEntries.as<IInspectable>());
         UpdateUiState();
         RefreshStats();
     }
@@ -50,7 +77,12 @@ namespace winrt::LogMinds::implementation
 
     void MainWindow::OnOpenLogClicked(IInspectable const&, RoutedEventArgs const&)
     {
-        LoadLogsAsync();
+        LoadLogsAsync(false);
+    }
+
+    void MainWindow::OnOpenFolderClicked(IInspectable const&, RoutedEventArgs const&)
+    {
+        LoadLogsAsync(true);
     }
 
     void MainWindow::OnInterpretClicked(IInspectable const&, RoutedEventArgs const&)
@@ -61,7 +93,7 @@ namespace winrt::LogMinds::implementation
     void MainWindow::OnSearchTextChanged(IInspectable const& sender, TextChangedEventArgs const&)
     {
         auto textBox = sender.as<TextBox>();
-        m_searchTerm = ToLower(std::wstring(textBox.Text().c_str()));
+        m_query.SearchTerm = Engine::ToLower(winrt::to_string(textBox.Text()));
         ApplyFilters();
     }
 
@@ -77,28 +109,41 @@ namespace winrt::LogMinds::implementation
             }
         }
 
-        auto upper = ToUpper(std::wstring(label.c_str()));
-        if (upper == L"全部" || upper == L"ALL" || upper.empty())
+        auto upper = Engine::ToUpper(winrt::to_string(label));
+        if (upper == "全部" || upper == "ALL" || upper.empty())
         {
-            m_selectedLevel.clear();
+            m_query.Level.clear();
         }
         else
         {
-            m_selectedLevel = upper;
+            m_query.Level = upper;
         }
 
         ApplyFilters();
     }
 
+    void MainWindow::OnOriginChanged(IInspectable const&, SelectionChangedEventArgs const&)
+    {
+        // Items line up with the origin ids; the first one is "all files".
+        if (m_isLoading)
+        {
+            return;
+        }
+        auto index = OriginCombo().SelectedIndex();
+        auto const& names = m_allEntries->OriginNames();
+        m_query.Origin = index > 0 && static_cast<size_t>(index) < names.size() ? names[index] : std::string();
+        ApplyFilters();
+    }
+
     void MainWindow::OnStartDateChanged(IInspectable const&, DatePickerValueChangedEventArgs const& args)
     {
         if (auto date = args.NewDate())
         {
-            m_startTimeFilter = date.Value();
+            m_query.StartTime = ToEngineTicks(date.Value());
         }
         else
         {
-            m_startTimeFilter.reset();
+            m_query.StartTime.reset();
         }
         ApplyFilters();
     }
@@ -107,37 +152,31 @@ namespace winrt::LogMinds::implementation
     {
         if (auto date = args.NewDate())
         {
-            auto value = date.Value();
-            value.Duration += c_ticksPerDay - 1;
-            m_endTimeFilter = value;
+            m_query.EndTime = ToEngineTicks(date.Value()) + Engine::c_ticksPerDay - 1;
         }
         else
         {
-            m_endTimeFilter.reset();
+            m_query.EndTime.reset();
         }
         ApplyFilters();
     }
 
     void MainWindow::OnStartTimeChanged(IInspectable const&, TimePickerValueChangedEventArgs const&)
     {
-        if (m_startTimeFilter)
+        if (m_query.StartTime)
         {
-            auto date = *m_startTimeFilter;
             auto time = StartTimePicker().Time();
-            date.Duration = (date.Duration / c_ticksPerDay) * c_ticksPerDay + time.Duration;
-            m_startTimeFilter = date;
+            m_query.StartTime = (*m_query.StartTime / Engine::c_ticksPerDay) * Engine::c_ticksPerDay + time.count();
             ApplyFilters();
         }
     }
 
     void MainWindow::OnEndTimeChanged(IInspectable const&, TimePickerValueChangedEventArgs const&)
     {
-        if (m_endTimeFilter)
+        if (m_query.EndTime)
         {
-            auto date = *m_endTimeFilter;
             auto time = EndTimePicker().Time();
-            date.Duration = (date.Duration / c_ticksPerDay) * c_ticksPerDay + time.Duration;
-            m_endTimeFilter = date;
+            m_query.EndTime = (*m_query.EndTime / Engine::c_ticksPerDay) * Engine::c_ticksPerDay + time.count();
             ApplyFilters();
         }
     }
@@ -146,64 +185,223 @@ namespace winrt::LogMinds::implementation
     {
         SearchBox().Text(L"");
         SeverityCombo().SelectedIndex(0);
+        OriginCombo().SelectedIndex(OriginCombo().Items().Size() != 0 ? 0 : -1);
         StartDatePicker().Date(nullptr);
         EndDatePicker().Date(nullptr);
         StartTimePicker().Time(TimeSpan{});
         EndTimePicker().Time(TimeSpan{});
 
-        m_searchTerm.clear();
-        m_selectedLevel.clear();
-        m_startTimeFilter.reset();
-        m_endTimeFilter.reset();
+        m_query = Engine::FilterQuery{};
         ApplyFilters();
     }
 
-    winrt::fire_and_forget MainWindow::LoadLogsAsync()
+    void MainWindow::OnFollowToggled(IInspectable const&, RoutedEventArgs const&)
     {
-        auto lifetime = get_strong();
+        auto checked = FollowToggle().IsChecked();
+        if (!checked || !checked.Value())
+        {
+            StopFollowing();
+            return;
+        }
+        if (m_follower || m_currentPath.empty())
+        {
+            return;
+        }
 
-        m_isLoading = true;
-        UpdateUiState();
-        UpdateSummary(L"");
+        auto generation = ++m_followGeneration;
+        m_follower = std::make_unique<Engine::LogFollower>(m_currentPath, m_allEntries, m_loadedBytes,
+            [weak = get_weak(), dispatcher = DispatcherQueue(), generation](Engine::FollowUpdate&& update)
+        {
+            dispatcher.TryEnqueue([weak, generation, update = std::move(update)]() mutable
+            {
+                auto self = weak.get();
+                if (self && self->m_followGeneration == generation)
+                {
+                    self->OnFollowUpdate(std::move(update));
+                }
+            });
+        });
+    }
 
-        FileOpenPicker picker;
-        picker.FileTypeFilter().Append(L".log");
-        picker.FileTypeFilter().Append(L".txt");
-        picker.FileTypeFilter().Append(L".json");
-        picker.FileTypeFilter().Append(L".csv");
-        picker.FileTypeFilter().Append(L".*");
+    void MainWindow::OnTemplateToggled(IInspectable const&, RoutedEventArgs const&)
+    {
+        if (IsGroupedByTemplate())
+        {
+            LogListView().ItemsSource(m_templateEntries.as<IInspectable>());
+            GroupByTemplateAsync();
+        }
+        else
+        {
+            ++m_groupGeneration;
+            LogListView().ItemsSource(m_filteredEntries.as<IInspectable>());
+        }
+        RefreshStats();
+    }
 
-        auto hwnd = GetWindowHandle();
-        if (hwnd != nullptr)
+    void MainWindow::OnEntryClicked(IInspectable const&, ItemClickEventArgs const& args)
+    {
+        // A group narrows the rows to its template and shows them.
+        uint32_t index = 0;
+        if (!IsGroupedByTemplate() || !m_templateEntries->IndexOf(args.ClickedItem(), index) ||
+            index >= m_templateGroups.size())
         {
-            Microsoft::UI::Win32Interop::InitializeWithWindow(picker, hwnd);
+            return;
         }
+        m_query.Template = m_templateGroups[index].Template;
+        TemplateToggle().IsChecked(false);
+        ApplyFilters();
+    }
 
-        StorageFile file{ nullptr };
+    winrt::fire_and_forget MainWindow::LoadLogsAsync(bool folder)
+    {
+        auto lifetime = get_strong();
 
+        StopFollowing();
+        FollowToggle().IsChecked(false);
+        TemplateToggle().IsChecked(false);
+        m_interpretGeneration = m_interpretGenerations.Advance();
+        m_isInterpreting = false;
+        m_isLoading = true;
+        UpdateUiState();
+        UpdateSummary(L"");
+
+        auto hwnd = GetWindowHandle();
+        std::vector<std::filesystem::path> paths;
+        hstring displayName;
         try
         {
-            file = co_await picker.PickSingleFileAsync();
+            if (folder)
+            {
+                FolderPicker picker;
+                picker.FileTypeFilter().Append(L"*");
+                if (hwnd != nullptr)
+                {
+                    Microsoft::UI::Win32Interop::InitializeWithWindow(picker, hwnd);
+                }
+                if (auto picked = co_await picker.PickSingleFolderAsync())
+                {
+                    paths.emplace_back(std::wstring_view(picked.Path()));
+                    displayName = picked.DisplayName();
+                }
+            }
+            else
+            {
+                FileOpenPicker picker;
+                picker.FileTypeFilter().Append(L".log");
+                picker.FileTypeFilter().Append(L".txt");
+                picker.FileTypeFilter().Append(L".json");
+                picker.FileTypeFilter().Append(L".csv");
+                picker.FileTypeFilter().Append(L".gz");
+                picker.FileTypeFilter().Append(L".zst");
+                picker.FileTypeFilter().Append(L".*");
+                if (hwnd != nullptr)
+                {
+                    Microsoft::UI::Win32Interop::InitializeWithWindow(picker, hwnd);
+                }
+                auto picked = co_await picker.PickMultipleFilesAsync();
+                for (auto const& file : picked)
+                {
+                    paths.emplace_back(std::wstring_view(file.Path()));
+                }
+                if (picked.Size() == 1)
+                {
+                    displayName = picked.GetAt(0).DisplayName();
+                }
+                else
+                {
+                    displayName = winrt::to_hstring(picked.Size()) + L" 个文件";
+                }
+            }
         }
         catch (...)
         {
         }
 
-        if (!file)
+        if (paths.empty())
         {
             m_isLoading = false;
             UpdateUiState();
             co_return;
         }
 
-        m_currentFileName = file.DisplayName();
+        m_currentFileName = displayName;
+        m_loadStartedAt = std::chrono::steady_clock::now();
+        m_firstRowLatency.reset();
 
-        hstring text;
-        try
+        co_await winrt::resume_background();
+
+        // A single file is mapped directly so that it can be followed from
+        // where loading stopped; anything else goes through the merge.
+        std::string error;
+        Engine::LogStore records;
+        Engine::ParseReport parseReport;
+        std::shared_ptr<Engine::AttributeIndex const> attributes;
+        std::shared_ptr<Engine::TrigramIndex const> searchIndex;
+        // Set when the cache entry is to be (re)written once the search
+        // index is built.
+        std::optional<Engine::SourceStamp> cacheStamp;
+        std::filesystem::path followPath;
+        uint64_t loadedBytes = 0;
+        bool opened = false;
+        // Without a cache entry the file is handed to a LogLoader, which
+        // shows rows while it parses the rest.
+        Engine::MappedFile mappedFile;
+        bool progressive = false;
+        std::error_code code;
+        if (paths.size() == 1 && !std::filesystem::is_directory(paths.front(), code))
+        {
+            opened = mappedFile.Open(paths.front(), error);
+            if (opened)
+            {
+                // A file opened before comes back from the cache, or is only
+                // parsed from where it was when that entry was written.
+                auto cacheable = mappedFile.Size() >= c_minimumCachedBytes;
+                auto state = Engine::CacheState::Missing;
+                if (cacheable)
+                {
+                    Engine::CachedLog cached;
+                    state = Engine::LogCache(Engine::LogCache::DefaultDirectory()).Load(paths.front(), mappedFile.Text(),
+                        0, cached);
+                    if (state == Engine::CacheState::Fresh || state == Engine::CacheState::Extended)
+                    {
+                        records = std::move(cached.Store);
+                        parseReport = std::move(cached.Report);
+                        if (cached.Attributes)
+                        {
+                            attributes = std::make_shared<Engine::AttributeIndex const>(std::move(*cached.Attributes));
+                        }
+                        if (cached.SearchIndex)
+                        {
+                            searchIndex = std::make_shared<Engine::TrigramIndex const>(std::move(*cached.SearchIndex));
+                        }
+                    }
+                }
+                progressive = state != Engine::CacheState::Fresh && state != Engine::CacheState::Extended;
+                if (cacheable && !searchIndex)
+                {
+                    cacheStamp = Engine::SourceStamp::Of(paths.front(), mappedFile.Text());
+                }
+                // Appends to a compressed file cannot be followed.
+                if (Engine::DetectCompression(mappedFile.Text()) == Engine::Compression::None)
+                {
+                    loadedBytes = mappedFile.Size();
+                    followPath = paths.front();
+                }
+            }
+        }
+        else
         {
-            text = co_await FileIO::ReadTextAsync(file);
+            records = Engine::ParseLogFiles(Engine::ExpandLogPaths(paths, error), 0, &parseReport, error);
+            opened = !records.Empty() || error.empty();
         }
-        catch (hresult_error const& ex)
+        if (opened && !progressive && !attributes)
+        {
+            attributes = std::make_shared<Engine::AttributeIndex const>(Engine::AttributeIndex::Build(records));
+        }
+
+        co_await winrt::resume_foreground(DispatcherQueue());
+
+        if (!opened)
         {
             m_isLoading = false;
             UpdateUiState();
@@ -211,89 +409,157 @@ namespace winrt::LogMinds::implementation
             ContentDialog dialog;
             dialog.XamlRoot(Content().XamlRoot());
             dialog.Title(box_value(L"读取失败"));
-            dialog.Content(box_value(ex.message()));
+            dialog.Content(box_value(winrt::to_hstring(error)));
             dialog.CloseButtonText(L"关闭");
             co_await dialog.ShowAsync();
             co_return;
         }
 
-        std::vector<ParsedEntry> parsedEntries;
-        bool parsedFromJson = false;
+        // The old selection indexes the old rows; clear it before the new
+        // store becomes visible to CreateEntry. So would a scan of the old
+        // store still on its way: a progressive load submits no query to
+        // overtake it.
+        if (m_filterWorker)
+        {
+            m_filterWorker->Cancel();
+        }
+        m_filterPending = false;
+        m_filteredEntries->DiscardEntries();
+        m_filteredEntries->Reset({});
+        m_viewAggregates = {};
+        m_templateEntries->DiscardEntries();
+        m_templateEntries->Reset({});
+        m_templateGroups.clear();
+        m_groupedStore.reset();
+        m_allEntries = std::make_shared<Engine::LogStore const>(std::move(records));
+        m_searchIndex = std::move(searchIndex);
+        m_attributeIndex = std::move(attributes);
+        m_parseReport = parseReport;
+        m_currentPath = followPath;
+        m_loadedBytes = loadedBytes;
+        m_query.Origin.clear();
+        // Template ids belong to the store they were mined in.
+        m_query.Template.reset();
+        RefreshOrigins();
+
+        if (progressive)
+        {
+            m_loadingPath = paths.front();
+            m_loadingStamp = cacheStamp;
+            FileNameText().Text(L"文件: " + m_currentFileName);
+            LoadProgress().Value(0);
 
-        try
-        {
-            auto json = JsonValue::Parse(text);
-            if (json.ValueType() == JsonValueType::Array)
+            // The filter controls are disabled until the load completes, so
+            // the batches are filtered against this query on the loader
+            // thread and the window only appends the matches.
+            m_loader = std::make_unique<Engine::LogLoader>(std::move(mappedFile),
+                [weak = get_weak(), dispatcher = DispatcherQueue(), query = m_query](Engine::LoadUpdate&& update)
             {
-                parsedFromJson = true;
-                for (auto const& item : json.GetArray())
+                std::vector<uint32_t> matches;
+                Engine::RowAggregates aggregates;
+                if (update.Store)
                 {
-                    if (item.ValueType() == JsonValueType::Object)
-                    {
-                        parsedEntries.emplace_back(ParseJsonObject(item.GetObject(), std::wstring(item.Stringify().c_str())));
-                    }
-                    else
+                    std::vector<uint32_t> fresh(update.Store->Size() - update.FirstNewRow);
+                    std::iota(fresh.begin(), fresh.end(), static_cast<uint32_t>(update.FirstNewRow));
+                    matches = Engine::ApplyFilter(*update.Store, query, fresh);
+                    aggregates = Engine::RowAggregates::Of(*update.Store, matches);
+                }
+                dispatcher.TryEnqueue([weak, update = std::move(update), matches = std::move(matches),
+                    aggregates = std::move(aggregates)]() mutable
+                {
+                    if (auto self = weak.get())
                     {
-                        ParsedEntry fallback;
-                        fallback.Entry = CreateEntry();
-                        auto raw = std::wstring(item.Stringify().c_str());
-                        fallback.Entry.Message(hstring(raw));
-                        fallback.Entry.Raw(hstring(raw));
-                        parsedEntries.emplace_back(std::move(fallback));
+                        self->OnLoadUpdate(std::move(update), std::move(matches), std::move(aggregates));
                     }
-                }
-            }
-            else if (json.ValueType() == JsonValueType::Object)
-            {
-                parsedFromJson = true;
-                parsedEntries.emplace_back(ParseJsonObject(json.GetObject(), std::wstring(text.c_str())));
-            }
+                });
+            }, 0, Engine::ParseContext{ Engine::LastWriteTicks(paths.front()) });
+            UpdateUiState();
+            RefreshStats();
+            co_return;
         }
-        catch (...)
+
+        if (!m_searchIndex)
         {
-            parsedFromJson = false;
+            BuildIndexesAsync(m_allEntries, cacheStamp ? paths.front() : std::filesystem::path(), cacheStamp);
         }
+        ApplyFilters();
+        m_firstRowLatency = std::chrono::steady_clock::now() - m_loadStartedAt;
+        RefreshStats();
+        CompleteLoadAsync(error);
+    }
 
-        if (!parsedFromJson)
+    void MainWindow::OnCancelLoadClicked(IInspectable const&, RoutedEventArgs const&)
+    {
+        if (m_loader)
         {
-            std::wistringstream stream(text.c_str());
-            std::wstring line;
-            while (std::getline(stream, line))
-            {
-                auto parsed = ParseLine(line);
-                if (parsed.Entry)
-                {
-                    parsedEntries.emplace_back(std::move(parsed));
-                }
-            }
+            m_loader->Cancel();
+            CancelLoadButton().IsEnabled(false);
         }
+    }
 
-        m_allEntries.clear();
-        m_allEntries.reserve(parsedEntries.size());
-        for (auto& entry : parsedEntries)
+    void MainWindow::OnLoadUpdate(Engine::LoadUpdate&& update, std::vector<uint32_t>&& matches,
+        Engine::RowAggregates&& aggregates)
+    {
+        if (update.BytesTotal != 0)
         {
-            if (entry.Entry)
+            LoadProgress().Value(100.0 * static_cast<double>(update.BytesParsed) / static_cast<double>(update.BytesTotal));
+        }
+        if (update.Store)
+        {
+            // Every update extends the rows of the previous one, so the rows
+            // already shown stay valid.
+            m_allEntries = std::move(update.Store);
+            m_filteredEntries->AppendRows(matches);
+            m_viewAggregates.Merge(aggregates);
+            if (!m_firstRowLatency && !m_allEntries->Empty())
             {
-                m_allEntries.emplace_back(std::move(entry));
+                m_firstRowLatency = std::chrono::steady_clock::now() - m_loadStartedAt;
             }
+            RefreshStats();
+        }
+        if (!update.Finished)
+        {
+            return;
         }
 
-        ApplyFilters();
+        m_loader.reset();
+        m_parseReport = update.Report;
+        hstring note;
+        if (update.Cancelled || !update.Report.Error.empty())
+        {
+            // A partial store is neither followed nor cached.
+            m_currentPath.clear();
+            m_loadedBytes = 0;
+            m_loadingStamp.reset();
+        }
+        if (update.Cancelled)
+        {
+            auto percent = update.BytesTotal != 0 ? update.BytesParsed * 100 / update.BytesTotal : 0;
+            note = L"（已取消，读取了 " + winrt::to_hstring(percent) + L"%）";
+        }
+
+        BuildIndexesAsync(m_allEntries, m_loadingStamp ? m_loadingPath : std::filesystem::path(), m_loadingStamp);
+        m_loadingStamp.reset();
         RefreshStats();
+        CompleteLoadAsync(update.Report.Error, note);
+    }
 
+    winrt::fire_and_forget MainWindow::CompleteLoadAsync(std::string error, hstring note)
+    {
+        auto lifetime = get_strong();
         m_isLoading = false;
         UpdateUiState();
 
         if (!m_currentFileName.empty())
         {
-            FileNameText().Text(L"文件: " + m_currentFileName);
+            FileNameText().Text(L"文件: " + m_currentFileName + note);
         }
         else
         {
-            FileNameText().Text(L"");
+            FileNameText().Text(note);
         }
 
-        if (!m_allEntries.empty())
+        if (!m_allEntries->Empty())
         {
             SummaryBlock().Text(L"点击“LLM解读”获取智能摘要");
         }
@@ -301,728 +567,460 @@ namespace winrt::LogMinds::implementation
         {
             SummaryBlock().Text(L"未解析到有效日志条目");
         }
+
+        // The files that did open are shown; the rest are listed here.
+        if (!error.empty())
+        {
+            ContentDialog dialog;
+            dialog.XamlRoot(Content().XamlRoot());
+            dialog.Title(box_value(L"部分内容未能读取"));
+            dialog.Content(box_value(winrt::to_hstring(error)));
+            dialog.CloseButtonText(L"关闭");
+            co_await dialog.ShowAsync();
+        }
     }
 
     winrt::fire_and_forget MainWindow::InterpretAsync()
     {
         auto lifetime = get_strong();
-        if (m_allEntries.empty())
+        auto store = m_allEntries;
+        if (store->Empty())
         {
             co_return;
         }
 
-        m_isLoading = true;
-        UpdateUiState();
-
-        co_await winrt::resume_background();
-        auto summary = BuildSummary();
-        co_await winrt::resume_foreground(DispatcherQueue());
-
-        UpdateSummary(summary);
-        m_isLoading = false;
-        UpdateUiState();
-    }
-
-    void MainWindow::UpdateFilters()
-    {
-        ApplyFilters();
-    }
-
-    void MainWindow::ApplyFilters()
-    {
-        if (!m_filteredEntries)
+        // The interpretation describes the rows on screen; they and their
+        // aggregates are taken as they are now.
+        std::optional<std::pair<std::vector<uint32_t>, Engine::RowAggregates>> view;
+        if (m_filteredEntries->Size() != store->Size())
         {
-            return;
+            view.emplace(m_filteredEntries->Rows(), m_viewAggregates);
         }
 
-        m_filteredEntries.Clear();
+        auto generation = m_interpretGenerations.Advance();
+        m_interpretGeneration = generation;
+        m_isInterpreting = true;
+        auto startedAt = std::chrono::steady_clock::now();
+        m_interpretStartedAt = startedAt;
+        m_packLatency.reset();
+        m_firstTokenLatency.reset();
+        UpdateUiState();
+        UpdateSummary(L"正在整理日志上下文…");
+        auto dispatcher = DispatcherQueue();
 
-        for (auto const& item : m_allEntries)
+        co_await winrt::resume_background();
+        auto settings = Engine::LlmSettings::FromEnvironment();
+        auto context = view ? Engine::PackContext(*store, view->second, view->first, settings.ContextTokens) :
+            Engine::PackContext(*store, settings.ContextTokens);
+        auto packLatency = std::chrono::steady_clock::now() - startedAt;
+        auto body = Engine::BuildChatRequest(settings, {
+            { "system", std::string(Engine::InterpretInstructions()) },
+            { "user", context.Text },
+        });
+        dispatcher.TryEnqueue([weak = get_weak(), generation, packLatency]
         {
-            if (!item.Entry)
-            {
-                continue;
-            }
-
-            if (!m_selectedLevel.empty())
-            {
-                if (item.NormalizedLevel != m_selectedLevel)
-                {
-                    continue;
-                }
-            }
-
-            if (!m_searchTerm.empty())
+            auto self = weak.get();
+            if (self && self->m_interpretGeneration == generation)
             {
-                std::wstring message = ToLower(std::wstring(item.Entry.Message().c_str()));
-                std::wstring context = ToLower(std::wstring(item.Entry.Context().c_str()));
-                std::wstring source = ToLower(std::wstring(item.Entry.Source().c_str()));
-                std::wstring raw = ToLower(std::wstring(item.Entry.Raw().c_str()));
-                if (message.find(m_searchTerm) == std::wstring::npos &&
-                    context.find(m_searchTerm) == std::wstring::npos &&
-                    source.find(m_searchTerm) == std::wstring::npos &&
-                    raw.find(m_searchTerm) == std::wstring::npos)
-                {
-                    continue;
-                }
+                self->m_packLatency = packLatency;
+                self->UpdateSummary(L"正在等待模型回复…");
+                self->RefreshStats();
             }
+        });
 
-            if (m_startTimeFilter || m_endTimeFilter)
+        // Text goes to the window piece by piece as it streams in.
+        std::string error;
+        auto streamed = false;
+        auto replied = Engine::StreamChatCompletion(settings, body, [&](std::string_view text)
+        {
+            streamed = true;
+            dispatcher.TryEnqueue([weak = get_weak(), generation, text = winrt::to_hstring(text)]
             {
-                if (!item.OccurredOn)
-                {
-                    continue;
-                }
-
-                if (m_startTimeFilter && item.OccurredOn.value() < m_startTimeFilter.value())
+                if (auto self = weak.get())
                 {
-                    continue;
+                    self->OnInterpretText(generation, text);
                 }
+            });
+            return true;
+        }, error, m_interpretGenerations.Token(generation));
 
-                if (m_endTimeFilter && item.OccurredOn.value() > m_endTimeFilter.value())
-                {
-                    continue;
-                }
-            }
-
-            m_filteredEntries.Append(item.Entry);
+        // Without a server the local summary stands in.
+        hstring fallback;
+        if (!replied && !streamed)
+        {
+            fallback = L"未能连接 LLM 服务（" + winrt::to_hstring(error) + L"），以下为本地摘要：\n" +
+                winrt::to_hstring(view ? Engine::BuildSummary(*store, view->second, view->first) : Engine::BuildSummary(*store));
         }
+        co_await winrt::resume_foreground(dispatcher);
 
-        RefreshStats();
+        if (generation != m_interpretGeneration)
+        {
+            co_return;
+        }
+        if (!fallback.empty())
+        {
+            UpdateSummary(fallback);
+        }
+        else if (!replied)
+        {
+            UpdateSummary(m_lastSummary + L"\n（回复中断：" + winrt::to_hstring(error) + L"）");
+        }
+        m_isInterpreting = false;
         UpdateUiState();
+        RefreshStats();
     }
 
-    void MainWindow::UpdateUiState()
-    {
-        OpenLogButton().IsEnabled(!m_isLoading);
-        InterpretButton().IsEnabled(!m_isLoading && !m_allEntries.empty());
-        ClearFiltersButton().IsEnabled(!m_isLoading && !m_allEntries.empty());
-        LoadingIndicator().IsActive(m_isLoading);
-        LoadingIndicator().Visibility(m_isLoading ? Visibility::Visible : Visibility::Collapsed);
-        SearchBox().IsEnabled(!m_isLoading);
-        SeverityCombo().IsEnabled(!m_isLoading);
-        StartDatePicker().IsEnabled(!m_isLoading);
-        EndDatePicker().IsEnabled(!m_isLoading);
-    }
-
-    void MainWindow::UpdateSummary(hstring const& summary)
+    void MainWindow::OnInterpretText(uint64_t generation, hstring const& text)
     {
-        m_lastSummary = summary;
-        SummaryBlock().Text(summary);
+        if (generation != m_interpretGeneration)
+        {
+            return;
+        }
+        if (!m_firstTokenLatency)
+        {
+            m_firstTokenLatency = std::chrono::steady_clock::now() - m_interpretStartedAt;
+            m_lastSummary.clear();
+            RefreshStats();
+        }
+        UpdateSummary(m_lastSummary + text);
     }
 
-    MainWindow::ParsedEntry MainWindow::ParseLine(std::wstring const& line)
+    winrt::fire_and_forget MainWindow::GroupByTemplateAsync()
     {
-        ParsedEntry result;
-        auto trimmed = Trim(line);
-        if (trimmed.empty())
+        auto lifetime = get_strong();
+        if (!IsGroupedByTemplate())
         {
-            return result;
+            co_return;
         }
+        auto generation = ++m_groupGeneration;
+        auto store = m_allEntries;
+        auto rows = m_filteredEntries->Rows();
 
-        if (trimmed.front() == L'{')
+        co_await winrt::resume_background();
+        auto groups = rows.size() == store->Size() ? Engine::GroupByTemplate(*store) :
+            Engine::GroupByTemplate(*store, rows);
+        co_await winrt::resume_foreground(DispatcherQueue());
+
+        if (generation != m_groupGeneration)
         {
-            try
-            {
-                auto json = JsonObject::Parse(trimmed);
-                return ParseJsonObject(json, trimmed);
-            }
-            catch (...)
-            {
-            }
+            co_return;
         }
+        std::vector<uint32_t> indexes(groups.size());
+        std::iota(indexes.begin(), indexes.end(), 0u);
+        m_templateEntries->DiscardEntries();
+        m_templateGroups = std::move(groups);
+        m_groupedStore = std::move(store);
+        m_templateEntries->Reset(std::move(indexes));
+        RefreshStats();
+    }
 
-        result.Entry = CreateEntry();
-        result.Entry.Raw(hstring(trimmed));
+    bool MainWindow::IsGroupedByTemplate()
+    {
+        auto checked = TemplateToggle().IsChecked();
+        return checked && checked.Value();
+    }
 
-        static const std::wregex isoPattern(
-            LR"(^\s*(\d{4}-\d{2}-\d{2}[ T]\d{2}:\d{2}:\d{2}(?:[.,]\d+)?)(?:\s*(?:Z|[+-]\d{2}:\d{2})?)?(?:\s*\[([^\]]+)\])?\s*(TRACE|DEBUG|INFO|WARN|WARNING|ERROR|ERR|FATAL|CRITICAL|NOTICE)?\s*[:-]?\s*(.*)$)",
-            std::regex_constants::icase);
-        std::wsmatch isoMatch;
-        if (std::regex_match(trimmed, isoMatch, isoPattern))
+    winrt::fire_and_forget MainWindow::BuildIndexesAsync(std::shared_ptr<Engine::LogStore const> store,
+        std::filesystem::path cacheSource, std::optional<Engine::SourceStamp> cacheStamp)
+    {
+        auto lifetime = get_strong();
+        if (store->Empty())
         {
-            auto timestamp = std::wstring(isoMatch[1].first, isoMatch[1].second);
-            auto source = std::wstring(isoMatch[2].first, isoMatch[2].second);
-            auto level = std::wstring(isoMatch[3].first, isoMatch[3].second);
-            auto message = std::wstring(isoMatch[4].first, isoMatch[4].second);
-
-            result.Entry.Timestamp(hstring(timestamp));
-            result.OccurredOn = ParseTimestamp(timestamp);
-            result.Entry.Source(hstring(source));
-            result.Entry.Message(hstring(Trim(message)));
-
-            if (!level.empty())
-            {
-                result.NormalizedLevel = ToUpper(level);
-                if (result.NormalizedLevel == L"WARNING")
-                {
-                    result.NormalizedLevel = L"WARN";
-                }
-                else if (result.NormalizedLevel == L"ERR")
-                {
-                    result.NormalizedLevel = L"ERROR";
-                }
-                result.Entry.Level(hstring(result.NormalizedLevel));
-            }
-            else
-            {
-                result.Entry.Level(L"");
-            }
-
-            return result;
+            co_return;
         }
+        auto report = m_parseReport;
+        auto attributes = m_attributeIndex;
+        auto builtAttributes = !attributes;
 
-        static const std::wregex syslogPattern(
-            LR"(^\s*([A-Za-z]{3}\s+\d{1,2}\s+\d{2}:\d{2}:\d{2})\s+([^\s]+)\s+([^:]+):\s*(.*)$)");
-        std::wsmatch syslogMatch;
-        if (std::regex_match(trimmed, syslogMatch, syslogPattern))
+        co_await winrt::resume_background();
+        if (builtAttributes)
         {
-            auto timestamp = std::wstring(syslogMatch[1].first, syslogMatch[1].second);
-            auto host = std::wstring(syslogMatch[2].first, syslogMatch[2].second);
-            auto process = std::wstring(syslogMatch[3].first, syslogMatch[3].second);
-            auto message = std::wstring(syslogMatch[4].first, syslogMatch[4].second);
-
-            result.Entry.Timestamp(hstring(timestamp));
-            result.Entry.Source(hstring(host + L" " + process));
-            result.Entry.Message(hstring(Trim(message)));
-            result.OccurredOn = ParseSyslogTimestamp(timestamp);
-            result.Entry.Level(L"");
-            result.NormalizedLevel.clear();
-            return result;
+            attributes = std::make_shared<Engine::AttributeIndex const>(Engine::AttributeIndex::Build(*store));
         }
-
-        static const std::wregex kvPattern(
-            LR"(^\s*\[?([^\]]+)\]?\s*[:|-]\s*(TRACE|DEBUG|INFO|WARN|WARNING|ERROR|ERR|FATAL|CRITICAL)\s*[:-]?\s*(.*)$)",
-            std::regex_constants::icase);
-        std::wsmatch kvMatch;
-        if (std::regex_match(trimmed, kvMatch, kvPattern))
+        auto index = std::make_shared<Engine::TrigramIndex const>(Engine::TrigramIndex::Build(*store));
+        if (cacheStamp)
         {
-            auto source = std::wstring(kvMatch[1].first, kvMatch[1].second);
-            auto level = std::wstring(kvMatch[2].first, kvMatch[2].second);
-            auto message = std::wstring(kvMatch[3].first, kvMatch[3].second);
-
-            result.Entry.Source(hstring(Trim(source)));
-            result.NormalizedLevel = ToUpper(level);
-            if (result.NormalizedLevel == L"WARNING")
-            {
-                result.NormalizedLevel = L"WARN";
-            }
-            else if (result.NormalizedLevel == L"ERR")
-            {
-                result.NormalizedLevel = L"ERROR";
-            }
-            result.Entry.Level(hstring(result.NormalizedLevel));
-            result.Entry.Message(hstring(Trim(message)));
-            return result;
+            // Best effort: without an entry the file is just parsed again.
+            std::string error;
+            Engine::LogCache(Engine::LogCache::DefaultDirectory()).Save(cacheSource, *cacheStamp, *store, report,
+                attributes.get(), index.get(), error);
         }
+        co_await winrt::resume_foreground(DispatcherQueue());
 
-        static const std::wregex simpleLevelPattern(
-            LR"(^\s*\[?(TRACE|DEBUG|INFO|WARN|WARNING|ERROR|ERR|FATAL|CRITICAL|NOTICE)\]?\s*[:-]?\s*(.*)$)",
-            std::regex_constants::icase);
-        std::wsmatch simpleMatch;
-        if (std::regex_match(trimmed, simpleMatch, simpleLevelPattern))
+        // A file loaded in the meantime has its own build.
+        if (store == m_allEntries)
         {
-            auto level = std::wstring(simpleMatch[1].first, simpleMatch[1].second);
-            auto message = std::wstring(simpleMatch[2].first, simpleMatch[2].second);
-            result.NormalizedLevel = ToUpper(level);
-            if (result.NormalizedLevel == L"WARNING")
+            if (builtAttributes)
             {
-                result.NormalizedLevel = L"WARN";
+                m_attributeIndex = std::move(attributes);
             }
-            else if (result.NormalizedLevel == L"ERR")
-            {
-                result.NormalizedLevel = L"ERROR";
-            }
-            result.Entry.Level(hstring(result.NormalizedLevel));
-            result.Entry.Message(hstring(Trim(message)));
-            return result;
+            m_searchIndex = std::move(index);
+            RefreshStats();
         }
+    }
 
-        result.Entry.Message(hstring(trimmed));
-        result.Entry.Level(L"");
-        result.NormalizedLevel.clear();
-        return result;
+    void MainWindow::UpdateFilters()
+    {
+        ApplyFilters();
     }
 
-    MainWindow::ParsedEntry MainWindow::ParseJsonObject(JsonObject const& object, std::wstring const& rawLine)
+    void MainWindow::ApplyFilters()
     {
-        ParsedEntry result;
-        result.Entry = CreateEntry();
-        result.Entry.Raw(hstring(rawLine));
+        if (!m_filteredEntries)
+        {
+            return;
+        }
 
-        auto getValue = [&](std::initializer_list<std::wstring_view> keys) -> std::wstring
+        if (!m_filterWorker)
         {
-            for (auto key : keys)
+            m_filterWorker = std::make_unique<Engine::FilterWorker>(
+                [weak = get_weak(), dispatcher = DispatcherQueue()](Engine::FilterResult&& result)
             {
-                hstring hkey(key.data(), key.size());
-                if (object.HasKey(hkey))
+                dispatcher.TryEnqueue([weak, result = std::move(result)]() mutable
                 {
-                    auto value = object.Lookup(hkey);
-                    switch (value.ValueType())
+                    if (auto self = weak.get())
                     {
-                    case JsonValueType::String:
-                        return std::wstring(value.GetString().c_str());
-                    case JsonValueType::Number:
-                        return std::to_wstring(value.GetNumber());
-                    case JsonValueType::Boolean:
-                        return value.GetBoolean() ? L"true" : L"false";
-                    default:
-                        return std::wstring(value.Stringify().c_str());
+                        self->OnFilterResult(std::move(result));
                     }
-                }
-            }
-            return L"";
-        };
-
-        auto timestamp = getValue({ L"timestamp", L"time", L"@timestamp", L"datetime", L"date", L"eventTime" });
-        if (!timestamp.empty())
-        {
-            result.Entry.Timestamp(hstring(timestamp));
-            result.OccurredOn = ParseTimestamp(timestamp);
-        }
-
-        auto level = getValue({ L"level", L"severity", L"logLevel", L"lvl", L"priority" });
-        if (!level.empty())
-        {
-            result.NormalizedLevel = ToUpper(level);
-            if (result.NormalizedLevel == L"WARNING")
-            {
-                result.NormalizedLevel = L"WARN";
-            }
-            else if (result.NormalizedLevel == L"ERR")
-            {
-                result.NormalizedLevel = L"ERROR";
-            }
-            result.Entry.Level(hstring(result.NormalizedLevel));
-        }
-
-        auto source = getValue({ L"logger", L"source", L"module", L"service", L"category", L"name" });
-        if (!source.empty())
-        {
-            result.Entry.Source(hstring(source));
+                });
+            });
         }
+        m_filterWorker->Submit(m_allEntries, m_searchIndex, m_attributeIndex, m_query);
+        m_filterPending = true;
+    }
 
-        auto message = getValue({ L"message", L"msg", L"event", L"description", L"detail" });
-        if (!message.empty())
-        {
-            result.Entry.Message(hstring(message));
-        }
-        else
+    void MainWindow::OnFilterResult(Engine::FilterResult&& result)
+    {
+        // Another query was submitted while this result was being queued.
+        if (!m_filterWorker->IsCurrent(result.Generation))
         {
-            result.Entry.Message(hstring(rawLine));
+            return;
         }
 
-        std::vector<std::wstring> contextPairs;
-        for (auto const& pair : object)
-        {
-            auto key = std::wstring(pair.Key().c_str());
-            auto lowerKey = ToLower(key);
-            if (lowerKey == L"timestamp" || lowerKey == L"time" || lowerKey == L"@timestamp" || lowerKey == L"datetime" ||
-                lowerKey == L"date" || lowerKey == L"eventtime" || lowerKey == L"level" || lowerKey == L"severity" ||
-                lowerKey == L"loglevel" || lowerKey == L"lvl" || lowerKey == L"priority" || lowerKey == L"message" ||
-                lowerKey == L"msg" || lowerKey == L"event" || lowerKey == L"description" || lowerKey == L"detail" ||
-                lowerKey == L"logger" || lowerKey == L"source" || lowerKey == L"module" || lowerKey == L"service" ||
-                lowerKey == L"category" || lowerKey == L"name")
-            {
-                continue;
-            }
+        m_filterPending = false;
+        m_filterLatency = std::chrono::steady_clock::now() - result.SubmittedAt;
+        m_filteredEntries->Reset(std::move(result.Rows));
+        m_viewAggregates = std::move(result.Aggregates);
+        GroupByTemplateAsync();
 
-            auto value = pair.Value();
-            std::wstring serialized;
-            switch (value.ValueType())
-            {
-            case JsonValueType::String:
-                serialized = std::wstring(value.GetString().c_str());
-                break;
-            case JsonValueType::Number:
-                serialized = std::to_wstring(value.GetNumber());
-                break;
-            case JsonValueType::Boolean:
-                serialized = value.GetBoolean() ? L"true" : L"false";
-                break;
-            default:
-                serialized = std::wstring(value.Stringify().c_str());
-                break;
-            }
-            contextPairs.push_back(key + L"=" + serialized);
-        }
+        RefreshStats();
+        UpdateUiState();
+    }
 
-        if (!contextPairs.empty())
+    void MainWindow::StopFollowing()
+    {
+        if (!m_follower)
         {
-            std::wstring context;
-            for (size_t i = 0; i < contextPairs.size(); ++i)
-            {
-                context.append(contextPairs[i]);
-                if (i + 1 < contextPairs.size())
-                {
-                    context.append(L" | ");
-                }
-            }
-            result.Entry.Context(hstring(context));
+            return;
         }
+        ++m_followGeneration;
+        m_follower.reset();
 
-        if (result.NormalizedLevel.empty())
+        // The index stopped at the rows present when following began.
+        if (m_searchIndex && m_searchIndex->Rows() != m_allEntries->Size())
         {
-            result.NormalizedLevel.clear();
+            m_searchIndex.reset();
+            BuildIndexesAsync(m_allEntries);
         }
-
-        return result;
     }
 
-    LogEntry MainWindow::CreateEntry()
+    void MainWindow::OnFollowUpdate(Engine::FollowUpdate&& update)
     {
-        return LogEntry();
-    }
+        m_loadedBytes = update.Offset;
+        if (update.Restarted)
+        {
+            m_filteredEntries->DiscardEntries();
+            m_filteredEntries->Reset({});
+            m_viewAggregates = {};
+        }
+        m_allEntries = std::move(update.Store);
 
-    std::wstring MainWindow::Trim(std::wstring_view text)
-    {
-        size_t start = 0;
-        size_t end = text.size();
-        while (start < end && std::iswspace(text[start]))
+        // The indexes describe fewer rows now, so the filter scans instead of
+        // using them. A scan still on its way covers only the old rows, so it
+        // is redone; otherwise only the new rows are filtered, in one batch
+        // per update.
+        if (update.Restarted || m_filterPending)
         {
-            ++start;
+            ApplyFilters();
         }
-        while (end > start && std::iswspace(text[end - 1]))
+        else
         {
-            --end;
+            std::vector<uint32_t> fresh(m_allEntries->Size() - update.FirstNewRow);
+            std::iota(fresh.begin(), fresh.end(), static_cast<uint32_t>(update.FirstNewRow));
+            auto matches = Engine::ApplyFilter(*m_allEntries, m_query, fresh);
+            m_viewAggregates.Merge(Engine::RowAggregates::Of(*m_allEntries, matches));
+            m_filteredEntries->AppendRows(matches);
+            GroupByTemplateAsync();
         }
-        return std::wstring(text.substr(start, end - start));
+
+        RefreshStats();
+        UpdateUiState();
     }
 
-    std::wstring MainWindow::ToLower(std::wstring value)
+    void MainWindow::UpdateUiState()
     {
-        std::transform(value.begin(), value.end(), value.begin(), [](wchar_t ch)
-        {
-            return static_cast<wchar_t>(std::towlower(ch));
-        });
-        return value;
+        OpenLogButton().IsEnabled(!m_isLoading);
+        OpenFolderButton().IsEnabled(!m_isLoading);
+        InterpretButton().IsEnabled(!m_isLoading && !m_isInterpreting && !m_allEntries->Empty());
+        ClearFiltersButton().IsEnabled(!m_isLoading && !m_allEntries->Empty());
+        FollowToggle().IsEnabled(!m_isLoading && !m_currentPath.empty());
+        TemplateToggle().IsEnabled(!m_isLoading && !m_allEntries->Empty());
+        // A file parsed batch by batch shows how far it got and can be
+        // cancelled; everything else just spins.
+        auto progressive = m_loader != nullptr;
+        LoadingIndicator().IsActive(m_isLoading && !progressive);
+        LoadingIndicator().Visibility(m_isLoading && !progressive ? Visibility::Visible : Visibility::Collapsed);
+        LoadProgress().Visibility(progressive ? Visibility::Visible : Visibility::Collapsed);
+        CancelLoadButton().IsEnabled(progressive);
+        CancelLoadButton().Visibility(progressive ? Visibility::Visible : Visibility::Collapsed);
+        SearchBox().IsEnabled(!m_isLoading);
+        SeverityCombo().IsEnabled(!m_isLoading);
+        OriginCombo().IsEnabled(!m_isLoading);
+        StartDatePicker().IsEnabled(!m_isLoading);
+        EndDatePicker().IsEnabled(!m_isLoading);
+        StartTimePicker().IsEnabled(!m_isLoading);
+        EndTimePicker().IsEnabled(!m_isLoading);
     }
 
-    std::wstring MainWindow::ToUpper(std::wstring value)
+    void MainWindow::UpdateSummary(hstring const& summary)
     {
-        std::transform(value.begin(), value.end(), value.begin(), [](wchar_t ch)
-        {
-            return static_cast<wchar_t>(std::towupper(ch));
-        });
-        return value;
+        m_lastSummary = summary;
+        SummaryBlock().Text(summary);
     }
 
-    std::optional<DateTime> MainWindow::ParseTimestamp(std::wstring_view text)
+    winrt::LogMinds::LogEntry MainWindow::CreateEntry(uint32_t row)
     {
-        std::wstring normalized(text);
-        for (auto& ch : normalized)
+        winrt::LogMinds::LogEntry entry;
+        entry.Timestamp(winrt::to_hstring(m_allEntries->Timestamp(row)));
+        entry.Level(winrt::to_hstring(m_allEntries->Level(row)));
+        entry.Source(winrt::to_hstring(m_allEntries->Source(row)));
+        entry.Message(winrt::to_hstring(m_allEntries->Message(row)));
+        entry.Context(winrt::to_hstring(m_allEntries->Context(row)));
+        entry.Raw(winrt::to_hstring(m_allEntries->Raw(row)));
+        if (m_allEntries->OriginNames().size() > 1)
         {
-            if (ch == L'T')
-            {
-                ch = L' ';
-            }
+            entry.Origin(winrt::to_hstring(m_allEntries->Origin(row)));
         }
-
-        auto dot = normalized.find_first_of(L".,");
-        int fractionalMilliseconds = 0;
-        if (dot != std::wstring::npos)
+        if (auto occurredOn = m_allEntries->OccurredOn(row))
         {
-            auto fraction = normalized.substr(dot + 1);
-            if (!fraction.empty())
-            {
-                int digits = static_cast<int>(std::min<size_t>(3, fraction.size()));
-                fractionalMilliseconds = std::stoi(fraction.substr(0, digits));
-            }
-            normalized = normalized.substr(0, dot);
+            entry.OccurredOn(IReference<DateTime>{ ToDateTime(*occurredOn) });
         }
+        return entry;
+    }
 
-        std::wistringstream stream(normalized);
-        std::tm tm{};
-        stream >> std::get_time(&tm, L"%Y-%m-%d %H:%M:%S");
-        if (stream.fail())
+    winrt::LogMinds::LogEntry MainWindow::CreateGroupEntry(uint32_t group)
+    {
+        // First seen under the time, the row count under the level and the
+        // last time seen as the context.
+        auto const& templateGroup = m_templateGroups[group];
+        winrt::LogMinds::LogEntry entry;
+        if (templateGroup.FirstTime)
         {
-            return std::nullopt;
+            entry.Timestamp(winrt::to_hstring(Engine::FormatTimestamp(*templateGroup.FirstTime)));
+            entry.OccurredOn(IReference<DateTime>{ ToDateTime(*templateGroup.FirstTime) });
         }
-
-#if defined(_WIN32)
-        auto seconds = _mkgmtime(&tm);
-#else
-        auto seconds = timegm(&tm);
-#endif
-        if (seconds == -1)
+        entry.Level(winrt::to_hstring(templateGroup.Rows) + L" 条");
+        entry.Message(winrt::to_hstring(m_groupedStore->Templates().Text(templateGroup.Template)));
+        entry.Raw(entry.Message());
+        if (templateGroup.LastTime)
         {
-            return std::nullopt;
+            entry.Context(L"最后出现：" + winrt::to_hstring(Engine::FormatTimestamp(*templateGroup.LastTime)));
         }
-
-        auto timePoint = std::chrono::system_clock::from_time_t(seconds) + std::chrono::milliseconds(fractionalMilliseconds);
-        DateTime dateTime{};
-        dateTime.Duration = winrt::clock::from_sys(timePoint).time_since_epoch().count();
-        return dateTime;
+        return entry;
     }
 
-    std::optional<DateTime> MainWindow::ParseSyslogTimestamp(std::wstring_view text)
+    void MainWindow::RefreshOrigins()
     {
-        std::wstring value(text);
-        std::wistringstream stream(value);
-        std::tm tm{};
-        stream >> std::get_time(&tm, L"%b %d %H:%M:%S");
-        if (stream.fail())
-        {
-            return std::nullopt;
-        }
-
-        auto now = std::chrono::system_clock::now();
-        auto nowTime = std::chrono::system_clock::to_time_t(now);
-        std::tm current{};
-#if defined(_WIN32)
-        gmtime_s(&current, &nowTime);
-#else
-        gmtime_r(&nowTime, &current);
-#endif
-        tm.tm_year = current.tm_year;
-
-#if defined(_WIN32)
-        auto seconds = _mkgmtime(&tm);
-#else
-        auto seconds = timegm(&tm);
-#endif
-        if (seconds == -1)
+        auto combo = OriginCombo();
+        combo.Items().Clear();
+        auto const& names = m_allEntries->OriginNames();
+        if (names.size() <= 1)
         {
-            return std::nullopt;
+            combo.Visibility(Visibility::Collapsed);
+            return;
         }
 
-        auto timePoint = std::chrono::system_clock::from_time_t(seconds);
-        DateTime dateTime{};
-        dateTime.Duration = winrt::clock::from_sys(timePoint).time_since_epoch().count();
-        return dateTime;
-    }
-
-    std::wstring MainWindow::FormatDateRange(std::optional<DateTime> const& start, std::optional<DateTime> const& end)
-    {
-        auto formatSingle = [](DateTime const& value)
-        {
-            auto sys = winrt::clock::to_sys(value);
-            auto tt = std::chrono::system_clock::to_time_t(sys);
-            std::tm tm{};
-#if defined(_WIN32)
-            gmtime_s(&tm, &tt);
-#else
-            gmtime_r(&tt, &tm);
-#endif
-            std::wstringstream ss;
-            ss << std::put_time(&tm, L"%Y-%m-%d %H:%M:%S");
-            return ss.str();
-        };
-
-        if (start && end)
-        {
-            return formatSingle(*start) + L" 至 " + formatSingle(*end);
-        }
-        if (start)
-        {
-            return L"自 " + formatSingle(*start);
-        }
-        if (end)
+        combo.Items().Append(box_value(L"全部文件"));
+        for (size_t id = 1; id < names.size(); ++id)
         {
-            return L"截至 " + formatSingle(*end);
+            combo.Items().Append(box_value(winrt::to_hstring(names[id])));
         }
-        return L"";
+        combo.SelectedIndex(0);
+        combo.Visibility(Visibility::Visible);
     }
 
-    hstring MainWindow::BuildSummary()
+    void MainWindow::RefreshStats()
     {
-        if (m_allEntries.empty())
+        std::wstringstream stats;
+        stats << L"共 " << m_allEntries->Size() << L" 条记录，当前显示 " << m_filteredEntries->Size() << L" 条。";
+        if (auto files = m_allEntries->OriginNames().size() - 1; files > 1)
         {
-            return L"尚未加载日志数据。";
+            stats << L" 合并自 " << files << L" 个文件。";
         }
 
-        std::map<std::wstring, int> levelCount;
-        std::map<std::wstring, int> sourceCount;
-        std::unordered_map<std::wstring, int> keywordFrequency;
-        std::vector<std::wstring> criticalMessages;
-        std::optional<DateTime> firstTimestamp;
-        std::optional<DateTime> lastTimestamp;
-
-        for (auto const& entry : m_allEntries)
+        auto parsedLines = m_parseReport.Hits + m_parseReport.Misses;
+        if (parsedLines != 0)
         {
-            if (!entry.Entry)
-            {
-                continue;
-            }
-
-            auto level = entry.NormalizedLevel;
-            if (level.empty())
-            {
-                level = L"未标记";
-            }
-            levelCount[level]++;
-
-            auto source = std::wstring(entry.Entry.Source().c_str());
-            if (!source.empty())
-            {
-                sourceCount[source]++;
-            }
-
-            if (entry.OccurredOn)
-            {
-                if (!firstTimestamp || entry.OccurredOn < firstTimestamp)
-                {
-                    firstTimestamp = entry.OccurredOn;
-                }
-                if (!lastTimestamp || entry.OccurredOn > lastTimestamp)
-                {
-                    lastTimestamp = entry.OccurredOn;
-                }
-            }
-
-            auto message = std::wstring(entry.Entry.Message().c_str());
-            if (!entry.NormalizedLevel.empty())
-            {
-                auto upper = entry.NormalizedLevel;
-                if (upper == L"ERROR" || upper == L"FATAL" || upper == L"CRITICAL")
-                {
-                    criticalMessages.push_back(message);
-                }
-            }
-
-            std::wstring lowerMessage = ToLower(message);
-            std::wstring word;
-            for (wchar_t ch : lowerMessage)
-            {
-                if (IsWordChar(ch))
-                {
-                    word.push_back(ch);
-                }
-                else
-                {
-                    if (word.size() > 3)
-                    {
-                        keywordFrequency[word]++;
-                    }
-                    word.clear();
-                }
-            }
-            if (word.size() > 3)
+            stats << L" 格式：" << winrt::to_hstring(Engine::LineFormatName(m_parseReport.Format)).c_str();
+            if (m_parseReport.Misses != 0)
             {
-                keywordFrequency[word]++;
+                stats << L"（" << m_parseReport.Misses << L" 行不符）";
             }
         }
 
-        std::vector<std::pair<std::wstring, int>> keywords(keywordFrequency.begin(), keywordFrequency.end());
-        std::sort(keywords.begin(), keywords.end(), [](auto const& left, auto const& right)
+        if (auto saved = m_allEntries->DictionarySavings(); saved != 0)
         {
-            if (left.second == right.second)
-            {
-                return left.first < right.first;
-            }
-            return left.second > right.second;
-        });
-
-        size_t maxKeywords = std::min<size_t>(5, keywords.size());
-
-        std::wstringstream summary;
-        summary << L"📊 日志总览" << std::endl;
-        summary << L"  • 共解析 " << m_allEntries.size() << L" 条记录";
-        if (!levelCount.empty())
-        {
-            summary << L"，级别分布：";
-            bool first = true;
-            for (auto const& pair : levelCount)
-            {
-                if (!first)
-                {
-                    summary << L"，";
-                }
-                summary << pair.first << L"=" << pair.second;
-                first = false;
-            }
+            stats << L" 字典编码节省：" << std::fixed << std::setprecision(1)
+                << static_cast<double>(saved) / (1 << 20) << L" MB";
         }
-        summary << std::endl;
 
-        if (firstTimestamp || lastTimestamp)
+        if (m_searchIndex)
         {
-            summary << L"  • 时间范围：" << FormatDateRange(firstTimestamp, lastTimestamp) << std::endl;
+            stats << L" 索引：" << std::fixed << std::setprecision(1)
+                << static_cast<double>(m_searchIndex->MemoryUsage()) / (1 << 20) << L" MB";
         }
 
-        if (!sourceCount.empty())
+        if (m_firstRowLatency)
         {
-            std::vector<std::pair<std::wstring, int>> sortedSources(sourceCount.begin(), sourceCount.end());
-            std::sort(sortedSources.begin(), sortedSources.end(), [](auto const& left, auto const& right)
-            {
-                if (left.second == right.second)
-                {
-                    return left.first < right.first;
-                }
-                return left.second > right.second;
-            });
-            summary << L"  • 主要来源：";
-            size_t count = std::min<size_t>(3, sortedSources.size());
-            for (size_t i = 0; i < count; ++i)
-            {
-                if (i > 0)
-                {
-                    summary << L"，";
-                }
-                summary << sortedSources[i].first << L"(" << sortedSources[i].second << L")";
-            }
-            summary << std::endl;
+            stats << L" 首行耗时：" << std::chrono::duration_cast<std::chrono::milliseconds>(*m_firstRowLatency).count()
+                << L" ms";
         }
 
-        if (!criticalMessages.empty())
+        if (m_firstTokenLatency)
         {
-            summary << L"⚠️ 关键异常" << std::endl;
-            size_t count = std::min<size_t>(3, criticalMessages.size());
-            for (size_t i = 0; i < count; ++i)
-            {
-                summary << L"  • " << criticalMessages[i] << std::endl;
-            }
-            if (criticalMessages.size() > count)
-            {
-                summary << L"  • 其余 " << (criticalMessages.size() - count) << L" 条错误已省略" << std::endl;
-            }
+            stats << L" 首字耗时：" << std::chrono::duration_cast<std::chrono::milliseconds>(*m_firstTokenLatency).count()
+                << L" ms";
         }
-
-        if (maxKeywords > 0)
+        if (m_packLatency)
         {
-            summary << L"🧠 主题洞察" << std::endl;
-            summary << L"  • 高频关键词：";
-            for (size_t i = 0; i < maxKeywords; ++i)
-            {
-                if (i > 0)
-                {
-                    summary << L"，";
-                }
-                summary << keywords[i].first << L"(" << keywords[i].second << L")";
-            }
-            summary << std::endl;
+            stats << L"（上下文整理 " << std::chrono::duration_cast<std::chrono::milliseconds>(*m_packLatency).count()
+                << L" ms）";
         }
 
-        summary << L"✅ 建议操作" << std::endl;
-        int warnCount = 0;
-        if (auto it = levelCount.find(L"WARN"); it != levelCount.end())
+        if (m_filterLatency)
         {
-            warnCount = it->second;
+            stats << L" 筛选耗时：" << std::chrono::duration_cast<std::chrono::milliseconds>(*m_filterLatency).count()
+                << L" ms";
         }
 
-        if (!criticalMessages.empty())
+        if (!m_query.Level.empty())
         {
-            summary << L"  • 优先处理上述关键异常，必要时增加告警阈值监控" << std::endl;
+            stats << L" 筛选级别：" << winrt::to_hstring(m_query.Level).c_str();
         }
-        else if (warnCount == 0)
+
+        if (!m_query.Origin.empty())
         {
-            summary << L"  • 当前日志未发现严重异常，可继续监控趋势" << std::endl;
+            stats << L" 筛选文件：" << winrt::to_hstring(m_query.Origin).c_str();
         }
-        else
+
+        if (m_query.Template && *m_query.Template < m_allEntries->Templates().Size())
         {
-            summary << L"  • 聚焦 WARN 级别日志，确认潜在风险是否可复现" << std::endl;
+            stats << L" 筛选模板：" << winrt::to_hstring(m_allEntries->Templates().Text(*m_query.Template)).c_str();
         }
 
-        return hstring(summary.str());
-    }
-
-    void MainWindow::RefreshStats()
-    {
-        std::wstringstream stats;
-        stats << L"共 " << m_allEntries.size() << L" 条记录，当前显示 " << static_cast<uint32_t>(m_filteredEntries.Size()) << L" 条。";
-
-        if (!m_selectedLevel.empty())
+        if (IsGroupedByTemplate())
         {
-            stats << L" 筛选级别：" << m_selectedLevel;
+            stats << L" 模板：" << m_templateGroups.size() << L" 个";
         }
 
         auto searchText = std::wstring(SearchBox().Text().c_str());
@@ -1031,12 +1029,12 @@ namespace winrt::LogMinds::implementation
             stats << L" 关键词：" << searchText;
         }
 
-        if (m_startTimeFilter || m_endTimeFilter)
+        if (m_query.StartTime || m_query.EndTime)
         {
-            auto rangeText = FormatDateRange(m_startTimeFilter, m_endTimeFilter);
+            auto rangeText = Engine::FormatDateRange(m_query.StartTime, m_query.EndTime);
             if (!rangeText.empty())
             {
-                stats << L" 时间：" << rangeText;
+                stats << L" 时间：" << winrt::to_hstring(rangeText).c_str();
             }
         }
 
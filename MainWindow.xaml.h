@@ -1,6 +1,19 @@
 #pragma once
 
 #include "MainWindow.g.h"
+#include "LogEntryCollection.h"
+#include "Engine/AttributeIndex.h"
+#include "Engine/Filter.h"
+#include "Engine/FilterWorker.h"
+#include "Engine/LlmClient.h"
+#include "Engine/LogDocument.h"
+#include "Engine/LogCache.h"
+#include "Engine/LogFollower.h"
+#include "Engine/LogLoader.h"
+#include "Engine/LogStore.h"
+#include "Engine/RowAggregates.h"
+#include "Engine/TemplateMiner.h"
+#include "Engine/TrigramIndex.h"
 
 namespace winrt::LogMinds::implementation
 {
@@ -12,51 +25,104 @@ namespace winrt::LogMinds::implementation
         void MyProperty(int32_t value);
 
         void OnOpenLogClicked(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::RoutedEventArgs const& args);
+        void OnOpenFolderClicked(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::RoutedEventArgs const& args);
         void OnInterpretClicked(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::RoutedEventArgs const& args);
         void OnSearchTextChanged(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::Controls::TextChangedEventArgs const& args);
         void OnSeverityChanged(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::Controls::SelectionChangedEventArgs const& args);
+        void OnOriginChanged(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::Controls::SelectionChangedEventArgs const& args);
         void OnStartDateChanged(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::Controls::DatePickerValueChangedEventArgs const& args);
         void OnEndDateChanged(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::Controls::DatePickerValueChangedEventArgs const& args);
         void OnStartTimeChanged(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::Controls::TimePickerValueChangedEventArgs const& args);
         void OnEndTimeChanged(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::Controls::TimePickerValueChangedEventArgs const& args);
         void OnClearFilters(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::RoutedEventArgs const& args);
+        void OnFollowToggled(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::RoutedEventArgs const& args);
+        void OnTemplateToggled(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::RoutedEventArgs const& args);
+        void OnEntryClicked(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::Controls::ItemClickEventArgs const& args);
+        void OnCancelLoadClicked(winrt::Windows::Foundation::IInspectable const& sender, winrt::Microsoft::UI::Xaml::RoutedEventArgs const& args);
 
     private:
-        struct ParsedEntry
-        {
-            winrt::LogMinds::LogEntry Entry{ nullptr };
-            std::optional<winrt::Windows::Foundation::DateTime> OccurredOn{};
-            std::wstring NormalizedLevel;
-        };
-
-        winrt::Windows::Foundation::Collections::IObservableVector<winrt::LogMinds::LogEntry> m_filteredEntries{ nullptr };
-        std::vector<ParsedEntry> m_allEntries;
+        winrt::com_ptr<LogEntryCollection> m_filteredEntries;
+        // Shared with background work (index build, summary) so a newly
+        // loaded file never pulls the rows out from under it.
+        std::shared_ptr<::LogMinds::Engine::LogStore const> m_allEntries{ std::make_shared<::LogMinds::Engine::LogStore>() };
+        // Null until the background build for m_allEntries has finished.
+        std::shared_ptr<::LogMinds::Engine::TrigramIndex const> m_searchIndex;
+        // Built with m_allEntries; resolves level and time range filters.
+        std::shared_ptr<::LogMinds::Engine::AttributeIndex const> m_attributeIndex;
+        ::LogMinds::Engine::FilterQuery m_query;
+        // Created on first use; delivers results through OnFilterResult.
+        std::unique_ptr<::LogMinds::Engine::FilterWorker> m_filterWorker;
+        std::optional<std::chrono::steady_clock::duration> m_filterLatency;
+        // Shown instead of m_filteredEntries while the template toggle is on;
+        // its items are indexes into m_templateGroups, which group the rows
+        // of m_filteredEntries in m_groupedStore. Groups of an older request
+        // are told apart by m_groupGeneration.
+        winrt::com_ptr<LogEntryCollection> m_templateEntries;
+        std::vector<::LogMinds::Engine::TemplateGroup> m_templateGroups;
+        std::shared_ptr<::LogMinds::Engine::LogStore const> m_groupedStore;
+        uint64_t m_groupGeneration{ 0 };
+        // Over the rows of m_filteredEntries; the summary describes them.
+        ::LogMinds::Engine::RowAggregates m_viewAggregates;
+        // Set from Submit until the current generation's result arrives.
+        bool m_filterPending{ false };
+        // Running while the follow toggle is on. Updates of an older follower
+        // are told apart by m_followGeneration.
+        std::unique_ptr<::LogMinds::Engine::LogFollower> m_follower;
+        uint64_t m_followGeneration{ 0 };
+        // Empty when several files were merged; only a single file is followed.
+        std::filesystem::path m_currentPath;
+        // Bytes of m_currentPath that m_allEntries was parsed from.
+        uint64_t m_loadedBytes{ 0 };
+        ::LogMinds::Engine::ParseReport m_parseReport;
+        // Set while a single file is being parsed batch by batch; its updates
+        // arrive through OnLoadUpdate. The path and stamp are for the cache
+        // entry written once the load completes.
+        std::unique_ptr<::LogMinds::Engine::LogLoader> m_loader;
+        std::filesystem::path m_loadingPath;
+        std::optional<::LogMinds::Engine::SourceStamp> m_loadingStamp;
+        std::chrono::steady_clock::time_point m_loadStartedAt;
+        // From picking the file to its first rows being shown.
+        std::optional<std::chrono::steady_clock::duration> m_firstRowLatency;
+        // Advanced for every interpretation and every load: the reply of an
+        // older one stops streaming and its text is dropped.
+        ::LogMinds::Engine::GenerationCounter m_interpretGenerations;
+        uint64_t m_interpretGeneration{ 0 };
+        bool m_isInterpreting{ false };
+        std::chrono::steady_clock::time_point m_interpretStartedAt;
+        // From the click to the packed context, and to the first reply text.
+        std::optional<std::chrono::steady_clock::duration> m_packLatency;
+        std::optional<std::chrono::steady_clock::duration> m_firstTokenLatency;
         int32_t m_myProperty{ 0 };
         bool m_isLoading{ false };
-        std::wstring m_searchTerm;
-        std::wstring m_selectedLevel;
-        std::optional<winrt::Windows::Foundation::DateTime> m_startTimeFilter;
-        std::optional<winrt::Windows::Foundation::DateTime> m_endTimeFilter;
         winrt::hstring m_lastSummary;
         winrt::hstring m_currentFileName;
 
-        winrt::fire_and_forget LoadLogsAsync();
+        winrt::fire_and_forget LoadLogsAsync(bool folder);
+        void OnLoadUpdate(::LogMinds::Engine::LoadUpdate&& update, std::vector<uint32_t>&& matches,
+            ::LogMinds::Engine::RowAggregates&& aggregates);
+        // Shared end of every load; note is appended to the file name.
+        winrt::fire_and_forget CompleteLoadAsync(std::string error, winrt::hstring note = {});
         winrt::fire_and_forget InterpretAsync();
+        void OnInterpretText(uint64_t generation, winrt::hstring const& text);
+        // Regroups the rows on screen by template when the grouped view is shown.
+        winrt::fire_and_forget GroupByTemplateAsync();
+        bool IsGroupedByTemplate();
+        // Builds the search index, and the attribute index if there is none
+        // yet. With a stamp, the cache entry for cacheSource is written once
+        // both are built.
+        winrt::fire_and_forget BuildIndexesAsync(std::shared_ptr<::LogMinds::Engine::LogStore const> store,
+            std::filesystem::path cacheSource = {}, std::optional<::LogMinds::Engine::SourceStamp> cacheStamp = {});
         void UpdateFilters();
         void ApplyFilters();
+        void OnFilterResult(::LogMinds::Engine::FilterResult&& result);
+        void StopFollowing();
+        void OnFollowUpdate(::LogMinds::Engine::FollowUpdate&& update);
         void UpdateUiState();
         void UpdateSummary(winrt::hstring const& summary);
-        ParsedEntry ParseLine(std::wstring const& line);
-        ParsedEntry ParseJsonObject(winrt::Windows::Data::Json::JsonObject const& object, std::wstring const& rawLine);
-        winrt::LogMinds::LogEntry CreateEntry();
-        static std::wstring Trim(std::wstring_view text);
-        static std::wstring ToLower(std::wstring value);
-        static std::wstring ToUpper(std::wstring value);
-        static std::optional<winrt::Windows::Foundation::DateTime> ParseTimestamp(std::wstring_view text);
-        static std::optional<winrt::Windows::Foundation::DateTime> ParseSyslogTimestamp(std::wstring_view text);
-        static std::wstring FormatDateRange(std::optional<winrt::Windows::Foundation::DateTime> const& start, std::optional<winrt::Windows::Foundation::DateTime> const& end);
-        winrt::hstring BuildSummary();
+        winrt::LogMinds::LogEntry CreateEntry(uint32_t row);
+        winrt::LogMinds::LogEntry CreateGroupEntry(uint32_t group);
         void RefreshStats();
+        void RefreshOrigins();
         HWND GetWindowHandle() const;
     };
 }
@@ -33,8 +33,11 @@
 #include <chrono>
 #include <cctype>
 #include <cwctype>
+#include <filesystem>
 #include <iomanip>
 #include <map>
+#include <memory>
+#include <numeric>
 #include <optional>
 #include <regex>
 #include <sstream>